@@ -0,0 +1,8 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/zipios_code_analysis"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang )
+  include(CMakeFiles/zipios_code_analysis.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
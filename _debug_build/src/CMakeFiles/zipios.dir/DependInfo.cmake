@@ -0,0 +1,68 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/backbuffer.cpp" "src/CMakeFiles/zipios.dir/backbuffer.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/backbuffer.cpp.o.d"
+  "/root/repo/src/codec.cpp" "src/CMakeFiles/zipios.dir/codec.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/codec.cpp.o.d"
+  "/root/repo/src/codecpool.cpp" "src/CMakeFiles/zipios.dir/codecpool.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/codecpool.cpp.o.d"
+  "/root/repo/src/collectioncollection.cpp" "src/CMakeFiles/zipios.dir/collectioncollection.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/collectioncollection.cpp.o.d"
+  "/root/repo/src/compressionpolicy.cpp" "src/CMakeFiles/zipios.dir/compressionpolicy.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/compressionpolicy.cpp.o.d"
+  "/root/repo/src/countingoutputstreambuf.cpp" "src/CMakeFiles/zipios.dir/countingoutputstreambuf.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/countingoutputstreambuf.cpp.o.d"
+  "/root/repo/src/crc32.cpp" "src/CMakeFiles/zipios.dir/crc32.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/crc32.cpp.o.d"
+  "/root/repo/src/deflatebackend.cpp" "src/CMakeFiles/zipios.dir/deflatebackend.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/deflatebackend.cpp.o.d"
+  "/root/repo/src/deflateoutputstreambuf.cpp" "src/CMakeFiles/zipios.dir/deflateoutputstreambuf.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/deflateoutputstreambuf.cpp.o.d"
+  "/root/repo/src/directorycollection.cpp" "src/CMakeFiles/zipios.dir/directorycollection.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/directorycollection.cpp.o.d"
+  "/root/repo/src/directoryentry.cpp" "src/CMakeFiles/zipios.dir/directoryentry.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/directoryentry.cpp.o.d"
+  "/root/repo/src/dosdatetime.cpp" "src/CMakeFiles/zipios.dir/dosdatetime.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/dosdatetime.cpp.o.d"
+  "/root/repo/src/dynamiclibrary.cpp" "src/CMakeFiles/zipios.dir/dynamiclibrary.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/dynamiclibrary.cpp.o.d"
+  "/root/repo/src/filecollection.cpp" "src/CMakeFiles/zipios.dir/filecollection.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/filecollection.cpp.o.d"
+  "/root/repo/src/fileentry.cpp" "src/CMakeFiles/zipios.dir/fileentry.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/fileentry.cpp.o.d"
+  "/root/repo/src/filepath.cpp" "src/CMakeFiles/zipios.dir/filepath.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/filepath.cpp.o.d"
+  "/root/repo/src/filterinputstreambuf.cpp" "src/CMakeFiles/zipios.dir/filterinputstreambuf.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/filterinputstreambuf.cpp.o.d"
+  "/root/repo/src/filteroutputstreambuf.cpp" "src/CMakeFiles/zipios.dir/filteroutputstreambuf.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/filteroutputstreambuf.cpp.o.d"
+  "/root/repo/src/gzipoutputstream.cpp" "src/CMakeFiles/zipios.dir/gzipoutputstream.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/gzipoutputstream.cpp.o.d"
+  "/root/repo/src/gzipoutputstreambuf.cpp" "src/CMakeFiles/zipios.dir/gzipoutputstreambuf.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/gzipoutputstreambuf.cpp.o.d"
+  "/root/repo/src/inflateindex.cpp" "src/CMakeFiles/zipios.dir/inflateindex.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/inflateindex.cpp.o.d"
+  "/root/repo/src/inflateinputstreambuf.cpp" "src/CMakeFiles/zipios.dir/inflateinputstreambuf.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/inflateinputstreambuf.cpp.o.d"
+  "/root/repo/src/iopolicy.cpp" "src/CMakeFiles/zipios.dir/iopolicy.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/iopolicy.cpp.o.d"
+  "/root/repo/src/memorystreambuf.cpp" "src/CMakeFiles/zipios.dir/memorystreambuf.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/memorystreambuf.cpp.o.d"
+  "/root/repo/src/nameindex.cpp" "src/CMakeFiles/zipios.dir/nameindex.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/nameindex.cpp.o.d"
+  "/root/repo/src/paralleldeflate.cpp" "src/CMakeFiles/zipios.dir/paralleldeflate.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/paralleldeflate.cpp.o.d"
+  "/root/repo/src/pushbackstreambuf.cpp" "src/CMakeFiles/zipios.dir/pushbackstreambuf.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/pushbackstreambuf.cpp.o.d"
+  "/root/repo/src/randomaccessfile.cpp" "src/CMakeFiles/zipios.dir/randomaccessfile.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/randomaccessfile.cpp.o.d"
+  "/root/repo/src/randomaccessstreambuf.cpp" "src/CMakeFiles/zipios.dir/randomaccessstreambuf.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/randomaccessstreambuf.cpp.o.d"
+  "/root/repo/src/streamentry.cpp" "src/CMakeFiles/zipios.dir/streamentry.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/streamentry.cpp.o.d"
+  "/root/repo/src/virtualseeker.cpp" "src/CMakeFiles/zipios.dir/virtualseeker.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/virtualseeker.cpp.o.d"
+  "/root/repo/src/zipcatalog.cpp" "src/CMakeFiles/zipios.dir/zipcatalog.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/zipcatalog.cpp.o.d"
+  "/root/repo/src/zipcentraldirectoryentry.cpp" "src/CMakeFiles/zipios.dir/zipcentraldirectoryentry.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/zipcentraldirectoryentry.cpp.o.d"
+  "/root/repo/src/zipendofcentraldirectory.cpp" "src/CMakeFiles/zipios.dir/zipendofcentraldirectory.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/zipendofcentraldirectory.cpp.o.d"
+  "/root/repo/src/zipfile.cpp" "src/CMakeFiles/zipios.dir/zipfile.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/zipfile.cpp.o.d"
+  "/root/repo/src/zipinputstream.cpp" "src/CMakeFiles/zipios.dir/zipinputstream.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/zipinputstream.cpp.o.d"
+  "/root/repo/src/zipinputstreambuf.cpp" "src/CMakeFiles/zipios.dir/zipinputstreambuf.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/zipinputstreambuf.cpp.o.d"
+  "/root/repo/src/zipios_common.cpp" "src/CMakeFiles/zipios.dir/zipios_common.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/zipios_common.cpp.o.d"
+  "/root/repo/src/ziplocalentry.cpp" "src/CMakeFiles/zipios.dir/ziplocalentry.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/ziplocalentry.cpp.o.d"
+  "/root/repo/src/zipoutputstream.cpp" "src/CMakeFiles/zipios.dir/zipoutputstream.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/zipoutputstream.cpp.o.d"
+  "/root/repo/src/zipoutputstreambuf.cpp" "src/CMakeFiles/zipios.dir/zipoutputstreambuf.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/zipoutputstreambuf.cpp.o.d"
+  "/root/repo/src/zipstreamreader.cpp" "src/CMakeFiles/zipios.dir/zipstreamreader.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/zipstreamreader.cpp.o.d"
+  "/root/repo/src/zstdcodec.cpp" "src/CMakeFiles/zipios.dir/zstdcodec.cpp.o" "gcc" "src/CMakeFiles/zipios.dir/zstdcodec.cpp.o.d"
+  )
+
+# Pairs of files generated by the same build rule.
+set(CMAKE_MULTIPLE_OUTPUT_PAIRS
+  "/root/repo/_debug_build/src/libzipios.so" "/root/repo/_debug_build/src/libzipios.so.2.3"
+  "/root/repo/_debug_build/src/libzipios.so.2" "/root/repo/_debug_build/src/libzipios.so.2.3"
+  )
+
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
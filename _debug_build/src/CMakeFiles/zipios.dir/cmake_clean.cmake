@@ -0,0 +1,97 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/zipios.dir/backbuffer.cpp.o"
+  "CMakeFiles/zipios.dir/backbuffer.cpp.o.d"
+  "CMakeFiles/zipios.dir/codec.cpp.o"
+  "CMakeFiles/zipios.dir/codec.cpp.o.d"
+  "CMakeFiles/zipios.dir/codecpool.cpp.o"
+  "CMakeFiles/zipios.dir/codecpool.cpp.o.d"
+  "CMakeFiles/zipios.dir/collectioncollection.cpp.o"
+  "CMakeFiles/zipios.dir/collectioncollection.cpp.o.d"
+  "CMakeFiles/zipios.dir/compressionpolicy.cpp.o"
+  "CMakeFiles/zipios.dir/compressionpolicy.cpp.o.d"
+  "CMakeFiles/zipios.dir/countingoutputstreambuf.cpp.o"
+  "CMakeFiles/zipios.dir/countingoutputstreambuf.cpp.o.d"
+  "CMakeFiles/zipios.dir/crc32.cpp.o"
+  "CMakeFiles/zipios.dir/crc32.cpp.o.d"
+  "CMakeFiles/zipios.dir/deflatebackend.cpp.o"
+  "CMakeFiles/zipios.dir/deflatebackend.cpp.o.d"
+  "CMakeFiles/zipios.dir/deflateoutputstreambuf.cpp.o"
+  "CMakeFiles/zipios.dir/deflateoutputstreambuf.cpp.o.d"
+  "CMakeFiles/zipios.dir/directorycollection.cpp.o"
+  "CMakeFiles/zipios.dir/directorycollection.cpp.o.d"
+  "CMakeFiles/zipios.dir/directoryentry.cpp.o"
+  "CMakeFiles/zipios.dir/directoryentry.cpp.o.d"
+  "CMakeFiles/zipios.dir/dosdatetime.cpp.o"
+  "CMakeFiles/zipios.dir/dosdatetime.cpp.o.d"
+  "CMakeFiles/zipios.dir/dynamiclibrary.cpp.o"
+  "CMakeFiles/zipios.dir/dynamiclibrary.cpp.o.d"
+  "CMakeFiles/zipios.dir/filecollection.cpp.o"
+  "CMakeFiles/zipios.dir/filecollection.cpp.o.d"
+  "CMakeFiles/zipios.dir/fileentry.cpp.o"
+  "CMakeFiles/zipios.dir/fileentry.cpp.o.d"
+  "CMakeFiles/zipios.dir/filepath.cpp.o"
+  "CMakeFiles/zipios.dir/filepath.cpp.o.d"
+  "CMakeFiles/zipios.dir/filterinputstreambuf.cpp.o"
+  "CMakeFiles/zipios.dir/filterinputstreambuf.cpp.o.d"
+  "CMakeFiles/zipios.dir/filteroutputstreambuf.cpp.o"
+  "CMakeFiles/zipios.dir/filteroutputstreambuf.cpp.o.d"
+  "CMakeFiles/zipios.dir/gzipoutputstream.cpp.o"
+  "CMakeFiles/zipios.dir/gzipoutputstream.cpp.o.d"
+  "CMakeFiles/zipios.dir/gzipoutputstreambuf.cpp.o"
+  "CMakeFiles/zipios.dir/gzipoutputstreambuf.cpp.o.d"
+  "CMakeFiles/zipios.dir/inflateindex.cpp.o"
+  "CMakeFiles/zipios.dir/inflateindex.cpp.o.d"
+  "CMakeFiles/zipios.dir/inflateinputstreambuf.cpp.o"
+  "CMakeFiles/zipios.dir/inflateinputstreambuf.cpp.o.d"
+  "CMakeFiles/zipios.dir/iopolicy.cpp.o"
+  "CMakeFiles/zipios.dir/iopolicy.cpp.o.d"
+  "CMakeFiles/zipios.dir/memorystreambuf.cpp.o"
+  "CMakeFiles/zipios.dir/memorystreambuf.cpp.o.d"
+  "CMakeFiles/zipios.dir/nameindex.cpp.o"
+  "CMakeFiles/zipios.dir/nameindex.cpp.o.d"
+  "CMakeFiles/zipios.dir/paralleldeflate.cpp.o"
+  "CMakeFiles/zipios.dir/paralleldeflate.cpp.o.d"
+  "CMakeFiles/zipios.dir/pushbackstreambuf.cpp.o"
+  "CMakeFiles/zipios.dir/pushbackstreambuf.cpp.o.d"
+  "CMakeFiles/zipios.dir/randomaccessfile.cpp.o"
+  "CMakeFiles/zipios.dir/randomaccessfile.cpp.o.d"
+  "CMakeFiles/zipios.dir/randomaccessstreambuf.cpp.o"
+  "CMakeFiles/zipios.dir/randomaccessstreambuf.cpp.o.d"
+  "CMakeFiles/zipios.dir/streamentry.cpp.o"
+  "CMakeFiles/zipios.dir/streamentry.cpp.o.d"
+  "CMakeFiles/zipios.dir/virtualseeker.cpp.o"
+  "CMakeFiles/zipios.dir/virtualseeker.cpp.o.d"
+  "CMakeFiles/zipios.dir/zipcatalog.cpp.o"
+  "CMakeFiles/zipios.dir/zipcatalog.cpp.o.d"
+  "CMakeFiles/zipios.dir/zipcentraldirectoryentry.cpp.o"
+  "CMakeFiles/zipios.dir/zipcentraldirectoryentry.cpp.o.d"
+  "CMakeFiles/zipios.dir/zipendofcentraldirectory.cpp.o"
+  "CMakeFiles/zipios.dir/zipendofcentraldirectory.cpp.o.d"
+  "CMakeFiles/zipios.dir/zipfile.cpp.o"
+  "CMakeFiles/zipios.dir/zipfile.cpp.o.d"
+  "CMakeFiles/zipios.dir/zipinputstream.cpp.o"
+  "CMakeFiles/zipios.dir/zipinputstream.cpp.o.d"
+  "CMakeFiles/zipios.dir/zipinputstreambuf.cpp.o"
+  "CMakeFiles/zipios.dir/zipinputstreambuf.cpp.o.d"
+  "CMakeFiles/zipios.dir/zipios_common.cpp.o"
+  "CMakeFiles/zipios.dir/zipios_common.cpp.o.d"
+  "CMakeFiles/zipios.dir/ziplocalentry.cpp.o"
+  "CMakeFiles/zipios.dir/ziplocalentry.cpp.o.d"
+  "CMakeFiles/zipios.dir/zipoutputstream.cpp.o"
+  "CMakeFiles/zipios.dir/zipoutputstream.cpp.o.d"
+  "CMakeFiles/zipios.dir/zipoutputstreambuf.cpp.o"
+  "CMakeFiles/zipios.dir/zipoutputstreambuf.cpp.o.d"
+  "CMakeFiles/zipios.dir/zipstreamreader.cpp.o"
+  "CMakeFiles/zipios.dir/zipstreamreader.cpp.o.d"
+  "CMakeFiles/zipios.dir/zstdcodec.cpp.o"
+  "CMakeFiles/zipios.dir/zstdcodec.cpp.o.d"
+  "libzipios.pdb"
+  "libzipios.so"
+  "libzipios.so.2"
+  "libzipios.so.2.3"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/zipios.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,40 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/catch_backbuffer.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_backbuffer.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_backbuffer.cpp.o.d"
+  "/root/repo/tests/catch_codec.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_codec.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_codec.cpp.o.d"
+  "/root/repo/tests/catch_codecpool.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_codecpool.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_codecpool.cpp.o.d"
+  "/root/repo/tests/catch_collectioncollection.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_collectioncollection.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_collectioncollection.cpp.o.d"
+  "/root/repo/tests/catch_common.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_common.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_common.cpp.o.d"
+  "/root/repo/tests/catch_compressionpolicy.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_compressionpolicy.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_compressionpolicy.cpp.o.d"
+  "/root/repo/tests/catch_crc32.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_crc32.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_crc32.cpp.o.d"
+  "/root/repo/tests/catch_directory_helper.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_directory_helper.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_directory_helper.cpp.o.d"
+  "/root/repo/tests/catch_directorycollection.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_directorycollection.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_directorycollection.cpp.o.d"
+  "/root/repo/tests/catch_directoryentry.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_directoryentry.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_directoryentry.cpp.o.d"
+  "/root/repo/tests/catch_dosdatetime.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_dosdatetime.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_dosdatetime.cpp.o.d"
+  "/root/repo/tests/catch_filepath.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_filepath.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_filepath.cpp.o.d"
+  "/root/repo/tests/catch_iopolicy.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_iopolicy.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_iopolicy.cpp.o.d"
+  "/root/repo/tests/catch_main.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_main.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_main.cpp.o.d"
+  "/root/repo/tests/catch_paralleldeflate.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_paralleldeflate.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_paralleldeflate.cpp.o.d"
+  "/root/repo/tests/catch_raii_helpers.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_raii_helpers.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_raii_helpers.cpp.o.d"
+  "/root/repo/tests/catch_stream.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_stream.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_stream.cpp.o.d"
+  "/root/repo/tests/catch_version.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_version.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_version.cpp.o.d"
+  "/root/repo/tests/catch_virtualseeker.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_virtualseeker.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_virtualseeker.cpp.o.d"
+  "/root/repo/tests/catch_zipfile.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_zipfile.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_zipfile.cpp.o.d"
+  "/root/repo/tests/catch_zipstreamreader.cpp" "tests/CMakeFiles/zipios_tests.dir/catch_zipstreamreader.cpp.o" "gcc" "tests/CMakeFiles/zipios_tests.dir/catch_zipstreamreader.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_debug_build/src/CMakeFiles/zipios.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
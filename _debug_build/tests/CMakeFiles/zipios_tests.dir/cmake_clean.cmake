@@ -0,0 +1,51 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/zipios_tests.dir/catch_backbuffer.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_backbuffer.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_codec.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_codec.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_codecpool.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_codecpool.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_collectioncollection.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_collectioncollection.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_common.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_common.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_compressionpolicy.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_compressionpolicy.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_crc32.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_crc32.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_directory_helper.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_directory_helper.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_directorycollection.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_directorycollection.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_directoryentry.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_directoryentry.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_dosdatetime.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_dosdatetime.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_filepath.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_filepath.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_iopolicy.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_iopolicy.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_main.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_main.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_paralleldeflate.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_paralleldeflate.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_raii_helpers.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_raii_helpers.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_stream.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_stream.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_version.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_version.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_virtualseeker.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_virtualseeker.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_zipfile.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_zipfile.cpp.o.d"
+  "CMakeFiles/zipios_tests.dir/catch_zipstreamreader.cpp.o"
+  "CMakeFiles/zipios_tests.dir/catch_zipstreamreader.cpp.o.d"
+  "zipios_tests"
+  "zipios_tests.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/zipios_tests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
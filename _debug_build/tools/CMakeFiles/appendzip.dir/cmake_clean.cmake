@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/appendzip.dir/appendzip.cpp.o"
+  "CMakeFiles/appendzip.dir/appendzip.cpp.o.d"
+  "appendzip"
+  "appendzip.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/appendzip.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
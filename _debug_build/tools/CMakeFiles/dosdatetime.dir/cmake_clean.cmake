@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/dosdatetime.dir/dosdatetime.cpp.o"
+  "CMakeFiles/dosdatetime.dir/dosdatetime.cpp.o.d"
+  "dosdatetime"
+  "dosdatetime.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/dosdatetime.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
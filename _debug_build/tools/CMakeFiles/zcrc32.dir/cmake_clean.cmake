@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/zcrc32.dir/zcrc32.cpp.o"
+  "CMakeFiles/zcrc32.dir/zcrc32.cpp.o.d"
+  "zcrc32"
+  "zcrc32.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/zcrc32.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/zipdir.dir/zipdir.cpp.o"
+  "CMakeFiles/zipdir.dir/zipdir.cpp.o.d"
+  "zipdir"
+  "zipdir.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/zipdir.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
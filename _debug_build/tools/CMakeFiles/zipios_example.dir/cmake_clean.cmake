@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/zipios_example.dir/zipios_example.cpp.o"
+  "CMakeFiles/zipios_example.dir/zipios_example.cpp.o.d"
+  "zipios_example"
+  "zipios_example.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/zipios_example.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
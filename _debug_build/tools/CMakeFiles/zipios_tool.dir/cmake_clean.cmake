@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/zipios_tool.dir/zipios.cpp.o"
+  "CMakeFiles/zipios_tool.dir/zipios.cpp.o.d"
+  "zipios"
+  "zipios.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/zipios_tool.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
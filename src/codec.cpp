@@ -0,0 +1,311 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::Codec and its registry.
+ *
+ * This file implements the registry of the compression codecs and
+ * registers the codecs which come with the library.
+ */
+
+#include "zipios/codec.hpp"
+
+#include "zipios/zipiosexceptions.hpp"
+
+#include "zstdcodec.hpp"
+
+#include <map>
+#include <mutex>
+
+
+namespace zipios
+{
+
+
+namespace
+{
+
+
+/** \brief The registered codecs.
+ *
+ * The registry is created the first time a codec is searched or
+ * registered. At that time, the codecs which come with the library
+ * get registered if they are available on this system.
+ */
+struct registry_t
+{
+    typedef std::map<StorageMethod, Codec::pointer_t>  codecs_t;
+
+                registry_t();
+
+    std::mutex  m_mutex = std::mutex();
+    codecs_t    m_codecs = codecs_t();
+};
+
+
+/** \brief Register the codecs of the library.
+ *
+ * The Zstandard codec is registered only if the zstd library can be
+ * loaded.
+ */
+registry_t::registry_t()
+{
+    Codec::pointer_t zstd(createZstdCodec());
+    if(zstd != nullptr)
+    {
+        m_codecs[zstd->getMethod()] = zstd;
+    }
+}
+
+
+/** \brief Retrieve the registry.
+ *
+ * \return A reference to the registry of codecs.
+ */
+registry_t & getRegistry()
+{
+    static registry_t registry;
+    return registry;
+}
+
+
+} // no name namespace
+
+
+/** \class Compressor
+ * \brief Compress the data of one entry.
+ *
+ * A Compressor gets created by a Codec for each entry to be compressed.
+ * The data is passed to the compress() function in chunks and the
+ * compressed data is appended to the output buffer.
+ */
+
+
+/** \brief Clean up the compressor.
+ *
+ * The destructor releases the resources of the compressor.
+ */
+Compressor::~Compressor()
+{
+}
+
+
+/** \fn void Compressor::compress(char const * data, size_t size, bool finish, std::vector<char> & output);
+ * \brief Compress a chunk of data.
+ *
+ * This function compresses the \p size bytes found at \p data and
+ * appends the compressed data available so far to \p output. The
+ * compressor may keep some of the data until more is available.
+ *
+ * When \p finish is true, \p data is the last chunk (it may be empty)
+ * and all the remaining compressed data gets appended to \p output.
+ * The compressor cannot be used anymore after that.
+ *
+ * \exception IOException
+ * This exception is raised if the compression fails.
+ *
+ * \param[in] data  The data to compress.
+ * \param[in] size  The number of bytes at \p data.
+ * \param[in] finish  Whether this is the last chunk of data.
+ * \param[in,out] output  The buffer where the compressed data gets appended.
+ */
+
+
+/** \class Decompressor
+ * \brief Decompress the data of one entry.
+ *
+ * A Decompressor gets created by a Codec for each entry to be read.
+ */
+
+
+/** \brief Clean up the decompressor.
+ *
+ * The destructor releases the resources of the decompressor.
+ */
+Decompressor::~Decompressor()
+{
+}
+
+
+/** \fn bool Decompressor::decompress(char const * & input, size_t & input_size, char * & output, size_t & output_size);
+ * \brief Decompress data.
+ *
+ * This function decompresses data from \p input to \p output. Both
+ * pointers are moved forward and both sizes decreased by the number
+ * of bytes consumed and produced. The function returns once the input
+ * is exhausted, the output is full, or the end of the compressed data
+ * is reached.
+ *
+ * \exception IOException
+ * This exception is raised if the compressed data is invalid.
+ *
+ * \param[in,out] input  The compressed data.
+ * \param[in,out] input_size  The number of bytes available at \p input.
+ * \param[in,out] output  The buffer receiving the uncompressed data.
+ * \param[in,out] output_size  The number of bytes available at \p output.
+ *
+ * \return true once the end of the compressed data was reached.
+ */
+
+
+/** \class Codec
+ * \brief A compression method.
+ *
+ * The STORED and DEFLATED methods are implemented by the stream buffers
+ * of the library. The other Zip compression methods are implemented
+ * by codecs: the ZipInputStreambuf and the ZipOutputStreambuf search
+ * the registry for the codec of the method of the entry they read or
+ * write and use its Compressor or Decompressor.
+ *
+ * The library registers a codec for StorageMethod::ZSTD when the
+ * Zstandard library (libzstd) is available on the system. Other codecs
+ * can be added with registerCodec().
+ *
+ * The codecs have to be thread safe: several compressors and
+ * decompressors may be used at the same time by different threads.
+ */
+
+
+/** \brief Clean up the codec.
+ *
+ * The destructor releases the resources of the codec.
+ */
+Codec::~Codec()
+{
+}
+
+
+/** \fn StorageMethod Codec::getMethod() const;
+ * \brief The method implemented by this codec.
+ *
+ * \return The compression method as saved in the Zip archive.
+ */
+
+
+/** \fn std::string Codec::getName() const;
+ * \brief The name of this codec.
+ *
+ * \return A human readable name such as "zstd".
+ */
+
+
+/** \fn uint16_t Codec::getExtractVersion() const;
+ * \brief The version needed to extract entries using this codec.
+ *
+ * This value is saved in the headers of the entries written with this
+ * codec (i.e. 63 for zstd, which is version 6.3 of the specification).
+ *
+ * \return The version needed to extract.
+ */
+
+
+/** \fn Compressor::pointer_t Codec::createCompressor(FileEntry::CompressionLevel level) const;
+ * \brief Create a compressor.
+ *
+ * \param[in] level  The compression level of the entry, the codec maps
+ *                   it to its own levels.
+ *
+ * \return A new compressor.
+ */
+
+
+/** \fn Decompressor::pointer_t Codec::createDecompressor() const;
+ * \brief Create a decompressor.
+ *
+ * \return A new decompressor.
+ */
+
+
+/** \brief Add a codec to the registry.
+ *
+ * This function registers \p codec for its method. A codec already
+ * registered for that method gets replaced.
+ *
+ * \exception InvalidException
+ * This exception is raised if \p codec is nullptr or its method is
+ * STORED or DEFLATED, which are implemented by the library itself.
+ *
+ * \param[in] codec  The codec to register.
+ */
+void Codec::registerCodec(pointer_t codec)
+{
+    if(codec == nullptr)
+    {
+        throw InvalidException("Codec::registerCodec(): the codec cannot be nullptr.");
+    }
+    StorageMethod const method(codec->getMethod());
+    if(method == StorageMethod::STORED
+    || method == StorageMethod::DEFLATED)
+    {
+        throw InvalidException("Codec::registerCodec(): the STORED and DEFLATED methods cannot be replaced.");
+    }
+
+    registry_t & registry(getRegistry());
+    std::lock_guard<std::mutex> lock(registry.m_mutex);
+    registry.m_codecs[method] = codec;
+}
+
+
+/** \brief Remove a codec from the registry.
+ *
+ * This function removes the codec registered for \p method, if any.
+ * Entries using that method cannot be read or written anymore.
+ *
+ * \param[in] method  The method of the codec to remove.
+ */
+void Codec::unregisterCodec(StorageMethod method)
+{
+    registry_t & registry(getRegistry());
+    std::lock_guard<std::mutex> lock(registry.m_mutex);
+    registry.m_codecs.erase(method);
+}
+
+
+/** \brief Search the codec of a method.
+ *
+ * This function returns the codec registered for \p method.
+ *
+ * \param[in] method  The compression method.
+ *
+ * \return The codec or nullptr if no codec supports \p method.
+ */
+Codec::pointer_t Codec::getCodec(StorageMethod method)
+{
+    registry_t & registry(getRegistry());
+    std::lock_guard<std::mutex> lock(registry.m_mutex);
+    auto const it(registry.m_codecs.find(method));
+    if(it == registry.m_codecs.end())
+    {
+        return pointer_t();
+    }
+    return it->second;
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
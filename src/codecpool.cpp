@@ -0,0 +1,520 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::CodecPool.
+ *
+ * This file implements the pool of zlib streams and buffers shared
+ * by all the streams of the library.
+ */
+
+#include "codecpool.hpp"
+
+#include "zipios/zipiosexceptions.hpp"
+
+#include "zipios_common.hpp"
+
+#include <mutex>
+
+
+namespace zipios
+{
+
+
+namespace
+{
+
+
+/** \brief Whether the pool was destroyed.
+ *
+ * Streams destroyed after the pool, at the time the process exits,
+ * release their zlib streams and buffers directly.
+ */
+bool g_pool_destroyed = false;
+
+
+/** \brief The objects kept in the pool.
+ *
+ * The pool holds initialized zlib streams, which are ready to be used
+ * since they get reset when released, and buffers of various sizes.
+ */
+struct pool_t
+{
+    typedef std::vector<z_stream *>         streams_t;
+    typedef std::vector<std::vector<char>>  buffers_t;
+
+                ~pool_t();
+
+    void        clear();
+
+    std::mutex  m_mutex = std::mutex();
+    streams_t   m_inflate_streams = streams_t();
+    streams_t   m_deflate_streams = streams_t();
+    buffers_t   m_buffers = buffers_t();
+    size_t      m_buffer_bytes = 0;
+};
+
+
+/** \brief Release all the objects of the pool.
+ *
+ * The destructor frees the objects and marks the pool as destroyed.
+ */
+pool_t::~pool_t()
+{
+    clear();
+    g_pool_destroyed = true;
+}
+
+
+/** \brief Free all the objects of the pool.
+ *
+ * This function ends and frees the zlib streams and frees the buffers.
+ */
+void pool_t::clear()
+{
+    streams_t inflate_streams;
+    streams_t deflate_streams;
+    buffers_t buffers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        inflate_streams.swap(m_inflate_streams);
+        deflate_streams.swap(m_deflate_streams);
+        buffers.swap(m_buffers);
+        m_buffer_bytes = 0;
+    }
+
+    for(auto zs : inflate_streams)
+    {
+        inflateEnd(zs);
+        delete zs;
+    }
+    for(auto zs : deflate_streams)
+    {
+        deflateEnd(zs);
+        delete zs;
+    }
+}
+
+
+/** \brief Retrieve the pool.
+ *
+ * The pool is created the first time it is needed.
+ *
+ * \return A reference to the pool.
+ */
+pool_t & getPool()
+{
+    static pool_t pool;
+    return pool;
+}
+
+
+/** \brief Remove one stream from a list of streams.
+ *
+ * \param[in,out] streams  The list of available streams.
+ *
+ * \return A stream or nullptr if none is available.
+ */
+z_stream * popStream(pool_t::streams_t & streams)
+{
+    if(streams.empty())
+    {
+        return nullptr;
+    }
+    z_stream * zs(streams.back());
+    streams.pop_back();
+    return zs;
+}
+
+
+/** \brief Add a stream to a list of streams.
+ *
+ * \param[in,out] streams  The list of available streams.
+ * \param[in] zs  The stream to add, which must be reset.
+ *
+ * \return true if the stream was added, false if the pool is full.
+ */
+bool pushStream(pool_t::streams_t & streams, z_stream * zs)
+{
+    if(streams.size() >= CodecPool::MAX_STREAMS)
+    {
+        return false;
+    }
+    streams.push_back(zs);
+    return true;
+}
+
+
+} // no name namespace
+
+
+/** \class CodecPool
+ * \brief A pool of zlib streams and buffers.
+ *
+ * Initializing a zlib stream allocates its state and window (about
+ * 44Kb to inflate and 256Kb to deflate) and the streams of the library
+ * also allocate their buffers. With archives of many small entries,
+ * this setup costs more than the data itself.
+ *
+ * The CodecPool keeps the zlib streams and buffers of the streams which
+ * were destroyed. A new stream borrows them from the pool and gives
+ * them back when it gets destroyed. The zlib streams get reset with
+ * inflateReset() or deflateReset() instead of being initialized again.
+ *
+ * The pool is global and thread safe. It keeps at most MAX_STREAMS
+ * streams of each kind and buffers up to a total of MAX_BUFFER_BYTES.
+ *
+ * All the zlib streams use raw deflate data (no zlib header) with the
+ * largest window, as used by the Zip archives.
+ */
+
+
+/** \typedef CodecPool::stream_pointer_t
+ * \brief A zlib stream borrowed from the pool.
+ *
+ * When the pointer gets destroyed, the stream is returned to the pool.
+ */
+
+
+/** \struct CodecPool::stream_deleter_t
+ * \brief The deleter of the stream_pointer_t.
+ *
+ * The deleter returns the stream to the pool. The m_deflate flag tells
+ * whether the stream is a deflate or an inflate stream.
+ */
+
+
+/** \brief Return a stream to the pool.
+ *
+ * \param[in] zs  The stream to return to the pool.
+ */
+void CodecPool::stream_deleter_t::operator () (z_stream * zs) const
+{
+    if(m_deflate)
+    {
+        releaseDeflateStream(zs);
+    }
+    else
+    {
+        releaseInflateStream(zs);
+    }
+}
+
+
+/** \var CodecPool::MAX_STREAMS
+ * \brief The maximum number of zlib streams of each kind in the pool.
+ */
+
+
+/** \var CodecPool::MAX_BUFFER_BYTES
+ * \brief The maximum number of bytes of buffers kept in the pool.
+ */
+
+
+/** \brief Borrow an inflate stream.
+ *
+ * This function returns an initialized inflate stream ready to inflate
+ * raw deflate data.
+ *
+ * \exception IOException
+ * This exception is raised if zlib cannot initialize a new stream.
+ *
+ * \return The inflate stream.
+ */
+CodecPool::stream_pointer_t CodecPool::getInflateStream()
+{
+    z_stream * zs(nullptr);
+    if(!g_pool_destroyed)
+    {
+        pool_t & pool(getPool());
+        std::lock_guard<std::mutex> lock(pool.m_mutex);
+        zs = popStream(pool.m_inflate_streams);
+    }
+
+    if(zs == nullptr)
+    {
+        zs = new z_stream();
+
+        // windowBits is passed < 0 to tell that there is no zlib header
+        //
+        int const err(inflateInit2(zs, -MAX_WBITS));
+        if(err != Z_OK)
+        {
+            delete zs; // LCOV_EXCL_LINE
+            OutputStringStream msgs; // LCOV_EXCL_LINE
+            msgs << "CodecPool::getInflateStream(): inflateInit2() failed: " << zError(err); // LCOV_EXCL_LINE
+            throw IOException(msgs.str()); // LCOV_EXCL_LINE
+        }
+    }
+
+    return stream_pointer_t(zs, stream_deleter_t{ false });
+}
+
+
+/** \brief Borrow a deflate stream.
+ *
+ * This function returns an initialized deflate stream ready to output
+ * raw deflate data using the compression \p level.
+ *
+ * \exception IOException
+ * This exception is raised if zlib cannot initialize a new stream.
+ *
+ * \param[in] level  The zlib compression level.
+ *
+ * \return The deflate stream.
+ */
+CodecPool::stream_pointer_t CodecPool::getDeflateStream(int level)
+{
+    z_stream * zs(nullptr);
+    if(!g_pool_destroyed)
+    {
+        pool_t & pool(getPool());
+        std::lock_guard<std::mutex> lock(pool.m_mutex);
+        zs = popStream(pool.m_deflate_streams);
+    }
+
+    int err(Z_OK);
+    if(zs == nullptr)
+    {
+        int const default_mem_level(8);
+
+        zs = new z_stream();
+        err = deflateInit2(zs, level, Z_DEFLATED, -MAX_WBITS, default_mem_level, Z_DEFAULT_STRATEGY);
+        if(err != Z_OK)
+        {
+            delete zs; // LCOV_EXCL_LINE
+            zs = nullptr; // LCOV_EXCL_LINE
+        }
+    }
+    else
+    {
+        // the stream was reset so this only changes the level
+        //
+        err = deflateParams(zs, level, Z_DEFAULT_STRATEGY);
+    }
+
+    stream_pointer_t result(zs, stream_deleter_t{ true });
+    if(err != Z_OK)
+    {
+        OutputStringStream msgs; // LCOV_EXCL_LINE
+        msgs << "CodecPool::getDeflateStream(): error while initializing zlib, " << zError(err); // LCOV_EXCL_LINE
+        throw IOException(msgs.str()); // LCOV_EXCL_LINE
+    }
+
+    return result;
+}
+
+
+/** \brief Borrow a buffer.
+ *
+ * This function replaces \p buffer with a buffer of \p size bytes
+ * taken from the pool, or a new buffer if none of that size is
+ * available. The content of the buffer is undefined.
+ *
+ * \param[out] buffer  The vector receiving the buffer.
+ * \param[in] size  The size of the buffer.
+ */
+void CodecPool::getBuffer(std::vector<char> & buffer, size_t size)
+{
+    if(!g_pool_destroyed)
+    {
+        pool_t & pool(getPool());
+        std::lock_guard<std::mutex> lock(pool.m_mutex);
+        for(auto & b : pool.m_buffers)
+        {
+            if(b.size() == size)
+            {
+                buffer.swap(b);
+                b.swap(pool.m_buffers.back());
+                pool.m_buffers.pop_back();
+                pool.m_buffer_bytes -= size;
+                return;
+            }
+        }
+    }
+
+    buffer.resize(size);
+}
+
+
+/** \brief Return a buffer to the pool.
+ *
+ * This function moves the content of \p buffer to the pool, unless the
+ * pool is full. Either way \p buffer is empty on return.
+ *
+ * \param[in,out] buffer  The buffer to release.
+ */
+void CodecPool::releaseBuffer(std::vector<char> & buffer)
+{
+    std::vector<char> released;
+    released.swap(buffer);
+    if(released.empty()
+    || g_pool_destroyed)
+    {
+        return;
+    }
+
+    pool_t & pool(getPool());
+    std::lock_guard<std::mutex> lock(pool.m_mutex);
+    if(pool.m_buffers.size() < MAX_STREAMS * 2
+    && pool.m_buffer_bytes + released.size() <= MAX_BUFFER_BYTES)
+    {
+        pool.m_buffer_bytes += released.size();
+        pool.m_buffers.push_back(std::move(released));
+    }
+}
+
+
+/** \brief Retrieve the number of inflate streams in the pool.
+ *
+ * \return The number of inflate streams ready to be borrowed.
+ */
+size_t CodecPool::availableInflateStreams()
+{
+    if(g_pool_destroyed)
+    {
+        return 0; // LCOV_EXCL_LINE
+    }
+
+    pool_t & pool(getPool());
+    std::lock_guard<std::mutex> lock(pool.m_mutex);
+    return pool.m_inflate_streams.size();
+}
+
+
+/** \brief Retrieve the number of deflate streams in the pool.
+ *
+ * \return The number of deflate streams ready to be borrowed.
+ */
+size_t CodecPool::availableDeflateStreams()
+{
+    if(g_pool_destroyed)
+    {
+        return 0; // LCOV_EXCL_LINE
+    }
+
+    pool_t & pool(getPool());
+    std::lock_guard<std::mutex> lock(pool.m_mutex);
+    return pool.m_deflate_streams.size();
+}
+
+
+/** \brief Retrieve the number of buffers in the pool.
+ *
+ * \return The number of buffers ready to be borrowed.
+ */
+size_t CodecPool::availableBuffers()
+{
+    if(g_pool_destroyed)
+    {
+        return 0; // LCOV_EXCL_LINE
+    }
+
+    pool_t & pool(getPool());
+    std::lock_guard<std::mutex> lock(pool.m_mutex);
+    return pool.m_buffers.size();
+}
+
+
+/** \brief Free all the objects of the pool.
+ *
+ * This function releases the memory used by the pool. The streams and
+ * buffers currently borrowed are not affected and return to the pool
+ * once released.
+ */
+void CodecPool::clear()
+{
+    if(!g_pool_destroyed)
+    {
+        getPool().clear();
+    }
+}
+
+
+/** \brief Return an inflate stream to the pool.
+ *
+ * The stream gets reset and saved in the pool, or freed if the pool
+ * is full.
+ *
+ * \param[in] zs  The stream to release.
+ */
+void CodecPool::releaseInflateStream(z_stream * zs)
+{
+    if(zs == nullptr)
+    {
+        return; // LCOV_EXCL_LINE
+    }
+
+    if(!g_pool_destroyed
+    && inflateReset(zs) == Z_OK)
+    {
+        pool_t & pool(getPool());
+        std::lock_guard<std::mutex> lock(pool.m_mutex);
+        if(pushStream(pool.m_inflate_streams, zs))
+        {
+            return;
+        }
+    }
+
+    inflateEnd(zs);
+    delete zs;
+}
+
+
+/** \brief Return a deflate stream to the pool.
+ *
+ * The stream gets reset and saved in the pool, or freed if the pool
+ * is full.
+ *
+ * \param[in] zs  The stream to release.
+ */
+void CodecPool::releaseDeflateStream(z_stream * zs)
+{
+    if(zs == nullptr)
+    {
+        return; // LCOV_EXCL_LINE
+    }
+
+    if(!g_pool_destroyed
+    && deflateReset(zs) == Z_OK)
+    {
+        pool_t & pool(getPool());
+        std::lock_guard<std::mutex> lock(pool.m_mutex);
+        if(pushStream(pool.m_deflate_streams, zs))
+        {
+            return;
+        }
+    }
+
+    deflateEnd(zs);
+    delete zs;
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
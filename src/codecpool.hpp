@@ -0,0 +1,86 @@
+#pragma once
+#ifndef ZIPIOS_CODECPOOL_HPP
+#define ZIPIOS_CODECPOOL_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Header file that defines zipios::CodecPool.
+ *
+ * The zipios::CodecPool keeps the zlib streams and the buffers of the
+ * closed streams so new streams can reuse them.
+ */
+
+#include "zlibbackend.hpp"
+
+#include "zipios/zipios-config.hpp"
+
+#include <memory>
+#include <vector>
+
+
+namespace zipios
+{
+
+
+class CodecPool
+{
+public:
+    struct stream_deleter_t
+    {
+        void                    operator () (z_stream * zs) const;
+
+        bool                    m_deflate = false;
+    };
+
+    typedef std::unique_ptr<z_stream, stream_deleter_t>
+                                stream_pointer_t;
+
+    // the pool does not keep more than these many objects
+    static constexpr size_t     MAX_STREAMS = 64;
+    static constexpr size_t     MAX_BUFFER_BYTES = 16 * 1024 * 1024;
+
+    static stream_pointer_t     getInflateStream();
+    static stream_pointer_t     getDeflateStream(int level);
+    static void                 getBuffer(std::vector<char> & buffer, size_t size);
+    static void                 releaseBuffer(std::vector<char> & buffer);
+    static size_t               availableInflateStreams();
+    static size_t               availableDeflateStreams();
+    static size_t               availableBuffers();
+    static void                 clear();
+
+private:
+    static void                 releaseInflateStream(z_stream * zs);
+    static void                 releaseDeflateStream(z_stream * zs);
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
@@ -56,8 +56,8 @@ namespace
  * \param[in] matchpath  How the name of the entry is compared with \p name.
  */
 void matchEntry(
-      CollectionCollection::vector_t collections
-    , std::string const & name
+      CollectionCollection::vector_t const & collections
+    , std::string_view name
     , FileEntry::pointer_t & cep
     , FileCollection::pointer_t & file_collection
     , CollectionCollection::MatchPath matchpath)
@@ -343,7 +343,7 @@ FileEntry::vector_t CollectionCollection::entries() const
  *
  * \sa mustBeValid()
  */
-FileEntry::pointer_t CollectionCollection::getEntry(std::string const & name, MatchPath matchpath) const
+FileEntry::pointer_t CollectionCollection::getEntry(std::string_view name, MatchPath matchpath) const
 {
     mustBeValid();
 
@@ -0,0 +1,529 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::CompressionPolicy.
+ *
+ * This file implements the rules used to choose how each entry gets
+ * saved in an archive.
+ */
+
+#include "zipios/compressionpolicy.hpp"
+
+#include <cmath>
+#include <cstring>
+
+
+namespace zipios
+{
+
+
+namespace
+{
+
+
+/** \brief The signature of a file format.
+ *
+ * The signature is \p m_size bytes found at \p m_offset from the start
+ * of the file.
+ */
+struct signature_t
+{
+    size_t          m_offset;
+    char const *    m_bytes;
+    size_t          m_size;
+};
+
+
+/** \brief The signatures of the formats which are already compressed.
+ *
+ * Compressing these files again with deflate costs a lot of CPU time
+ * and saves close to nothing.
+ */
+signature_t const g_compressed_formats[] =
+{
+    { 0, "\xFF\xD8\xFF",                        3 },    // JPEG
+    { 0, "\x89PNG\r\n\x1A\n",                   8 },    // PNG
+    { 0, "GIF87a",                              6 },    // GIF
+    { 0, "GIF89a",                              6 },    // GIF
+    { 8, "WEBP",                                4 },    // WebP (RIFF)
+    { 4, "ftyp",                                4 },    // MP4, MOV, HEIC
+    { 0, "ID3",                                 3 },    // MP3
+    { 0, "OggS",                                4 },    // Ogg
+    { 0, "fLaC",                                4 },    // FLAC
+    { 0, "\x1A\x45\xDF\xA3",                    4 },    // Matroska, WebM
+    { 0, "\x1F\x8B",                            2 },    // gzip
+    { 0, "PK\x03\x04",                          4 },    // Zip, JAR, OpenDocument
+    { 0, "BZh",                                 3 },    // bzip2
+    { 0, "\xFD" "7zXZ\x00",                     6 },    // xz
+    { 0, "\x28\xB5\x2F\xFD",                    4 },    // Zstandard
+    { 0, "\x04\x22\x4D\x18",                    4 },    // LZ4
+    { 0, "7z\xBC\xAF\x27\x1C",                  6 },    // 7-Zip
+    { 0, "Rar!\x1A\x07",                        6 },    // RAR
+    { 0, "wOFF",                                4 },    // WOFF
+    { 0, "wOF2",                                4 },    // WOFF2
+};
+
+
+/** \brief Convert an ASCII letter to lowercase.
+ *
+ * The patterns are matched without regard to case so "*.jpg" also
+ * matches "PHOTO.JPG".
+ *
+ * \param[in] c  The character to convert.
+ *
+ * \return The lowercase version of \p c.
+ */
+char lower(char c)
+{
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+
+} // no name namespace
+
+
+
+/** \class CompressionPolicy
+ * \brief Choose how each entry gets saved.
+ *
+ * FileCollection::setMethod() and FileCollection::setLevel() choose
+ * the storage method of an entry from its size only. This means files
+ * which are already compressed, such as JPEG images or gzip files, get
+ * deflated again at full CPU cost for almost no gain.
+ *
+ * The CompressionPolicy looks at each entry when it gets saved by
+ * ZipFile::saveCollectionToArchive() (see ZipFile::SaveOptions). The
+ * first of the following tests which applies decides:
+ *
+ * \li the name of the entry matches a rule added with addRule(), the
+ *     entry uses the method and level of that rule;
+ * \li the entry is not larger than the store limit, it gets STORED;
+ * \li the first bytes of the entry match the signature of a compressed
+ *     format (see isCompressedFormat()), it gets STORED;
+ * \li the entropy of the first bytes is at least the entropy threshold,
+ *     it gets STORED;
+ * \li otherwise the entry uses the method and level defined with
+ *     setCompression(), DEFLATED by default.
+ *
+ * Finally, when the store fallback is on, an entry which did not get
+ * smaller once compressed is saved again as STORED. This is only done
+ * for entries up to the buffer limit (see
+ * ZipFile::SaveOptions::setBufferLimit()) since the compressed data
+ * has to be kept in memory.
+ */
+
+
+/** \brief Add a rule for entries with a matching name.
+ *
+ * This function adds a rule forcing the entries with a name matching
+ * \p pattern to be saved with \p method and \p level. The rules are
+ * checked in the order they were added and the first match wins.
+ *
+ * See matchPattern() for the syntax of the pattern.
+ *
+ * When \p method is StorageMethod::STORED, the level is ignored.
+ *
+ * \param[in] pattern  The glob pattern matched against the entry names.
+ * \param[in] method  The storage method of the matching entries.
+ * \param[in] level  The compression level of the matching entries.
+ */
+void CompressionPolicy::addRule(std::string const & pattern, StorageMethod method, FileEntry::CompressionLevel level)
+{
+    rule_t rule;
+    rule.m_pattern = pattern;
+    rule.m_method = method;
+    rule.m_level = method == StorageMethod::STORED ? FileEntry::COMPRESSION_LEVEL_NONE : level;
+    m_rules.push_back(rule);
+}
+
+
+/** \brief Remove all the rules.
+ *
+ * This function removes all the rules added with addRule().
+ */
+void CompressionPolicy::clearRules()
+{
+    m_rules.clear();
+}
+
+
+/** \brief Retrieve the method used to compress the entries.
+ *
+ * This function returns the method used by the entries which are not
+ * found to be already compressed. By default it is DEFLATED.
+ *
+ * \return The method used to compress the entries.
+ */
+StorageMethod CompressionPolicy::getMethod() const
+{
+    return m_method;
+}
+
+
+/** \brief Retrieve the level used to compress the entries.
+ *
+ * This function returns the compression level used by the entries
+ * which are not found to be already compressed.
+ *
+ * \return The level used to compress the entries.
+ */
+FileEntry::CompressionLevel CompressionPolicy::getLevel() const
+{
+    return m_level;
+}
+
+
+/** \brief Change the method and level used to compress the entries.
+ *
+ * This function sets the method and level used by the entries which
+ * do not match a rule and are not found to be already compressed.
+ *
+ * \param[in] method  The storage method.
+ * \param[in] level  The compression level.
+ */
+void CompressionPolicy::setCompression(StorageMethod method, FileEntry::CompressionLevel level)
+{
+    m_method = method;
+    m_level = method == StorageMethod::STORED ? FileEntry::COMPRESSION_LEVEL_NONE : level;
+}
+
+
+/** \brief Retrieve the size of the largest entry always stored.
+ *
+ * This function returns the size under which entries get STORED
+ * whatever their content. By default it is 0 so only empty entries
+ * are stored.
+ *
+ * \return The store limit in bytes.
+ */
+size_t CompressionPolicy::getStoreLimit() const
+{
+    return m_store_limit;
+}
+
+
+/** \brief Change the size of the largest entry always stored.
+ *
+ * Very small files do not compress well. Entries of \p limit bytes or
+ * less are STORED unless they match a rule. This is the limit of the
+ * FileCollection::setMethod() function.
+ *
+ * \param[in] limit  The store limit in bytes.
+ */
+void CompressionPolicy::setStoreLimit(size_t limit)
+{
+    m_store_limit = limit;
+}
+
+
+/** \brief Retrieve the size of the sample.
+ *
+ * This function returns the number of bytes read from the start of
+ * each entry to detect compressed data. By default it is 4Kb.
+ *
+ * \return The size of the sample in bytes.
+ */
+size_t CompressionPolicy::getSampleSize() const
+{
+    return m_sample_size;
+}
+
+
+/** \brief Change the size of the sample.
+ *
+ * This function sets the number of bytes read from the start of each
+ * entry to detect the compressed formats and compute the entropy. Use
+ * 0 to turn off both tests.
+ *
+ * \param[in] size  The size of the sample in bytes.
+ */
+void CompressionPolicy::setSampleSize(size_t size)
+{
+    m_sample_size = size;
+}
+
+
+/** \brief Retrieve the entropy threshold.
+ *
+ * This function returns the entropy, in bits per byte, from which an
+ * entry gets STORED. By default it is 7.5.
+ *
+ * \return The entropy threshold.
+ */
+double CompressionPolicy::getEntropyThreshold() const
+{
+    return m_entropy_threshold;
+}
+
+
+/** \brief Change the entropy threshold.
+ *
+ * Data which is already compressed or encrypted looks random: its
+ * entropy is close to 8 bits per byte. Text is generally around 4 to
+ * 5 bits per byte. Entries with a sample entropy of at least
+ * \p threshold get STORED. Use a value larger than 8 to turn off
+ * this test.
+ *
+ * \param[in] threshold  The entropy threshold in bits per byte.
+ */
+void CompressionPolicy::setEntropyThreshold(double threshold)
+{
+    m_entropy_threshold = threshold;
+}
+
+
+/** \brief Check whether the compressed formats get detected.
+ *
+ * \return true if the signatures of compressed formats are checked.
+ */
+bool CompressionPolicy::getDetectFormats() const
+{
+    return m_detect_formats;
+}
+
+
+/** \brief Change whether the compressed formats get detected.
+ *
+ * When true (the default), entries starting with the signature of a
+ * compressed format get STORED.
+ *
+ * \param[in] detect  Whether to check the signatures.
+ */
+void CompressionPolicy::setDetectFormats(bool detect)
+{
+    m_detect_formats = detect;
+}
+
+
+/** \brief Check whether entries which do not compress get stored.
+ *
+ * \return true if the store fallback is on.
+ */
+bool CompressionPolicy::getStoreFallback() const
+{
+    return m_store_fallback;
+}
+
+
+/** \brief Change whether entries which do not compress get stored.
+ *
+ * When true (the default), an entry which compressed size is at least
+ * its uncompressed size is saved again as STORED.
+ *
+ * \param[in] fallback  Whether to store entries which do not compress.
+ */
+void CompressionPolicy::setStoreFallback(bool fallback)
+{
+    m_store_fallback = fallback;
+}
+
+
+/** \brief Choose the method and level of an entry.
+ *
+ * This function sets the method and level of \p entry following the
+ * rules described in the CompressionPolicy class. The \p sample is
+ * the first bytes of the data of the entry, up to getSampleSize()
+ * bytes.
+ *
+ * Directories are left alone.
+ *
+ * \param[in,out] entry  The entry to update.
+ * \param[in] sample  The first bytes of the entry.
+ * \param[in] size  The number of bytes in \p sample.
+ */
+void CompressionPolicy::apply(FileEntry & entry, char const * sample, size_t size) const
+{
+    if(entry.isDirectory())
+    {
+        return;
+    }
+
+    std::string const name(entry.getName());
+    for(auto const & r : m_rules)
+    {
+        if(matchPattern(r.m_pattern, name))
+        {
+            entry.setMethod(r.m_method);
+            entry.setLevel(r.m_level);
+            return;
+        }
+    }
+
+    if(entry.getSize() <= m_store_limit
+    || (m_detect_formats && isCompressedFormat(sample, size))
+    || (size > 0 && entropy(sample, size) >= m_entropy_threshold))
+    {
+        entry.setMethod(StorageMethod::STORED);
+        entry.setLevel(FileEntry::COMPRESSION_LEVEL_NONE);
+        return;
+    }
+
+    entry.setMethod(m_method);
+    entry.setLevel(m_level);
+}
+
+
+/** \brief Compute the entropy of a buffer.
+ *
+ * This function computes the Shannon entropy of the bytes in \p data,
+ * in bits per byte: from 0 (one repeated byte) to 8 (all the byte
+ * values equally represented). Note that a buffer of N bytes cannot
+ * have an entropy larger than log2(N).
+ *
+ * \param[in] data  The data to check.
+ * \param[in] size  The number of bytes in \p data.
+ *
+ * \return The entropy in bits per byte.
+ */
+double CompressionPolicy::entropy(char const * data, size_t size)
+{
+    if(size == 0)
+    {
+        return 0.0;
+    }
+
+    size_t counts[256] = {};
+    for(size_t idx(0); idx < size; ++idx)
+    {
+        ++counts[static_cast<unsigned char>(data[idx])];
+    }
+
+    double result(0.0);
+    for(auto const c : counts)
+    {
+        if(c != 0)
+        {
+            double const p(static_cast<double>(c) / static_cast<double>(size));
+            result -= p * std::log2(p);
+        }
+    }
+
+    return result;
+}
+
+
+/** \brief Check whether a buffer starts with a compressed format.
+ *
+ * This function checks \p data against the signatures of common
+ * compressed formats: images (JPEG, PNG, GIF, WebP), audio and video
+ * (MP3, MP4, Ogg, FLAC, Matroska), archives (gzip, Zip, bzip2, xz,
+ * Zstandard, LZ4, 7-Zip, RAR), and fonts (WOFF).
+ *
+ * \param[in] data  The first bytes of a file.
+ * \param[in] size  The number of bytes in \p data.
+ *
+ * \return true if \p data starts with the signature of a compressed format.
+ */
+bool CompressionPolicy::isCompressedFormat(char const * data, size_t size)
+{
+    for(auto const & s : g_compressed_formats)
+    {
+        if(s.m_offset + s.m_size <= size
+        && memcmp(data + s.m_offset, s.m_bytes, s.m_size) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/** \brief Check whether a name matches a glob pattern.
+ *
+ * The pattern supports '*' to match any number of characters and '?'
+ * to match exactly one character. The match is case insensitive for
+ * ASCII letters.
+ *
+ * A pattern without a '/' is matched against the basename so "*.jpg"
+ * matches "images/photo.jpg". Otherwise it is matched against the full
+ * name and '*' also matches '/' so "images/" followed by '*' matches
+ * all the entries under the "images" directory.
+ *
+ * \param[in] pattern  The glob pattern.
+ * \param[in] name  The name of the entry.
+ *
+ * \return true if \p name matches \p pattern.
+ */
+bool CompressionPolicy::matchPattern(std::string const & pattern, std::string const & name)
+{
+    std::string::size_type start(0);
+    if(pattern.find('/') == std::string::npos)
+    {
+        std::string::size_type const slash(name.rfind('/'));
+        if(slash != std::string::npos)
+        {
+            start = slash + 1;
+        }
+    }
+
+    // iterative match with backtracking to the last '*'
+    //
+    std::string::size_type p(0);
+    std::string::size_type n(start);
+    std::string::size_type star(std::string::npos);
+    std::string::size_type star_n(0);
+    while(n < name.length())
+    {
+        if(p < pattern.length()
+        && (pattern[p] == '?' || lower(pattern[p]) == lower(name[n])))
+        {
+            ++p;
+            ++n;
+        }
+        else if(p < pattern.length()
+             && pattern[p] == '*')
+        {
+            star = p;
+            ++p;
+            star_n = n;
+        }
+        else if(star != std::string::npos)
+        {
+            p = star + 1;
+            ++star_n;
+            n = star_n;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    while(p < pattern.length()
+       && pattern[p] == '*')
+    {
+        ++p;
+    }
+
+    return p == pattern.length();
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
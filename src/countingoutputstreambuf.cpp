@@ -0,0 +1,189 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::CountingOutputStreambuf.
+ *
+ * This file implements an output streambuf filter which counts the
+ * bytes written through it.
+ */
+
+#include "countingoutputstreambuf.hpp"
+
+
+namespace zipios
+{
+
+
+/** \class CountingOutputStreambuf
+ * \brief An output streambuf filter which knows its position.
+ *
+ * This streambuf passes everything written to it to another streambuf
+ * and counts the bytes. Its tellp() position is that count, even when
+ * the other streambuf cannot seek, such as a pipe or a socket.
+ *
+ * Only the current position can be queried; the streambuf cannot seek.
+ *
+ * The streambuf has no buffer of its own, each write goes straight
+ * to the other streambuf.
+ */
+
+
+/** \brief Initialize the streambuf.
+ *
+ * This constructor attaches the filter to \p outbuf. The count starts
+ * at \p position, which is expected to be the current position in
+ * \p outbuf when it is known.
+ *
+ * \param[in] outbuf  The streambuf receiving the data.
+ * \param[in] position  The position of the first byte written.
+ */
+CountingOutputStreambuf::CountingOutputStreambuf(std::streambuf * outbuf, offset_t position)
+    : FilterOutputStreambuf(outbuf)
+    , m_position(position)
+{
+}
+
+
+/** \brief Clean up the streambuf.
+ *
+ * The streambuf does not own the output streambuf so there is nothing
+ * to do here.
+ */
+CountingOutputStreambuf::~CountingOutputStreambuf()
+{
+}
+
+
+/** \brief Retrieve the streambuf receiving the data.
+ *
+ * \return The streambuf this filter writes to.
+ */
+std::streambuf * CountingOutputStreambuf::getOutputStreambuf() const
+{
+    return m_outbuf;
+}
+
+
+/** \brief Retrieve the current position.
+ *
+ * This function returns the position defined on construction plus the
+ * number of bytes written so far.
+ *
+ * \return The current position.
+ */
+offset_t CountingOutputStreambuf::getPosition() const
+{
+    return m_position;
+}
+
+
+/** \brief Write one character.
+ *
+ * Since the streambuf has no buffer, this function gets called for
+ * each character written with sputc().
+ *
+ * \param[in] c  The character to write.
+ *
+ * \return \p c or EOF if the write failed.
+ */
+CountingOutputStreambuf::int_type CountingOutputStreambuf::overflow(int_type c)
+{
+    if(traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        return traits_type::not_eof(c);
+    }
+
+    if(traits_type::eq_int_type(m_outbuf->sputc(traits_type::to_char_type(c)), traits_type::eof()))
+    {
+        return traits_type::eof();
+    }
+    ++m_position;
+
+    return c;
+}
+
+
+/** \brief Write a block of characters.
+ *
+ * This function writes the \p n characters at \p s to the output
+ * streambuf and counts them.
+ *
+ * \param[in] s  The characters to write.
+ * \param[in] n  The number of characters to write.
+ *
+ * \return The number of characters written.
+ */
+std::streamsize CountingOutputStreambuf::xsputn(char_type const * s, std::streamsize n)
+{
+    std::streamsize const written(m_outbuf->sputn(s, n));
+    if(written > 0)
+    {
+        m_position += written;
+    }
+    return written;
+}
+
+
+/** \brief Synchronize the output streambuf.
+ *
+ * \return 0 on success, -1 on failure.
+ */
+int CountingOutputStreambuf::sync()
+{
+    return m_outbuf->pubsync();
+}
+
+
+/** \brief Retrieve the current position.
+ *
+ * The only supported seek is a seek of 0 bytes from the current
+ * position, which is what tellp() does. It returns getPosition().
+ *
+ * \param[in] off  The offset, it must be 0.
+ * \param[in] dir  The direction, it must be std::ios_base::cur.
+ * \param[in] which  The position to query, it must include
+ *                   std::ios_base::out.
+ *
+ * \return The current position or -1 if the seek is not supported.
+ */
+CountingOutputStreambuf::pos_type CountingOutputStreambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if(off != 0
+    || dir != std::ios_base::cur
+    || (which & std::ios_base::out) == 0)
+    {
+        return pos_type(off_type(-1));
+    }
+
+    return pos_type(m_position);
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,471 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of the CRC-32 functions.
+ *
+ * The CRC-32 of Zip archives uses the reflected polynomial 0xEDB88320.
+ * This file offers a portable slice-by-16 implementation and, on x86-64
+ * CPUs supporting the PCLMULQDQ instruction, a carry-less multiplication
+ * folding implementation. The implementation gets selected once, at
+ * runtime, the first time a CRC-32 is computed.
+ */
+
+#include "crc32.hpp"
+
+#include <array>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ZIPIOS_CRC32_PCLMUL
+#include <immintrin.h>
+#endif
+
+
+namespace zipios
+{
+
+
+namespace
+{
+
+
+/** \brief The reflected CRC-32 polynomial.
+ *
+ * This is the polynomial used by Zip archives (and gzip, PNG, etc.)
+ * in its reflected form.
+ */
+uint32_t const          g_polynomial = 0xEDB88320;
+
+
+/** \brief The slice-by-16 tables.
+ *
+ * The first table is the usual byte-at-a-time table. Table \em k gives
+ * the CRC-32 of a byte followed by \em k zero bytes so 16 bytes can be
+ * processed with 16 independent lookups.
+ */
+typedef std::array<std::array<uint32_t, 256>, 16>   crc32_tables_t;
+
+
+/** \brief Compute the slice-by-16 tables.
+ *
+ * This function computes the slice-by-16 tables at compile time.
+ *
+ * \return The slice-by-16 tables.
+ */
+constexpr crc32_tables_t generateTables()
+{
+    crc32_tables_t tables = {};
+    for(uint32_t i(0); i < 256; ++i)
+    {
+        uint32_t crc(i);
+        for(int bit(0); bit < 8; ++bit)
+        {
+            crc = (crc & 1) != 0 ? (crc >> 1) ^ g_polynomial : crc >> 1;
+        }
+        tables[0][i] = crc;
+    }
+    for(size_t k(1); k < tables.size(); ++k)
+    {
+        for(size_t i(0); i < 256; ++i)
+        {
+            tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+
+
+constexpr crc32_tables_t const  g_tables = generateTables();
+
+
+/** \brief Compute a CRC-32 with the slice-by-16 algorithm.
+ *
+ * This function updates the inverted \p crc with the \p size bytes
+ * found in \p buffer. The bytes are read one by one so the function
+ * works on any endianness and alignment.
+ *
+ * \param[in] crc  The current inverted CRC-32.
+ * \param[in] buffer  The data to add to the CRC-32.
+ * \param[in] size  The number of bytes in \p buffer.
+ *
+ * \return The updated inverted CRC-32.
+ */
+uint32_t sliceBy16(uint32_t crc, unsigned char const * buffer, size_t size)
+{
+    while(size >= 16)
+    {
+        crc ^= static_cast<uint32_t>(buffer[0])
+            | (static_cast<uint32_t>(buffer[1]) << 8)
+            | (static_cast<uint32_t>(buffer[2]) << 16)
+            | (static_cast<uint32_t>(buffer[3]) << 24);
+        crc = g_tables[15][crc & 0xFF]
+            ^ g_tables[14][(crc >> 8) & 0xFF]
+            ^ g_tables[13][(crc >> 16) & 0xFF]
+            ^ g_tables[12][crc >> 24]
+            ^ g_tables[11][buffer[4]]
+            ^ g_tables[10][buffer[5]]
+            ^ g_tables[ 9][buffer[6]]
+            ^ g_tables[ 8][buffer[7]]
+            ^ g_tables[ 7][buffer[8]]
+            ^ g_tables[ 6][buffer[9]]
+            ^ g_tables[ 5][buffer[10]]
+            ^ g_tables[ 4][buffer[11]]
+            ^ g_tables[ 3][buffer[12]]
+            ^ g_tables[ 2][buffer[13]]
+            ^ g_tables[ 1][buffer[14]]
+            ^ g_tables[ 0][buffer[15]];
+        buffer += 16;
+        size -= 16;
+    }
+
+    while(size > 0)
+    {
+        crc = (crc >> 8) ^ g_tables[0][(crc ^ *buffer) & 0xFF];
+        ++buffer;
+        --size;
+    }
+
+    return crc;
+}
+
+
+#ifdef ZIPIOS_CRC32_PCLMUL
+/** \brief Compute a CRC-32 with the PCLMULQDQ instruction.
+ *
+ * This function folds the data 64 bytes at a time using carry-less
+ * multiplications and then reduces the result to 32 bits with a
+ * Barrett reduction as described in Intel's "Fast CRC Computation for
+ * Generic Polynomials Using PCLMULQDQ Instruction" paper.
+ *
+ * The function handles blocks of 16 bytes. The remaining bytes, if
+ * any, are handled by the sliceBy16() function.
+ *
+ * \param[in] crc  The current inverted CRC-32.
+ * \param[in] buffer  The data to add to the CRC-32.
+ * \param[in] size  The number of bytes in \p buffer, at least 64.
+ *
+ * \return The updated inverted CRC-32.
+ */
+__attribute__((target("pclmul,sse4.1")))
+uint32_t pclmul(uint32_t crc, unsigned char const * buffer, size_t size)
+{
+    // the x^(4*128+32), x^(4*128-32), x^(128+32), x^(128-32), x^64
+    // constants reflected and the Barrett constants
+    //
+    alignas(16) static uint64_t const k1k2[2] = { 0x0154442bd4, 0x01c6e41596 };
+    alignas(16) static uint64_t const k3k4[2] = { 0x01751997d0, 0x00ccaa009e };
+    alignas(16) static uint64_t const k5k0[2] = { 0x0163cd6124, 0x0000000000 };
+    alignas(16) static uint64_t const poly[2] = { 0x01db710641, 0x01f7011641 };
+
+    size_t const tail(size & 15);
+    size -= tail;
+
+    __m128i x1(_mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x00)));
+    __m128i x2(_mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x10)));
+    __m128i x3(_mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x20)));
+    __m128i x4(_mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x30)));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+    buffer += 64;
+    size -= 64;
+
+    // fold 4 x 128 bits in parallel
+    //
+    __m128i x0(_mm_load_si128(reinterpret_cast<__m128i const *>(k1k2)));
+    while(size >= 64)
+    {
+        __m128i const x5(_mm_clmulepi64_si128(x1, x0, 0x00));
+        __m128i const x6(_mm_clmulepi64_si128(x2, x0, 0x00));
+        __m128i const x7(_mm_clmulepi64_si128(x3, x0, 0x00));
+        __m128i const x8(_mm_clmulepi64_si128(x4, x0, 0x00));
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer + 0x30)));
+
+        buffer += 64;
+        size -= 64;
+    }
+
+    // fold the 4 x 128 bits into 128 bits
+    //
+    x0 = _mm_load_si128(reinterpret_cast<__m128i const *>(k3k4));
+    for(__m128i const x : { x2, x3, x4 })
+    {
+        __m128i const x5(_mm_clmulepi64_si128(x1, x0, 0x00));
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x), x5);
+    }
+
+    // fold the remaining blocks of 128 bits
+    //
+    while(size >= 16)
+    {
+        __m128i const x5(_mm_clmulepi64_si128(x1, x0, 0x00));
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<__m128i const *>(buffer))), x5);
+        buffer += 16;
+        size -= 16;
+    }
+
+    // fold 128 bits to 64 bits
+    //
+    __m128i const mask(_mm_setr_epi32(~0, 0, ~0, 0));
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    x0 = _mm_loadl_epi64(reinterpret_cast<__m128i const *>(k5k0));
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    // Barrett reduction to 32 bits
+    //
+    x0 = _mm_load_si128(reinterpret_cast<__m128i const *>(poly));
+    x2 = _mm_and_si128(x1, mask);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, mask);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    crc = static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+
+    return sliceBy16(crc, buffer, tail);
+}
+#endif
+
+
+/** \brief The type of the CRC-32 implementations.
+ *
+ * All the implementations work on the inverted CRC-32.
+ */
+typedef uint32_t (*crc32_function_t)(uint32_t crc, unsigned char const * buffer, size_t size);
+
+
+/** \brief The CRC-32 implementation selected for this CPU.
+ *
+ * This structure holds the fastest implementation available on the
+ * running CPU and its name.
+ */
+struct implementation_t
+{
+    crc32_function_t    m_function = &sliceBy16;
+    size_t              m_minimum_size = 0;
+    char const *        m_name = "slice-by-16";
+};
+
+
+/** \brief Select the CRC-32 implementation.
+ *
+ * This function checks the features of the CPU and selects the fastest
+ * CRC-32 implementation. The selection happens only once.
+ *
+ * \return The selected implementation.
+ */
+implementation_t const & getImplementation()
+{
+    static implementation_t const g_implementation([]()
+        {
+            implementation_t implementation;
+#ifdef ZIPIOS_CRC32_PCLMUL
+            __builtin_cpu_init();
+            if(__builtin_cpu_supports("pclmul")
+            && __builtin_cpu_supports("sse4.1"))
+            {
+                // the folding needs at least 64 bytes and is not worth
+                // setting up for short buffers
+                //
+                implementation.m_function = &pclmul;
+                implementation.m_minimum_size = 256;
+                implementation.m_name = "pclmul";
+            }
+#endif
+            return implementation;
+        }());
+
+    return g_implementation;
+}
+
+
+/** \brief Multiply two polynomials modulo the CRC-32 polynomial.
+ *
+ * This function multiplies \p a by \p b modulo the CRC-32 polynomial.
+ * Both are reflected polynomials where the most significant bit
+ * represents x^0.
+ *
+ * \param[in] a  The first polynomial.
+ * \param[in] b  The second polynomial.
+ *
+ * \return a * b modulo the CRC-32 polynomial.
+ */
+uint32_t multiplyModulo(uint32_t a, uint32_t b)
+{
+    uint32_t m(1U << 31);
+    uint32_t p(0);
+    for(;;)
+    {
+        if((a & m) != 0)
+        {
+            p ^= b;
+            if((a & (m - 1)) == 0)
+            {
+                break;
+            }
+        }
+        m >>= 1;
+        b = (b & 1) != 0 ? (b >> 1) ^ g_polynomial : b >> 1;
+    }
+    return p;
+}
+
+
+/** \brief Compute x^(2^n) modulo the CRC-32 polynomial.
+ *
+ * The table holds x^(2^n) modulo the CRC-32 polynomial for n from 0
+ * to 31. It is used to compute x^(8 * size) in log(size) steps.
+ */
+std::array<uint32_t, 32> const g_x2n_table([]()
+    {
+        std::array<uint32_t, 32> table = {};
+        uint32_t p(1U << 30);           // x^1
+        table[0] = p;
+        for(size_t n(1); n < table.size(); ++n)
+        {
+            p = multiplyModulo(p, p);
+            table[n] = p;
+        }
+        return table;
+    }());
+
+
+} // no name namespace
+
+
+/** \brief Update a CRC-32.
+ *
+ * This function adds the \p size bytes found in \p buffer to \p crc
+ * and returns the new CRC-32. Start with a \p crc of 0. It returns
+ * the same value as the zlib crc32() function.
+ *
+ * The function uses the fastest implementation available on the CPU
+ * (see getCRC32Implementation()).
+ *
+ * \param[in] crc  The CRC-32 of the previous data or 0.
+ * \param[in] buffer  The data to add to the CRC-32.
+ * \param[in] size  The number of bytes in \p buffer.
+ *
+ * \return The updated CRC-32.
+ */
+uint32_t updateCRC32(uint32_t crc, void const * buffer, size_t size)
+{
+    if(buffer == nullptr)
+    {
+        return crc;
+    }
+
+    implementation_t const & implementation(getImplementation());
+    crc32_function_t const f(size >= implementation.m_minimum_size ? implementation.m_function : &sliceBy16);
+    return ~f(~crc, reinterpret_cast<unsigned char const *>(buffer), size);
+}
+
+
+/** \brief Update a CRC-32 with the portable implementation.
+ *
+ * This function is the same as updateCRC32() except that it always
+ * uses the slice-by-16 implementation. It is mainly used to verify
+ * the CPU specific implementations.
+ *
+ * \param[in] crc  The CRC-32 of the previous data or 0.
+ * \param[in] buffer  The data to add to the CRC-32.
+ * \param[in] size  The number of bytes in \p buffer.
+ *
+ * \return The updated CRC-32.
+ */
+uint32_t updateCRC32Portable(uint32_t crc, void const * buffer, size_t size)
+{
+    if(buffer == nullptr)
+    {
+        return crc;
+    }
+
+    return ~sliceBy16(~crc, reinterpret_cast<unsigned char const *>(buffer), size);
+}
+
+
+/** \brief Combine two CRC-32.
+ *
+ * This function returns the CRC-32 of two consecutive blocks of data
+ * from the CRC-32 of each block and the size of the second block. This
+ * is what allows several threads to compute the CRC-32 of a large file.
+ * It returns the same value as the zlib crc32_combine() function.
+ *
+ * \param[in] crc1  The CRC-32 of the first block.
+ * \param[in] crc2  The CRC-32 of the second block.
+ * \param[in] size2  The size of the second block in bytes.
+ *
+ * \return The CRC-32 of both blocks.
+ */
+uint32_t combineCRC32(uint32_t crc1, uint32_t crc2, offset_t size2)
+{
+    // compute x^(8 * size2) modulo the polynomial
+    //
+    uint32_t p(1U << 31);               // x^0
+    uint64_t n(size2 < 0 ? 0 : static_cast<uint64_t>(size2));
+    for(size_t k(3); n != 0; n >>= 1, ++k)
+    {
+        if((n & 1) != 0)
+        {
+            p = multiplyModulo(g_x2n_table[k & 31], p);
+        }
+    }
+
+    return multiplyModulo(p, crc1) ^ crc2;
+}
+
+
+/** \brief Retrieve the name of the CRC-32 implementation.
+ *
+ * This function returns the name of the implementation used by
+ * updateCRC32() for large buffers: "pclmul" or "slice-by-16".
+ *
+ * \return The name of the CRC-32 implementation.
+ */
+char const * getCRC32Implementation()
+{
+    return getImplementation().m_name;
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
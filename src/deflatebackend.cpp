@@ -0,0 +1,431 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of the deflate backends.
+ *
+ * libdeflate only offers whole buffer functions: it cannot be used to
+ * compress a stream. It is loaded at runtime so the library does not
+ * depend on it. When it is not available, or the library was compiled
+ * with the ZIPIOS_LIBDEFLATE CMake option turned off, the zlib API is
+ * used for everything.
+ */
+
+#include "deflatebackend.hpp"
+
+#include "zipios/zipiosexceptions.hpp"
+
+#include "dynamiclibrary.hpp"
+#include "zlibbackend.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+
+
+namespace zipios
+{
+
+
+namespace
+{
+
+
+/** \brief The parts of the libdeflate API used by the library.
+ *
+ * These declarations match libdeflate.h (version 1.0 and newer).
+ */
+struct libdeflate_compressor;
+struct libdeflate_decompressor;
+
+int const   LIBDEFLATE_SUCCESS = 0;
+
+
+/** \brief The highest level of libdeflate.
+ *
+ * The zlib levels 1 to 9 are used as is, the smallest level goes
+ * up to the highest level of libdeflate.
+ */
+int const   g_libdeflate_smallest_level = 12;
+
+
+/** \brief The libdeflate functions.
+ *
+ * The library is loaded once, the first time it is needed. It is never
+ * unloaded.
+ */
+struct libdeflate_library_t
+{
+                libdeflate_library_t();
+
+    bool        isValid() const;
+
+    libdeflate_compressor *     (*m_alloc_compressor)(int) = nullptr;
+    size_t                      (*m_deflate_compress)(libdeflate_compressor *, void const *, size_t, void *, size_t) = nullptr;
+    size_t                      (*m_deflate_compress_bound)(libdeflate_compressor *, size_t) = nullptr;
+    void                        (*m_free_compressor)(libdeflate_compressor *) = nullptr;
+    libdeflate_decompressor *   (*m_alloc_decompressor)() = nullptr;
+    int                         (*m_deflate_decompress)(libdeflate_decompressor *, void const *, size_t, void *, size_t, size_t *) = nullptr;
+    void                        (*m_free_decompressor)(libdeflate_decompressor *) = nullptr;
+};
+
+
+/** \brief Load libdeflate.
+ *
+ * This constructor searches for libdeflate and loads the functions
+ * used by the library.
+ */
+libdeflate_library_t::libdeflate_library_t()
+{
+#ifdef ZIPIOS_LIBDEFLATE
+    DynamicLibrary const library({
+#ifdef ZIPIOS_WINDOWS
+            "libdeflate.dll",
+            "deflate.dll",
+#elif defined(__APPLE__)
+            "libdeflate.0.dylib",
+            "libdeflate.dylib",
+#else
+            "libdeflate.so.0",
+            "libdeflate.so",
+#endif
+        });
+
+    library.load("libdeflate_alloc_compressor",         m_alloc_compressor);
+    library.load("libdeflate_deflate_compress",         m_deflate_compress);
+    library.load("libdeflate_deflate_compress_bound",   m_deflate_compress_bound);
+    library.load("libdeflate_free_compressor",          m_free_compressor);
+    library.load("libdeflate_alloc_decompressor",       m_alloc_decompressor);
+    library.load("libdeflate_deflate_decompress",       m_deflate_decompress);
+    library.load("libdeflate_free_decompressor",        m_free_decompressor);
+#endif
+}
+
+
+/** \brief Check whether all the functions were found.
+ *
+ * \return true if libdeflate was loaded and has all the functions.
+ */
+bool libdeflate_library_t::isValid() const
+{
+    return m_alloc_compressor != nullptr
+        && m_deflate_compress != nullptr
+        && m_deflate_compress_bound != nullptr
+        && m_free_compressor != nullptr
+        && m_alloc_decompressor != nullptr
+        && m_deflate_decompress != nullptr
+        && m_free_decompressor != nullptr;
+}
+
+
+/** \brief Retrieve libdeflate.
+ *
+ * \return The functions of libdeflate.
+ */
+libdeflate_library_t const & getLibrary()
+{
+    static libdeflate_library_t const library;
+    return library;
+}
+
+
+/** \brief Free a libdeflate decompressor.
+ */
+struct decompressor_deleter_t
+{
+    void operator () (libdeflate_decompressor * d) const
+    {
+        getLibrary().m_free_decompressor(d);
+    }
+};
+
+
+/** \brief Free a libdeflate compressor.
+ */
+struct compressor_deleter_t
+{
+    void operator () (libdeflate_compressor * c) const
+    {
+        getLibrary().m_free_compressor(c);
+    }
+};
+
+
+/** \brief The decompressor of this thread.
+ *
+ * A libdeflate decompressor can be reused but not shared between
+ * threads so each thread keeps its own.
+ */
+thread_local std::unique_ptr<libdeflate_decompressor, decompressor_deleter_t>
+                g_decompressor;
+
+
+/** \brief The compressor of this thread.
+ *
+ * The compressor is kept with its level and gets replaced when a
+ * different level is needed.
+ */
+thread_local std::unique_ptr<libdeflate_compressor, compressor_deleter_t>
+                g_compressor;
+thread_local int
+                g_compressor_level = 0;
+
+
+class WholeBufferCompressor
+    : public Compressor
+{
+public:
+                            WholeBufferCompressor(int level);
+
+    virtual void            compress(char const * data, size_t size, bool finish, std::vector<char> & output) override;
+
+private:
+    int                     m_level = 0;
+    std::vector<char>       m_data = std::vector<char>();
+};
+
+
+/** \brief Initialize the compressor.
+ *
+ * \param[in] level  The libdeflate compression level.
+ */
+WholeBufferCompressor::WholeBufferCompressor(int level)
+    : m_level(level)
+{
+}
+
+
+/** \brief Compress the data in one call.
+ *
+ * The data gets accumulated until \p finish is true. It then gets
+ * deflated in one call to libdeflate.
+ *
+ * \exception IOException
+ * This exception is raised if the data cannot be compressed.
+ *
+ * \param[in] data  The data to compress.
+ * \param[in] size  The number of bytes at \p data.
+ * \param[in] finish  Whether this is the last chunk of data.
+ * \param[in,out] output  The buffer where the compressed data gets appended.
+ */
+void WholeBufferCompressor::compress(char const * data, size_t size, bool finish, std::vector<char> & output)
+{
+    m_data.insert(m_data.end(), data, data + size);
+    if(!finish)
+    {
+        return;
+    }
+
+    libdeflate_library_t const & libdeflate(getLibrary());
+    if(g_compressor == nullptr
+    || g_compressor_level != m_level)
+    {
+        g_compressor.reset(libdeflate.m_alloc_compressor(m_level));
+        if(g_compressor == nullptr)
+        {
+            throw IOException("WholeBufferCompressor::compress(): could not allocate a libdeflate compressor."); // LCOV_EXCL_LINE
+        }
+        g_compressor_level = m_level;
+    }
+
+    size_t const used(output.size());
+    output.resize(used + libdeflate.m_deflate_compress_bound(g_compressor.get(), m_data.size()));
+    size_t const compressed(libdeflate.m_deflate_compress(g_compressor.get(), m_data.data(), m_data.size(), output.data() + used, output.size() - used));
+    if(compressed == 0)
+    {
+        throw IOException("WholeBufferCompressor::compress(): libdeflate could not compress the data."); // LCOV_EXCL_LINE
+    }
+    output.resize(used + compressed);
+
+    m_data.clear();
+    m_data.shrink_to_fit();
+}
+
+
+} // no name namespace
+
+
+/** \brief Convert a compression level to a zlib level.
+ *
+ * This function converts the FileEntry \p compression_level to a
+ * zlib level: 1 to 9 or Z_DEFAULT_COMPRESSION.
+ *
+ * \param[in] compression_level  The level of compression. A number from 1 to
+ * 100 or a special number representing the best, minimum, maximum compression
+ * available.
+ *
+ * \return The corresponding zlib level.
+ */
+int getDeflateLevel(FileEntry::CompressionLevel compression_level)
+{
+    switch(compression_level)
+    {
+    case FileEntry::COMPRESSION_LEVEL_DEFAULT:
+        return Z_DEFAULT_COMPRESSION;
+
+    case FileEntry::COMPRESSION_LEVEL_SMALLEST:
+        return Z_BEST_COMPRESSION;
+
+    case FileEntry::COMPRESSION_LEVEL_FASTEST:
+        return Z_BEST_SPEED;
+
+    case FileEntry::COMPRESSION_LEVEL_NONE:
+        throw std::logic_error("the compression level NONE is not supported in DeflateOutputStreambuf::init()"); // LCOV_EXCL_LINE
+
+    default:
+        if(compression_level < FileEntry::COMPRESSION_LEVEL_MINIMUM
+        || compression_level > FileEntry::COMPRESSION_LEVEL_MAXIMUM)
+        {
+            // This is excluded from the coverage since if we reach this
+            // line there is an internal error that needs to be fixed.
+            throw std::logic_error("the compression level must be defined between -3 and 100, see the zipios/fileentry.hpp for a list of valid levels."); // LCOV_EXCL_LINE
+        }
+        // The zlevel is calculated linearly from the user specified value
+        // of 1 to 100
+        //
+        // The calculation goes as follow:
+        //
+        //    x = user specified value - 1    (0 to 99)
+        //    x = x * 8                       (0 to 792)
+        //    x = x + 11 / 2                  (5 to 797, i.e. +5 with integers)
+        //    x = x / 99                      (0 to 8)
+        //    x = x + 1                       (1 to 9)
+        //
+        return ((compression_level - 1) * 8 + 11 / 2) / 99 + 1;
+
+    }
+}
+
+
+/** \brief Retrieve the name of the zlib API implementation.
+ *
+ * \return "zlib-ng" when compiled against the native zlib-ng API,
+ *         "zlib" otherwise.
+ */
+char const * getZlibImplementation()
+{
+#ifdef ZIPIOS_ZLIB_NG
+    return "zlib-ng";
+#else
+    return "zlib";
+#endif
+}
+
+
+/** \brief Check whether libdeflate is available.
+ *
+ * \return true if the whole buffer functions use libdeflate.
+ */
+bool hasLibdeflate()
+{
+    return getLibrary().isValid();
+}
+
+
+/** \brief Inflate a whole buffer with libdeflate.
+ *
+ * This function inflates the raw deflate data found in \p in directly
+ * to \p out which must be exactly the size of the uncompressed data.
+ *
+ * \exception IOException
+ * This exception is raised if the data cannot be inflated or its size
+ * is not exactly \p out_size.
+ *
+ * \param[in] in  The compressed data.
+ * \param[in] in_size  The size of the compressed data.
+ * \param[out] out  The buffer receiving the uncompressed data.
+ * \param[in] out_size  The size of the uncompressed data.
+ *
+ * \return false if libdeflate is not available and the data has to be
+ *         inflated with zlib instead, true otherwise.
+ */
+bool inflateWholeBuffer(char const * in, size_t in_size, void * out, size_t out_size)
+{
+    libdeflate_library_t const & libdeflate(getLibrary());
+    if(!libdeflate.isValid())
+    {
+        return false; // LCOV_EXCL_LINE
+    }
+
+    if(g_decompressor == nullptr)
+    {
+        g_decompressor.reset(libdeflate.m_alloc_decompressor());
+        if(g_decompressor == nullptr)
+        {
+            return false; // LCOV_EXCL_LINE
+        }
+    }
+
+    // with a null actual size, libdeflate fails unless the output is
+    // exactly out_size bytes
+    //
+    char empty(0);
+    int const result(libdeflate.m_deflate_decompress(
+                                  g_decompressor.get()
+                                , in
+                                , in_size
+                                , out_size == 0 ? &empty : out
+                                , out_size
+                                , nullptr));
+    if(result != LIBDEFLATE_SUCCESS)
+    {
+        throw IOException("ZipFile::readEntry(): inflate failed: invalid compressed data or uncompressed size");
+    }
+
+    return true;
+}
+
+
+/** \brief Create a compressor deflating whole buffers.
+ *
+ * The returned compressor keeps all the data in memory and deflates
+ * it in one call to libdeflate once all of it was received. The output
+ * is a raw deflate stream, as with zlib, but the exact bytes differ.
+ *
+ * \param[in] level  The zlib level, as returned by getDeflateLevel().
+ *
+ * \return The compressor or nullptr if libdeflate is not available.
+ */
+Compressor::pointer_t createWholeBufferCompressor(int level)
+{
+    if(!hasLibdeflate())
+    {
+        return Compressor::pointer_t(); // LCOV_EXCL_LINE
+    }
+
+    int const libdeflate_level(level == Z_DEFAULT_COMPRESSION
+                                    ? 6
+                                    : level == Z_BEST_COMPRESSION
+                                        ? g_libdeflate_smallest_level
+                                        : std::clamp(level, 1, Z_BEST_COMPRESSION));
+    return std::make_unique<WholeBufferCompressor>(libdeflate_level);
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
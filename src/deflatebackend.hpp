@@ -0,0 +1,57 @@
+#pragma once
+#ifndef ZIPIOS_DEFLATEBACKEND_HPP
+#define ZIPIOS_DEFLATEBACKEND_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief The deflate implementations used by the library.
+ *
+ * Streams are compressed with the zlib API (zlib or zlib-ng, see
+ * zlibbackend.hpp). Whole buffers can be inflated and deflated in one
+ * call with libdeflate, which is faster, when it is available.
+ */
+
+#include "zipios/codec.hpp"
+
+
+namespace zipios
+{
+
+
+int                     getDeflateLevel(FileEntry::CompressionLevel compression_level);
+char const *            getZlibImplementation();
+bool                    hasLibdeflate();
+bool                    inflateWholeBuffer(char const * in, size_t in_size, void * out, size_t out_size);
+Compressor::pointer_t   createWholeBufferCompressor(int level);
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
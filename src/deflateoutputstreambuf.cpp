@@ -29,8 +29,13 @@
 
 #include "zipios/zipiosexceptions.hpp"
 
+#include "crc32.hpp"
+#include "deflatebackend.hpp"
 #include "zipios_common.hpp"
 
+#include <algorithm>
+#include <thread>
+
 
 namespace zipios
 {
@@ -52,13 +57,19 @@ namespace zipios
  * This function initializes the DeflateOutputStreambuf object to make it
  * ready for compressing data using the zlib library.
  *
+ * The \p buffer_size defines the size of the input and output buffers,
+ * which is also the size of the writes to \p outbuf (see
+ * IOPolicy::setOutputBufferSize()).
+ *
  * \param[in,out] outbuf  The streambuf to use for output.
+ * \param[in] buffer_size  The size of the buffers.
  */
-DeflateOutputStreambuf::DeflateOutputStreambuf(std::streambuf * outbuf)
+DeflateOutputStreambuf::DeflateOutputStreambuf(std::streambuf * outbuf, size_t buffer_size)
     : FilterOutputStreambuf(outbuf)
-    , m_invec(getBufferSize())
-    , m_outvec(getBufferSize())
 {
+    CodecPool::getBuffer(m_invec, std::max(buffer_size, static_cast<size_t>(1)));
+    CodecPool::getBuffer(m_outvec, std::max(buffer_size, static_cast<size_t>(1)));
+
     // NOTICE: It is important that this constructor and the methods it
     //         calls do not do anything with the output streambuf m_outbuf.
     //         The reason is that this class can be sub-classed, and the
@@ -78,6 +89,11 @@ DeflateOutputStreambuf::DeflateOutputStreambuf(std::streambuf * outbuf)
 DeflateOutputStreambuf::~DeflateOutputStreambuf()
 {
     closeStream();
+
+    // the zlib stream returns to the pool by itself
+    //
+    CodecPool::releaseBuffer(m_invec);
+    CodecPool::releaseBuffer(m_outvec);
 }
 
 
@@ -108,78 +124,48 @@ bool DeflateOutputStreambuf::init(FileEntry::CompressionLevel compression_level)
     }
     m_zs_initialized = true;
 
-    int const default_mem_level(8);
+    int const zlevel(getDeflateLevel(compression_level));
+    m_zlevel = zlevel;
+    m_parallel_deflate.reset();
 
-    int zlevel(Z_NO_COMPRESSION);
-    switch(compression_level)
+    // the deflate stream is borrowed from the pool the first time and
+    // then reused by all the following entries; the streams of the pool
+    // use a windowBits of -MAX_WBITS so no zlib header gets written
+    //
+    int err(Z_OK);
+    if(m_zs == nullptr)
     {
-    case FileEntry::COMPRESSION_LEVEL_DEFAULT:
-        zlevel = Z_DEFAULT_COMPRESSION;
-        break;
-
-    case FileEntry::COMPRESSION_LEVEL_SMALLEST:
-        zlevel = Z_BEST_COMPRESSION;
-        break;
-
-    case FileEntry::COMPRESSION_LEVEL_FASTEST:
-        zlevel = Z_BEST_SPEED;
-        break;
-
-    case FileEntry::COMPRESSION_LEVEL_NONE:
-        throw std::logic_error("the compression level NONE is not supported in DeflateOutputStreambuf::init()"); // LCOV_EXCL_LINE
-
-    default:
-        if(compression_level < FileEntry::COMPRESSION_LEVEL_MINIMUM
-        || compression_level > FileEntry::COMPRESSION_LEVEL_MAXIMUM)
-        {
-            // This is excluded from the coverage since if we reach this
-            // line there is an internal error that needs to be fixed.
-            throw std::logic_error("the compression level must be defined between -3 and 100, see the zipios/fileentry.hpp for a list of valid levels."); // LCOV_EXCL_LINE
-        }
-        // The zlevel is calculated linearly from the user specified value
-        // of 1 to 100
-        //
-        // The calculation goes as follow:
-        //
-        //    x = user specified value - 1    (0 to 99)
-        //    x = x * 8                       (0 to 792)
-        //    x = x + 11 / 2                  (5 to 797, i.e. +5 with integers)
-        //    x = x / 99                      (0 to 8)
-        //    x = x + 1                       (1 to 9)
+        m_zs = CodecPool::getDeflateStream(zlevel);
+    }
+    else
+    {
+        // the stream was reset by closeStream() so this only changes
+        // the compression level
         //
-        zlevel = ((compression_level - 1) * 8 + 11 / 2) / 99 + 1;
-        break;
-
+        err = deflateParams(m_zs.get(), zlevel, Z_DEFAULT_STRATEGY);
     }
-
-    // m_zs.next_in and avail_in must be set according to
-    // zlib.h (inline doc).
-    m_zs.next_in  = reinterpret_cast<unsigned char *>(&m_invec[0]);
-    m_zs.avail_in = 0;
-
-    m_zs.next_out  = reinterpret_cast<unsigned char *>(&m_outvec[0]);
-    m_zs.avail_out = getBufferSize();
-
-    //
-    // windowBits is passed -MAX_WBITS to tell that no zlib
-    // header should be written.
-    //
-    int const err = deflateInit2(&m_zs, zlevel, Z_DEFLATED, -MAX_WBITS, default_mem_level, Z_DEFAULT_STRATEGY);
     if(err != Z_OK)
     {
-        // Not too sure how we could generate an error here, the deflateInit2()
-        // would fail if (1) there is not enough memory and (2) if a parameter
-        // is out of wack which neither can be generated from the outside
-        // (well... not easily)
+        // Not too sure how we could generate an error here, the
+        // deflateParams() only fails if a parameter is out of wack
+        // which cannot be generated from the outside (well... not easily)
         std::ostringstream msgs; // LCOV_EXCL_LINE
         msgs << "DeflateOutputStreambuf::init(): error while initializing zlib, " << zError(err) << std::endl; // LCOV_EXCL_LINE
         throw IOException(msgs.str()); // LCOV_EXCL_LINE
     }
 
+    // m_zs->next_in and avail_in must be set according to
+    // zlib.h (inline doc).
+    m_zs->next_in  = reinterpret_cast<unsigned char *>(&m_invec[0]);
+    m_zs->avail_in = 0;
+
+    m_zs->next_out  = reinterpret_cast<unsigned char *>(&m_outvec[0]);
+    m_zs->avail_out = m_outvec.size();
+
     // streambuf init:
-    setp(&m_invec[0], &m_invec[0] + getBufferSize());
+    setp(&m_invec[0], &m_invec[0] + m_invec.size());
 
-    m_crc32 = crc32(0, Z_NULL, 0);
+    m_crc32 = 0;
 
     return err == Z_OK;
 }
@@ -205,14 +191,17 @@ void DeflateOutputStreambuf::closeStream()
 
         // flush any remaining data
         endDeflation();
+        m_parallel_deflate.reset();
 
-        int const err(deflateEnd(&m_zs));
-        if(err != Z_OK) // when we close a directory, we get the Z_DATA_ERROR!
+        // keep the stream for the next entry
+        //
+        int const err(deflateReset(m_zs.get()));
+        if(err != Z_OK)
         {
-            // There are not too many cases which break the deflateEnd()
+            // There are not too many cases which break the deflateReset()
             // function call...
             std::ostringstream msgs; // LCOV_EXCL_LINE
-            msgs << "DeflateOutputStreambuf::closeStream(): deflateEnd failed: " << zError(err) << std::endl; // LCOV_EXCL_LINE
+            msgs << "DeflateOutputStreambuf::closeStream(): deflateReset failed: " << zError(err) << std::endl; // LCOV_EXCL_LINE
             throw IOException(msgs.str()); // LCOV_EXCL_LINE
         }
     }
@@ -254,6 +243,33 @@ size_t DeflateOutputStreambuf::getSize() const
 }
 
 
+/** \brief Compress large streams in blocks.
+ *
+ * This function turns on block compression: the data gets cut in
+ * blocks of \p block_size bytes which are deflated separately by
+ * \p threads threads using a ParallelDeflate object. The result is
+ * still one standard deflate stream. When the data fits in a single
+ * block, the output is exactly the same as without block compression.
+ *
+ * The setting is used by the next stream started with init() and
+ * by the current stream if no data was compressed yet. Use a
+ * \p block_size of 0 to turn block compression off.
+ *
+ * \param[in] block_size  The size of the blocks or 0.
+ * \param[in] threads  The number of threads to use, 0 for one per
+ *                     hardware thread.
+ */
+void DeflateOutputStreambuf::setBlockSize(size_t block_size, size_t threads)
+{
+    if(threads == 0)
+    {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    m_block_size = block_size;
+    m_block_threads = threads;
+}
+
+
 /** \brief Handle an overflow.
  *
  * This function is called by the streambuf implementation whenever
@@ -269,27 +285,50 @@ size_t DeflateOutputStreambuf::getSize() const
  */
 int DeflateOutputStreambuf::overflow(int c)
 {
+    if(m_block_size > 0
+    && m_parallel_deflate == nullptr
+    && m_zs->total_in == 0)
+    {
+        m_parallel_deflate = std::make_unique<ParallelDeflate>(m_outbuf, m_zlevel, m_block_size, m_block_threads);
+    }
+
+    if(m_parallel_deflate != nullptr)
+    {
+        // the ParallelDeflate computes the CRC-32 of its blocks
+        //
+        m_parallel_deflate->write(&m_invec[0], pptr() - pbase());
+        setp(&m_invec[0], &m_invec[0] + m_invec.size());
+
+        if(c != EOF)
+        {
+            *pptr() = c;
+            pbump(1);
+        }
+
+        return 0;
+    }
+
     int err(Z_OK);
 
-    m_zs.avail_in = pptr() - pbase();
-    m_zs.next_in = reinterpret_cast<unsigned char *>(&m_invec[0]);
+    m_zs->avail_in = pptr() - pbase();
+    m_zs->next_in = reinterpret_cast<unsigned char *>(&m_invec[0]);
 
-    if(m_zs.avail_in > 0)
+    if(m_zs->avail_in > 0)
     {
-        m_crc32 = crc32(m_crc32, m_zs.next_in, m_zs.avail_in); // update crc32
+        m_crc32 = updateCRC32(m_crc32, m_zs->next_in, m_zs->avail_in); // update crc32
 
-        m_zs.next_out = reinterpret_cast<unsigned char *>(&m_outvec[0]);
-        m_zs.avail_out = getBufferSize();
+        m_zs->next_out = reinterpret_cast<unsigned char *>(&m_outvec[0]);
+        m_zs->avail_out = m_outvec.size();
 
         // Deflate until m_invec is empty.
-        while((m_zs.avail_in > 0 || m_zs.avail_out == 0) && err == Z_OK)
+        while((m_zs->avail_in > 0 || m_zs->avail_out == 0) && err == Z_OK)
         {
-            if(m_zs.avail_out == 0)
+            if(m_zs->avail_out == 0)
             {
                 flushOutvec();
             }
 
-            err = deflate(&m_zs, Z_NO_FLUSH);
+            err = deflate(m_zs.get(), Z_NO_FLUSH);
         }
     }
 
@@ -297,7 +336,7 @@ int DeflateOutputStreambuf::overflow(int c)
     flushOutvec();
 
     // Update 'put' pointers
-    setp(&m_invec[0], &m_invec[0] + getBufferSize());
+    setp(&m_invec[0], &m_invec[0] + m_invec.size());
 
     if(err != Z_OK && err != Z_STREAM_END)
     {
@@ -341,7 +380,7 @@ int DeflateOutputStreambuf::sync() // LCOV_EXCL_LINE
 /** \brief Flush the cached output data.
  *
  * This function flushes m_outvec and updates the output pointer
- * and size m_zs.next_out and m_zs.avail_out.
+ * and size m_zs->next_out and m_zs->avail_out.
  */
 void DeflateOutputStreambuf::flushOutvec()
 {
@@ -350,7 +389,7 @@ void DeflateOutputStreambuf::flushOutvec()
      * flow through without the need to have this crap of bytes to
      * skip...
      */
-    std::size_t const deflated_bytes(getBufferSize() - m_zs.avail_out);
+    std::size_t const deflated_bytes(m_outvec.size() - m_zs->avail_out);
     if(deflated_bytes > 0)
     {
         std::size_t const bc(m_outbuf->sputn(&m_outvec[0], deflated_bytes));
@@ -363,8 +402,8 @@ void DeflateOutputStreambuf::flushOutvec()
         }
     }
 
-    m_zs.next_out = reinterpret_cast<unsigned char *>(&m_outvec[0]);
-    m_zs.avail_out = getBufferSize();
+    m_zs->next_out = reinterpret_cast<unsigned char *>(&m_outvec[0]);
+    m_zs->avail_out = m_outvec.size();
 }
 
 
@@ -378,8 +417,15 @@ void DeflateOutputStreambuf::endDeflation()
 {
     overflow();
 
-    m_zs.next_out = reinterpret_cast<unsigned char *>(&m_outvec[0]);
-    m_zs.avail_out = getBufferSize();
+    if(m_parallel_deflate != nullptr)
+    {
+        m_parallel_deflate->finish();
+        m_crc32 = m_parallel_deflate->getCrc32();
+        return;
+    }
+
+    m_zs->next_out = reinterpret_cast<unsigned char *>(&m_outvec[0]);
+    m_zs->avail_out = m_outvec.size();
 
     // Deflate until _invec is empty.
     int err(Z_OK);
@@ -393,12 +439,12 @@ void DeflateOutputStreambuf::endDeflation()
     {
         while(err == Z_OK)
         {
-            if(m_zs.avail_out == 0)
+            if(m_zs->avail_out == 0)
             {
                 flushOutvec();
             }
 
-            err = deflate(&m_zs, Z_FINISH);
+            err = deflate(m_zs.get(), Z_FINISH);
         }
     }
     else
@@ -32,14 +32,15 @@
  * The counter part is the class zipios::InflateInputStreambuf.
  */
 
+#include "codecpool.hpp"
 #include "filteroutputstreambuf.hpp"
+#include "paralleldeflate.hpp"
+#include "zlibbackend.hpp"
 
 #include "zipios/fileentry.hpp"
 
 #include <cstdint>
 
-#include <zlib.h>
-
 
 namespace zipios
 {
@@ -47,7 +48,7 @@ namespace zipios
 class DeflateOutputStreambuf : public FilterOutputStreambuf
 {
 public:
-                            DeflateOutputStreambuf(std::streambuf * outbuf);
+                            DeflateOutputStreambuf(std::streambuf * outbuf, size_t buffer_size = getBufferSize());
                             DeflateOutputStreambuf(DeflateOutputStreambuf const & rhs) = delete;
     virtual                 ~DeflateOutputStreambuf();
 
@@ -57,12 +58,13 @@ public:
     void                    closeStream();
     uint32_t                getCrc32() const;
     size_t                  getSize() const;
+    void                    setBlockSize(size_t block_size, size_t threads = 1);
 
 protected:
     virtual int             overflow(int c = EOF);
     virtual int             sync();
 
-    uint32_t                m_overflown_bytes = 0;
+    size_t                  m_overflown_bytes = 0;
     std::vector<char>       m_invec = std::vector<char>();
     uint32_t                m_crc32 = 0;
 
@@ -70,8 +72,14 @@ private:
     void                    endDeflation();
     void                    flushOutvec();
 
-    z_stream                m_zs = z_stream();
+    CodecPool::stream_pointer_t
+                            m_zs = CodecPool::stream_pointer_t();
     bool                    m_zs_initialized = false;
+    int                     m_zlevel = Z_DEFAULT_COMPRESSION;
+    size_t                  m_block_size = 0;
+    size_t                  m_block_threads = 1;
+    ParallelDeflate::pointer_t
+                            m_parallel_deflate = ParallelDeflate::pointer_t();
 
     std::vector<char>       m_outvec = std::vector<char>();
 };
@@ -167,7 +167,7 @@ FileEntry::vector_t DirectoryCollection::entries() const
  *
  * \sa mustBeValid()
  */
-FileEntry::pointer_t DirectoryCollection::getEntry(std::string const & name, MatchPath matchpath) const
+FileEntry::pointer_t DirectoryCollection::getEntry(std::string_view name, MatchPath matchpath) const
 {
     loadEntries();
 
@@ -256,6 +256,8 @@ void DirectoryCollection::loadEntries() const
             {
                 const_cast<DirectoryCollection *>(this)->load(FilePath());
             }
+
+            const_cast<DirectoryCollection *>(this)->indexEntries();
         }
         catch(...)
         {
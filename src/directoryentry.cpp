@@ -30,10 +30,10 @@
 
 #include "zipios/zipiosexceptions.hpp"
 
+#include "crc32.hpp"
 #include "zipios_common.hpp"
 
 #include <fstream>
-#include <zlib.h>
 
 
 namespace zipios
@@ -135,13 +135,10 @@ bool DirectoryEntry::isEqual(FileEntry const & file_entry) const
  */
 uint32_t DirectoryEntry::computeCRC32() const
 {
-    uint32_t result(crc32(0L, Z_NULL, 0));
+    uint32_t result(0);
 
     if(!m_filename.isDirectory())
     {
-        // TODO: I tried to use std::basic_ifstream<Bytef> to avoid the
-        //       reinterpret_cast<>(), but somehow that doesn't work at all
-        //
         std::ifstream in;
         in.open(m_filename);
         if(!in.is_open())
@@ -154,13 +151,13 @@ uint32_t DirectoryEntry::computeCRC32() const
 
         for(;;)
         {
-            Bytef buf[64 * 1024];
-            in.read(reinterpret_cast<char *>(buf), sizeof(buf));
+            char buf[64 * 1024];
+            in.read(buf, sizeof(buf));
             if(in.gcount() == 0)
             {
                 break;
             }
-            result = crc32(result, buf, in.gcount());
+            result = updateCRC32(result, buf, in.gcount());
         }
     }
 
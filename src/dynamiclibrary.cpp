@@ -0,0 +1,116 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::DynamicLibrary.
+ *
+ * This file loads shared libraries with dlopen() or LoadLibrary().
+ */
+
+#include "dynamiclibrary.hpp"
+
+#include "zipios/zipios-config.hpp"
+
+#ifdef ZIPIOS_WINDOWS
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+
+namespace zipios
+{
+
+
+/** \class DynamicLibrary
+ * \brief A shared library loaded at runtime.
+ *
+ * This class loads the first library found in a list of names. The
+ * library is never unloaded since the objects created by its functions
+ * may live until the process exits. The objects of this class are
+ * expected to be static.
+ */
+
+
+/** \brief Load a library.
+ *
+ * This constructor tries to load each library in \p names, in order,
+ * until one gets loaded. Use isLoaded() to know whether one was found.
+ *
+ * \param[in] names  The names of the library to try, i.e. the names used
+ *                   on the various systems and with various versions.
+ */
+DynamicLibrary::DynamicLibrary(std::initializer_list<char const *> names)
+{
+    for(auto const name : names)
+    {
+#ifdef ZIPIOS_WINDOWS
+        m_handle = LoadLibraryA(name);
+#else
+        m_handle = dlopen(name, RTLD_NOW | RTLD_LOCAL);
+#endif
+        if(m_handle != nullptr)
+        {
+            break;
+        }
+    }
+}
+
+
+/** \brief Check whether the library was loaded.
+ *
+ * \return true if one of the libraries was found.
+ */
+bool DynamicLibrary::isLoaded() const
+{
+    return m_handle != nullptr;
+}
+
+
+/** \brief Search a symbol in the library.
+ *
+ * \param[in] name  The name of the symbol.
+ *
+ * \return The address of the symbol or nullptr.
+ */
+void * DynamicLibrary::findSymbol(char const * name) const
+{
+    if(m_handle == nullptr)
+    {
+        return nullptr; // LCOV_EXCL_LINE
+    }
+#ifdef ZIPIOS_WINDOWS
+    return reinterpret_cast<void *>(GetProcAddress(static_cast<HMODULE>(m_handle), name));
+#else
+    return dlsym(m_handle, name);
+#endif
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
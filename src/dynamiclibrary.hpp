@@ -0,0 +1,81 @@
+#pragma once
+#ifndef ZIPIOS_DYNAMICLIBRARY_HPP
+#define ZIPIOS_DYNAMICLIBRARY_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief A library loaded at runtime.
+ *
+ * The optional compression libraries (zstd, libdeflate) are loaded at
+ * runtime so zipios does not depend on them.
+ */
+
+#include <initializer_list>
+
+
+namespace zipios
+{
+
+
+class DynamicLibrary
+{
+public:
+                            DynamicLibrary(std::initializer_list<char const *> names);
+                            DynamicLibrary(DynamicLibrary const & rhs) = delete;
+
+    DynamicLibrary &        operator = (DynamicLibrary const & rhs) = delete;
+
+    bool                    isLoaded() const;
+
+    /** \brief Load a function from the library.
+     *
+     * \param[in] name  The name of the function.
+     * \param[out] f  The variable receiving the function pointer, set
+     *                to nullptr if the function is not found.
+     *
+     * \return true if the function was found.
+     */
+    template<typename F>
+    bool                    load(char const * name, F & f) const
+                            {
+                                f = reinterpret_cast<F>(findSymbol(name));
+                                return f != nullptr;
+                            }
+
+private:
+    void *                  findSymbol(char const * name) const;
+
+    void *                  m_handle = nullptr;
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
@@ -31,7 +31,7 @@
 
 #include "zipios/zipiosexceptions.hpp"
 
-#include <algorithm>
+#include "nameindex.hpp"
 
 
 namespace zipios
@@ -50,106 +50,6 @@ namespace
 char const * g_default_filename = "-";
 
 
-/** \brief Class object used with the std::find_if() function.
- *
- * This function object is used with the STL find_if algorithm to
- * find a FileEntry in a container, which name (as obtained with
- * FileEntry::getName()) is identical to the name specified in the
- * MatchName constructor.
- */
-class MatchName
-{
-public:
-    /** \brief Initialize a MatchName object.
-     *
-     * This function saves the name to search in the FileCollection.
-     *
-     * This class expect the name to be a full path and file name
-     * with extension. The full name has to match.
-     *
-     * \param[in] name  The name of the file being searched.
-     */
-    explicit MatchName(std::string const & name)
-        : m_name(name)
-    {
-    }
-
-    /** \brief Compare an entry to this MatchName.
-     *
-     * This function compares the full name of the entry with the
-     * saved full name. If equal, then it returns true. It is used
-     * with the std::find_if() function.
-     *
-     * \todo
-     * We could transform that with lambda at some point.
-     *
-     * \param[in] entry  The entry to compare with the MatchName.
-     *
-     * \return true if the name of the entry matches the MatchName.
-     */
-    bool operator() (FileEntry::pointer_t entry) const
-    {
-        return entry->getName() == m_name;
-    }
-
-private:
-    std::string const       m_name;
-};
-
-
-/** \brief Class object used with the std::find_if() function.
- *
- * This function object is used with the STL find_if algorithm to
- * find a FileEntry in a container, which name (as obtained with
- * FileEntry::getFileName()) is identical to the name specified in the
- * MatchFileName constructor.
- *
- * \warning
- * The file name cannot include a '/' in this case or the search will
- * always fail.
- */
-class MatchFileName
-{
-public:
-    /** \brief Initialize a MatchFileName object.
-     *
-     * This function saves the base name to search in the
-     * FileCollection.
-     *
-     * This class expect the name to be a base file name, eventually with
-     * an extension. If the name includes a slash then the search will
-     * always fail.
-     *
-     * \param[in] name  The name of the file being searched.
-     */
-    explicit MatchFileName(std::string const & name)
-        : m_name(name)
-    {
-    }
-
-    /** \brief Compare an entry to this MatchFileName.
-     *
-     * This function compares the base name of the entry with the
-     * saved base name. If equal, then it returns true. It is used
-     * with the std::find_if() function.
-     *
-     * \todo
-     * We could transform that with lambda at some point.
-     *
-     * \param[in] entry  The entry to compare with the MatchFileName.
-     *
-     * \return true if the name of the entry matches the MatchFileName.
-     */
-    bool operator() (FileEntry::pointer_t entry) const
-    {
-        return entry->getFileName() == m_name;
-    }
-
-private:
-    std::string const       m_name;
-};
-
-
 } // no name namespace
 
 
@@ -281,6 +181,9 @@ FileCollection::FileCollection(std::string const & filename)
  * can be modified and it has no effect on the entries in the other
  * collection.
  *
+ * The name index is not copied. It gets rebuilt against the cloned
+ * entries.
+ *
  * \param[in] rhs  The source collection to copy in this collection.
  */
 FileCollection::FileCollection(FileCollection const & rhs)
@@ -292,6 +195,7 @@ FileCollection::FileCollection(FileCollection const & rhs)
     {
         m_entries.push_back((*it)->clone());
     }
+    indexEntries();
 }
 
 
@@ -315,12 +219,14 @@ FileCollection & FileCollection::operator = (FileCollection const & rhs)
     {
         m_filename = rhs.m_filename;
 
+        clearIndex();
         m_entries.clear();
         m_entries.reserve(rhs.m_entries.size());
         for(auto it(rhs.m_entries.begin()); it != rhs.m_entries.end(); ++it)
         {
             m_entries.push_back((*it)->clone());
         }
+        indexEntries();
 
         m_valid = rhs.m_valid;
     }
@@ -360,11 +266,16 @@ FileCollection::~FileCollection()
  * the caller's entry can be modified without affecting the
  * FileCollection.
  *
+ * The name index gets updated here so getEntry() never has to modify
+ * the collection. This means that adding entries while other threads
+ * call getEntry() on the same collection is not safe.
+ *
  * \param[in] entry  The entry to add to the FileCollection.
  */
 void FileCollection::addEntry(FileEntry const & entry)
 {
     m_entries.push_back(entry.clone());
+    indexEntries();
 }
 
 
@@ -374,6 +285,7 @@ void FileCollection::addEntry(FileEntry const & entry)
  */
 void FileCollection::close()
 {
+    clearIndex();
     m_entries.clear();
     m_filename = g_default_filename;
     m_valid = false;
@@ -405,6 +317,14 @@ FileEntry::vector_t FileCollection::entries() const
  * filename while searching for a match, specify FileCollection::IGNORE
  * as the second argument.
  *
+ * The search makes use of a hash index of the entry names so the cost
+ * of a lookup does not depend on the number of entries in the
+ * collection. If several entries have the same name, the first one
+ * (in the order in which they appear in the collection) is returned.
+ *
+ * The function does not modify the collection so several threads can
+ * search the same collection at the same time.
+ *
  * \note
  * The collection must be valid or the function raises an exception.
  *
@@ -417,25 +337,12 @@ FileEntry::vector_t FileCollection::entries() const
  *         is null if no entry is found.
  *
  * \sa mustBeValid()
+ * \sa indexEntries()
  */
-FileEntry::pointer_t FileCollection::getEntry(std::string const & name, MatchPath matchpath) const
+FileEntry::pointer_t FileCollection::getEntry(std::string_view name, MatchPath matchpath) const
 {
-    // make sure the entries were loaded if necessary
-    entries();
-
-    mustBeValid();
-
-    FileEntry::vector_t::const_iterator iter;
-    if(matchpath == MatchPath::MATCH)
-    {
-        iter = std::find_if(m_entries.begin(), m_entries.end(), MatchName(name));
-    }
-    else
-    {
-        iter = std::find_if(m_entries.begin(), m_entries.end(), MatchFileName(name));
-    }
-
-    return iter == m_entries.end() ? FileEntry::pointer_t() : *iter;
+    size_t const idx(findEntryIndex(name, matchpath));
+    return idx == g_no_entry ? FileEntry::pointer_t() : m_entries[idx];
 }
 
 
@@ -471,7 +378,7 @@ std::string FileCollection::getName() const
 size_t FileCollection::size() const
 {
     // make sure the entries were loaded if necessary
-    entries();
+    loadEntries();
 
     mustBeValid();
     return m_entries.size();
@@ -512,6 +419,121 @@ void FileCollection::mustBeValid() const
 }
 
 
+/** \brief Load the entries of this collection.
+ *
+ * Collections which read their entries lazily (i.e. the
+ * DirectoryCollection) override this function to load the entries
+ * on the first access. The default implementation does nothing since
+ * the entries are expected to already be available in m_entries.
+ *
+ * This function is called by getEntry() and size() instead of entries()
+ * so that a lookup does not require a copy of the vector of entries.
+ */
+void FileCollection::loadEntries() const
+{
+}
+
+
+/** \brief Search the index of an entry.
+ *
+ * This function searches the entry named \p name and returns its index
+ * in m_entries. It is the implementation of getEntry() and can be used
+ * by derived classes which need to attach data to their entries.
+ *
+ * If several entries match, the index of the first one is returned.
+ *
+ * \note
+ * The collection must be valid or the function raises an exception.
+ *
+ * \param[in] name  A string containing the name of the entry to get.
+ * \param[in] matchpath  Specify MatchPath::MATCH, if the path should match
+ *                       as well, specify MatchPath::IGNORE, if the path
+ *                       should be ignored.
+ *
+ * \return The index of the entry or g_no_entry if not found.
+ */
+size_t FileCollection::findEntryIndex(std::string_view name, MatchPath matchpath) const
+{
+    // make sure the entries were loaded if necessary
+    loadEntries();
+
+    mustBeValid();
+
+    if(m_index == nullptr)
+    {
+        // no entries
+        return g_no_entry;
+    }
+
+    return m_index->find(name, matchpath);
+}
+
+
+/** \brief Add the new entries to the name index.
+ *
+ * This function adds the entries found in m_entries which were not yet
+ * indexed to the name index used by getEntry(). Entries are only ever
+ * appended to a collection so the index can be caught up incrementally.
+ * It has to be called by the functions which add entries to m_entries.
+ * Collections which load all of their entries at once call it once
+ * after loading them.
+ *
+ * The NameIndex keeps one map of the full names (used with
+ * MatchPath::MATCH) and one of the basenames (used with
+ * MatchPath::IGNORE). The keys are views to strings saved in
+ * m_index_names; a std::deque is used so those strings never move.
+ */
+void FileCollection::indexEntries()
+{
+    size_t const max(m_entries.size());
+    if(m_indexed_entries >= max)
+    {
+        return;
+    }
+
+    if(m_index == nullptr)
+    {
+        m_index = std::make_shared<NameIndex>();
+    }
+    m_index->reserve(max);
+    for(size_t idx(m_indexed_entries); idx < max; ++idx)
+    {
+        m_index_names.push_back(m_entries[idx]->getName());
+        std::string_view const name(m_index_names.back());
+
+        // in most cases the basename is the end of the full name and
+        // we can reuse the same string
+        //
+        std::string const filename(m_entries[idx]->getFileName());
+        if(name.size() >= filename.size()
+        && name.substr(name.size() - filename.size()) == filename)
+        {
+            m_index->add(name, name.substr(name.size() - filename.size()), idx);
+        }
+        else
+        {
+            m_index_names.push_back(filename);  // LCOV_EXCL_LINE
+            m_index->add(name, m_index_names.back(), idx);  // LCOV_EXCL_LINE
+        }
+    }
+    m_indexed_entries = max;
+}
+
+
+/** \brief Clear the name index.
+ *
+ * This function releases the name index. It must be called whenever
+ * entries get removed from m_entries. The index gets rebuilt by
+ * the next call to indexEntries().
+ */
+void FileCollection::clearIndex()
+{
+    m_index.reset();
+    m_index_names.clear();
+    m_indexed_entries = 0;
+}
+
+
 /** \brief Change the storage method to the specified value.
  *
  * This function changes the storage method of all the entries in
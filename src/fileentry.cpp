@@ -31,6 +31,7 @@
 
 #include "zipios/fileentry.hpp"
 
+#include "zipios/codec.hpp"
 #include "zipios/zipiosexceptions.hpp"
 
 #include "zipios_common.hpp"
@@ -47,7 +48,9 @@ namespace zipios
  * i.e. STORED is indicated by a 0 in the method field in a zip file and
  * so on.
  *
- * The zipios library only support STORED and DEFLATED at this time.
+ * The zipios library supports STORED and DEFLATED. The other methods
+ * are supported when a Codec is registered for them. The library
+ * registers a codec for ZSTD when the zstd library is available.
  */
 
 
@@ -581,9 +584,10 @@ void FileEntry::setLevel(CompressionLevel level)
  *
  * \exception InvalidStateException
  * This exception is raised if the \p method parameter does not represent
- * a supported method. At this time the library only supports STORED and
- * DEFLATED. The getMethod() may return more types as read from a Zip
- * archive, but it is not possible to set such types using this function.
+ * a supported method. The library supports STORED, DEFLATED, and the
+ * methods for which a Codec is registered (see Codec::registerCodec()).
+ * The getMethod() may return more types as read from a Zip archive, but
+ * it is not possible to set such types using this function.
  *
  * \param[in] method  The method field is set to the specified value.
  */
@@ -616,7 +620,13 @@ void FileEntry::setMethod(StorageMethod method)
         break;
 
     default:
-        throw InvalidStateException("unknown method");
+        // other methods are supported by codecs
+        //
+        if(Codec::getCodec(method) == nullptr)
+        {
+            throw InvalidStateException("unknown method");
+        }
+        break;
 
     }
 
@@ -86,6 +86,11 @@ std::string pruneTrailingSeparator(std::string path)
  * \warning
  * The information about a file is cached so at the time it gets used
  * the file on disk may have changed, it may even have been deleted.
+ *
+ * The statistics are only allocated once one of the functions that
+ * need them gets called. A FilePath that only represents a name, such
+ * as the name of an entry in a Zip archive, is not much bigger than
+ * its string.
  */
 
 
@@ -115,6 +120,10 @@ FilePath::FilePath(std::string const & path)
  * This means stat()'ing is deferred until it becomes necessary. But also
  * it is cached meaning that if the file changes in between we get the
  * old flags.
+ *
+ * The statistics are saved in a separate buffer which is only allocated
+ * when the file exists. Copies of this FilePath share that buffer since
+ * it never gets modified once created.
  */
 void FilePath::check() const
 {
@@ -131,8 +140,15 @@ void FilePath::check() const
          *
          * See zipios/zipios-config.hpp.in
          */
-        m_stat = {};
-        m_exists = stat(m_path.c_str(), &m_stat) == 0;
+        os_stat_t st = {};
+        if(stat(m_path.c_str(), &st) == 0)
+        {
+            m_stat = std::make_shared<os_stat_t const>(st);
+        }
+        else
+        {
+            m_stat.reset();
+        }
     }
 }
 
@@ -150,6 +166,7 @@ FilePath & FilePath::operator = (std::string const & path)
 {
     m_path = pruneTrailingSeparator(path);
     m_checked = false;
+    m_stat.reset();
     return *this;
 }
 
@@ -302,6 +319,7 @@ void FilePath::clear()
 {
     m_path.clear();
     m_checked = false;
+    m_stat.reset();
 }
 
 
@@ -394,7 +412,7 @@ bool FilePath::empty() const
 bool FilePath::exists() const
 {
     check();
-    return m_exists;
+    return m_stat != nullptr;
 }
 
 
@@ -408,7 +426,7 @@ bool FilePath::exists() const
 bool FilePath::isRegular() const
 {
     check();
-    return m_exists && S_ISREG(m_stat.st_mode);
+    return m_stat != nullptr && S_ISREG(m_stat->st_mode);
 }
 
 
@@ -422,7 +440,7 @@ bool FilePath::isRegular() const
 bool FilePath::isDirectory() const
 {
     check();
-    return m_exists && S_ISDIR(m_stat.st_mode);
+    return m_stat != nullptr && S_ISDIR(m_stat->st_mode);
 }
 
 
@@ -436,7 +454,7 @@ bool FilePath::isDirectory() const
 bool FilePath::isCharSpecial() const
 {
     check();
-    return m_exists && S_ISCHR(m_stat.st_mode);
+    return m_stat != nullptr && S_ISCHR(m_stat->st_mode);
 }
 
 
@@ -450,7 +468,7 @@ bool FilePath::isCharSpecial() const
 bool FilePath::isBlockSpecial() const
 {
     check();
-    return m_exists && S_ISBLK(m_stat.st_mode);
+    return m_stat != nullptr && S_ISBLK(m_stat->st_mode);
 }
 
 
@@ -464,7 +482,7 @@ bool FilePath::isBlockSpecial() const
 bool FilePath::isSocket() const
 {
     check();
-    return m_exists && S_ISSOCK(m_stat.st_mode);
+    return m_stat != nullptr && S_ISSOCK(m_stat->st_mode);
 }
 
 
@@ -478,7 +496,7 @@ bool FilePath::isSocket() const
 bool FilePath::isFifo() const
 {
     check();
-    return m_exists && S_ISFIFO(m_stat.st_mode);
+    return m_stat != nullptr && S_ISFIFO(m_stat->st_mode);
 }
 
 
@@ -504,7 +522,7 @@ bool FilePath::isFifo() const
 size_t FilePath::fileSize() const
 {
     check();
-    return m_stat.st_size;
+    return m_stat == nullptr ? 0 : m_stat->st_size;
 }
 
 
@@ -521,7 +539,7 @@ size_t FilePath::fileSize() const
 std::time_t FilePath::lastModificationTime() const
 {
     check();
-    return m_stat.st_mtime;
+    return m_stat == nullptr ? 0 : m_stat->st_mtime;
 }
 
 
@@ -59,9 +59,10 @@ namespace zipios
  *
  * \param[in,out] os  ostream to which the compressed zip archive is written.
  * \param[in] compression_level  The compression level to use to compress.
+ * \param[in] policy  The I/O policy defining the size of the output buffers.
  */
-GZIPOutputStream::GZIPOutputStream(std::ostream & os, FileEntry::CompressionLevel compression_level)
-    : m_ozf(std::make_unique<GZIPOutputStreambuf>(os.rdbuf(), compression_level))
+GZIPOutputStream::GZIPOutputStream(std::ostream & os, FileEntry::CompressionLevel compression_level, IOPolicy const & policy)
+    : m_ozf(std::make_unique<GZIPOutputStreambuf>(os.rdbuf(), compression_level, policy.getOutputBufferSize()))
 {
     init(m_ozf.get());
 }
@@ -76,11 +77,12 @@ GZIPOutputStream::GZIPOutputStream(std::ostream & os, FileEntry::CompressionLeve
  * \param[in] filename  Name of the file where the zip archive is to
  *                      be written.
  * \param[in] compression_level  The compression level to use to compress.
+ * \param[in] policy  The I/O policy defining the size of the output buffers.
  */
-GZIPOutputStream::GZIPOutputStream(std::string const & filename, FileEntry::CompressionLevel compression_level)
+GZIPOutputStream::GZIPOutputStream(std::string const & filename, FileEntry::CompressionLevel compression_level, IOPolicy const & policy)
     : std::ostream(0)
     , m_ofs(std::make_unique<std::ofstream>(filename.c_str(), std::ios::out | std::ios::binary))
-    , m_ozf(std::make_unique<GZIPOutputStreambuf>(m_ofs->rdbuf(), compression_level))
+    , m_ozf(std::make_unique<GZIPOutputStreambuf>(m_ofs->rdbuf(), compression_level, policy.getOutputBufferSize()))
 {
     init(m_ozf.get());
 }
@@ -110,6 +112,23 @@ void GZIPOutputStream::setFilename(std::string const & filename)
 }
 
 
+/** \brief Compress the stream in parallel.
+ *
+ * This function cuts the data in blocks of \p block_size bytes which
+ * get compressed by \p threads threads. The result is a standard gzip
+ * file. It has to be called before any data gets written.
+ *
+ * \param[in] block_size  The size of the blocks, 0 to turn it off.
+ * \param[in] threads  The number of threads, 0 for one per hardware thread.
+ *
+ * \sa DeflateOutputStreambuf::setBlockSize()
+ */
+void GZIPOutputStream::setBlockSize(size_t block_size, size_t threads)
+{
+    m_ozf->setBlockSize(block_size, threads);
+}
+
+
 /** \brief Set a comment in the stream.
  *
  * This function can be used to add a comment to the zip file.
@@ -32,6 +32,8 @@
 
 #include "gzipoutputstreambuf.hpp"
 
+#include "zipios/iopolicy.hpp"
+
 #include <memory>
 
 
@@ -42,12 +44,13 @@ namespace zipios
 class GZIPOutputStream : public std::ostream
 {
 public:
-                                            GZIPOutputStream(std::ostream & os, FileEntry::CompressionLevel compression_level);
-                                            GZIPOutputStream(std::string const & filename, FileEntry::CompressionLevel compression_level);
+                                            GZIPOutputStream(std::ostream & os, FileEntry::CompressionLevel compression_level, IOPolicy const & policy = IOPolicy());
+                                            GZIPOutputStream(std::string const & filename, FileEntry::CompressionLevel compression_level, IOPolicy const & policy = IOPolicy());
     virtual                                 ~GZIPOutputStream();
 
     void                                    setFilename(std::string const & filename);
     void                                    setComment(std::string const & comment);
+    void                                    setBlockSize(size_t block_size, size_t threads = 1);
     void                                    close();
     void                                    finish();
 
@@ -50,9 +50,10 @@ namespace zipios
  *
  * \param[in,out] outbuf  The streambuf to use for output.
  * \param[in] compression_level  The compression level to use to compress.
+ * \param[in] buffer_size  The size of the output buffers.
  */
-GZIPOutputStreambuf::GZIPOutputStreambuf(std::streambuf * outbuf, FileEntry::CompressionLevel compression_level)
-    : DeflateOutputStreambuf(outbuf)
+GZIPOutputStreambuf::GZIPOutputStreambuf(std::streambuf * outbuf, FileEntry::CompressionLevel compression_level, size_t buffer_size)
+    : DeflateOutputStreambuf(outbuf, buffer_size)
 {
     if(!init(compression_level))
     {
@@ -101,13 +102,20 @@ void GZIPOutputStreambuf::close()
  */
 void GZIPOutputStreambuf::finish()
 {
-    if(!m_open)
+    // data smaller than the buffer did not trigger an overflow() yet
+    //
+    if(!m_open
+    && pptr() == pbase())
     {
         return;
     }
-    m_open = false;
 
+    // the stream must still be marked open or the last overflow()
+    // would write a second header
+    //
     closeStream();
+    m_open = false;
+
     writeTrailer();
 }
 
@@ -119,6 +127,7 @@ int GZIPOutputStreambuf::overflow(int c)
         writeHeader();
         m_open = true;
     }
+    m_overflown_bytes += pptr() - pbase();
 
     return DeflateOutputStreambuf::overflow(c);
 }
@@ -174,9 +183,9 @@ void GZIPOutputStreambuf::writeHeader()
 
 void GZIPOutputStreambuf::writeTrailer()
 {
-    // write the CRC32 and Size at the end of the file
+    // write the CRC32 and Size (modulo 2^32) at the end of the file
     writeInt(getCrc32());
-    writeInt(getSize());
+    writeInt(static_cast<uint32_t>(getSize()));
 }
 
 
@@ -41,7 +41,7 @@ namespace zipios
 class GZIPOutputStreambuf : public DeflateOutputStreambuf
 {
 public:
-                  GZIPOutputStreambuf(std::streambuf * outbuf, FileEntry::CompressionLevel compression_level);
+                  GZIPOutputStreambuf(std::streambuf * outbuf, FileEntry::CompressionLevel compression_level, size_t buffer_size = getBufferSize());
     virtual       ~GZIPOutputStreambuf() override;
 
     void          setFilename(std::string const & filename);
@@ -0,0 +1,191 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::InflateIndex.
+ *
+ * This file implements the index of access points used to seek in
+ * deflated data.
+ */
+
+#include "inflateindex.hpp"
+
+#include <algorithm>
+
+
+namespace zipios
+{
+
+
+/** \class InflateIndex
+ * \brief An index of access points in deflated data.
+ *
+ * Deflated data can only be inflated from the start. To seek in the
+ * middle of the data, the InflateIndex saves access points at deflate
+ * block boundaries, about every span bytes of uncompressed data. Each
+ * access point holds the position in the compressed and uncompressed
+ * data, the number of bits of the last compressed byte which belong
+ * to the previous block, and the last 32Kb of uncompressed data (the
+ * deflate window). The inflation can restart from any access point.
+ *
+ * The access points are added in order while the data gets inflated
+ * the first time. The index is shared by all the streams reading the
+ * same entry and can be used by several threads at the same time.
+ */
+
+
+/** \typedef InflateIndex::pointer_t
+ * \brief A shared pointer to an InflateIndex.
+ */
+
+
+/** \var InflateIndex::WINDOW_SIZE
+ * \brief The size of the deflate window.
+ *
+ * Deflate can reference up to 32Kb of previous data. This is the size
+ * of the window saved in each access point.
+ */
+
+
+/** \struct InflateIndex::access_point_t
+ * \brief One position where the inflation can restart.
+ *
+ * The m_compressed_offset is the position of the first byte of the
+ * compressed data which was not yet used when the access point was
+ * created. When m_bits is not zero, that many bits of the previous
+ * byte are still to be used.
+ */
+
+
+/** \brief Initialize an InflateIndex.
+ *
+ * The index gets an access point about every \p span bytes of
+ * uncompressed data.
+ *
+ * \param[in] span  The distance between access points.
+ */
+InflateIndex::InflateIndex(offset_t span)
+    : m_span(span)
+{
+}
+
+
+/** \brief Retrieve the distance between access points.
+ *
+ * This function returns the number of bytes of uncompressed data between
+ * two access points.
+ *
+ * \return The span of this index.
+ */
+offset_t InflateIndex::getSpan() const
+{
+    return m_span;
+}
+
+
+/** \brief Get the uncompressed offset of the next access point.
+ *
+ * This function returns the smallest uncompressed offset at which the
+ * next access point can be added.
+ *
+ * \return The offset at which the next access point is expected.
+ */
+offset_t InflateIndex::nextAccessPoint() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_access_points.empty()
+                ? m_span
+                : m_access_points.back()->m_uncompressed_offset + m_span;
+}
+
+
+/** \brief Add an access point.
+ *
+ * This function adds \p point to the index. Points that are not
+ * far enough from the last access point are ignored. This happens
+ * when several streams read the same data at the same time.
+ *
+ * \param[in] point  The access point to add.
+ */
+void InflateIndex::addAccessPoint(access_point_t::pointer_t point)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    offset_t const next(m_access_points.empty()
+                ? m_span
+                : m_access_points.back()->m_uncompressed_offset + m_span);
+    if(point->m_uncompressed_offset >= next)
+    {
+        m_access_points.push_back(point);
+    }
+}
+
+
+/** \brief Search for the access point to seek to an offset.
+ *
+ * This function returns the last access point at or before
+ * \p uncompressed_offset.
+ *
+ * \param[in] uncompressed_offset  The offset to seek to.
+ *
+ * \return The access point or nullptr if the inflation has to restart
+ *         from the start of the data.
+ */
+InflateIndex::access_point_t::pointer_t InflateIndex::findAccessPoint(offset_t uncompressed_offset) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto const it(std::upper_bound(
+              m_access_points.begin()
+            , m_access_points.end()
+            , uncompressed_offset
+            , [](offset_t offset, access_point_t::pointer_t const & point)
+                {
+                    return offset < point->m_uncompressed_offset;
+                }));
+    if(it == m_access_points.begin())
+    {
+        return access_point_t::pointer_t();
+    }
+    return *(it - 1);
+}
+
+
+/** \brief Retrieve the number of access points.
+ *
+ * This function returns the number of access points in the index.
+ *
+ * \return The number of access points.
+ */
+size_t InflateIndex::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_access_points.size();
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
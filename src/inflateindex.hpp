@@ -0,0 +1,91 @@
+#pragma once
+#ifndef ZIPIOS_INFLATEINDEX_HPP
+#define ZIPIOS_INFLATEINDEX_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Header file that defines zipios::InflateIndex.
+ *
+ * The zipios::InflateIndex class saves access points in a deflated
+ * stream so inflation can restart from the middle of the stream.
+ */
+
+#include "zipios_common.hpp"
+
+#include <memory>
+#include <mutex>
+
+
+namespace zipios
+{
+
+
+class InflateIndex
+{
+public:
+    typedef std::shared_ptr<InflateIndex>   pointer_t;
+
+    // maximum size of a deflate window
+    static size_t const     WINDOW_SIZE = 32768;
+
+    struct access_point_t
+    {
+        typedef std::shared_ptr<access_point_t const>   pointer_t;
+
+        offset_t            m_uncompressed_offset = 0;
+        offset_t            m_compressed_offset = 0;
+        int                 m_bits = 0;
+        buffer_t            m_window = buffer_t();
+    };
+
+                            InflateIndex(offset_t span);
+                            InflateIndex(InflateIndex const & rhs) = delete;
+
+    InflateIndex &          operator = (InflateIndex const & rhs) = delete;
+
+    offset_t                getSpan() const;
+    offset_t                nextAccessPoint() const;
+    void                    addAccessPoint(access_point_t::pointer_t point);
+    access_point_t::pointer_t
+                            findAccessPoint(offset_t uncompressed_offset) const;
+    size_t                  size() const;
+
+private:
+    typedef std::vector<access_point_t::pointer_t>  access_point_vector_t;
+
+    mutable std::mutex      m_mutex = std::mutex();
+    offset_t                m_span = 0;
+    access_point_vector_t   m_access_points = access_point_vector_t();
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
@@ -33,6 +33,10 @@
 
 #include "zipios_common.hpp"
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 
 namespace zipios
 {
@@ -66,12 +70,19 @@ namespace zipios
  * \param[in,out] inbuf  The streambuf to use for input.
  * \param[in] start_pos  A position to reset the inbuf to before reading. Specify
  *                       -1 to not change the position.
+ * \param[in] buffer_size  The size of the input and output buffers (see
+ *                         IOPolicy::setInputBufferSize()).
  */
-InflateInputStreambuf::InflateInputStreambuf(std::streambuf * inbuf, offset_t start_pos)
+InflateInputStreambuf::InflateInputStreambuf(std::streambuf * inbuf, offset_t start_pos, size_t buffer_size)
     : FilterInputStreambuf(inbuf)
-    , m_outvec(getBufferSize())
-    , m_invec(getBufferSize())
+    , m_stream(CodecPool::getInflateStream())
+    , m_zs(*m_stream)
 {
+    // the zlib stream and the buffers are borrowed from the pool
+    //
+    CodecPool::getBuffer(m_outvec, std::max(buffer_size, static_cast<size_t>(1)));
+    CodecPool::getBuffer(m_invec, std::max(buffer_size, static_cast<size_t>(1)));
+
     // NOTICE: It is important that this constructor and the methods it
     // calls doesn't do anything with the input streambuf inbuf, other
     // than repositioning it to the specified \p start_pos. The reason is
@@ -91,20 +102,10 @@ InflateInputStreambuf::InflateInputStreambuf(std::streambuf * inbuf, offset_t st
  */
 InflateInputStreambuf::~InflateInputStreambuf()
 {
-    // Dealloc z_stream stuff
-    int const err(inflateEnd(&m_zs));
-    if(err != Z_OK)
-    {
-        // in a destructor we cannot throw...
-        OutputStringStream msgs; // LCOV_EXCL_LINE
-        msgs << "InflateInputStreambuf::~InflateInputStreambuf(): inflateEnd() failed" // LCOV_EXCL_LINE
-             << ": " << zError(err); // LCOV_EXCL_LINE
-        /** \TODO
-         * Write an error callback interface and call that instead of
-         * using std::cerr...
-         */
-        std::cerr << msgs.str() << std::endl; // LCOV_EXCL_LINE
-    }
+    // the zlib stream returns to the pool by itself
+    //
+    CodecPool::releaseBuffer(m_outvec);
+    CodecPool::releaseBuffer(m_invec);
 }
 
 
@@ -130,18 +131,34 @@ std::streambuf::int_type InflateInputStreambuf::underflow()
     }
 
     // Prepare _outvec and get array pointers
-    m_zs.avail_out = getBufferSize();
+    m_zs.avail_out = m_outvec.size();
     m_zs.next_out = reinterpret_cast<unsigned char *>(&m_outvec[0]);
 
     // Inflate until _outvec is full
     // eof (or I/O prob) on _inbuf will break out of loop too.
+    //
+    // When an index is being built, inflate() stops at the end of each
+    // block so we can create access points
+    //
+    int const flush(m_index != nullptr ? Z_BLOCK : Z_NO_FLUSH);
     int err(Z_OK);
     while(m_zs.avail_out > 0 && err == Z_OK)
     {
-        if(m_zs.avail_in == 0)
+        if(m_zs.avail_in == 0 && m_memory != nullptr)
+        {
+            // the input is in memory, give zlib the next block as is
+            // (avail_in is limited to 32 bits)
+            //
+            size_t const size(std::min(m_memory_size, static_cast<size_t>(std::numeric_limits<uInt>::max())));
+            m_zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(m_memory));
+            m_zs.avail_in = static_cast<uInt>(size);
+            m_memory += size;
+            m_memory_size -= size;
+        }
+        if(m_zs.avail_in == 0 && m_memory == nullptr)
         {
             // fill m_invec
-            std::streamsize const bc(m_inbuf->sgetn(&m_invec[0], getBufferSize()));
+            std::streamsize const bc(m_inbuf->sgetn(&m_invec[0], m_invec.size()));
             /** \FIXME
              * Add I/O error handling while inflating data from a file.
              */
@@ -153,14 +170,30 @@ std::streambuf::int_type InflateInputStreambuf::underflow()
             // where we cannot read more bytes here.
         }
 
-        err = inflate(&m_zs, Z_NO_FLUSH);
+        unsigned char const * const out(m_zs.next_out);
+        err = inflate(&m_zs, flush);
+
+        if(m_index != nullptr)
+        {
+            updateWindow(out, m_zs.next_out - out);
+
+            // at the end of a block which is not the last block?
+            //
+            if(err == Z_OK
+            && (m_zs.data_type & 128) != 0
+            && (m_zs.data_type & 64) == 0
+            && m_uncompressed_base + static_cast<offset_t>(m_zs.total_out) >= m_next_access_point)
+            {
+                addAccessPoint();
+            }
+        }
     }
 
     // Normally the number of inflated bytes will be the
     // full length of the output buffer, but if we can't read
     // more input from the _inbuf streambuf, we end up with
     // less.
-    offset_t const inflated_bytes = getBufferSize() - m_zs.avail_out;
+    offset_t const inflated_bytes = m_outvec.size() - m_zs.avail_out;
     setg(&m_outvec[0], &m_outvec[0], &m_outvec[0] + inflated_bytes);
 
     /** \FIXME
@@ -211,43 +244,341 @@ bool InflateInputStreambuf::reset(offset_t stream_position)
     {
         // reposition m_inbuf
         m_inbuf->pubseekpos(stream_position);
+        m_input_start = stream_position;
+    }
+    else
+    {
+        // remember where the data starts to be able to seek back
+        // (-1 if m_inbuf is not seekable)
+        //
+        m_input_start = m_inbuf->pubseekoff(0, std::ios::cur, std::ios::in);
     }
 
     // m_zs.next_in and avail_in must be set according to
     // zlib.h (inline doc).
     m_zs.next_in = reinterpret_cast<Bytef *>(&m_invec[0]);
     m_zs.avail_in = 0;
-
-    int err(Z_OK);
-    if(m_zs_initialized)
-    {
-        // just reset it
-        err = inflateReset(&m_zs);
-    }
-    else
-    {
-        // initialize it
-        err = inflateInit2(&m_zs, -MAX_WBITS);
-        /* windowBits is passed < 0 to tell that there is no zlib header.
-           Note that in this case inflate *requires* an extra "dummy" byte
-           after the compressed stream in order to complete decompression
-           and return Z_STREAM_END.  We always have an extra "dummy" byte,
-           because there is always some trailing data after the compressed
-           data (either the next entry or the central directory.  */
-        m_zs_initialized = true;
-    }
+    m_memory = nullptr;
+    m_memory_size = 0;
+    m_memory_start = nullptr;
+    m_memory_total = 0;
+    m_compressed_base = 0;
+    m_uncompressed_base = 0;
+    m_window_pos = 0;
+    m_window_size = 0;
+
+    // the stream from the pool is initialized with a windowBits < 0
+    // which means there is no zlib header. Note that in this case
+    // inflate *requires* an extra "dummy" byte after the compressed
+    // stream in order to complete decompression and return
+    // Z_STREAM_END. We always have an extra "dummy" byte, because there
+    // is always some trailing data after the compressed data (either
+    // the next entry or the central directory.)
+    //
+    int const err(inflateReset(&m_zs));
 
     // streambuf init:
     // The important thing here, is that
     // - the pointers are not NULL (which would mean unbuffered)
     // - and that gptr() is not less than egptr() (so we trigger underflow
     //   the first time data is read).
-    setg(&m_outvec[0], &m_outvec[0] + getBufferSize(), &m_outvec[0] + getBufferSize());
+    setg(&m_outvec[0], &m_outvec[0] + m_outvec.size(), &m_outvec[0] + m_outvec.size());
 
     return err == Z_OK;
 }
 
 
+/** \brief Read the compressed data directly from memory.
+ *
+ * This function tells the InflateInputStreambuf that the compressed
+ * data is available in memory, at \p data. The data is given to zlib
+ * as is instead of being copied to the input buffer first. The
+ * \p data buffer must remain valid until the end of the inflation.
+ *
+ * The input streambuf does not get used anymore until the next
+ * reset().
+ *
+ * \param[in] data  The compressed data.
+ * \param[in] size  The number of bytes available at \p data.
+ */
+void InflateInputStreambuf::setInput(char const * data, size_t size)
+{
+    m_memory = data;
+    m_memory_size = size;
+    m_memory_start = data;
+    m_memory_total = size;
+}
+
+
+/** \brief Use an index of access points.
+ *
+ * This function attaches an index to this InflateInputStreambuf. While
+ * the data gets inflated, access points are added to the index when
+ * the uncompressed position goes past the last access point plus the
+ * span of the index. The seekInflated() function then makes use of
+ * those access points to restart inflating close to the destination.
+ *
+ * The same index can be shared by all the streams reading the same
+ * data.
+ *
+ * \param[in] index  The index to use.
+ */
+void InflateInputStreambuf::setIndex(InflateIndex::pointer_t index)
+{
+    m_index = index;
+    if(m_index != nullptr)
+    {
+        m_next_access_point = m_index->nextAccessPoint();
+        m_window.resize(InflateIndex::WINDOW_SIZE);
+    }
+}
+
+
+/** \brief Get the current position in the inflated data.
+ *
+ * This function returns the position of the next byte to be read from
+ * this streambuf in the uncompressed data.
+ *
+ * \return The current position.
+ */
+offset_t InflateInputStreambuf::getInflatedPosition() const
+{
+    return m_uncompressed_base
+         + static_cast<offset_t>(m_zs.total_out)
+         - static_cast<offset_t>(egptr() - gptr());
+}
+
+
+/** \brief Get the input read past the end of the compressed data.
+ *
+ * The input is read in blocks so once the end of the compressed data
+ * is reached, the block may include data that follows it. This function
+ * returns those bytes, which zlib did not use. It is used when the
+ * input cannot seek back to the end of the compressed data.
+ *
+ * \return The input which was read but not inflated.
+ */
+std::string_view InflateInputStreambuf::getUnusedInput() const
+{
+    if(m_memory != nullptr)
+    {
+        return std::string_view();
+    }
+    return std::string_view(reinterpret_cast<char const *>(m_zs.next_in), m_zs.avail_in);
+}
+
+
+/** \brief Move to a position in the inflated data.
+ *
+ * This function changes the current position to \p position in the
+ * uncompressed data.
+ *
+ * If the position is in the current buffer, only the pointers change.
+ * Otherwise, the inflation restarts at the closest access point found
+ * in the index, or from the start of the data when going backward
+ * without an index, and the data gets inflated up to \p position.
+ *
+ * \param[in] position  The new position in the uncompressed data.
+ *
+ * \return true if the position could be reached.
+ */
+bool InflateInputStreambuf::seekInflated(offset_t position)
+{
+    offset_t const end_of_buffer(m_uncompressed_base + static_cast<offset_t>(m_zs.total_out));
+    offset_t const start_of_buffer(end_of_buffer - static_cast<offset_t>(egptr() - eback()));
+    if(position >= start_of_buffer
+    && position <= end_of_buffer)
+    {
+        setg(eback(), egptr() - (end_of_buffer - position), egptr());
+        return true;
+    }
+
+    InflateIndex::access_point_t::pointer_t point;
+    if(m_index != nullptr)
+    {
+        point = m_index->findAccessPoint(position);
+    }
+
+    offset_t const current(getInflatedPosition());
+    if(position < current
+    || (point != nullptr && point->m_uncompressed_offset > current))
+    {
+        if(!restart(point.get()))
+        {
+            return false;
+        }
+    }
+
+    return skip(position - getInflatedPosition());
+}
+
+
+/** \brief Restart the inflation at an access point.
+ *
+ * This function resets the zlib stream and restarts it at \p point or
+ * at the start of the data if \p point is nullptr.
+ *
+ * \param[in] point  The access point or nullptr.
+ *
+ * \return true if the restart succeeded.
+ */
+bool InflateInputStreambuf::restart(InflateIndex::access_point_t const * point)
+{
+    if(m_memory_start == nullptr
+    && m_input_start < 0)
+    {
+        // the input is not seekable
+        return false;
+    }
+
+    offset_t compressed(0);
+    int bits(0);
+    if(point != nullptr)
+    {
+        compressed = point->m_compressed_offset;
+        bits = point->m_bits;
+    }
+
+    // the partial byte is the one before the compressed offset
+    //
+    offset_t const pos(compressed - (bits != 0 ? 1 : 0));
+    if(m_memory_start != nullptr)
+    {
+        m_memory = m_memory_start + pos;
+        m_memory_size = m_memory_total - pos;
+    }
+    else
+    {
+        if(m_inbuf->pubseekpos(m_input_start + pos, std::ios::in) == std::streampos(-1))
+        {
+            return false;   // LCOV_EXCL_LINE
+        }
+    }
+    m_zs.next_in = reinterpret_cast<Bytef *>(&m_invec[0]);
+    m_zs.avail_in = 0;
+
+    if(inflateReset(&m_zs) != Z_OK)
+    {
+        return false;   // LCOV_EXCL_LINE
+    }
+
+    m_window_pos = 0;
+    m_window_size = 0;
+    if(point != nullptr)
+    {
+        if(bits != 0)
+        {
+            int c(0);
+            if(m_memory_start != nullptr)
+            {
+                c = static_cast<unsigned char>(*m_memory);
+                ++m_memory;
+                --m_memory_size;
+            }
+            else
+            {
+                c = m_inbuf->sbumpc();
+            }
+            inflatePrime(&m_zs, bits, c >> (8 - bits));
+        }
+        inflateSetDictionary(&m_zs, point->m_window.data(), point->m_window.size());
+        if(m_index != nullptr)
+        {
+            updateWindow(point->m_window.data(), point->m_window.size());
+        }
+    }
+
+    m_compressed_base = compressed;
+    m_uncompressed_base = point != nullptr ? point->m_uncompressed_offset : 0;
+
+    setg(&m_outvec[0], &m_outvec[0] + m_outvec.size(), &m_outvec[0] + m_outvec.size());
+
+    return true;
+}
+
+
+/** \brief Skip inflated data.
+ *
+ * This function inflates and ignores \p count bytes.
+ *
+ * \param[in] count  The number of bytes to skip.
+ *
+ * \return true if all the bytes were skipped, false if the end of the
+ *         data was reached first.
+ */
+bool InflateInputStreambuf::skip(offset_t count)
+{
+    while(count > 0)
+    {
+        if(gptr() >= egptr()
+        && traits_type::eq_int_type(underflow(), traits_type::eof()))
+        {
+            return false;
+        }
+        offset_t const available(std::min(count, static_cast<offset_t>(egptr() - gptr())));
+        gbump(static_cast<int>(available));
+        count -= available;
+    }
+
+    return true;
+}
+
+
+/** \brief Save the last inflated bytes.
+ *
+ * This function keeps the last 32Kb of inflated data, the deflate
+ * window, which has to be saved in each access point.
+ *
+ * \param[in] data  The newly inflated data.
+ * \param[in] size  The number of bytes at \p data.
+ */
+void InflateInputStreambuf::updateWindow(unsigned char const * data, size_t size)
+{
+    size_t const window_size(m_window.size());
+    if(size >= window_size)
+    {
+        data += size - window_size;
+        size = window_size;
+    }
+    while(size > 0)
+    {
+        size_t const n(std::min(size, window_size - m_window_pos));
+        memcpy(&m_window[m_window_pos], data, n);
+        data += n;
+        size -= n;
+        m_window_pos = (m_window_pos + n) % window_size;
+        m_window_size = std::min(m_window_size + n, window_size);
+    }
+}
+
+
+/** \brief Add an access point at the current position.
+ *
+ * This function creates an access point at the current position, which
+ * is expected to be the end of a deflate block, and adds it to the
+ * index.
+ */
+void InflateInputStreambuf::addAccessPoint()
+{
+    std::shared_ptr<InflateIndex::access_point_t> point(std::make_shared<InflateIndex::access_point_t>());
+    point->m_uncompressed_offset = m_uncompressed_base + static_cast<offset_t>(m_zs.total_out);
+    point->m_compressed_offset = m_compressed_base + static_cast<offset_t>(m_zs.total_in);
+    point->m_bits = m_zs.data_type & 7;
+
+    // save the window in order
+    //
+    point->m_window.reserve(m_window_size);
+    if(m_window_size == m_window.size())
+    {
+        point->m_window.insert(point->m_window.end(), m_window.begin() + m_window_pos, m_window.end());
+    }
+    point->m_window.insert(point->m_window.end(), m_window.begin(), m_window.begin() + m_window_pos);
+
+    m_index->addAccessPoint(point);
+    m_next_access_point = m_index->nextAccessPoint();
+}
+
+
 } // zipios namespace
 
 // Local Variables:
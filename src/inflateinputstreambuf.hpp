@@ -31,14 +31,16 @@
  * class and which may be compressed using the zlib library.
  */
 
+#include "codecpool.hpp"
 #include "filterinputstreambuf.hpp"
+#include "inflateindex.hpp"
+#include "zlibbackend.hpp"
 
 #include "zipios/zipios-config.hpp"
 
+#include <string_view>
 #include <vector>
 
-#include <zlib.h>
-
 
 namespace zipios
 {
@@ -47,7 +49,7 @@ namespace zipios
 class InflateInputStreambuf : public FilterInputStreambuf
 {
 public:
-                            InflateInputStreambuf(std::streambuf * inbuf, offset_t s_pos = -1);
+                            InflateInputStreambuf(std::streambuf * inbuf, offset_t s_pos = -1, size_t buffer_size = getBufferSize());
                             InflateInputStreambuf(InflateInputStreambuf const & rhs) = delete;
     virtual                 ~InflateInputStreambuf();
 
@@ -57,16 +59,40 @@ public:
 
 protected:
     virtual std::streambuf::int_type             underflow() override;
+    void                    setInput(char const * data, size_t size);
+    void                    setIndex(InflateIndex::pointer_t index);
+    offset_t                getInflatedPosition() const;
+    std::string_view        getUnusedInput() const;
+    bool                    seekInflated(offset_t position);
 
     /** \FIXME Consider design?
      */
     std::vector<char>       m_outvec = std::vector<char>();
 
 private:
-    std::vector<char>       m_invec = std::vector<char>();
+    bool                    restart(InflateIndex::access_point_t const * point);
+    bool                    skip(offset_t count);
+    void                    updateWindow(unsigned char const * data, size_t size);
+    void                    addAccessPoint();
 
-    z_stream                m_zs = z_stream();
-    bool                    m_zs_initialized = false;
+    std::vector<char>       m_invec = std::vector<char>();
+    char const *            m_memory = nullptr;
+    size_t                  m_memory_size = 0;
+    char const *            m_memory_start = nullptr;
+    size_t                  m_memory_total = 0;
+    offset_t                m_input_start = -1;
+    offset_t                m_compressed_base = 0;
+    offset_t                m_uncompressed_base = 0;
+
+    InflateIndex::pointer_t m_index = InflateIndex::pointer_t();
+    offset_t                m_next_access_point = 0;
+    std::vector<char>       m_window = std::vector<char>();
+    size_t                  m_window_pos = 0;
+    size_t                  m_window_size = 0;
+
+    CodecPool::stream_pointer_t
+                            m_stream;
+    z_stream &              m_zs;
 };
 
 
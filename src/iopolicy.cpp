@@ -0,0 +1,144 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::IOPolicy.
+ *
+ * This file implements the accessors of the IOPolicy class.
+ */
+
+#include "zipios/iopolicy.hpp"
+
+#include <algorithm>
+
+
+namespace zipios
+{
+
+
+/** \class IOPolicy
+ * \brief The buffer sizes used to read and write archives.
+ *
+ * By default the streams of the library read and write data in chunks
+ * of getBufferSize() bytes (BUFSIZ). This is small for fast disks and
+ * for network file systems where each read or write call has a high
+ * cost. The IOPolicy lets you choose the size of the buffers of the
+ * input and output streams and how much data the operating system
+ * should read ahead of the current position.
+ *
+ * A policy can be given to ZipFile (see ZipFile::OpenOptions),
+ * ZipFile::saveCollectionToArchive() (see ZipFile::SaveOptions),
+ * the ZipOutputStream, and the GZIPOutputStream.
+ */
+
+
+/** \brief Retrieve the size of the input buffers.
+ *
+ * This function returns the size of the buffers used by the streams
+ * reading the entries of an archive. It is also the size of each read
+ * from the archive file.
+ *
+ * \return The size of the input buffers in bytes.
+ */
+size_t IOPolicy::getInputBufferSize() const
+{
+    return m_input_buffer_size;
+}
+
+
+/** \brief Change the size of the input buffers.
+ *
+ * This function sets the size of the buffers used to read the entries.
+ * The minimum is 1 byte. The default is getBufferSize().
+ *
+ * \param[in] size  The new size in bytes.
+ */
+void IOPolicy::setInputBufferSize(size_t size)
+{
+    m_input_buffer_size = std::max(size, static_cast<size_t>(1));
+}
+
+
+/** \brief Retrieve the size of the output buffers.
+ *
+ * This function returns the size of the buffers used by the streams
+ * writing archives. It is also the size of each write to the output.
+ *
+ * \return The size of the output buffers in bytes.
+ */
+size_t IOPolicy::getOutputBufferSize() const
+{
+    return m_output_buffer_size;
+}
+
+
+/** \brief Change the size of the output buffers.
+ *
+ * This function sets the size of the buffers used to compress and
+ * write data. The minimum is 1 byte. The default is getBufferSize().
+ *
+ * \param[in] size  The new size in bytes.
+ */
+void IOPolicy::setOutputBufferSize(size_t size)
+{
+    m_output_buffer_size = std::max(size, static_cast<size_t>(1));
+}
+
+
+/** \brief Retrieve the read-ahead size.
+ *
+ * This function returns the number of bytes the operating system is
+ * asked to read ahead of the position of a stream reading an entry.
+ * By default it is 0, meaning the operating system decides.
+ *
+ * \return The read-ahead size in bytes.
+ */
+size_t IOPolicy::getReadAhead() const
+{
+    return m_read_ahead;
+}
+
+
+/** \brief Change the read-ahead size.
+ *
+ * When not zero, the streams reading entries from a ZipFile tell the
+ * operating system that the next \p size bytes of the entry will be
+ * needed soon (posix_fadvise() or madvise() with WILLNEED) so it can
+ * load them while the current data gets processed. This is mostly
+ * useful on network file systems.
+ *
+ * \param[in] size  The read-ahead size in bytes or 0.
+ */
+void IOPolicy::setReadAhead(size_t size)
+{
+    m_read_ahead = size;
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
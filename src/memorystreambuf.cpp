@@ -0,0 +1,171 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::MemoryStreambuf.
+ *
+ * This file implements a read-only streambuf over a block of memory.
+ */
+
+#include "memorystreambuf.hpp"
+
+
+namespace zipios
+{
+
+
+/** \class MemoryStreambuf
+ * \brief A read-only streambuf over a block of memory.
+ *
+ * This streambuf gives access to a block of memory, such as a memory
+ * mapped file, without copying it. The get area is the block itself
+ * so reading from an std::istream using this streambuf is a plain
+ * memory access.
+ *
+ * The streambuf does not own the memory. It must remain valid for as
+ * long as the streambuf is in use.
+ */
+
+
+/** \brief Initialize the streambuf.
+ *
+ * This constructor sets the get area to the \p size bytes at \p data.
+ *
+ * \param[in] data  The memory block.
+ * \param[in] size  The size of the memory block.
+ */
+MemoryStreambuf::MemoryStreambuf(char const * data, size_t size)
+{
+    // the get area is never written to
+    //
+    char * ptr(const_cast<char *>(data));
+    setg(ptr, ptr, ptr + size);
+}
+
+
+/** \brief Clean up the streambuf.
+ *
+ * The memory block does not belong to the streambuf so the destructor
+ * has nothing to do.
+ */
+MemoryStreambuf::~MemoryStreambuf()
+{
+}
+
+
+/** \brief Retrieve a pointer to the current position.
+ *
+ * This function returns a pointer to the next byte to be read.
+ *
+ * \return The pointer to the current position.
+ */
+char const * MemoryStreambuf::current() const
+{
+    return gptr();
+}
+
+
+/** \brief Retrieve the number of bytes left.
+ *
+ * This function returns the number of bytes between the current
+ * position and the end of the memory block.
+ *
+ * \return The number of bytes left to read.
+ */
+size_t MemoryStreambuf::remaining() const
+{
+    return egptr() - gptr();
+}
+
+
+/** \brief Change the current position.
+ *
+ * This function moves the current position by \p off bytes relative
+ * to the start, the current position, or the end of the block.
+ *
+ * \param[in] off  The offset to move by.
+ * \param[in] dir  The position \p off is relative to.
+ * \param[in] which  Only std::ios_base::in is supported.
+ *
+ * \return The new position or -1 if the position is out of bounds.
+ */
+MemoryStreambuf::pos_type MemoryStreambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if((which & std::ios_base::in) == 0)
+    {
+        return pos_type(off_type(-1));
+    }
+
+    off_type base(0);
+    switch(dir)
+    {
+    case std::ios_base::beg:
+        break;
+
+    case std::ios_base::cur:
+        base = gptr() - eback();
+        break;
+
+    case std::ios_base::end:
+        base = egptr() - eback();
+        break;
+
+    default: // LCOV_EXCL_LINE
+        return pos_type(off_type(-1)); // LCOV_EXCL_LINE
+
+    }
+
+    off_type const pos(base + off);
+    if(pos < 0 || pos > egptr() - eback())
+    {
+        return pos_type(off_type(-1));
+    }
+
+    setg(eback(), eback() + pos, egptr());
+    return pos_type(pos);
+}
+
+
+/** \brief Change the current position.
+ *
+ * This function moves the current position to \p pos bytes from the
+ * start of the block.
+ *
+ * \param[in] pos  The new position.
+ * \param[in] which  Only std::ios_base::in is supported.
+ *
+ * \return The new position or -1 if the position is out of bounds.
+ */
+MemoryStreambuf::pos_type MemoryStreambuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef ZIPIOS_MEMORYSTREAMBUF_HPP
+#define ZIPIOS_MEMORYSTREAMBUF_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Header file that defines zipios::MemoryStreambuf.
+ */
+
+#include "zipios/zipios-config.hpp"
+
+#include <iostream>
+
+
+namespace zipios
+{
+
+
+class MemoryStreambuf : public std::streambuf
+{
+public:
+                                MemoryStreambuf(char const * data, size_t size);
+                                MemoryStreambuf(MemoryStreambuf const & rhs) = delete;
+    virtual                     ~MemoryStreambuf() override;
+
+    MemoryStreambuf &           operator = (MemoryStreambuf const & rhs) = delete;
+
+    char const *                current() const;
+    size_t                      remaining() const;
+
+protected:
+    virtual pos_type            seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in) override;
+    virtual pos_type            seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override;
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
@@ -0,0 +1,144 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief The implementation file of zipios::NameIndex.
+ *
+ * This class implements the hash index used to search entries by name.
+ */
+
+#include "nameindex.hpp"
+
+#include <iterator>
+
+
+namespace zipios
+{
+
+
+/** \class NameIndex
+ * \brief Hash index of entry names.
+ *
+ * The NameIndex is used to search entries by full name
+ * (MatchPath::MATCH) or by basename (MatchPath::IGNORE) without
+ * having to go through all the entries.
+ *
+ * The index maps names to the position of the entries in the
+ * collection. The names are saved as std::string_view objects; the
+ * owner of the index is responsible for keeping the strings alive
+ * for as long as the index is used.
+ */
+
+
+/** \brief Remove all the names from the index.
+ *
+ * This function clears the index.
+ */
+void NameIndex::clear()
+{
+    m_name_index.clear();
+    m_filename_index.clear();
+}
+
+
+/** \brief Prepare the index for \p count entries.
+ *
+ * This function reserves space for a total of \p count entries.
+ *
+ * \param[in] count  The total number of entries expected in the index.
+ */
+void NameIndex::reserve(size_t count)
+{
+    m_name_index.reserve(count);
+    m_filename_index.reserve(count);
+}
+
+
+/** \brief Add an entry to the index.
+ *
+ * This function adds the entry at position \p idx to the index.
+ *
+ * When two entries have the same full name, the first one added is
+ * kept, which is the one a linear search would find first.
+ *
+ * \param[in] name  The full name of the entry.
+ * \param[in] filename  The basename of the entry.
+ * \param[in] idx  The position of the entry in the collection.
+ */
+void NameIndex::add(std::string_view name, std::string_view filename, size_t idx)
+{
+    m_name_index.emplace(name, idx);    // no-op on duplicates
+    m_filename_index.emplace(filename, idx);
+}
+
+
+/** \brief Search for an entry.
+ *
+ * This function returns the position of the first entry named \p name.
+ *
+ * \param[in] name  The name of the entry to search.
+ * \param[in] matchpath  Whether \p name is a full name (MatchPath::MATCH)
+ *                       or a basename (MatchPath::IGNORE).
+ *
+ * \return The position of the entry or FileCollection::g_no_entry.
+ */
+size_t NameIndex::find(std::string_view name, FileCollection::MatchPath matchpath) const
+{
+    if(matchpath == FileCollection::MatchPath::MATCH)
+    {
+        auto const it(m_name_index.find(name));
+        if(it != m_name_index.end())
+        {
+            return it->second;
+        }
+        return FileCollection::g_no_entry;
+    }
+
+    // the multimap does not keep the items in insertion order so
+    // we have to search for the smallest index to return the first
+    // entry with that basename
+    //
+    auto const range(m_filename_index.equal_range(name));
+    if(range.first == range.second)
+    {
+        return FileCollection::g_no_entry;
+    }
+    size_t idx(range.first->second);
+    for(auto it(std::next(range.first)); it != range.second; ++it)
+    {
+        if(it->second < idx)
+        {
+            idx = it->second;
+        }
+    }
+    return idx;
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,68 @@
+#pragma once
+#ifndef ZIPIOS_NAMEINDEX_HPP
+#define ZIPIOS_NAMEINDEX_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief The header file for zipios::NameIndex.
+ *
+ * The zipios::NameIndex class is used to search entries by name.
+ */
+
+#include "zipios/filecollection.hpp"
+
+#include <string_view>
+#include <unordered_map>
+
+
+namespace zipios
+{
+
+
+class NameIndex
+{
+public:
+    void                    clear();
+    void                    reserve(size_t count);
+    void                    add(std::string_view name, std::string_view filename, size_t idx);
+    size_t                  find(std::string_view name, FileCollection::MatchPath matchpath) const;
+
+private:
+    typedef std::unordered_map<std::string_view, size_t>        name_index_t;
+    typedef std::unordered_multimap<std::string_view, size_t>   filename_index_t;
+
+    name_index_t            m_name_index = name_index_t();
+    filename_index_t        m_filename_index = filename_index_t();
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
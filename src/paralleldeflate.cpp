@@ -0,0 +1,474 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::ParallelDeflate.
+ *
+ * This file implements the block compressor used to deflate one large
+ * stream with several threads.
+ */
+
+#include "paralleldeflate.hpp"
+
+#include "zipios/zipiosexceptions.hpp"
+
+#include "crc32.hpp"
+
+#include <algorithm>
+
+
+namespace zipios
+{
+
+
+/** \class ParallelDeflate
+ * \brief Deflate one stream in blocks compressed by worker threads.
+ *
+ * The ParallelDeflate class cuts its input in blocks of a fixed size
+ * and deflates each block separately, the way pigz does. Each block
+ * gets the last 32Kb of the data preceding it as its dictionary so the
+ * compression ratio is nearly the same as with a single stream. All the
+ * blocks but the last end with a sync flush which aligns them on a byte
+ * boundary and does not mark them as final. The blocks can therefore
+ * be concatenated in order and the result is one standard raw deflate
+ * stream that any inflater can read.
+ *
+ * The CRC-32 of each block is computed by the thread compressing it
+ * and the results are merged with combineCRC32().
+ *
+ * With one thread the blocks are compressed by the calling thread.
+ * With more threads, worker threads get started when the second block
+ * begins and the writer never has more than two blocks per thread in
+ * memory. Whatever the number of threads, the output only depends on
+ * the block size. When the whole input fits in a single block, the
+ * output is the same as the one of a plain deflate stream.
+ */
+
+
+/** \typedef ParallelDeflate::pointer_t
+ * \brief A pointer to a ParallelDeflate object.
+ */
+
+
+/** \var ParallelDeflate::DICTIONARY_SIZE
+ * \brief The size of the dictionary passed to the next block.
+ *
+ * Deflate can reference up to 32Kb of previous data. The last 32Kb of
+ * data of a block are given to the next block as its dictionary.
+ */
+
+
+/** \struct ParallelDeflate::block_t
+ * \brief One block of input and the corresponding deflated data.
+ *
+ * The m_output, m_crc32, and m_exception fields get set by the thread
+ * compressing the block, which then sets m_done to true.
+ */
+
+
+/** \brief Initialize a ParallelDeflate object.
+ *
+ * The deflated data gets written to \p outbuf, in order, as the blocks
+ * get compressed.
+ *
+ * \param[in] outbuf  The buffer receiving the deflated data.
+ * \param[in] level  The zlib compression level.
+ * \param[in] block_size  The size of the blocks of input.
+ * \param[in] threads  The number of threads used to compress the blocks.
+ */
+ParallelDeflate::ParallelDeflate(std::streambuf * outbuf, int level, size_t block_size, size_t threads)
+    : m_outbuf(outbuf)
+    , m_level(level)
+    , m_block_size(std::max(block_size, static_cast<size_t>(1)))
+    , m_threads(std::max(threads, static_cast<size_t>(1)))
+{
+    m_input.reserve(m_block_size);
+}
+
+
+/** \brief Stop the worker threads.
+ *
+ * The destructor stops the worker threads, which may still be running
+ * if the writer failed, and waits for them. Data which was not yet
+ * passed to finish() is lost.
+ */
+ParallelDeflate::~ParallelDeflate()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    for(auto & t : m_workers)
+    {
+        t.join();
+    }
+
+    if(m_zs_initialized)
+    {
+        deflateEnd(&m_zs);
+    }
+}
+
+
+/** \brief Add data to the stream.
+ *
+ * The data gets appended to the current block. Full blocks are
+ * compressed and written to the output.
+ *
+ * \exception IOException
+ * This exception is raised if the compression or the write fails.
+ *
+ * \param[in] buffer  The data to compress.
+ * \param[in] size  The number of bytes in \p buffer.
+ */
+void ParallelDeflate::write(char const * buffer, size_t size)
+{
+    m_size += size;
+    while(size > 0)
+    {
+        // a full block is only sent once more data comes in so the
+        // last block is never empty
+        //
+        if(m_input.size() >= m_block_size)
+        {
+            submit(false);
+        }
+
+        size_t const len(std::min(size, m_block_size - m_input.size()));
+        m_input.insert(m_input.end(), buffer, buffer + len);
+        buffer += len;
+        size -= len;
+    }
+}
+
+
+/** \brief End the stream.
+ *
+ * This function compresses the last block and waits until all the
+ * deflated data was written to the output. If no data was written
+ * to the stream, nothing gets output.
+ *
+ * \exception IOException
+ * This exception is raised if the compression or the write fails.
+ */
+void ParallelDeflate::finish()
+{
+    if(m_finished)
+    {
+        return;
+    }
+    m_finished = true;
+
+    if(m_size > 0)
+    {
+        submit(true);
+    }
+    writeBlocks(0);
+}
+
+
+/** \brief Retrieve the CRC-32 of the data.
+ *
+ * The CRC-32 only includes the blocks written so far. Once finish()
+ * returned, it is the CRC-32 of the whole stream.
+ *
+ * \return The CRC-32 of the data.
+ */
+uint32_t ParallelDeflate::getCrc32() const
+{
+    return m_crc32;
+}
+
+
+/** \brief Retrieve the number of bytes written to the stream.
+ *
+ * \return The size of the uncompressed data.
+ */
+offset_t ParallelDeflate::getSize() const
+{
+    return m_size;
+}
+
+
+/** \brief Send the current block to be compressed.
+ *
+ * The current block gets compressed by the calling thread when only
+ * one thread is used or when it is the only block of the stream.
+ * Otherwise it is queued for the worker threads, which get started
+ * the first time.
+ *
+ * \param[in] last  Whether this is the last block of the stream.
+ */
+void ParallelDeflate::submit(bool last)
+{
+    block_t::pointer_t block(std::make_shared<block_t>());
+    block->m_input.swap(m_input);
+    block->m_dictionary = m_dictionary;
+    block->m_last = last;
+
+    if(!last)
+    {
+        // the next block uses the last 32Kb of data as its dictionary
+        //
+        m_dictionary.insert(m_dictionary.end(), block->m_input.begin(), block->m_input.end());
+        if(m_dictionary.size() > DICTIONARY_SIZE)
+        {
+            m_dictionary.erase(m_dictionary.begin(), m_dictionary.end() - DICTIONARY_SIZE);
+        }
+        m_input.reserve(m_block_size);
+    }
+
+    if(m_threads == 1
+    || (last && m_workers.empty()))
+    {
+        if(!m_zs_initialized)
+        {
+            initStream(m_zs);
+            m_zs_initialized = true;
+        }
+        compress(*block, m_zs);
+        block->m_done = true;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_blocks.push_back(block);
+        }
+        writeBlocks(0);
+        return;
+    }
+
+    if(m_workers.empty())
+    {
+        for(size_t t(0); t < m_threads; ++t)
+        {
+            m_workers.emplace_back(&ParallelDeflate::run, this);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_blocks.push_back(block);
+        m_queue.push_back(block);
+    }
+    m_condition.notify_all();
+
+    writeBlocks(last ? 0 : m_threads * 2 - 1);
+}
+
+
+/** \brief Write the blocks which were compressed.
+ *
+ * This function writes the compressed blocks to the output in order.
+ * It waits for the blocks to be compressed until no more than \p keep
+ * blocks remain in memory.
+ *
+ * \exception std::exception
+ * Any exception raised while compressing a block is rethrown here.
+ *
+ * \param[in] keep  The number of blocks which can remain in memory.
+ */
+void ParallelDeflate::writeBlocks(size_t keep)
+{
+    for(;;)
+    {
+        block_t::pointer_t block;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if(m_blocks.empty())
+            {
+                return;
+            }
+            if(!m_blocks.front()->m_done)
+            {
+                if(m_blocks.size() <= keep)
+                {
+                    return;
+                }
+                m_condition.wait(lock, [this]() { return m_blocks.front()->m_done; });
+            }
+            block = m_blocks.front();
+            m_blocks.pop_front();
+        }
+
+        if(block->m_exception != nullptr)
+        {
+            std::rethrow_exception(block->m_exception);
+        }
+
+        m_crc32 = combineCRC32(m_crc32, block->m_crc32, block->m_input.size());
+
+        std::streamsize const size(block->m_output.size());
+        if(m_outbuf->sputn(block->m_output.data(), size) != size)
+        {
+            throw IOException("ParallelDeflate::writeBlocks(): write to buffer failed."); // LCOV_EXCL_LINE
+        }
+    }
+}
+
+
+/** \brief Compress one block.
+ *
+ * This function deflates the input of \p block with \p zs. The last
+ * block is finished. The other blocks end with a sync flush so the
+ * next block starts on a byte boundary.
+ *
+ * \exception IOException
+ * This exception is raised if zlib fails compressing the block.
+ *
+ * \param[in,out] block  The block to compress.
+ * \param[in,out] zs  The zlib stream to use, initialized with initStream().
+ */
+void ParallelDeflate::compress(block_t & block, z_stream & zs)
+{
+    int err(deflateReset(&zs));
+    if(err == Z_OK
+    && !block.m_dictionary.empty())
+    {
+        err = deflateSetDictionary(
+                      &zs
+                    , reinterpret_cast<Bytef const *>(block.m_dictionary.data())
+                    , block.m_dictionary.size());
+    }
+    if(err != Z_OK)
+    {
+        OutputStringStream msgs; // LCOV_EXCL_LINE
+        msgs << "ParallelDeflate::compress(): could not prepare the block: " << zError(err); // LCOV_EXCL_LINE
+        throw IOException(msgs.str()); // LCOV_EXCL_LINE
+    }
+
+    block.m_crc32 = updateCRC32(0, block.m_input.data(), block.m_input.size());
+
+    zs.next_in = reinterpret_cast<Bytef *>(block.m_input.data());
+    zs.avail_in = block.m_input.size();
+
+    // the bound does not include the sync flush marker
+    //
+    block.m_output.resize(deflateBound(&zs, block.m_input.size()) + 16);
+    size_t used(0);
+    int const flush(block.m_last ? Z_FINISH : Z_SYNC_FLUSH);
+    for(;;)
+    {
+        zs.next_out = reinterpret_cast<Bytef *>(block.m_output.data() + used);
+        zs.avail_out = block.m_output.size() - used;
+        err = deflate(&zs, flush);
+        used = block.m_output.size() - zs.avail_out;
+        if(block.m_last ? err == Z_STREAM_END : err == Z_OK && zs.avail_out > 0)
+        {
+            break;
+        }
+        if(err != Z_OK
+        && err != Z_BUF_ERROR)
+        {
+            OutputStringStream msgs; // LCOV_EXCL_LINE
+            msgs << "ParallelDeflate::compress(): deflate() failed: " << zError(err); // LCOV_EXCL_LINE
+            throw IOException(msgs.str()); // LCOV_EXCL_LINE
+        }
+        block.m_output.resize(block.m_output.size() * 2); // LCOV_EXCL_LINE
+    }
+    block.m_output.resize(used);
+}
+
+
+/** \brief Initialize a zlib stream.
+ *
+ * The streams generate raw deflate data, without the zlib header,
+ * with the same parameters as the DeflateOutputStreambuf.
+ *
+ * \exception IOException
+ * This exception is raised if zlib cannot be initialized.
+ *
+ * \param[out] zs  The zlib stream to initialize.
+ */
+void ParallelDeflate::initStream(z_stream & zs)
+{
+    int const default_mem_level(8);
+
+    zs = z_stream();
+    int const err(deflateInit2(&zs, m_level, Z_DEFLATED, -MAX_WBITS, default_mem_level, Z_DEFAULT_STRATEGY));
+    if(err != Z_OK)
+    {
+        OutputStringStream msgs; // LCOV_EXCL_LINE
+        msgs << "ParallelDeflate::initStream(): error while initializing zlib, " << zError(err); // LCOV_EXCL_LINE
+        throw IOException(msgs.str()); // LCOV_EXCL_LINE
+    }
+}
+
+
+/** \brief Compress blocks until stopped.
+ *
+ * This function is the main loop of a worker thread. Each worker has
+ * its own zlib stream which it resets for each block.
+ */
+void ParallelDeflate::run()
+{
+    z_stream zs = z_stream();
+    bool zs_initialized(false);
+    for(;;)
+    {
+        block_t::pointer_t block;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+            if(m_stop)
+            {
+                break;
+            }
+            block = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        try
+        {
+            if(!zs_initialized)
+            {
+                initStream(zs);
+                zs_initialized = true;
+            }
+            compress(*block, zs);
+        }
+        catch(...)
+        {
+            block->m_exception = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            block->m_done = true;
+        }
+        m_condition.notify_all();
+    }
+
+    if(zs_initialized)
+    {
+        deflateEnd(&zs);
+    }
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
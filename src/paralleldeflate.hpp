@@ -0,0 +1,119 @@
+#pragma once
+#ifndef ZIPIOS_PARALLELDEFLATE_HPP
+#define ZIPIOS_PARALLELDEFLATE_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Header file that defines zipios::ParallelDeflate.
+ *
+ * The zipios::ParallelDeflate class compresses one stream of data
+ * in blocks, possibly using several threads.
+ */
+
+#include "zipios_common.hpp"
+#include "zlibbackend.hpp"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <thread>
+
+
+namespace zipios
+{
+
+
+class ParallelDeflate
+{
+public:
+    typedef std::unique_ptr<ParallelDeflate>    pointer_t;
+
+    // the size of the dictionary passed from one block to the next
+    static size_t const     DICTIONARY_SIZE = 32768;
+
+                            ParallelDeflate(std::streambuf * outbuf, int level, size_t block_size, size_t threads);
+                            ParallelDeflate(ParallelDeflate const & rhs) = delete;
+                            ~ParallelDeflate();
+
+    ParallelDeflate &       operator = (ParallelDeflate const & rhs) = delete;
+
+    void                    write(char const * buffer, size_t size);
+    void                    finish();
+    uint32_t                getCrc32() const;
+    offset_t                getSize() const;
+
+private:
+    struct block_t
+    {
+        typedef std::shared_ptr<block_t>    pointer_t;
+
+        std::vector<char>   m_input = std::vector<char>();
+        std::vector<char>   m_dictionary = std::vector<char>();
+        bool                m_last = false;
+        std::vector<char>   m_output = std::vector<char>();
+        uint32_t            m_crc32 = 0;
+        bool                m_done = false;
+        std::exception_ptr  m_exception = std::exception_ptr();
+    };
+
+    void                    submit(bool last);
+    void                    writeBlocks(size_t keep);
+    void                    compress(block_t & block, z_stream & zs);
+    void                    initStream(z_stream & zs);
+    void                    run();
+
+    std::streambuf *        m_outbuf = nullptr;
+    int const               m_level;
+    size_t const            m_block_size;
+    size_t const            m_threads;
+    std::vector<char>       m_input = std::vector<char>();
+    std::vector<char>       m_dictionary = std::vector<char>();
+    uint32_t                m_crc32 = 0;
+    offset_t                m_size = 0;
+    bool                    m_finished = false;
+    z_stream                m_zs = z_stream();
+    bool                    m_zs_initialized = false;
+    std::mutex              m_mutex = std::mutex();
+    std::condition_variable m_condition = std::condition_variable();
+    std::deque<block_t::pointer_t>
+                            m_blocks = std::deque<block_t::pointer_t>();
+    std::deque<block_t::pointer_t>
+                            m_queue = std::deque<block_t::pointer_t>();
+    bool                    m_stop = false;
+    std::vector<std::thread>
+                            m_workers = std::vector<std::thread>();
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
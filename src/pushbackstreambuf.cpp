@@ -0,0 +1,160 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::PushbackStreambuf.
+ *
+ * This file implements an input streambuf filter which accepts data
+ * back once it was read.
+ */
+
+#include "pushbackstreambuf.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace zipios
+{
+
+
+/** \class PushbackStreambuf
+ * \brief An input streambuf filter which can be given data back.
+ *
+ * The decompressors read their input in blocks so, once the compressed
+ * data of an entry ends, the start of what follows may already be in
+ * their buffers. When the input cannot seek, such as a pipe or a socket,
+ * those bytes are given back with pushback() and are then read again
+ * before any new data.
+ *
+ * The streambuf also counts the bytes read so the position in the input
+ * is known even though it cannot seek.
+ */
+
+
+/** \brief Initialize the streambuf.
+ *
+ * \param[in] inbuf  The streambuf to read the data from.
+ * \param[in] buffer_size  The size of the reads from \p inbuf.
+ */
+PushbackStreambuf::PushbackStreambuf(std::streambuf * inbuf, size_t buffer_size)
+    : FilterInputStreambuf(inbuf)
+    , m_buffer_size(std::max(buffer_size, static_cast<size_t>(1)))
+{
+    setg(nullptr, nullptr, nullptr);
+}
+
+
+/** \brief Clean up the streambuf.
+ *
+ * The streambuf does not own the input streambuf so there is nothing
+ * to do here.
+ */
+PushbackStreambuf::~PushbackStreambuf()
+{
+}
+
+
+/** \brief Give data back to the streambuf.
+ *
+ * The \p size bytes at \p data are returned by the next reads, before
+ * the data not read yet. They are expected to be the last \p size bytes
+ * read from this streambuf.
+ *
+ * \param[in] data  The bytes to give back.
+ * \param[in] size  The number of bytes to give back.
+ */
+void PushbackStreambuf::pushback(char const * data, size_t size)
+{
+    if(size == 0)
+    {
+        return;
+    }
+
+    if(static_cast<size_t>(gptr() - eback()) >= size)
+    {
+        // the bytes are still right before the read position
+        //
+        gbump(-static_cast<int>(size));
+        std::memmove(gptr(), data, size);
+        return;
+    }
+
+    std::vector<char> buffer(size + (egptr() - gptr()));
+    std::memcpy(buffer.data(), data, size);
+    if(egptr() != gptr())
+    {
+        std::memcpy(buffer.data() + size, gptr(), egptr() - gptr());
+    }
+    m_buffer.swap(buffer);
+    setg(m_buffer.data(), m_buffer.data(), m_buffer.data() + m_buffer.size());
+}
+
+
+/** \brief Retrieve the position in the input.
+ *
+ * This function returns the number of bytes read from this streambuf
+ * minus the bytes given back.
+ *
+ * \return The current position.
+ */
+offset_t PushbackStreambuf::getPosition() const
+{
+    return m_read - (egptr() - gptr());
+}
+
+
+/** \brief Read more data.
+ *
+ * This function reads the next block of data from the input streambuf.
+ *
+ * \return The next character or EOF.
+ */
+PushbackStreambuf::int_type PushbackStreambuf::underflow()
+{
+    if(gptr() < egptr())
+    {
+        return traits_type::to_int_type(*gptr()); // LCOV_EXCL_LINE
+    }
+
+    m_buffer.resize(m_buffer_size);
+    std::streamsize const g(m_inbuf->sgetn(m_buffer.data(), m_buffer.size()));
+    if(g <= 0)
+    {
+        setg(nullptr, nullptr, nullptr);
+        return traits_type::eof();
+    }
+    m_read += g;
+    setg(m_buffer.data(), m_buffer.data(), m_buffer.data() + g);
+
+    return traits_type::to_int_type(*gptr());
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,72 @@
+#pragma once
+#ifndef ZIPIOS_PUSHBACKSTREAMBUF_HPP
+#define ZIPIOS_PUSHBACKSTREAMBUF_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Header file that defines zipios::PushbackStreambuf.
+ */
+
+#include "filterinputstreambuf.hpp"
+
+#include "zipios/zipios-config.hpp"
+
+#include <vector>
+
+
+namespace zipios
+{
+
+
+class PushbackStreambuf : public FilterInputStreambuf
+{
+public:
+                                PushbackStreambuf(std::streambuf * inbuf, size_t buffer_size = getBufferSize());
+                                PushbackStreambuf(PushbackStreambuf const & rhs) = delete;
+    virtual                     ~PushbackStreambuf() override;
+
+    PushbackStreambuf &         operator = (PushbackStreambuf const & rhs) = delete;
+
+    void                        pushback(char const * data, size_t size);
+    offset_t                    getPosition() const;
+
+protected:
+    virtual int_type            underflow() override;
+
+private:
+    std::vector<char>           m_buffer = std::vector<char>();
+    size_t                      m_buffer_size = 0;
+    offset_t                    m_read = 0;
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
@@ -0,0 +1,328 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief The implementation file of zipios::RandomAccessFile.
+ *
+ * This class implements positional reads (i.e. pread()) on a file.
+ */
+
+#include "randomaccessfile.hpp"
+
+#include "zipios/zipiosexceptions.hpp"
+
+#include <algorithm>
+
+#include <errno.h>
+#include <fcntl.h>
+
+#include <string.h>
+
+#ifdef ZIPIOS_WINDOWS
+#include <io.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+namespace zipios
+{
+
+
+/** \class RandomAccessFile
+ * \brief Read a file at any position.
+ *
+ * A RandomAccessFile opens a file once and then gives access to any
+ * part of it with the read() functions. The read() functions take the
+ * position where the data has to be read from and do not change any
+ * shared state (on POSIX systems they make use of pread()) so one
+ * RandomAccessFile can be used by many threads simultaneously.
+ *
+ * This is used by the ZipFile to verify the local headers of the
+ * entries in parallel.
+ *
+ * When memory mapped, the whole file is accessible with data() and
+ * the read() functions copy the data from the mapping.
+ *
+ * \note
+ * Under MS-Windows, the reads are serialized with a mutex and the
+ * files do not get memory mapped.
+ */
+
+
+/** \brief Open a file for random access.
+ *
+ * This function opens the file named \p filename in read-only mode
+ * and determines its size.
+ *
+ * If \p memory_map is true, the file also gets mapped in memory. The
+ * mapping is shared with other processes mapping the same file. An
+ * empty file does not get mapped.
+ *
+ * \exception IOException
+ * This exception is raised if the file cannot be opened or mapped.
+ *
+ * \param[in] filename  The name of the file to open.
+ * \param[in] memory_map  Whether the file gets memory mapped.
+ */
+RandomAccessFile::RandomAccessFile(std::string const & filename, bool memory_map)
+    : m_filename(filename)
+{
+#ifdef ZIPIOS_WINDOWS
+    m_fd = _open(filename.c_str(), _O_RDONLY | _O_BINARY);
+#else
+    m_fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+    if(m_fd < 0)
+    {
+        throw IOException("Error opening file \"" + filename + "\" for reading.");
+    }
+
+#ifdef ZIPIOS_WINDOWS
+    m_size = _lseeki64(m_fd, 0, SEEK_END);
+#else
+    m_size = lseek(m_fd, 0, SEEK_END);
+#endif
+    if(m_size < 0)
+    {
+        // this happens with pipes and similar non-seekable files
+        //
+#ifdef ZIPIOS_WINDOWS
+        _close(m_fd);
+#else
+        close(m_fd);
+#endif
+        throw IOException("Could not determine the size of \"" + filename + "\".");
+    }
+
+#ifdef ZIPIOS_WINDOWS
+    static_cast<void>(memory_map);
+#else
+    if(memory_map && m_size > 0)
+    {
+        void * ptr(mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0));
+        if(ptr == MAP_FAILED)
+        {
+            close(m_fd);
+            throw IOException("Could not memory map \"" + filename + "\".");
+        }
+        m_data = reinterpret_cast<char const *>(ptr);
+    }
+#endif
+}
+
+
+/** \brief Close the file.
+ *
+ * The destructor unmaps and closes the file.
+ */
+RandomAccessFile::~RandomAccessFile()
+{
+#ifdef ZIPIOS_WINDOWS
+    _close(m_fd);
+#else
+    if(m_data != nullptr)
+    {
+        munmap(const_cast<char *>(m_data), m_size);
+    }
+    close(m_fd);
+#endif
+}
+
+
+/** \brief Retrieve the name of the file.
+ *
+ * This function returns the name of the file as passed to the
+ * constructor.
+ *
+ * \return The name of the file.
+ */
+std::string const & RandomAccessFile::getFilename() const
+{
+    return m_filename;
+}
+
+
+/** \brief Retrieve the size of the file.
+ *
+ * This function returns the size of the file at the time it was opened.
+ *
+ * \return The size of the file in bytes.
+ */
+offset_t RandomAccessFile::size() const
+{
+    return m_size;
+}
+
+
+/** \brief Retrieve a pointer to the memory mapped file.
+ *
+ * This function returns a pointer to the first byte of the file when
+ * it is memory mapped. The size of the buffer is size().
+ *
+ * \return A pointer to the data of the file or nullptr if the file is
+ *         not memory mapped.
+ */
+char const * RandomAccessFile::data() const
+{
+    return m_data;
+}
+
+
+/** \brief Read data at the specified position.
+ *
+ * This function reads up to \p size bytes at position \p pos in
+ * \p buffer. The function only returns less than \p size bytes when
+ * the end of the file is reached.
+ *
+ * \exception IOException
+ * This exception is raised if an I/O error occurs.
+ *
+ * \param[in] pos  The position where the data is read from.
+ * \param[out] buffer  The buffer receiving the data.
+ * \param[in] size  The number of bytes to read.
+ *
+ * \return The number of bytes read.
+ */
+size_t RandomAccessFile::read(offset_t pos, void * buffer, size_t size) const
+{
+    if(m_data != nullptr)
+    {
+        if(pos >= m_size)
+        {
+            return 0;
+        }
+        size_t const available(std::min(size, static_cast<size_t>(m_size - pos)));
+        memcpy(buffer, m_data + pos, available);
+        return available;
+    }
+
+#ifdef ZIPIOS_WINDOWS
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(_lseeki64(m_fd, pos, SEEK_SET) != pos)
+    {
+        throw IOException("an I/O error occurred while seeking in a zip archive file.");
+    }
+#endif
+
+    char * ptr(reinterpret_cast<char *>(buffer));
+    size_t total(0);
+    while(total < size)
+    {
+#ifdef ZIPIOS_WINDOWS
+        int const r(_read(m_fd, ptr + total, static_cast<unsigned int>(std::min(size - total, static_cast<size_t>(0x40000000)))));
+#else
+        ssize_t const r(pread(m_fd, ptr + total, size - total, pos + total));
+#endif
+        if(r < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;   // LCOV_EXCL_LINE
+            }
+            throw IOException("an I/O error occurred while reading a zip archive file.");
+        }
+        if(r == 0)
+        {
+            break;
+        }
+        total += r;
+    }
+
+    return total;
+}
+
+
+/** \brief Tell the system that some data will be needed soon.
+ *
+ * This function asks the operating system to start loading the
+ * \p size bytes found at position \p pos so a later read() does not
+ * have to wait for them. It uses madvise() when the file is memory
+ * mapped and posix_fadvise() otherwise. This is only a hint and errors
+ * are ignored.
+ *
+ * \param[in] pos  The position of the data.
+ * \param[in] size  The number of bytes that will be read.
+ */
+void RandomAccessFile::willNeed(offset_t pos, size_t size) const
+{
+    if(pos < 0
+    || pos >= m_size
+    || size == 0)
+    {
+        return;
+    }
+    size = std::min(size, static_cast<size_t>(m_size - pos));
+
+#ifdef ZIPIOS_WINDOWS
+    // no equivalent, Windows does its own read-ahead
+    static_cast<void>(pos);
+    static_cast<void>(size);
+#else
+    if(m_data != nullptr)
+    {
+        // madvise() wants a page aligned address
+        //
+        offset_t const page(sysconf(_SC_PAGESIZE));
+        offset_t const start(pos / page * page);
+        madvise(const_cast<char *>(m_data) + start, size + (pos - start), MADV_WILLNEED);
+    }
+    else
+    {
+        posix_fadvise(m_fd, pos, size, POSIX_FADV_WILLNEED);
+    }
+#endif
+}
+
+
+/** \brief Read exactly \p size bytes at the specified position.
+ *
+ * This function resizes \p buffer to \p size bytes and fills it with
+ * the data found at position \p pos in the file.
+ *
+ * \exception IOException
+ * This exception is raised if an I/O error occurs or the end of the
+ * file is reached before \p size bytes were read.
+ *
+ * \param[in] pos  The position where the data is read from.
+ * \param[out] buffer  The buffer receiving the data.
+ * \param[in] size  The number of bytes to read.
+ */
+void RandomAccessFile::read(offset_t pos, buffer_t & buffer, size_t size) const
+{
+    buffer.resize(size);
+    if(read(pos, buffer.data(), size) != size)
+    {
+        throw IOException("EOF reached while reading zip archive data from file.");
+    }
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef ZIPIOS_RANDOMACCESSFILE_HPP
+#define ZIPIOS_RANDOMACCESSFILE_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief The header file for zipios::RandomAccessFile.
+ *
+ * The zipios::RandomAccessFile class gives positional read access to
+ * a file. Reads do not make use of a shared file pointer so several
+ * threads can read from the same file at the same time. The file can
+ * also be memory mapped.
+ */
+
+#include "zipios_common.hpp"
+
+#include <memory>
+#include <mutex>
+
+
+namespace zipios
+{
+
+
+class RandomAccessFile
+{
+public:
+    typedef std::shared_ptr<RandomAccessFile>   pointer_t;
+
+                            RandomAccessFile(std::string const & filename, bool memory_map = false);
+                            RandomAccessFile(RandomAccessFile const & rhs) = delete;
+                            ~RandomAccessFile();
+
+    RandomAccessFile &      operator = (RandomAccessFile const & rhs) = delete;
+
+    std::string const &     getFilename() const;
+    offset_t                size() const;
+    char const *            data() const;
+    size_t                  read(offset_t pos, void * buffer, size_t size) const;
+    void                    read(offset_t pos, buffer_t & buffer, size_t size) const;
+    void                    willNeed(offset_t pos, size_t size) const;
+
+private:
+    std::string             m_filename = std::string();
+    int                     m_fd = -1;
+    offset_t                m_size = 0;
+    char const *            m_data = nullptr;
+#ifdef ZIPIOS_WINDOWS
+    mutable std::mutex      m_mutex = std::mutex();
+#endif
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
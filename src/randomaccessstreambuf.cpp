@@ -0,0 +1,241 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::RandomAccessStreambuf.
+ *
+ * This file implements a read-only streambuf which reads a
+ * RandomAccessFile with positional reads.
+ */
+
+#include "randomaccessstreambuf.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace zipios
+{
+
+
+/** \class RandomAccessStreambuf
+ * \brief A read-only streambuf using positional reads.
+ *
+ * This streambuf reads a RandomAccessFile. It keeps its own position
+ * and reads the file with positional reads at absolute offsets. Many
+ * RandomAccessStreambuf objects can therefore share the same file,
+ * and be used by different threads, without opening the file again.
+ *
+ * Large reads bypass the internal buffer and go directly to the
+ * destination buffer.
+ *
+ * When a read-ahead size is given, the operating system is told to load
+ * that many bytes past the current position as the reading progresses
+ * (see IOPolicy::setReadAhead()).
+ */
+
+
+/** \brief Initialize the streambuf.
+ *
+ * This constructor attaches the streambuf to \p file. The position
+ * starts at the beginning of the file.
+ *
+ * \param[in] file  The file to read from.
+ * \param[in] buffer_size  The size of the internal buffer.
+ * \param[in] read_ahead  The number of bytes to read ahead or 0.
+ */
+RandomAccessStreambuf::RandomAccessStreambuf(RandomAccessFile::pointer_t file, size_t buffer_size, size_t read_ahead)
+    : m_file(file)
+    , m_buffer(std::max(buffer_size, static_cast<size_t>(1)))
+    , m_read_ahead(read_ahead)
+{
+    setg(m_buffer.data(), m_buffer.data(), m_buffer.data());
+}
+
+
+/** \brief Clean up the streambuf.
+ *
+ * The file is shared so the destructor has nothing to do.
+ */
+RandomAccessStreambuf::~RandomAccessStreambuf()
+{
+}
+
+
+/** \brief Read more data.
+ *
+ * This function reads the next block of data from the file in the
+ * internal buffer.
+ *
+ * \return The next character or EOF if the end of the file was reached.
+ */
+RandomAccessStreambuf::int_type RandomAccessStreambuf::underflow()
+{
+    if(gptr() < egptr())
+    {
+        return traits_type::to_int_type(*gptr()); // LCOV_EXCL_LINE
+    }
+
+    readAhead();
+    size_t const size(m_file->read(m_position, m_buffer.data(), m_buffer.size()));
+    m_position += size;
+    setg(m_buffer.data(), m_buffer.data(), m_buffer.data() + size);
+
+    if(size == 0)
+    {
+        return traits_type::eof();
+    }
+    return traits_type::to_int_type(*gptr());
+}
+
+
+/** \brief Read a block of data.
+ *
+ * This function first returns the data still available in the internal
+ * buffer. If more than one buffer of data is still necessary, the data
+ * is read directly in \p s.
+ *
+ * \param[out] s  The destination buffer.
+ * \param[in] count  The number of bytes to read.
+ *
+ * \return The number of bytes read.
+ */
+std::streamsize RandomAccessStreambuf::xsgetn(char_type * s, std::streamsize count)
+{
+    std::streamsize const available(std::min(count, static_cast<std::streamsize>(egptr() - gptr())));
+    memcpy(s, gptr(), available);
+    gbump(static_cast<int>(available));
+    if(available == count)
+    {
+        return count;
+    }
+
+    std::streamsize const left(count - available);
+    if(static_cast<size_t>(left) >= m_buffer.size())
+    {
+        readAhead();
+        size_t const size(m_file->read(m_position, s + available, left));
+        m_position += size;
+        return available + size;
+    }
+
+    return available + std::streambuf::xsgetn(s + available, left);
+}
+
+
+/** \brief Change the current position.
+ *
+ * This function moves the current position by \p off bytes relative
+ * to the start, the current position, or the end of the file. The
+ * internal buffer is emptied so the next read happens at the new
+ * position.
+ *
+ * \param[in] off  The offset to move by.
+ * \param[in] dir  The position \p off is relative to.
+ * \param[in] which  Only std::ios_base::in is supported.
+ *
+ * \return The new position or -1 if the position is out of bounds.
+ */
+RandomAccessStreambuf::pos_type RandomAccessStreambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if((which & std::ios_base::in) == 0)
+    {
+        return pos_type(off_type(-1));
+    }
+
+    offset_t base(0);
+    switch(dir)
+    {
+    case std::ios_base::beg:
+        break;
+
+    case std::ios_base::cur:
+        base = m_position - (egptr() - gptr());
+        break;
+
+    case std::ios_base::end:
+        base = m_file->size();
+        break;
+
+    default: // LCOV_EXCL_LINE
+        return pos_type(off_type(-1)); // LCOV_EXCL_LINE
+
+    }
+
+    offset_t const pos(base + off);
+    if(pos < 0 || pos > m_file->size())
+    {
+        return pos_type(off_type(-1));
+    }
+
+    m_position = pos;
+    m_advised = pos;
+    setg(m_buffer.data(), m_buffer.data(), m_buffer.data());
+    return pos_type(pos);
+}
+
+
+/** \brief Change the current position.
+ *
+ * This function moves the current position to \p pos bytes from the
+ * start of the file.
+ *
+ * \param[in] pos  The new position.
+ * \param[in] which  Only std::ios_base::in is supported.
+ *
+ * \return The new position or -1 if the position is out of bounds.
+ */
+RandomAccessStreambuf::pos_type RandomAccessStreambuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+
+/** \brief Ask the system to load the data ahead of the position.
+ *
+ * When a read-ahead size is defined, this function tells the file that
+ * the data up to the read-ahead size past the current position will be
+ * needed. The hint is renewed each time half of it was consumed.
+ */
+void RandomAccessStreambuf::readAhead()
+{
+    if(m_read_ahead == 0
+    || m_position + static_cast<offset_t>(m_read_ahead / 2) < m_advised)
+    {
+        return;
+    }
+
+    offset_t const start(std::max(m_position, m_advised));
+    offset_t const end(m_position + m_read_ahead);
+    m_file->willNeed(start, end - start);
+    m_advised = end;
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef ZIPIOS_RANDOMACCESSSTREAMBUF_HPP
+#define ZIPIOS_RANDOMACCESSSTREAMBUF_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Header file that defines zipios::RandomAccessStreambuf.
+ */
+
+#include "randomaccessfile.hpp"
+
+#include <iostream>
+#include <vector>
+
+
+namespace zipios
+{
+
+
+class RandomAccessStreambuf : public std::streambuf
+{
+public:
+                                RandomAccessStreambuf(RandomAccessFile::pointer_t file, size_t buffer_size = getBufferSize(), size_t read_ahead = 0);
+                                RandomAccessStreambuf(RandomAccessStreambuf const & rhs) = delete;
+    virtual                     ~RandomAccessStreambuf() override;
+
+    RandomAccessStreambuf &     operator = (RandomAccessStreambuf const & rhs) = delete;
+
+protected:
+    virtual int_type            underflow() override;
+    virtual std::streamsize     xsgetn(char_type * s, std::streamsize count) override;
+    virtual pos_type            seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in) override;
+    virtual pos_type            seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override;
+
+private:
+    void                        readAhead();
+
+    RandomAccessFile::pointer_t m_file = RandomAccessFile::pointer_t();
+    offset_t                    m_position = 0;
+    std::vector<char>           m_buffer = std::vector<char>();
+    size_t                      m_read_ahead = 0;
+    offset_t                    m_advised = 0;
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
@@ -0,0 +1,316 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief The implementation file of zipios::ZipCatalog.
+ *
+ * This class keeps a raw copy of the Central Directory of a Zip
+ * archive and only creates FileEntry objects when requested.
+ */
+
+#include "zipcatalog.hpp"
+
+#include "zipcentraldirectoryentry.hpp"
+
+#include "zipios/zipiosexceptions.hpp"
+
+
+namespace zipios
+{
+
+
+namespace
+{
+
+
+/** \brief The signature of a Central Directory entry.
+ *
+ * This value represents the signature of a Zip Central Directory Entry.
+ * It has to match the one found in zipcentraldirectoryentry.cpp.
+ */
+uint32_t const  g_signature = 0x02014b50;
+
+
+/** \brief The size of the fixed part of a Central Directory entry.
+ *
+ * The Central Directory entries are composed of a fixed part followed
+ * by the filename, the extra field, and the comment.
+ */
+size_t const    g_header_size = 46;
+
+
+/** \brief An entry created from the catalog.
+ *
+ * This class is used to initialize a ZipCentralDirectoryEntry from
+ * the fields saved in the catalog without having to parse the Central
+ * Directory again.
+ */
+class ZipCatalogEntry
+    : public ZipCentralDirectoryEntry
+{
+public:
+    ZipCatalogEntry(
+              uint16_t extract_version
+            , uint16_t general_purpose_bitfield
+            , uint16_t compress_method
+            , uint32_t dosdatetime
+            , uint32_t crc_32
+            , uint64_t compressed_size
+            , uint64_t uncompressed_size
+            , uint64_t entry_offset
+            , std::string_view filename
+            , std::string_view extra_field
+            , std::string_view comment)
+    {
+        m_extract_version = extract_version;
+        m_general_purpose_bitfield = general_purpose_bitfield;
+        m_compress_method = static_cast<StorageMethod>(compress_method);
+        DOSDateTime t;
+        t.setDOSDateTime(dosdatetime);
+        m_unix_time = t.getUnixTimestamp();
+        m_crc_32 = crc_32;
+        m_compressed_size = compressed_size;
+        m_uncompressed_size = uncompressed_size;
+        m_entry_offset = entry_offset;
+        m_extra_field.assign(extra_field.begin(), extra_field.end());
+        m_comment = comment;
+
+        // the FilePath() removes the trailing slash
+        //
+        m_is_directory = !filename.empty() && filename.back() == g_separator;
+        m_filename = FilePath(std::string(filename));
+
+        m_valid = true;
+    }
+};
+
+
+} // no name namespace
+
+
+/** \class ZipCatalog
+ * \brief The Central Directory of a Zip archive kept in memory.
+ *
+ * The ZipCatalog keeps the Central Directory of a Zip archive in a
+ * compact form: one packed record per entry with the fields of the
+ * entry and a single string, the arena, with all the names, extra
+ * fields, and comments. Opening an archive with many entries therefore
+ * costs one allocation for the records, one for the arena, and the name
+ * index instead of several allocations per entry.
+ *
+ * The FileEntry objects are only created when getEntry() is called.
+ *
+ * The name index keys are views of the names found in the arena so no
+ * extra string gets allocated.
+ *
+ * The catalog is read-only once created so it can be shared between
+ * ZipFile copies and used by several threads at the same time.
+ */
+
+
+/** \brief Parse a Central Directory.
+ *
+ * This function parses the \p count entries found in the
+ * \p central_directory buffer and saves their fields in the catalog.
+ * The buffer is released once parsed.
+ *
+ * \exception IOException
+ * This exception is raised if the signature of an entry is invalid or
+ * an entry goes past the end of the buffer.
+ *
+ * \param[in] central_directory  The buffer with the Central Directory.
+ * \param[in] count  The number of entries in the Central Directory.
+ */
+ZipCatalog::ZipCatalog(buffer_t && central_directory, size_t count)
+{
+    buffer_t const cd(std::move(central_directory));
+    size_t const max(cd.size());
+
+    // the strings cannot be larger than the Central Directory itself
+    //
+    m_records.reserve(count);
+    m_arena.reserve(max > g_header_size * count ? max - g_header_size * count : 0);
+
+    size_t pos(0);
+    for(size_t idx(0); idx < count; ++idx)
+    {
+        if(pos + g_header_size > max)
+        {
+            throw IOException("EOF reached while reading zip archive data from file.");
+        }
+
+        uint32_t signature(0);
+        zipRead(cd, pos, signature);
+        if(g_signature != signature)
+        {
+            throw IOException("ZipCentralDirectoryEntry::read(): Expected Central Directory entry signature not found");
+        }
+
+        record_t r;
+        uint16_t writer_version(0);
+        uint32_t compressed_size(0);
+        uint32_t uncompressed_size(0);
+        uint16_t disk_num_start(0);
+        uint16_t intern_file_attr(0);
+        uint32_t extern_file_attr(0);
+        uint32_t entry_offset(0);
+        zipRead(cd, pos, writer_version);                   // 16
+        zipRead(cd, pos, r.m_extract_version);              // 16
+        zipRead(cd, pos, r.m_general_purpose_bitfield);     // 16
+        zipRead(cd, pos, r.m_compress_method);              // 16
+        zipRead(cd, pos, r.m_dosdatetime);                  // 32
+        zipRead(cd, pos, r.m_crc_32);                       // 32
+        zipRead(cd, pos, compressed_size);                  // 32
+        zipRead(cd, pos, uncompressed_size);                // 32
+        zipRead(cd, pos, r.m_filename_len);                 // 16
+        zipRead(cd, pos, r.m_extra_field_len);              // 16
+        zipRead(cd, pos, r.m_file_comment_len);             // 16
+        zipRead(cd, pos, disk_num_start);                   // 16
+        zipRead(cd, pos, intern_file_attr);                 // 16
+        zipRead(cd, pos, extern_file_attr);                 // 32
+        zipRead(cd, pos, entry_offset);                     // 32
+
+        size_t const strings_len(r.m_filename_len + r.m_extra_field_len + r.m_file_comment_len);
+        if(pos + strings_len > max)
+        {
+            throw IOException("EOF reached while reading zip archive data from file.");
+        }
+
+        // sizes and offset of 0xFFFFFFFF are defined in the Zip64 extra field
+        //
+        r.m_compressed_size = compressed_size;
+        r.m_uncompressed_size = uncompressed_size;
+        r.m_entry_offset = entry_offset;
+        zipReadZip64ExtraField(
+                  cd.data() + pos + r.m_filename_len
+                , r.m_extra_field_len
+                , r.m_uncompressed_size
+                , r.m_compressed_size
+                , r.m_entry_offset);
+
+        r.m_arena_offset = m_arena.length();
+        m_arena.append(reinterpret_cast<char const *>(cd.data()) + pos, strings_len);
+        m_records.push_back(r);
+
+        pos += strings_len;
+    }
+    m_central_directory_size = pos;
+
+    // the arena does not change anymore so we can now index the names
+    // as views of the arena
+    //
+    m_index.reserve(count);
+    for(size_t idx(0); idx < count; ++idx)
+    {
+        // the name as FilePath would return it: without the trailing
+        // separator of directories
+        //
+        std::string_view name(m_arena.data() + m_records[idx].m_arena_offset, m_records[idx].m_filename_len);
+        if(!name.empty() && name.back() == g_separator)
+        {
+            name.remove_suffix(1);
+        }
+        std::string_view::size_type const slash(name.rfind(g_separator));
+        m_index.add(name, slash == std::string_view::npos ? name : name.substr(slash + 1), idx);
+    }
+}
+
+
+/** \brief Retrieve the number of entries.
+ *
+ * This function returns the number of entries found in the catalog.
+ *
+ * \return The number of entries.
+ */
+size_t ZipCatalog::size() const
+{
+    return m_records.size();
+}
+
+
+/** \brief Retrieve the size of the Central Directory.
+ *
+ * This function returns the number of bytes used by the entries of
+ * the Central Directory. It is used to verify that the Central Directory
+ * size found in the End of Central Directory is valid.
+ *
+ * \return The size of the Central Directory in bytes.
+ */
+size_t ZipCatalog::getCentralDirectorySize() const
+{
+    return m_central_directory_size;
+}
+
+
+/** \brief Search for an entry.
+ *
+ * This function searches for the entry named \p name and returns
+ * its index.
+ *
+ * \param[in] name  The name of the entry to search.
+ * \param[in] matchpath  Whether \p name is a full name (MatchPath::MATCH)
+ *                       or a basename (MatchPath::IGNORE).
+ *
+ * \return The index of the entry or FileCollection::g_no_entry.
+ */
+size_t ZipCatalog::find(std::string_view name, FileCollection::MatchPath matchpath) const
+{
+    return m_index.find(name, matchpath);
+}
+
+
+/** \brief Create the FileEntry of an entry.
+ *
+ * This function creates a new FileEntry object from the record at
+ * index \p idx. Each call returns a new object.
+ *
+ * \param[in] idx  The index of the entry, it must be smaller than size().
+ *
+ * \return A new FileEntry representing that entry.
+ */
+FileEntry::pointer_t ZipCatalog::getEntry(size_t idx) const
+{
+    record_t const & r(m_records[idx]);
+    std::string_view const strings(m_arena.data() + r.m_arena_offset, r.m_filename_len + r.m_extra_field_len + r.m_file_comment_len);
+    return std::make_shared<ZipCatalogEntry>(
+                  r.m_extract_version
+                , r.m_general_purpose_bitfield
+                , r.m_compress_method
+                , r.m_dosdatetime
+                , r.m_crc_32
+                , r.m_compressed_size
+                , r.m_uncompressed_size
+                , r.m_entry_offset
+                , strings.substr(0, r.m_filename_len)
+                , strings.substr(r.m_filename_len, r.m_extra_field_len)
+                , strings.substr(r.m_filename_len + r.m_extra_field_len));
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
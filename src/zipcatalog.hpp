@@ -0,0 +1,93 @@
+#pragma once
+#ifndef ZIPIOS_ZIPCATALOG_HPP
+#define ZIPIOS_ZIPCATALOG_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief The header file for zipios::ZipCatalog.
+ *
+ * The zipios::ZipCatalog class keeps the Central Directory of a Zip
+ * archive in memory and creates the FileEntry objects on demand.
+ */
+
+#include "nameindex.hpp"
+#include "zipios_common.hpp"
+
+
+namespace zipios
+{
+
+
+class ZipCatalog
+{
+public:
+    typedef std::shared_ptr<ZipCatalog const>   pointer_t;
+
+                            ZipCatalog(buffer_t && central_directory, size_t count);
+                            ZipCatalog(ZipCatalog const & rhs) = delete;
+
+    ZipCatalog &            operator = (ZipCatalog const & rhs) = delete;
+
+    size_t                  size() const;
+    size_t                  getCentralDirectorySize() const;
+    size_t                  find(std::string_view name, FileCollection::MatchPath matchpath) const;
+    FileEntry::pointer_t    getEntry(size_t idx) const;
+
+private:
+    // the fields of one entry; the names, extra fields, and comments
+    // are saved one after the other in the arena
+    //
+    struct record_t
+    {
+        uint64_t            m_arena_offset = 0;
+        uint64_t            m_entry_offset = 0;
+        uint64_t            m_compressed_size = 0;
+        uint64_t            m_uncompressed_size = 0;
+        uint32_t            m_crc_32 = 0;
+        uint32_t            m_dosdatetime = 0;
+        uint16_t            m_filename_len = 0;
+        uint16_t            m_extra_field_len = 0;
+        uint16_t            m_file_comment_len = 0;
+        uint16_t            m_compress_method = 0;
+        uint16_t            m_extract_version = 0;
+        uint16_t            m_general_purpose_bitfield = 0;
+    };
+    typedef std::vector<record_t>   record_vector_t;
+
+    record_vector_t         m_records = record_vector_t();
+    std::string             m_arena = std::string();
+    size_t                  m_central_directory_size = 0;
+    NameIndex               m_index = NameIndex();
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
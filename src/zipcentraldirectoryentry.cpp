@@ -34,6 +34,8 @@
 
 #include "zipios_common.hpp"
 
+#include <algorithm>
+
 
 namespace zipios
 {
@@ -180,20 +182,48 @@ ZipCentralDirectoryEntry::~ZipCentralDirectoryEntry()
 size_t ZipCentralDirectoryEntry::getHeaderSize() const
 {
     /** \todo
-     * Add support for 64 bit Zip. At this time this function returns
-     * an invalid size if the filename, extra field, or file comment
-     * sizes are more than allowed in an older version of the Zip format.
+     * At this time this function returns an invalid size if the
+     * filename, extra field, or file comment sizes are more than
+     * allowed by the Zip format.
      */
     // Note that the structure is 48 bytes because of an alignment
     // and attempting to use options to avoid the alignment would
     // not be portable so we use a hard coded value (yuck!)
     return 46 /* sizeof(ZipCentralDirectoryEntryHeader) */
          + m_filename.length() + (m_is_directory ? 1 : 0)
-         + m_extra_field.size()
+         + getCentralExtraField().size()
          + m_comment.length();
 }
 
 
+/** \brief Retrieve the extra field saved in the Central Directory.
+ *
+ * This function returns the extra field of the entry with the Zip64
+ * extended information extra field added when the uncompressed size,
+ * the compressed size, or the offset of the entry do not fit in 32 bits.
+ * Only the values which do not fit are saved in that field.
+ *
+ * \return The extra field of the Central Directory entry.
+ */
+buffer_t ZipCentralDirectoryEntry::getCentralExtraField() const
+{
+    std::vector<uint64_t> values;
+    if(m_uncompressed_size >= 0xFFFFFFFF)
+    {
+        values.push_back(m_uncompressed_size);
+    }
+    if(m_compressed_size >= 0xFFFFFFFF)
+    {
+        values.push_back(m_compressed_size);
+    }
+    if(m_entry_offset >= 0xFFFFFFFF)
+    {
+        values.push_back(m_entry_offset);
+    }
+    return zipMakeZip64ExtraField(m_extra_field, values);
+}
+
+
 /** \brief Create a clone of this Central Directory entry.
  *
  * This function allocates a new copy of this ZipCentralDirectoryEntry
@@ -213,6 +243,11 @@ FileEntry::pointer_t ZipCentralDirectoryEntry::clone() const
  * input stream. If anything goes wrong with the input stream, the read
  * function will throw an error.
  *
+ * The function reads the fixed size part of the header and then the
+ * variable size part (filename, extra field, and comment) with one call
+ * each. The data is then parsed with the read() function working on a
+ * buffer.
+ *
  * \note
  * While reading the entry is marked as invalid. If the read fails, the
  * entry will remain invalid. On success, the function restores the status
@@ -235,15 +270,79 @@ void ZipCentralDirectoryEntry::read(std::istream & is)
 {
     m_valid = false; // set back to true upon successful completion below.
 
+    buffer_t header;
+    zipRead(is, header, 46 /* sizeof(ZipCentralDirectoryEntryHeader) */);
+
     // verify the signature
+    size_t pos(0);
     uint32_t signature;
-    zipRead(is, signature);
+    zipRead(header, pos, signature);
     if(g_signature != signature)
     {
         is.setstate(std::ios::failbit);
         throw IOException("ZipCentralDirectoryEntry::read(): Expected Central Directory entry signature not found");
     }
 
+    // read the filename, extra field, and comment
+    uint16_t filename_len(0);
+    uint16_t extra_field_len(0);
+    uint16_t file_comment_len(0);
+    pos = 28;
+    zipRead(header, pos, filename_len);
+    zipRead(header, pos, extra_field_len);
+    zipRead(header, pos, file_comment_len);
+
+    buffer_t variable;
+    zipRead(is, variable, filename_len + extra_field_len + file_comment_len);
+    header += variable;
+
+    pos = 0;
+    read(header, pos);
+}
+
+
+/** \brief Read a Central Directory entry from a buffer.
+ *
+ * This function parses one Central Directory entry found in \p is
+ * at position \p pos. On return, \p pos points right after the entry
+ * so the function can be called in a loop to parse a whole Central
+ * Directory which was loaded in memory with a single read.
+ *
+ * \note
+ * While reading the entry is marked as invalid. If the read fails, the
+ * entry will remain invalid. On success, the function restores the status
+ * back to valid.
+ *
+ * \exception IOException
+ * This exception is thrown if the signature read does not match the
+ * signature of a Central Directory entry or if the buffer is too
+ * small to hold the entry.
+ *
+ * \param[in] is  The buffer to parse.
+ * \param[in,out] pos  The position of the entry in \p is.
+ *
+ * \sa write()
+ */
+void ZipCentralDirectoryEntry::read(buffer_t const & is, size_t & pos)
+{
+    m_valid = false; // set back to true upon successful completion below.
+
+    // make sure the whole fixed size header is available once
+    // instead of failing in the middle of it
+    //
+    if(pos + 46 /* sizeof(ZipCentralDirectoryEntryHeader) */ > is.size())
+    {
+        throw IOException("EOF reached while reading zip archive data from file.");
+    }
+
+    // verify the signature
+    uint32_t signature;
+    zipRead(is, pos, signature);
+    if(g_signature != signature)
+    {
+        throw IOException("ZipCentralDirectoryEntry::read(): Expected Central Directory entry signature not found");
+    }
+
     uint16_t writer_version(0);
     uint16_t compress_method(0);
     uint32_t dosdatetime(0);
@@ -259,27 +358,31 @@ void ZipCentralDirectoryEntry::read(std::istream & is)
     std::string filename;
 
     // read the header
-    zipRead(is, writer_version);                    // 16
-    zipRead(is, m_extract_version);                 // 16
-    zipRead(is, m_general_purpose_bitfield);        // 16
-    zipRead(is, compress_method);                   // 16
-    zipRead(is, dosdatetime);                       // 32
-    zipRead(is, m_crc_32);                          // 32
-    zipRead(is, compressed_size);                   // 32
-    zipRead(is, uncompressed_size);                 // 32
-    zipRead(is, filename_len);                      // 16
-    zipRead(is, extra_field_len);                   // 16
-    zipRead(is, file_comment_len);                  // 16
-    zipRead(is, disk_num_start);                    // 16
-    zipRead(is, intern_file_attr);                  // 16
-    zipRead(is, extern_file_attr);                  // 32
-    zipRead(is, rel_offset_loc_head);               // 32
-    zipRead(is, filename, filename_len);            // string
-    zipRead(is, m_extra_field, extra_field_len);    // buffer
-    zipRead(is, m_comment, file_comment_len);       // string
-    /** \todo check whether this was a 64 bit header and make sure
-     *        to read the 64 bit header too if so
-     */
+    zipRead(is, pos, writer_version);                   // 16
+    zipRead(is, pos, m_extract_version);                // 16
+    zipRead(is, pos, m_general_purpose_bitfield);       // 16
+    zipRead(is, pos, compress_method);                  // 16
+    zipRead(is, pos, dosdatetime);                      // 32
+    zipRead(is, pos, m_crc_32);                         // 32
+    zipRead(is, pos, compressed_size);                  // 32
+    zipRead(is, pos, uncompressed_size);                // 32
+    zipRead(is, pos, filename_len);                     // 16
+    zipRead(is, pos, extra_field_len);                  // 16
+    zipRead(is, pos, file_comment_len);                 // 16
+    zipRead(is, pos, disk_num_start);                   // 16
+    zipRead(is, pos, intern_file_attr);                 // 16
+    zipRead(is, pos, extern_file_attr);                 // 32
+    zipRead(is, pos, rel_offset_loc_head);              // 32
+    zipRead(is, pos, filename, filename_len);           // string
+    zipRead(is, pos, m_extra_field, extra_field_len);   // buffer
+    zipRead(is, pos, m_comment, file_comment_len);      // string
+
+    // sizes and offset of 0xFFFFFFFF are defined in the Zip64 extra field
+    //
+    uint64_t size(uncompressed_size);
+    uint64_t csize(compressed_size);
+    uint64_t offset(rel_offset_loc_head);
+    zipReadZip64ExtraField(m_extra_field.data(), m_extra_field.size(), size, csize, offset);
 
     // the FilePath() will remove the trailing slash so make sure
     // to defined the m_is_directory ahead of time!
@@ -289,9 +392,9 @@ void ZipCentralDirectoryEntry::read(std::istream & is)
     DOSDateTime t;
     t.setDOSDateTime(dosdatetime);
     m_unix_time = t.getUnixTimestamp();
-    m_compressed_size = compressed_size;
-    m_uncompressed_size = uncompressed_size;
-    m_entry_offset = rel_offset_loc_head;
+    m_compressed_size = csize;
+    m_uncompressed_size = size;
+    m_entry_offset = offset;
     m_filename = FilePath(filename);
 
     // the zipRead() should throw if it is false...
@@ -326,29 +429,17 @@ void ZipCentralDirectoryEntry::read(std::istream & is)
  */
 void ZipCentralDirectoryEntry::write(std::ostream & os)
 {
-    /** \todo add support for 64 bit entries
-     *        (zip64 is available, just need to add a 64 bit header...)
-     */
-    if(m_filename.length()  > 0x10000
-    || m_extra_field.size() > 0x10000
-    || m_comment.length()   > 0x10000)
+    buffer_t const extra_field(getCentralExtraField());
+    if(m_filename.length() > 0x10000
+    || extra_field.size()  > 0x10000
+    || m_comment.length()  > 0x10000)
     {
         throw InvalidStateException("ZipCentralDirectoryEntry::write(): file name, comment, or extra field too large to save in a Zip file.");
     }
 
-// Solaris defines _ILP32 for 32 bit platforms
-#if INTPTR_MAX != INT32_MAX
-    if(m_compressed_size   >= 0x100000000ULL
-    || m_uncompressed_size >= 0x100000000ULL
-    || m_entry_offset      >= 0x100000000LL)
-    {
-        // This represents really large files which we do not test at this point
-        throw InvalidStateException("ZipCentralDirectoryEntry::write(): The size of this file is too large to fit in a zip archive."); // LCOV_EXCL_LINE
-    }
-#endif
-
     // define version
-    uint16_t writer_version = g_zip_format_version;
+    bool const zip64(isZip64() || m_entry_offset >= 0xFFFFFFFF);
+    uint16_t writer_version = zip64 ? g_zip64_format_version : g_zip_format_version;
     // including the "compatibility" code
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32)
     // MS-Windows
@@ -380,10 +471,11 @@ void ZipCentralDirectoryEntry::write(std::ostream & os)
     DOSDateTime t;
     t.setUnixTimestamp(m_unix_time);
     uint32_t dosdatetime(t.getDOSDateTime());   // type could be set to DOSDateTime::dosdatetime_t
-    uint32_t compressed_size(m_compressed_size);
-    uint32_t uncompressed_size(m_uncompressed_size);
+    uint16_t extract_version(getWriteExtractVersion());
+    uint32_t compressed_size(std::min<uint64_t>(m_compressed_size, 0xFFFFFFFF));
+    uint32_t uncompressed_size(std::min<uint64_t>(m_uncompressed_size, 0xFFFFFFFF));
     uint16_t filename_len(filename.length());
-    uint16_t extra_field_len(m_extra_field.size());
+    uint16_t extra_field_len(extra_field.size());
     uint16_t file_comment_len(m_comment.length());
     uint16_t disk_num_start(0);
     uint16_t intern_file_attr(0);
@@ -407,11 +499,11 @@ void ZipCentralDirectoryEntry::write(std::ostream & os)
      * from the file entry.
      */
     uint32_t extern_file_attr(m_is_directory ? 0x41FD0010 : 0x81B40000);
-    uint32_t rel_offset_loc_head(m_entry_offset);
+    uint32_t rel_offset_loc_head(std::min<uint64_t>(m_entry_offset, 0xFFFFFFFF));
 
     zipWrite(os, g_signature);                  // 32
     zipWrite(os, writer_version);               // 16
-    zipWrite(os, m_extract_version);            // 16
+    zipWrite(os, extract_version);              // 16
     zipWrite(os, m_general_purpose_bitfield);   // 16
     zipWrite(os, compress_method);              // 16
     zipWrite(os, dosdatetime);                  // 32
@@ -426,7 +518,7 @@ void ZipCentralDirectoryEntry::write(std::ostream & os)
     zipWrite(os, extern_file_attr);             // 32
     zipWrite(os, rel_offset_loc_head);          // 32
     zipWrite(os, filename);                     // string
-    zipWrite(os, m_extra_field);                // buffer
+    zipWrite(os, extra_field);                  // buffer
     zipWrite(os, m_comment);                    // string
 }
 
@@ -51,7 +51,11 @@ public:
     virtual size_t              getHeaderSize() const override;
 
     virtual void                read(std::istream & is) override;
+    void                        read(buffer_t const & is, size_t & pos);
     virtual void                write(std::ostream & os) override;
+
+private:
+    buffer_t                    getCentralExtraField() const;
 };
 
 
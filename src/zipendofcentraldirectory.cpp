@@ -29,8 +29,12 @@
 
 #include "zipendofcentraldirectory.hpp"
 
+#include "ziplocalentry.hpp"
+
 #include "zipios/zipiosexceptions.hpp"
 
+#include <algorithm>
+
 
 namespace zipios
 {
@@ -68,6 +72,20 @@ namespace
 uint32_t const g_signature = 0x06054b50;
 
 
+/** \brief Signature of the Zip64 End of Central Directory record.
+ *
+ * "PK 6.6" -- Zip64 End of Central Directory
+ */
+uint32_t const g_zip64_signature = 0x06064b50;
+
+
+/** \brief Signature of the Zip64 End of Central Directory locator.
+ *
+ * "PK 6.7" -- Zip64 End of Central Directory Locator
+ */
+uint32_t const g_zip64_locator_signature = 0x07064b50;
+
+
 } // no name namespace
 
 
@@ -102,6 +120,19 @@ size_t ZipEndOfCentralDirectory::getCentralDirectorySize() const
 }
 
 
+/** \brief Retrieve the comment of the Zip archive.
+ *
+ * This function returns the global comment of the Zip archive as
+ * read by read() or as passed to the constructor.
+ *
+ * \return The comment of the Zip archive.
+ */
+std::string const & ZipEndOfCentralDirectory::getComment() const
+{
+    return m_zip_comment;
+}
+
+
 /** \brief Retrieve the number of entries.
  *
  * This function returns the number of entries that will be found
@@ -142,6 +173,36 @@ offset_t ZipEndOfCentralDirectory::getOffset() const
 }
 
 
+/** \brief Retrieve the offset of the Zip64 End of Central Directory.
+ *
+ * This function returns the offset found in the Zip64 End of Central
+ * Directory locator by readZip64Locator().
+ *
+ * \return The offset of the Zip64 End of Central Directory record.
+ */
+offset_t ZipEndOfCentralDirectory::getZip64Offset() const
+{
+    return m_zip64_offset;
+}
+
+
+/** \brief Check whether the Zip64 record is required.
+ *
+ * When the number of entries, the size, or the offset of the Central
+ * Directory do not fit in the End of Central Directory, their field
+ * is set to all ones (0xFFFF or 0xFFFFFFFF) and the actual value is
+ * found in the Zip64 End of Central Directory record.
+ *
+ * \return true if one of the fields read by read() is set to all ones.
+ */
+bool ZipEndOfCentralDirectory::needsZip64() const
+{
+    return m_central_directory_entries == 0xFFFF
+        || m_central_directory_size    == 0xFFFFFFFF
+        || m_central_directory_offset  == 0xFFFFFFFF;
+}
+
+
 /** \brief Define the size of the central directory.
  *
  * When creating a Zip archive, it is necessary to call this function
@@ -165,10 +226,6 @@ void ZipEndOfCentralDirectory::setCentralDirectorySize(size_t size)
  * This function is used to define the number of entries one will find
  * in the central directory.
  *
- * \note
- * The maximum number of entries is 65535. (until we add support for
- * 64 bit Zip archives.)
- *
  * \param[in] count  The number of entries in the Central Directory.
  *
  * \sa getCount()
@@ -203,9 +260,9 @@ void ZipEndOfCentralDirectory::setOffset(offset_t start_offset)
 /** \brief Attempt to read an ZipEndOfCentralDirectory structure.
  *
  * This function tries to read an ZipEndOfCentralDirectory structure from the
- * specified buffer. This function expects a BackBuffer, which is used
- * because that is generally the fastest way to read the data (instead of
- * scanning the entire file).
+ * specified buffer. The buffer is expected to hold the end of the file
+ * (the ZipFile reads the last 64Kb + 22 bytes at once) so the comment
+ * is available in full.
  *
  * \note
  * If a read from the buffer fails, then an exception is raised. Since
@@ -279,6 +336,112 @@ bool ZipEndOfCentralDirectory::read(::zipios::buffer_t const & buf, size_t pos)
 }
 
 
+/** \brief Attempt to read a Zip64 End of Central Directory locator.
+ *
+ * Zip64 archives have a locator of 20 bytes right before the End of
+ * Central Directory. It gives the offset of the Zip64 End of Central
+ * Directory record which can then be read with readZip64().
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the archive spans several disks.
+ *
+ * \param[in] buf  The buffer with the file data.
+ * \param[in] pos  The position of the locator in \p buf.
+ *
+ * \return true if a locator was found, false otherwise.
+ */
+bool ZipEndOfCentralDirectory::readZip64Locator(::zipios::buffer_t const & buf, size_t pos)
+{
+    if(pos + 20 > buf.size())
+    {
+        return false;
+    }
+
+    uint32_t signature;
+    zipRead(buf, pos, signature);               // 32
+    if(signature != g_zip64_locator_signature)
+    {
+        return false;
+    }
+
+    uint32_t disk_number;
+    uint64_t zip64_offset;
+    uint32_t total_disks;
+    zipRead(buf, pos, disk_number);             // 32
+    zipRead(buf, pos, zip64_offset);            // 64
+    zipRead(buf, pos, total_disks);             // 32
+
+    if(disk_number != 0
+    || total_disks > 1)
+    {
+        throw FileCollectionException("Zip64 End of Central Directory locator referencing another disk, spanned zip files are not supported");
+    }
+
+    m_zip64_offset = zip64_offset;
+
+    return true;
+}
+
+
+/** \brief Attempt to read a Zip64 End of Central Directory record.
+ *
+ * This function reads the Zip64 End of Central Directory record found
+ * in \p buf at \p pos. The number of entries, the size, and the offset
+ * of the Central Directory it defines replace the ones read by read().
+ *
+ * The extensible data sector which may follow is ignored.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the number of entries is not equal to
+ * the total number of entries, as expected.
+ *
+ * \param[in] buf  The buffer with the record.
+ * \param[in] pos  The position of the record in \p buf.
+ *
+ * \return true if the record was found, false if the signature is invalid.
+ */
+bool ZipEndOfCentralDirectory::readZip64(::zipios::buffer_t const & buf, size_t pos)
+{
+    uint32_t signature;
+    zipRead(buf, pos, signature);                           // 32
+    if(signature != g_zip64_signature)
+    {
+        return false;
+    }
+
+    uint64_t record_size;
+    uint16_t version_made_by;
+    uint16_t version_needed;
+    uint32_t disk_number;
+    uint32_t central_directory_disk;
+    uint64_t central_directory_entries;
+    uint64_t central_directory_total_entries;
+    uint64_t central_directory_size;
+    uint64_t central_directory_offset;
+
+    zipRead(buf, pos, record_size);                         // 64
+    zipRead(buf, pos, version_made_by);                     // 16
+    zipRead(buf, pos, version_needed);                      // 16
+    zipRead(buf, pos, disk_number);                         // 32
+    zipRead(buf, pos, central_directory_disk);              // 32
+    zipRead(buf, pos, central_directory_entries);           // 64
+    zipRead(buf, pos, central_directory_total_entries);     // 64
+    zipRead(buf, pos, central_directory_size);              // 64
+    zipRead(buf, pos, central_directory_offset);            // 64
+
+    if(central_directory_entries != central_directory_total_entries)
+    {
+        throw FileCollectionException("Zip64 End of Central Directory with a number of entries and total entries that differ is not supported, spanned zip files are not supported");
+    }
+
+    m_central_directory_entries = central_directory_entries;
+    m_central_directory_size    = central_directory_size;
+    m_central_directory_offset  = central_directory_offset;
+
+    return true;
+}
+
+
 /** \brief Write the ZipEndOfCentralDirectory structure to a stream.
  *
  * This function writes the currently defined end of central
@@ -293,41 +456,59 @@ bool ZipEndOfCentralDirectory::read(::zipios::buffer_t const & buf, size_t pos)
  * The function does not change the output pointer of the stream
  * before writing to it.
  *
- * \exception FileCollectionException
- * This function throws this exception if the data cannot be saved. In
- * general this means there are too many entries, the size is too large
- * or the comment is more than 64Kb (some of which will be resolved with
- * Zip64 support.)
+ * When the number of entries, the size, or the offset of the Central
+ * Directory do not fit in their field, a Zip64 End of Central Directory
+ * record and its locator are written first. The record is expected to
+ * immediately follow the Central Directory. The fields which do not fit
+ * are then set to all ones in the End of Central Directory.
+ *
+ * \exception InvalidStateException
+ * This function throws this exception if the comment is more than 64Kb.
  *
  * \param[in] os  The output stream where the data is to be saved.
  */
 void ZipEndOfCentralDirectory::write(std::ostream & os)
 {
-    /** \todo
-     * Add support for 64 bit Zip archive. This would allow for pretty
-     * much all the following conditions to be dropped out.
-     */
     if(m_zip_comment.length() > 65535)
     {
         throw InvalidStateException("the Zip archive comment is too large");
     }
-    if(m_central_directory_entries > 65535)
-    {
-        throw InvalidStateException("the number of entries in the Zip archive is too large");
-    }
-// Solaris defines _ILP32 for 32 bit platforms
-#if INTPTR_MAX != INT32_MAX
-    if(m_central_directory_size   >= 0x100000000UL
-    || m_central_directory_offset >= 0x100000000L)
+
+    bool const zip64(m_central_directory_entries >= 0xFFFF
+                  || m_central_directory_size    >= 0xFFFFFFFF
+                  || m_central_directory_offset  >= 0xFFFFFFFF);
+    if(zip64)
     {
-        throw FileCollectionException("the Zip archive size or offset are too large"); // LCOV_EXCL_LINE
+        uint64_t const record_size(56 - 12);
+        uint16_t const version(ZipLocalEntry::g_zip64_format_version);
+        uint32_t const disk(0);
+        uint64_t const entries(m_central_directory_entries);
+        uint64_t const size(m_central_directory_size);
+        uint64_t const offset(m_central_directory_offset);
+        uint64_t const record_offset(offset + size);
+        uint32_t const total_disks(1);
+
+        zipWrite(os, g_zip64_signature);            // 32
+        zipWrite(os, record_size);                  // 64
+        zipWrite(os, version);                      // 16
+        zipWrite(os, version);                      // 16
+        zipWrite(os, disk);                         // 32
+        zipWrite(os, disk);                         // 32
+        zipWrite(os, entries);                      // 64
+        zipWrite(os, entries);                      // 64
+        zipWrite(os, size);                         // 64
+        zipWrite(os, offset);                       // 64
+
+        zipWrite(os, g_zip64_locator_signature);    // 32
+        zipWrite(os, disk);                         // 32
+        zipWrite(os, record_offset);                // 64
+        zipWrite(os, total_disks);                  // 32
     }
-#endif
 
     uint16_t const disk_number(0);
-    uint16_t const central_directory_entries(m_central_directory_entries);
-    uint32_t const central_directory_size(m_central_directory_size);
-    uint32_t const central_directory_offset(m_central_directory_offset);
+    uint16_t const central_directory_entries(std::min<size_t>(m_central_directory_entries, 0xFFFF));
+    uint32_t const central_directory_size(std::min<uint64_t>(m_central_directory_size, 0xFFFFFFFF));
+    uint32_t const central_directory_offset(std::min<uint64_t>(m_central_directory_offset, 0xFFFFFFFF));
     uint16_t const comment_len(m_zip_comment.length());
 
     // the total number of entries, across all disks is the same in our
@@ -48,13 +48,18 @@ public:
                         ZipEndOfCentralDirectory(std::string const & zip_comment = std::string());
 
     size_t              getCentralDirectorySize() const;
+    std::string const & getComment() const;
     size_t              getCount() const;
     offset_t            getOffset() const;
+    offset_t            getZip64Offset() const;
+    bool                needsZip64() const;
     void                setCentralDirectorySize(size_t size);
     void                setCount(size_t c);
     void                setOffset(offset_t new_offset);
 
     bool                read(::zipios::buffer_t const & buf, size_t pos);
+    bool                readZip64Locator(::zipios::buffer_t const & buf, size_t pos);
+    bool                readZip64(::zipios::buffer_t const & buf, size_t pos);
     void                write(std::ostream & os);
 
 private:
@@ -62,6 +67,7 @@ private:
     size_t              m_central_directory_entries = 0;
     size_t              m_central_directory_size = 0;
     offset_t            m_central_directory_offset = 0;
+    offset_t            m_zip64_offset = 0;
     std::string         m_zip_comment = std::string();
 };
 
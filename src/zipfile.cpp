@@ -28,16 +28,34 @@
 
 #include "zipios/zipfile.hpp"
 
+#include "zipios/codec.hpp"
 #include "zipios/streamentry.hpp"
 #include "zipios/zipiosexceptions.hpp"
 
-#include "backbuffer.hpp"
+#include "codecpool.hpp"
+#include "crc32.hpp"
+#include "deflatebackend.hpp"
+#include "inflateindex.hpp"
+#include "memorystreambuf.hpp"
+#include "randomaccessfile.hpp"
+#include "randomaccessstreambuf.hpp"
+#include "zipcatalog.hpp"
 #include "zipendofcentraldirectory.hpp"
 #include "zipcentraldirectoryentry.hpp"
 #include "zipinputstream.hpp"
 #include "zipoutputstream.hpp"
+#include "zlibbackend.hpp"
 
+#include <algorithm>
+#include <condition_variable>
+#include <filesystem>
 #include <fstream>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+#include <string.h>
 
 
 /** \brief The zipios namespace includes the Zipios library definitions.
@@ -266,347 +284,2872 @@ namespace zipios
  */
 
 
-/** \class ZipFile
- * \brief The ZipFile class represents a collection of files.
+namespace
+{
+
+
+/** \brief Minimum number of entries verified by one thread.
  *
- * ZipFile is a FileCollection, where the files are stored
- * in a .zip file.
+ * When verifying the local headers of a Zip archive in parallel, each
+ * thread is given at least this many entries. Smaller archives are
+ * verified using fewer threads (possibly just the calling thread).
  */
+size_t const g_minimum_entries_per_thread = 64;
 
 
-
-/** \brief Open a zip archive that was previously appended to another file.
- *
- * Opens a Zip archive embedded in another file, by writing the zip
- * archive to the end of the file followed by the start offset of
- * the zip file on 4 bytes. The offset must be written in zip-file
- * byte-order (little endian).
+/** \brief Maximum size of the End of Central Directory.
  *
- * The program appendzip, which is part of the Zipios distribution can
- * be used to append a Zip archive to a file, e.g. a binary program.
+ * The End of Central Directory is 22 bytes followed by a comment of at
+ * most 65535 bytes. A valid Zip archive has its End of Central Directory
+ * signature within that many bytes from the end of the file.
+ */
+offset_t const g_end_of_central_directory_window = 22 + 65535;
+
+
+/** \brief Size of the Zip64 End of Central Directory locator.
  *
- * The function may throw various exception if the named file does not
- * seem to include a valid zip archive attached.
+ * The locator appears right before the End of Central Directory of
+ * Zip64 archives.
+ */
+offset_t const g_zip64_locator_size = 20;
+
+
+/** \brief Size of the fixed part of the Zip64 End of Central Directory.
  *
- * \note
- * Only one file can be appended and opened in this way. Although
- * the appendzip tool can be used to append any number of files,
- * only the last one is accessible.
+ * The record may be followed by an extensible data sector which we
+ * ignore.
+ */
+offset_t const g_zip64_end_of_central_directory_size = 56;
+
+
+/** \brief Search for the last End of Central Directory signature.
  *
- * \exception FileCollectionException
- * This exception is raised if the initialization fails. The function verifies
- * that the input stream represents what is considered a valid zip file.
+ * This function searches \p buf backward, starting right before
+ * position \p end, for the "PK\5\6" signature of an End of Central
+ * Directory. The search for the 'P' makes use of memrchr() when
+ * available since the C library has it vectorized.
  *
- * \param[in] filename  The filename of your executable (generally, argv[0]).
+ * \param[in] buf  The buffer to search.
+ * \param[in] end  The position right after the first position to check.
  *
- * \return A ZipFile that one can use to read compressed data.
+ * \return The position of the signature or std::string::npos.
  */
-ZipFile::pointer_t ZipFile::openEmbeddedZipFile(std::string const & filename)
+size_t findEndOfCentralDirectorySignature(buffer_t const & buf, size_t end)
 {
-    // open zipfile, read 4 last bytes close file
-    uint32_t start_offset;
+    unsigned char const * s(buf.data());
+    while(end > 0)
     {
-        std::ifstream ifs(filename, std::ios::in | std::ios::binary);
-        ifs.seekg(-4, std::ios::end);
-        zipRead(ifs, start_offset);
-        // todo: add support for 64 bit (files of more than 4Gb)
+#ifdef __GLIBC__
+        unsigned char const * p(static_cast<unsigned char const *>(memrchr(s, 'P', end)));
+        if(p == nullptr)
+        {
+            break;
+        }
+        size_t const pos(p - s);
+#else
+        size_t const pos(end - 1);
+        if(s[pos] != 'P')
+        {
+            --end;
+            continue;
+        }
+#endif
+        if(pos + 4 <= buf.size()
+        && s[pos + 1] == 'K'
+        && s[pos + 2] == 0x05
+        && s[pos + 3] == 0x06)
+        {
+            return pos;
+        }
+        end = pos;
     }
 
-    // create ZipFile object from embedded data
-    return std::make_shared<ZipFile>(filename, start_offset, 4);
+    return std::string::npos;
 }
 
 
-/** \brief Initialize a ZipFile object.
- *
- * This is the default constructor of the ZipFile object.
+/** \brief Throw the consistency error.
  *
- * Note that an empty ZipFile is marked as invalid. More or less, such
- * an object is useless although it is useful to have this constructor
- * if you want to work with maps or vectors of ZipFile objects.
+ * This function throws the exception raised whenever the local header
+ * of an entry does not match its Central Directory entry.
  */
-ZipFile::ZipFile()
+[[noreturn]] void throwInconsistentLocalHeader()
 {
+    throw FileCollectionException("Zip file consistency problem. Zip file data fields are inconsistent with zip file layout.");
 }
 
 
-/** \brief Initialize a ZipFile object from an existing file.
- *
- * This constructor opens the named zip file. If the zip "file" is
- * embedded in a file that contains other data, e.g. a binary
- * program, the offset of the zip file start and end must be
- * specified.
+/** \brief Verify one local header using an input stream.
  *
- * If the file cannot be opened or the Zip directory cannot
- * be read, then the constructor throws an exception.
+ * This function reads the local header of \p entry from \p is and
+ * compares it against \p entry which was read from the Central
+ * Directory.
  *
  * \exception FileCollectionException
- * This exception is raised if the initialization fails. The function verifies
- * that the input stream represents what is considered a valid zip file.
+ * This exception is raised if the local header does not match.
  *
- * \param[in] filename  The filename of the zip file to open.
- * \param[in] s_off  Offset relative to the start of the file, that
- *                   indicates the beginning of the zip data in the file.
- * \param[in] e_off  Offset relative to the end of the file, that
- *                   indicates the end of the zip data in the file.
- *                   The offset is a positive number, even though the
- *                   offset goes toward the beginning of the file.
+ * \param[in] is  The stream to read the local header from.
+ * \param[in] vs  The virtual seeker used to access the archive in \p is.
+ * \param[in] entry  The Central Directory entry to compare against.
  */
-ZipFile::ZipFile(std::string const & filename, offset_t s_off, offset_t e_off)
-    : FileCollection(filename)
-    , m_vs(s_off, e_off)
+void verifyLocalHeader(std::istream & is, VirtualSeeker const & vs, FileEntry const & entry)
 {
-    std::ifstream zipfile(m_filename, std::ios::in | std::ios::binary);
-    if(!zipfile)
+    /** \TODO
+     * Make sure the entry offset is properly defined by
+     * ZipCentralDirectoryEntry.
+     *
+     * Also the isEqual() is a quite advanced (slow) test here!
+     */
+    vs.vseekg(is, entry.getEntryOffset(), std::ios::beg);
+    ZipLocalEntry zlh;
+    zlh.read(is);
+    if(!is || !zlh.isEqual(entry))
     {
-        throw IOException("Error opening Zip archive file for reading in binary mode.");
+        throwInconsistentLocalHeader();
     }
-
-    init(zipfile);
 }
 
 
-/** \brief Initialize a ZipFile object from an istream.
- *
- * This constructor opens the ZipFile from the specified istream. The
- * istream can be in memory or even an Internet stream. However, the
- * ZipFile algorithm requires a stream with proper back and forth seek
- * capabilities.
+/** \brief Read one local header using positional reads.
  *
- * If the Zip directory cannot be read, then the constructor throws an
- * exception.
+ * This function reads the local header of \p entry from \p file in
+ * \p zlh. It does not change any state shared with other threads
+ * so it can be called by several threads in parallel.
  *
- * \exception FileCollectionException
- * This exception is raised if the initialization fails. The function verifies
- * that the input stream represents what is considered a valid zip file.
+ * \param[in] file  The file to read the local header from.
+ * \param[in] start_offset  The offset of the archive in \p file.
+ * \param[in] entry  The Central Directory entry of the local header.
+ * \param[out] zlh  The local header.
  *
- * \param[in] is  The input stream with the zip file data.
- * \param[in] s_off  Offset relative to the start of the file, that
- *                   indicates the beginning of the zip data in the file.
- * \param[in] e_off  Offset relative to the end of the file, that
- *                   indicates the end of the zip data in the file.
- *                   The offset is a positive number, even though the
- *                   offset goes toward the beginning of the file.
+ * \return The position of the data of the entry in \p file.
  */
-ZipFile::ZipFile(std::istream & is, offset_t s_off, offset_t e_off)
-    : m_vs(s_off, e_off)
+offset_t readLocalHeader(RandomAccessFile const & file, offset_t start_offset, FileEntry const & entry, ZipLocalEntry & zlh)
 {
-    init(is);
+    offset_t const pos(start_offset + entry.getEntryOffset());
+
+    buffer_t header;
+    file.read(pos, header, 30 /* sizeof(ZipLocalEntryHeader) */);
+
+    uint16_t filename_len(0);
+    uint16_t extra_field_len(0);
+    size_t p(26);
+    zipRead(header, p, filename_len);
+    zipRead(header, p, extra_field_len);
+
+    buffer_t variable;
+    file.read(pos + header.size(), variable, filename_len + extra_field_len);
+    header += variable;
+
+    p = 0;
+    zlh.read(header, p);
+
+    // with a trailing data descriptor, the sizes and CRC are only
+    // found in the Central Directory entry, which is all we use
+    //
+    return pos + header.size();
 }
 
 
-/** \brief Initialize the ZipFile from the specified input stream.
+/** \brief Inflate a buffer in one go.
  *
- * This function finishes the initialization of the ZipFile from the
- * constructor. It is 100% private.
+ * This function inflates the raw deflate data found in \p in directly
+ * to \p out which must be exactly the size of the uncompressed data.
  *
- * \exception FileCollectionException
- * This exception is raised if the initialization fails. The function verifies
- * that the input stream represents what is considered a valid zip file.
+ * When available, libdeflate is used since it is faster than zlib
+ * when the whole buffer is known.
  *
- * \param[in] is  The input stream used to read the ZipFile.
+ * \exception IOException
+ * This exception is raised if the data cannot be inflated or its size
+ * is not exactly \p out_size.
+ *
+ * \param[in] in  The compressed data.
+ * \param[in] in_size  The size of the compressed data.
+ * \param[out] out  The buffer receiving the uncompressed data.
+ * \param[in] out_size  The size of the uncompressed data.
  */
-void ZipFile::init(std::istream & is)
+void inflateBuffer(char const * in, size_t in_size, void * out, size_t out_size)
 {
-    // Find and read the End of Central Directory.
-    ZipEndOfCentralDirectory eocd;
+    // the ZipOutputStreambuf writes no compressed data at all for
+    // empty DEFLATED entries
+    //
+    if(in_size == 0
+    && out_size == 0)
     {
-        BackBuffer bb(is, m_vs);
-        ssize_t read_p(-1);
-        for(;;)
-        {
-            if(read_p < 0)
-            {
-                if(!bb.readChunk(read_p))
-                {
-                    throw FileCollectionException("Unable to find zip structure: End-of-central-directory");
-                }
-            }
-            // Note: this is pretty fast since it reads from 'bb' which
-            //       caches the buffer the readChunk() function just read.
-            //
-            if(eocd.read(bb, read_p))
-            {
-                // found it!
-                break;
-            }
-            --read_p;
-        }
+        return;
     }
 
-    // Position read pointer to start of first entry in central dir.
-    m_vs.vseekg(is, eocd.getOffset(), std::ios::beg);
-
-    // TBD -- is that ", 0" still necessary? (With VC2012 and better)
-    // Give the second argument in the next line to keep Visual C++ quiet
-    //m_entries.resize(eocd.getCount(), 0);
-    m_entries.resize(eocd.getCount());
-
-    size_t const max_entry(eocd.getCount());
-    for(size_t entry_num(0); entry_num < max_entry; ++entry_num)
+    if(inflateWholeBuffer(in, in_size, out, out_size))
     {
-        m_entries[entry_num] = std::make_shared<ZipCentralDirectoryEntry>();
-        m_entries[entry_num].get()->read(is);
+        return;
     }
 
-    // Consistency check #1:
-    // The virtual seeker position is exactly the start offset of the
-    // Central Directory plus the Central Directory size
+    // zlib does not accept a null output pointer, even for empty files
     //
-    offset_t const pos(m_vs.vtellg(is));
-    if(static_cast<offset_t>(eocd.getOffset() + eocd.getCentralDirectorySize()) != pos)
-    {
-        throw FileCollectionException("Zip file consistency problem. Zip file data fields are inconsistent with zip file layout.");
-    }
+    Bytef empty(0);
 
-    // Consistency check #2:
-    // Are local headers consistent with CD headers?
+    // the streams of the pool inflate raw deflate data (no zlib header)
     //
-    for(auto it = m_entries.begin(); it != m_entries.end(); ++it)
-    {
-        /** \TODO
-         * Make sure the entry offset is properly defined by
-         * ZipCentralDirectoryEntry.
-         *
-         * Also the isEqual() is a quite advanced (slow) test here!
-         */
-        m_vs.vseekg(is, (*it)->getEntryOffset(), std::ios::beg);
-        ZipLocalEntry zlh;
-        zlh.read(is);
-        if(!is || !zlh.isEqual(**it))
+    CodecPool::stream_pointer_t zs(CodecPool::getInflateStream());
+    zs->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in));
+    zs->next_out = out_size == 0 ? &empty : reinterpret_cast<Bytef *>(out);
+
+    // the zlib counters are limited to 32 bits, Zip64 entries are fed
+    // in chunks
+    //
+    size_t const max_chunk(std::numeric_limits<uInt>::max());
+    size_t in_left(in_size);
+    size_t out_left(out_size);
+    int err(Z_OK);
+    do
+    {
+        size_t const in_chunk(std::min(in_left, max_chunk));
+        size_t const out_chunk(std::min(out_left, max_chunk));
+        zs->avail_in = static_cast<uInt>(in_chunk);
+        zs->avail_out = static_cast<uInt>(out_chunk);
+        bool const last(in_chunk == in_left && out_chunk == out_left);
+        err = inflate(zs.get(), last ? Z_FINISH : Z_NO_FLUSH);
+        in_left -= in_chunk - zs->avail_in;
+        out_left -= out_chunk - zs->avail_out;
+        if(last
+        || (err != Z_OK && err != Z_BUF_ERROR))
+        {
+            break;
+        }
+
+        // on a Z_BUF_ERROR without any progress the data is truncated
+        // or the output too small, retrying would loop forever
+        //
+        if(zs->avail_in == in_chunk
+        && zs->avail_out == out_chunk)
         {
-            throw FileCollectionException("Zip file consistency problem. Zip file data fields are inconsistent with zip file layout.");
+            break;
         }
     }
+    while(in_left > 0 || out_left > 0);
 
-    // we are all good!
-    m_valid = true;
+    if(err != Z_STREAM_END
+    || zs->total_out != out_size)
+    {
+        OutputStringStream msgs;
+        msgs << "ZipFile::readEntry(): inflate failed"
+             << ": " << (err == Z_STREAM_END ? "invalid uncompressed size" : zError(err == Z_OK ? Z_BUF_ERROR : err));
+        throw IOException(msgs.str());
+    }
 }
 
 
-/** \brief Create a clone of this ZipFile.
+/** \brief Decompress a buffer in one go using a codec.
  *
- * This function creates a heap allocated clone of the ZipFile object.
+ * This function decompresses the data found in \p in directly to \p out
+ * which must be exactly the size of the uncompressed data.
  *
- * \return A shared pointer to a copy of this ZipFile object.
+ * \exception IOException
+ * This exception is raised if the data cannot be decompressed or its
+ * size is not exactly \p out_size.
+ *
+ * \param[in] codec  The codec of the entry.
+ * \param[in] in  The compressed data.
+ * \param[in] in_size  The size of the compressed data.
+ * \param[out] out  The buffer receiving the uncompressed data.
+ * \param[in] out_size  The size of the uncompressed data.
  */
-FileCollection::pointer_t ZipFile::clone() const
+void decompressBuffer(Codec const & codec, char const * in, size_t in_size, void * out, size_t out_size)
 {
-    return FileCollection::pointer_t(std::make_shared<ZipFile>(*this));
+    Decompressor::pointer_t decompressor(codec.createDecompressor());
+    char * output(reinterpret_cast<char *>(out));
+    size_t output_size(out_size);
+    bool end(false);
+    do
+    {
+        size_t const before(in_size + output_size);
+        end = decompressor->decompress(in, in_size, output, output_size);
+        if(!end
+        && in_size + output_size == before)
+        {
+            // no progress: the data is truncated or larger than expected
+            //
+            break;
+        }
+    }
+    while(!end);
+
+    if(!end
+    || output_size != 0)
+    {
+        throw IOException("ZipFile::readEntry(): " + codec.getName() + " decompression failed: invalid uncompressed size");
+    }
 }
 
 
-/** \brief Clean up the ZipFile object.
+/** \brief Verify one local header using positional reads.
  *
- * The destructor ensures that any ZipFile data gets flushed
- * out before returning.
+ * This function reads the local header of \p entry from \p file and
+ * compares it against \p entry which was read from the Central
+ * Directory. It does not change any state shared with other threads
+ * so it can be called by several threads in parallel.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the local header does not match.
+ *
+ * \param[in] file  The file to read the local header from.
+ * \param[in] start_offset  The offset of the archive in \p file.
+ * \param[in] entry  The Central Directory entry to compare against.
+ *
+ * \return The position of the data as returned by readLocalHeader().
  */
-ZipFile::~ZipFile()
+offset_t verifyLocalHeader(RandomAccessFile const & file, offset_t start_offset, FileEntry const & entry)
 {
-    close();
+    ZipLocalEntry zlh;
+    offset_t const data(readLocalHeader(file, start_offset, entry, zlh));
+    if(!zlh.isEqual(entry))
+    {
+        throwInconsistentLocalHeader();
+    }
+    return data;
 }
 
 
-/** \brief Retrieve a pointer to a file in the Zip archive.
- *
- * This function returns a shared pointer to an istream defined from the
- * named entry, which gives you access to the corresponding file defined
- * in the Zip archive.
- *
- * The function returns nullptr if there is no entry with the
- * specified name in this ZipFile.
- *
- * Note that the function returns a smart pointer to an istream. The
- * ZipFile class does not hold that pointer meaning that
- * if you call getInputStream() multiple times with the same
- * \p entry_name parameter, you get different istream instance each
- * time.
+/** \brief Write one entry of a collection.
  *
- * By default the \p entry_name parameter is expected to match the full
- * path and filename (MatchPath::MATCH). If you are looking for a file
- * and want to ignore the path, set the matchpath parameter
- * to MatchPath::IGNORE.
+ * This function writes the local header and the data of \p entry
+ * to \p output_stream.
  *
- * \note
- * If the file is compressed inside the Zip archive, this input stream
- * returns the uncompressed data transparently to you (outside of the
- * time it takes to decompress the data, of course.)
+ * The input stream is opened before the entry gets added because
+ * adding it changes the offset of entries read from a ZipFile.
  *
- * \param[in] entry_name  The name of the file to search in the collection.
- * \param[in] matchpath  Whether the full path or just the filename is matched.
+ * When a \p policy is defined, the first bytes of the data are read
+ * first and the policy chooses the method and level of the entry. The
+ * policy is applied to a copy so \p entry remains unchanged.
  *
- * \return A shared pointer to an open istream for the specified entry.
+ * \param[in,out] output_stream  The stream receiving the entry.
+ * \param[in] collection  The collection the entry comes from.
+ * \param[in] entry  The entry to write.
+ * \param[in] policy  The compression policy or nullptr.
  *
- * \sa CollectionCollection
- * \sa DirectoryCollection
- * \sa FileCollection
+ * \return The ZipCentralDirectoryEntry saved in the archive.
  */
-ZipFile::stream_pointer_t ZipFile::getInputStream(std::string const & entry_name, MatchPath matchpath)
+FileEntry::pointer_t writeEntry(
+      ZipOutputStream & output_stream
+    , FileCollection & collection
+    , FileEntry::pointer_t entry
+    , CompressionPolicy const * policy)
 {
-    mustBeValid();
+    // the ZipOutputStream would create the same Central Directory entry
+    //
+    if(dynamic_cast<ZipCentralDirectoryEntry *>(entry.get()) == nullptr)
+    {
+        entry = std::make_shared<ZipCentralDirectoryEntry>(*entry);
+    }
+    else if(policy != nullptr)
+    {
+        entry = entry->clone();
+    }
 
-    // TODO: see whether we could make the handling of the StreamEntry
-    //       non-special
+    // we need to include the data of that file in the output buffer
+    // if it is not a directory and the file is not an empty file
     //
-    FileEntry::pointer_t entry(getEntry(entry_name, matchpath));
-    StreamEntry::pointer_t stream(std::dynamic_pointer_cast<StreamEntry>(entry));
-    if(stream != nullptr)
+    FileCollection::stream_pointer_t is;
+    if(!entry->isDirectory()
+    && entry->getSize() > 0)
     {
-        stream_pointer_t zis(std::make_shared<ZipInputStream>(stream->getStream()));
-        return zis;
+        is = collection.getInputStream(entry->getName());
     }
-    else if(entry != nullptr)
+
+    std::vector<char> sample;
+    if(policy != nullptr)
     {
-        stream_pointer_t zis(std::make_shared<ZipInputStream>(m_filename, entry->getEntryOffset() + m_vs.startOffset()));
-        return zis;
+        if(is != nullptr
+        && is->good())
+        {
+            sample.resize(policy->getSampleSize());
+            is->read(sample.data(), sample.size());
+            sample.resize(is->gcount());
+        }
+        policy->apply(*entry, sample.data(), sample.size());
+    }
+
+    output_stream.putNextEntry(entry);
+
+    output_stream.write(sample.data(), sample.size());
+    if(is != nullptr
+    && is->good()
+    && (sample.empty() || is->peek() != std::istream::traits_type::eof()))
+    {
+        // copy the file content to the output
+        //
+        output_stream << is->rdbuf();
     }
 
-    // no entry with that name (and match) available
-    return nullptr;
+    return entry;
 }
 
 
-/** \brief Create a Zip archive from the specified FileCollection.
+/** \brief An entry compressed by a worker thread.
  *
- * This function is expected to be used with a DirectoryCollection
- * that you created to save the collection in an archive.
+ * This structure holds the result of the compression of one entry:
+ * the entry to save in the Central Directory and its local header
+ * followed by its compressed data. When the entry is too large to be
+ * buffered, m_entry remains nullptr.
+ */
+struct compressed_entry_t
+{
+    typedef std::shared_ptr<compressed_entry_t>     pointer_t;
+
+    FileEntry::pointer_t    m_entry = FileEntry::pointer_t();
+    std::string             m_data = std::string();
+    std::exception_ptr      m_exception = std::exception_ptr();
+};
+
+
+/** \brief Compress one entry in memory.
  *
- * \param[in,out] os  The output stream where the Zip archive is saved.
- * \param[in] collection  The collection to save in this output stream.
- * \param[in] zip_comment  The global comment of the Zip archive.
+ * This function compresses \p entry exactly as writeEntry() would but
+ * to a memory buffer.
+ *
+ * When the store fallback of the \p policy is on and the compressed
+ * data is not smaller than the uncompressed data, the entry is saved
+ * again as STORED.
+ *
+ * \param[in] collection  The collection the entry comes from.
+ * \param[in] entry  The entry to compress.
+ * \param[in] block_size  The size of the blocks of deflated entries.
+ * \param[in] whole_buffer_limit  The size of the largest entry deflated
+ *                                with libdeflate.
+ * \param[in] policy  The compression policy or nullptr.
+ *
+ * \return The compressed entry.
  */
-void ZipFile::saveCollectionToArchive(
-      std::ostream & os
-    , FileCollection & collection
-    , std::string const & zip_comment)
+compressed_entry_t::pointer_t bufferEntry(
+      FileCollection & collection
+    , FileEntry::pointer_t entry
+    , size_t block_size
+    , size_t whole_buffer_limit
+    , CompressionPolicy const * policy)
 {
-    try
+    compressed_entry_t::pointer_t compressed(std::make_shared<compressed_entry_t>());
+    compressed->m_entry = entry;
+
+    auto write = [&](CompressionPolicy const * entry_policy)
     {
-        ZipOutputStream output_stream(os);
+        std::ostringstream buffer(std::ios::out | std::ios::binary);
+        ZipOutputStream output_stream(buffer);
 
-        output_stream.setComment(zip_comment);
+        // the blocks give the same output with one thread and the
+        // workers are already all busy
+        //
+        output_stream.setBlockSize(block_size, 1);
+        output_stream.setWholeBufferLimit(whole_buffer_limit);
+        compressed->m_entry = writeEntry(output_stream, collection, compressed->m_entry, entry_policy);
+        output_stream.closeEntry();
 
-        FileEntry::vector_t entries(collection.entries());
-        for(auto it(entries.begin()); it != entries.end(); ++it)
-        {
-            output_stream.putNextEntry(*it);
+        // the Central Directory written by the ZipOutputStream destructor
+        // is not part of the data
+        //
+        compressed->m_data = buffer.str();
+    };
+    write(policy);
 
-            // next we need to include the data of that file in the
-            // output buffer if it is not a directory and the file is
-            // not an empty file
-            //
-            if(!(*it)->isDirectory()
-            && (*it)->getSize() > 0)
-            {
-                // get an InputStream
-                //
-                FileCollection::stream_pointer_t is(collection.getInputStream((*it)->getName()));
-                if(is != nullptr
-                && is->good())
+    if(policy != nullptr
+    && policy->getStoreFallback()
+    && !compressed->m_entry->isDirectory()
+    && compressed->m_entry->getMethod() != StorageMethod::STORED
+    && compressed->m_entry->getCompressedSize() >= compressed->m_entry->getSize())
+    {
+        // compressing did not help, save the data as is
+        //
+        compressed->m_entry->setMethod(StorageMethod::STORED);
+        compressed->m_entry->setLevel(FileEntry::COMPRESSION_LEVEL_NONE);
+        static_cast<ZipLocalEntry *>(compressed->m_entry.get())->setExtractVersion(ZipLocalEntry::g_zip_format_version);
+        write(nullptr);
+    }
+
+    return compressed;
+}
+
+
+/** \brief Compress the entries of a collection in parallel.
+ *
+ * This class starts worker threads which compress the entries of a
+ * collection in memory buffers, in order. The writer retrieves the
+ * buffers with get(), also in order. The workers never get more than
+ * two buffers per thread ahead of the writer.
+ */
+class ParallelCompressor
+{
+public:
+                            ParallelCompressor(
+                                      FileCollection & collection
+                                    , FileEntry::vector_t const & entries
+                                    , size_t threads
+                                    , size_t buffer_limit
+                                    , size_t block_size
+                                    , size_t whole_buffer_limit
+                                    , CompressionPolicy const * policy);
+                            ParallelCompressor(ParallelCompressor const & rhs) = delete;
+                            ~ParallelCompressor();
+
+    ParallelCompressor &    operator = (ParallelCompressor const & rhs) = delete;
+
+    compressed_entry_t::pointer_t
+                            get(size_t idx);
+
+private:
+    void                    run();
+    compressed_entry_t::pointer_t
+                            compress(FileEntry::pointer_t entry);
+
+    FileCollection &        m_collection;
+    FileEntry::vector_t const &
+                            m_entries;
+    size_t const            m_buffer_limit;
+    size_t const            m_block_size;
+    size_t const            m_whole_buffer_limit;
+    CompressionPolicy const *
+                            m_policy;
+    size_t const            m_window;
+    std::mutex              m_mutex = std::mutex();
+    std::condition_variable m_condition = std::condition_variable();
+    std::vector<compressed_entry_t::pointer_t>
+                            m_compressed = std::vector<compressed_entry_t::pointer_t>();
+    size_t                  m_next = 0;
+    size_t                  m_written = 0;
+    bool                    m_stop = false;
+    std::vector<std::thread>
+                            m_threads = std::vector<std::thread>();
+};
+
+
+/** \brief Start the worker threads.
+ *
+ * \param[in] collection  The collection being saved.
+ * \param[in] entries  The entries of the collection.
+ * \param[in] threads  The number of worker threads.
+ * \param[in] buffer_limit  The size of the largest entry to buffer.
+ * \param[in] block_size  The size of the blocks of deflated entries.
+ * \param[in] whole_buffer_limit  The size of the largest entry deflated
+ *                                with libdeflate.
+ * \param[in] policy  The compression policy or nullptr.
+ */
+ParallelCompressor::ParallelCompressor(
+          FileCollection & collection
+        , FileEntry::vector_t const & entries
+        , size_t threads
+        , size_t buffer_limit
+        , size_t block_size
+        , size_t whole_buffer_limit
+        , CompressionPolicy const * policy)
+    : m_collection(collection)
+    , m_entries(entries)
+    , m_buffer_limit(buffer_limit)
+    , m_block_size(block_size)
+    , m_whole_buffer_limit(whole_buffer_limit)
+    , m_policy(policy)
+    , m_window(threads * 2)
+    , m_compressed(entries.size())
+{
+    for(size_t t(0); t < threads; ++t)
+    {
+        m_threads.emplace_back(&ParallelCompressor::run, this);
+    }
+}
+
+
+/** \brief Stop the worker threads.
+ *
+ * The destructor stops the workers, which may still be running if the
+ * writer failed, and waits for them.
+ */
+ParallelCompressor::~ParallelCompressor()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_condition.notify_all();
+    for(auto & t : m_threads)
+    {
+        t.join();
+    }
+}
+
+
+/** \brief Retrieve a compressed entry.
+ *
+ * This function waits until the entry at index \p idx was compressed
+ * and returns it. The entries must be retrieved in order.
+ *
+ * \exception std::exception
+ * Any exception raised while compressing the entry is rethrown here.
+ *
+ * \param[in] idx  The index of the entry to retrieve.
+ *
+ * \return The compressed entry.
+ */
+compressed_entry_t::pointer_t ParallelCompressor::get(size_t idx)
+{
+    compressed_entry_t::pointer_t compressed;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this, idx]() { return m_compressed[idx] != nullptr; });
+        compressed.swap(m_compressed[idx]);
+        m_written = idx + 1;
+    }
+    m_condition.notify_all();
+
+    if(compressed->m_exception != nullptr)
+    {
+        std::rethrow_exception(compressed->m_exception);
+    }
+
+    return compressed;
+}
+
+
+/** \brief Compress entries until all are done.
+ *
+ * This function is the main loop of a worker thread.
+ */
+void ParallelCompressor::run()
+{
+    for(;;)
+    {
+        size_t idx(0);
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]()
+                {
+                    return m_stop
+                        || m_next >= m_entries.size()
+                        || m_next < m_written + m_window;
+                });
+            if(m_stop
+            || m_next >= m_entries.size())
+            {
+                return;
+            }
+            idx = m_next;
+            ++m_next;
+        }
+
+        compressed_entry_t::pointer_t compressed;
+        try
+        {
+            compressed = compress(m_entries[idx]);
+        }
+        catch(...)
+        {
+            compressed = std::make_shared<compressed_entry_t>();
+            compressed->m_exception = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_compressed[idx] = compressed;
+        }
+        m_condition.notify_all();
+    }
+}
+
+
+/** \brief Compress one entry in memory.
+ *
+ * This function compresses \p entry exactly as the writer would but
+ * to a memory buffer. Entries larger than the buffer limit are not
+ * compressed and get returned without an entry.
+ *
+ * \param[in] entry  The entry to compress.
+ *
+ * \return The compressed entry.
+ */
+compressed_entry_t::pointer_t ParallelCompressor::compress(FileEntry::pointer_t entry)
+{
+    if(!entry->isDirectory()
+    && entry->getSize() > m_buffer_limit)
+    {
+        return std::make_shared<compressed_entry_t>();
+    }
+
+    return bufferEntry(m_collection, entry, m_block_size, m_whole_buffer_limit, m_policy);
+}
+
+
+/** \brief Save the entries of a collection.
+ *
+ * This function compresses and saves the \p entries of \p collection
+ * in \p output_stream as defined by the \p options. It is used to
+ * create new archives and to append to existing ones. The comment and
+ * streaming mode of \p output_stream are expected to be set already.
+ *
+ * See ZipFile::saveCollectionToArchive() for details.
+ *
+ * \param[in,out] output_stream  The stream receiving the entries.
+ * \param[in] collection  The collection the entries come from.
+ * \param[in] entries  The entries to save.
+ * \param[in] options  The options used to save the entries.
+ */
+void saveEntries(
+      ZipOutputStream & output_stream
+    , FileCollection & collection
+    , FileEntry::vector_t const & entries
+    , ZipFile::SaveOptions const & options)
+{
+    bool const streaming(output_stream.isStreaming());
+
+    size_t threads(options.getThreads());
+    if(threads == 0)
+    {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    // the entries written by this thread use all the threads for
+    // their blocks
+    //
+    output_stream.setBlockSize(options.getBlockSize(), threads);
+
+    size_t const whole_buffer_limit(options.getDeflateBackend() == ZipFile::DeflateBackend::LIBDEFLATE
+                                        ? options.getBufferLimit()
+                                        : 0);
+    output_stream.setWholeBufferLimit(whole_buffer_limit);
+
+    threads = std::min(threads, entries.size());
+
+    CompressionPolicy const * policy(options.getCompressionPolicy().get());
+    if(threads <= 1)
+    {
+        for(auto it(entries.begin()); it != entries.end(); ++it)
+        {
+            if(((policy != nullptr && policy->getStoreFallback()) || streaming)
+            && ((*it)->isDirectory() || (*it)->getSize() <= options.getBufferLimit()))
+            {
+                // the store fallback needs the compressed data
+                // in memory; when streaming, the entries buffered
+                // by the workers have no data descriptor so we
+                // buffer the same ones to get the same archive
+                //
+                compressed_entry_t::pointer_t compressed(bufferEntry(
+                              collection
+                            , *it
+                            , options.getBlockSize()
+                            , whole_buffer_limit
+                            , policy));
+                output_stream.putBufferedEntry(compressed->m_entry, compressed->m_data);
+            }
+            else
+            {
+                writeEntry(output_stream, collection, *it, policy);
+            }
+        }
+    }
+    else
+    {
+        ParallelCompressor compressor(
+                  collection
+                , entries
+                , threads
+                , options.getBufferLimit()
+                , options.getBlockSize()
+                , whole_buffer_limit
+                , policy);
+        for(size_t idx(0); idx < entries.size(); ++idx)
+        {
+            compressed_entry_t::pointer_t compressed(compressor.get(idx));
+            if(compressed->m_entry == nullptr)
+            {
+                // too large to be buffered
+                //
+                writeEntry(output_stream, collection, entries[idx], policy);
+            }
+            else
+            {
+                output_stream.putBufferedEntry(compressed->m_entry, compressed->m_data);
+            }
+        }
+    }
+}
+
+
+} // no name namespace
+
+
+
+/** \class ZipFile
+ * \brief The ZipFile class represents a collection of files.
+ *
+ * ZipFile is a FileCollection, where the files are stored
+ * in a .zip file.
+ */
+
+
+
+/** \enum ZipFile::Verification
+ * \brief How the local headers get verified when opening a ZipFile.
+ *
+ * Each entry of a Zip archive is described twice: once in the Central
+ * Directory and once in a local header just before the data of the
+ * entry. The ZipFile verifies that both descriptions match. This
+ * requires one random read per entry which can be very slow on cold
+ * storage with archives of many entries. This enumeration lets you
+ * choose when that verification happens.
+ *
+ * \var ZipFile::Verification::EAGER
+ * All the local headers are verified by the constructor. When the
+ * ZipFile is opened from a filename, the headers are read in parallel
+ * using positional reads. This is the default.
+ *
+ * \var ZipFile::Verification::LAZY
+ * The local header of an entry is verified the first time the
+ * getInputStream() function is called for that entry.
+ *
+ * \var ZipFile::Verification::NONE
+ * The local headers are never verified. Only use this mode with
+ * archives you trust.
+ */
+
+
+/** \brief The seek indexes of the DEFLATED entries.
+ *
+ * This structure holds one InflateIndex per entry found in the Central
+ * Directory. The indexes get created the first time a stream gets
+ * opened for that entry.
+ */
+struct ZipFile::inflate_indexes_t
+{
+    std::mutex                          m_mutex = std::mutex();
+    std::vector<InflateIndex::pointer_t>
+                                        m_indexes = std::vector<InflateIndex::pointer_t>();
+};
+
+
+/** \enum ZipFile::CRCVerification
+ * \brief When the data read from the archive gets verified.
+ *
+ * Each entry of a Zip archive includes the CRC-32 and size of its
+ * uncompressed data. This enumeration defines when the data returned
+ * by getInputStream() and readEntry() gets verified against those
+ * values.
+ *
+ * The CRC-32 is computed while the data is read. A stream reports an
+ * error once it reaches the end of the data: the read fails with the
+ * badbit set or the IOException gets rethrown if the stream exceptions
+ * include the badbit. readEntry() throws an IOException.
+ *
+ * \var ZipFile::CRCVerification::NONE
+ * The data is never verified. This is the default.
+ *
+ * \var ZipFile::CRCVerification::ALWAYS
+ * The data is verified each time it is read.
+ *
+ * \var ZipFile::CRCVerification::FIRST_READ
+ * The data of an entry is verified until it was read once successfully.
+ * After that, the entry is trusted.
+ */
+
+
+/** \enum ZipFile::Access
+ * \brief How the ZipFile accesses the archive file.
+ *
+ * This enumeration defines how a ZipFile opened from a filename reads
+ * the archive.
+ *
+ * \var ZipFile::Access::STREAM
+ * The archive is read with an std::ifstream and each stream returned
+ * by getInputStream() opens its own std::ifstream. This is the default.
+ *
+ * \var ZipFile::Access::POSITIONAL_READ
+ * The archive is opened once and read with positional reads (pread()
+ * on POSIX systems). The streams returned by getInputStream() share
+ * that file so they do not open the file again and they can be used
+ * from any number of threads at the same time. The position of the
+ * data of each entry is cached once its local header was read so
+ * further streams read the data directly.
+ *
+ * \var ZipFile::Access::MEMORY_MAP
+ * The archive is memory mapped once. The Central Directory, the local
+ * headers, and the data of the entries are read directly from the
+ * mapping. STORED data is returned in place and DEFLATED data is
+ * inflated without first being copied to a buffer. The pages are
+ * shared with other processes mapping the same archive. The positions
+ * of the data are cached as in Access::POSITIONAL_READ mode. Under
+ * MS-Windows, files do not get mapped and this mode works like
+ * Access::POSITIONAL_READ.
+ */
+
+
+/** \enum ZipFile::DeflateBackend
+ * \brief The library used to deflate the entries.
+ *
+ * This enumeration defines which library deflates the entries saved by
+ * saveCollectionToArchive().
+ *
+ * \var ZipFile::DeflateBackend::ZLIB
+ * The entries are deflated with the zlib API, which is zlib or zlib-ng
+ * depending on how the library was compiled. This is the default.
+ *
+ * \var ZipFile::DeflateBackend::LIBDEFLATE
+ * The entries up to the buffer limit are deflated in one call with
+ * libdeflate which is faster and compresses better than zlib. The
+ * larger entries are deflated with zlib. If libdeflate is not found
+ * at runtime, all the entries are deflated with zlib. The archive
+ * remains the same whatever the number of threads.
+ */
+
+
+/** \class ZipFile::OpenOptions
+ * \brief Options used when opening a ZipFile.
+ *
+ * This class holds the options one can pass to the ZipFile constructor.
+ * The default options give the same behavior as the ZipFile constructors
+ * which do not take options.
+ */
+
+
+/** \brief Retrieve the access mode.
+ *
+ * This function returns the access mode. By default it is set to
+ * Access::STREAM.
+ *
+ * \return The access mode.
+ */
+ZipFile::Access ZipFile::OpenOptions::getAccess() const
+{
+    return m_access;
+}
+
+
+/** \brief Change the access mode.
+ *
+ * This function changes the way the ZipFile accesses the archive file.
+ * It has no effect on a ZipFile created from an std::istream.
+ *
+ * \param[in] access  The new access mode.
+ */
+void ZipFile::OpenOptions::setAccess(Access access)
+{
+    m_access = access;
+}
+
+
+/** \brief Retrieve the local header verification mode.
+ *
+ * This function returns the verification mode. By default it is set
+ * to Verification::EAGER.
+ *
+ * \return The local header verification mode.
+ */
+ZipFile::Verification ZipFile::OpenOptions::getVerification() const
+{
+    return m_verification;
+}
+
+
+/** \brief Change the local header verification mode.
+ *
+ * This function changes the verification mode used by the ZipFile
+ * constructor.
+ *
+ * \param[in] verification  The new verification mode.
+ *
+ * \sa ZipFile::Verification
+ */
+void ZipFile::OpenOptions::setVerification(Verification verification)
+{
+    m_verification = verification;
+}
+
+
+/** \brief Retrieve the number of threads used by the verification.
+ *
+ * This function returns the maximum number of threads used to verify
+ * the local headers in Verification::EAGER mode. Zero (the default)
+ * means that the number of hardware threads is used.
+ *
+ * \return The maximum number of verification threads.
+ */
+size_t ZipFile::OpenOptions::getVerificationThreads() const
+{
+    return m_verification_threads;
+}
+
+
+/** \brief Change the number of threads used by the verification.
+ *
+ * This function sets the maximum number of threads used to verify the
+ * local headers in Verification::EAGER mode. Use 1 to verify serially
+ * and 0 to use one thread per hardware thread.
+ *
+ * \param[in] threads  The maximum number of verification threads.
+ */
+void ZipFile::OpenOptions::setVerificationThreads(size_t threads)
+{
+    m_verification_threads = threads;
+}
+
+
+/** \brief Check whether the entries are created lazily.
+ *
+ * This function returns true if the ZipFile only creates FileEntry
+ * objects when they are requested. By default it is false.
+ *
+ * \return true if the lazy entries mode is turned on.
+ */
+bool ZipFile::OpenOptions::getLazyEntries() const
+{
+    return m_lazy_entries;
+}
+
+
+/** \brief Change whether the entries are created lazily.
+ *
+ * By default, the ZipFile constructor creates one FileEntry object per
+ * entry found in the Central Directory. When \p lazy is true, the
+ * ZipFile instead keeps a raw copy of the Central Directory and only
+ * creates a FileEntry when getEntry() or entries() returns it. This
+ * is much faster to open and uses much less memory when only a few
+ * entries of a large archive get used.
+ *
+ * \warning
+ * In lazy mode, each call to getEntry() or entries() returns new
+ * FileEntry objects. Modifying those objects has no effect on the
+ * ZipFile.
+ *
+ * \param[in] lazy  Whether the lazy entries mode is used.
+ */
+void ZipFile::OpenOptions::setLazyEntries(bool lazy)
+{
+    m_lazy_entries = lazy;
+}
+
+
+/** \brief Retrieve the span between seek index access points.
+ *
+ * This function returns the number of uncompressed bytes between two
+ * access points of the seek index of DEFLATED entries. By default it
+ * is 0 meaning that no index is kept.
+ *
+ * \return The span between two access points or 0.
+ */
+offset_t ZipFile::OpenOptions::getSeekIndexSpan() const
+{
+    return m_seek_index_span;
+}
+
+
+/** \brief Change the span between seek index access points.
+ *
+ * The streams returned by getInputStream() can be seeked with seekg().
+ * For DEFLATED entries, seeking backward means inflating the data again
+ * from the start of the entry. When \p span is not 0, the ZipFile keeps
+ * an index per DEFLATED entry with one access point about every
+ * \p span bytes of uncompressed data. Each access point saves the
+ * 32Kb window of the inflater so a seek only inflates the data from the
+ * nearest access point instead.
+ *
+ * The index of an entry is built while its data gets read and it is
+ * shared by all the streams of that entry. A seek past the data read
+ * so far inflates the data up to that position and adds the missing
+ * access points on the way. Each access point uses a little over 32Kb
+ * of memory.
+ *
+ * \param[in] span  The span between two access points or 0 to not
+ *                  keep an index.
+ */
+void ZipFile::OpenOptions::setSeekIndexSpan(offset_t span)
+{
+    m_seek_index_span = std::max(span, static_cast<offset_t>(0));
+}
+
+
+
+/** \brief Retrieve the CRC-32 verification mode.
+ *
+ * This function returns the CRC-32 verification mode. By default it is
+ * set to CRCVerification::NONE.
+ *
+ * \return The CRC-32 verification mode.
+ */
+ZipFile::CRCVerification ZipFile::OpenOptions::getCRCVerification() const
+{
+    return m_crc_verification;
+}
+
+
+/** \brief Change the CRC-32 verification mode.
+ *
+ * This function changes when the data read from the archive gets
+ * verified against the CRC-32 and size of its entry.
+ *
+ * \note
+ * A stream stops verifying its data once seekg() was used to change
+ * its position since the data is not read sequentially anymore.
+ *
+ * \param[in] verification  The new CRC-32 verification mode.
+ *
+ * \sa ZipFile::CRCVerification
+ */
+void ZipFile::OpenOptions::setCRCVerification(CRCVerification verification)
+{
+    m_crc_verification = verification;
+}
+
+
+/** \brief Retrieve the I/O policy.
+ *
+ * This function returns the I/O policy used by the streams returned
+ * by getInputStream(). By default the buffers are getBufferSize()
+ * bytes and there is no read-ahead.
+ *
+ * \return The I/O policy.
+ */
+IOPolicy const & ZipFile::OpenOptions::getIOPolicy() const
+{
+    return m_io_policy;
+}
+
+
+/** \brief Change the I/O policy.
+ *
+ * This function sets the size of the buffers of the streams returned
+ * by getInputStream() and their read-ahead. The read-ahead is only
+ * used with Access::POSITIONAL_READ and Access::MEMORY_MAP.
+ *
+ * \param[in] policy  The new I/O policy.
+ */
+void ZipFile::OpenOptions::setIOPolicy(IOPolicy const & policy)
+{
+    m_io_policy = policy;
+}
+
+
+
+/** \class ZipFile::SaveOptions
+ * \brief Options used when saving a collection to an archive.
+ *
+ * This class holds the options one can pass to the
+ * saveCollectionToArchive() function. The default options give the same
+ * behavior as the saveCollectionToArchive() function which does not take
+ * options.
+ */
+
+
+/** \brief Retrieve the number of threads used to compress the entries.
+ *
+ * This function returns the number of threads used to compress the
+ * entries. By default it is 1, meaning that the entries are compressed
+ * one after the other by the calling thread.
+ *
+ * \return The number of threads or 0 for one per hardware thread.
+ */
+size_t ZipFile::SaveOptions::getThreads() const
+{
+    return m_threads;
+}
+
+
+/** \brief Change the number of threads used to compress the entries.
+ *
+ * This function sets the number of worker threads used to compress the
+ * entries in parallel. Use 1 to compress them serially and 0 to use one
+ * thread per hardware thread. The output is the same whatever the
+ * number of threads.
+ *
+ * \param[in] threads  The number of threads.
+ */
+void ZipFile::SaveOptions::setThreads(size_t threads)
+{
+    m_threads = threads;
+}
+
+
+/** \brief Retrieve the size of the largest entry compressed in memory.
+ *
+ * This function returns the size of the largest entry that a worker
+ * thread compresses in a memory buffer. By default it is 16Mb.
+ *
+ * \return The buffer limit in bytes.
+ */
+size_t ZipFile::SaveOptions::getBufferLimit() const
+{
+    return m_buffer_limit;
+}
+
+
+/** \brief Change the size of the largest entry compressed in memory.
+ *
+ * When compressing with several threads, the workers compress entries
+ * in memory buffers. Entries larger than \p limit bytes are instead
+ * compressed directly to the output by the writer thread, which bounds
+ * the memory used to about 2 x threads x \p limit bytes.
+ *
+ * \param[in] limit  The size of the largest entry compressed in memory.
+ */
+void ZipFile::SaveOptions::setBufferLimit(size_t limit)
+{
+    m_buffer_limit = limit;
+}
+
+
+/** \brief Retrieve the size of the blocks of large entries.
+ *
+ * This function returns the size of the blocks used to compress large
+ * entries in parallel. By default it is 0, meaning that each entry is
+ * compressed as a single stream.
+ *
+ * \return The block size in bytes or 0.
+ */
+size_t ZipFile::SaveOptions::getBlockSize() const
+{
+    return m_block_size;
+}
+
+
+/** \brief Change the size of the blocks of large entries.
+ *
+ * Compressing entries in parallel does not help when one entry is much
+ * larger than the others, such as a database dump. With a block size,
+ * the data of each deflated entry gets cut in blocks of \p block_size
+ * bytes which are compressed separately, using as many threads as
+ * defined by setThreads(). The result is a standard deflate stream.
+ *
+ * Entries smaller than one block are saved as without this option.
+ * The archive only depends on the block size, not on the number of
+ * threads. A block size of 128Kb to 1Mb works well.
+ *
+ * \param[in] block_size  The size of the blocks or 0 to turn it off.
+ */
+void ZipFile::SaveOptions::setBlockSize(size_t block_size)
+{
+    m_block_size = block_size;
+}
+
+
+/** \brief Retrieve the deflate backend.
+ *
+ * This function returns the library used to deflate the entries. By
+ * default it is DeflateBackend::ZLIB.
+ *
+ * \return The deflate backend.
+ */
+ZipFile::DeflateBackend ZipFile::SaveOptions::getDeflateBackend() const
+{
+    return m_deflate_backend;
+}
+
+
+/** \brief Change the deflate backend.
+ *
+ * This function selects the library used to deflate the entries. With
+ * DeflateBackend::LIBDEFLATE, the entries up to the buffer limit (see
+ * setBufferLimit()) are deflated with libdeflate.
+ *
+ * \param[in] backend  The new deflate backend.
+ */
+void ZipFile::SaveOptions::setDeflateBackend(DeflateBackend backend)
+{
+    m_deflate_backend = backend;
+}
+
+
+/** \brief Retrieve the compression policy.
+ *
+ * This function returns the compression policy used to choose the
+ * method and level of each entry. By default there is none.
+ *
+ * \return The compression policy or nullptr.
+ */
+CompressionPolicy::pointer_t ZipFile::SaveOptions::getCompressionPolicy() const
+{
+    return m_compression_policy;
+}
+
+
+/** \brief Change the compression policy.
+ *
+ * Without a policy, the entries are saved with the method and level
+ * they already have, as defined by FileCollection::setMethod() and
+ * FileCollection::setLevel(). With a \p policy, the method and level
+ * of each entry get chosen from its name and the first bytes of its
+ * data when it gets saved. See the CompressionPolicy class for details.
+ *
+ * \param[in] policy  The compression policy or nullptr.
+ */
+void ZipFile::SaveOptions::setCompressionPolicy(CompressionPolicy::pointer_t policy)
+{
+    m_compression_policy = policy;
+}
+
+
+/** \brief Retrieve the I/O policy.
+ *
+ * This function returns the I/O policy used to write the archive.
+ *
+ * \return The I/O policy.
+ */
+IOPolicy const & ZipFile::SaveOptions::getIOPolicy() const
+{
+    return m_io_policy;
+}
+
+
+/** \brief Change the I/O policy.
+ *
+ * The output buffer size of the \p policy defines the size of the
+ * buffers used to compress the entries and therefore the size of the
+ * writes to the output stream.
+ *
+ * \param[in] policy  The new I/O policy.
+ */
+void ZipFile::SaveOptions::setIOPolicy(IOPolicy const & policy)
+{
+    m_io_policy = policy;
+}
+
+
+/** \brief Check whether the archive gets written in streaming mode.
+ *
+ * \return true if the streaming mode was requested.
+ *
+ * \sa setStreaming()
+ */
+bool ZipFile::SaveOptions::getStreaming() const
+{
+    return m_streaming;
+}
+
+
+/** \brief Write the archive without seeking in the output stream.
+ *
+ * In streaming mode, the entries which cannot be compressed in memory
+ * first, i.e. those larger than the buffer limit, are followed by a data
+ * descriptor instead of having their local header written again. This
+ * way the output stream can be a pipe or a socket.
+ *
+ * The streaming mode is used even when this option is false if the
+ * output stream cannot tell its position.
+ *
+ * \param[in] streaming  Whether to write the archive in streaming mode.
+ */
+void ZipFile::SaveOptions::setStreaming(bool streaming)
+{
+    m_streaming = streaming;
+}
+
+
+
+/** \brief Open a zip archive that was previously appended to another file.
+ *
+ * Opens a Zip archive embedded in another file, by writing the zip
+ * archive to the end of the file followed by the start offset of
+ * the zip file on 4 bytes. The offset must be written in zip-file
+ * byte-order (little endian).
+ *
+ * When the offset does not fit in 32 bits, it is written on 8 bytes
+ * followed by 0xFFFFFFFF on 4 bytes instead.
+ *
+ * The program appendzip, which is part of the Zipios distribution can
+ * be used to append a Zip archive to a file, e.g. a binary program.
+ *
+ * The function may throw various exception if the named file does not
+ * seem to include a valid zip archive attached.
+ *
+ * \note
+ * Only one file can be appended and opened in this way. Although
+ * the appendzip tool can be used to append any number of files,
+ * only the last one is accessible.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the initialization fails. The function verifies
+ * that the input stream represents what is considered a valid zip file.
+ *
+ * \param[in] filename  The filename of your executable (generally, argv[0]).
+ *
+ * \return A ZipFile that one can use to read compressed data.
+ */
+ZipFile::pointer_t ZipFile::openEmbeddedZipFile(std::string const & filename)
+{
+    // open zipfile, read 4 last bytes close file
+    uint32_t start_offset;
+    uint64_t start_offset64(0);
+    offset_t end_offset(4);
+    {
+        std::ifstream ifs(filename, std::ios::in | std::ios::binary);
+        ifs.seekg(-4, std::ios::end);
+        zipRead(ifs, start_offset);
+        start_offset64 = start_offset;
+        if(start_offset == 0xFFFFFFFF)
+        {
+            // the 64 bit offset is saved before the marker
+            //
+            ifs.seekg(-12, std::ios::end);
+            zipRead(ifs, start_offset64);
+            end_offset = 12;
+        }
+    }
+
+    // create ZipFile object from embedded data
+    return std::make_shared<ZipFile>(filename, start_offset64, end_offset);
+}
+
+
+/** \brief Initialize a ZipFile object.
+ *
+ * This is the default constructor of the ZipFile object.
+ *
+ * Note that an empty ZipFile is marked as invalid. More or less, such
+ * an object is useless although it is useful to have this constructor
+ * if you want to work with maps or vectors of ZipFile objects.
+ */
+ZipFile::ZipFile()
+{
+}
+
+
+/** \brief Initialize a ZipFile object from an existing file.
+ *
+ * This constructor opens the named zip file. If the zip "file" is
+ * embedded in a file that contains other data, e.g. a binary
+ * program, the offset of the zip file start and end must be
+ * specified.
+ *
+ * If the file cannot be opened or the Zip directory cannot
+ * be read, then the constructor throws an exception.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the initialization fails. The function verifies
+ * that the input stream represents what is considered a valid zip file.
+ *
+ * \param[in] filename  The filename of the zip file to open.
+ * \param[in] s_off  Offset relative to the start of the file, that
+ *                   indicates the beginning of the zip data in the file.
+ * \param[in] e_off  Offset relative to the end of the file, that
+ *                   indicates the end of the zip data in the file.
+ *                   The offset is a positive number, even though the
+ *                   offset goes toward the beginning of the file.
+ */
+ZipFile::ZipFile(std::string const & filename, offset_t s_off, offset_t e_off)
+    : ZipFile(filename, OpenOptions(), s_off, e_off)
+{
+}
+
+
+/** \brief Initialize a ZipFile object from an existing file.
+ *
+ * This constructor opens the named zip file using the specified
+ * \p options. See the other constructor for details about the
+ * offsets.
+ *
+ * When the verification mode is not Verification::NONE, the file
+ * is kept open for positional reads. In Verification::EAGER mode,
+ * those reads happen in parallel.
+ *
+ * When the access mode is Access::POSITIONAL_READ, the file is opened
+ * once and all the reads, including those of the streams returned by
+ * getInputStream(), are positional reads on that one file. When the
+ * access mode is Access::MEMORY_MAP, the file gets memory mapped and
+ * the reads are done directly from the mapping.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the initialization fails. The function verifies
+ * that the input stream represents what is considered a valid zip file.
+ *
+ * \param[in] filename  The filename of the zip file to open.
+ * \param[in] options  The options used to open the zip file.
+ * \param[in] s_off  Offset relative to the start of the file, that
+ *                   indicates the beginning of the zip data in the file.
+ * \param[in] e_off  Offset relative to the end of the file, that
+ *                   indicates the end of the zip data in the file.
+ *                   The offset is a positive number, even though the
+ *                   offset goes toward the beginning of the file.
+ */
+ZipFile::ZipFile(std::string const & filename, OpenOptions const & options, offset_t s_off, offset_t e_off)
+    : FileCollection(filename)
+    , m_vs(s_off, e_off)
+    , m_options(options)
+{
+    if(m_options.getAccess() != Access::STREAM)
+    {
+        m_file = std::make_shared<RandomAccessFile>(m_filename, m_options.getAccess() == Access::MEMORY_MAP);
+        std::unique_ptr<std::streambuf> buf;
+        if(m_file->data() != nullptr)
+        {
+            buf = std::make_unique<MemoryStreambuf>(m_file->data(), m_file->size());
+        }
+        else
+        {
+            buf = std::make_unique<RandomAccessStreambuf>(m_file);
+        }
+        std::istream zipfile(buf.get());
+        init(zipfile);
+        return;
+    }
+
+    std::ifstream zipfile(m_filename, std::ios::in | std::ios::binary);
+    if(!zipfile)
+    {
+        throw IOException("Error opening Zip archive file for reading in binary mode.");
+    }
+
+    if(m_options.getVerification() != Verification::NONE)
+    {
+        m_file = std::make_shared<RandomAccessFile>(m_filename);
+    }
+
+    init(zipfile);
+}
+
+
+/** \brief Initialize a ZipFile object from an istream.
+ *
+ * This constructor opens the ZipFile from the specified istream. The
+ * istream can be in memory or even an Internet stream. However, the
+ * ZipFile algorithm requires a stream with proper back and forth seek
+ * capabilities.
+ *
+ * If the Zip directory cannot be read, then the constructor throws an
+ * exception.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the initialization fails. The function verifies
+ * that the input stream represents what is considered a valid zip file.
+ *
+ * \param[in] is  The input stream with the zip file data.
+ * \param[in] s_off  Offset relative to the start of the file, that
+ *                   indicates the beginning of the zip data in the file.
+ * \param[in] e_off  Offset relative to the end of the file, that
+ *                   indicates the end of the zip data in the file.
+ *                   The offset is a positive number, even though the
+ *                   offset goes toward the beginning of the file.
+ */
+ZipFile::ZipFile(std::istream & is, offset_t s_off, offset_t e_off)
+    : ZipFile(is, OpenOptions(), s_off, e_off)
+{
+}
+
+
+/** \brief Initialize a ZipFile object from an istream.
+ *
+ * This constructor opens the ZipFile from the specified istream using
+ * the specified \p options. See the other constructor for details.
+ *
+ * \note
+ * Since an istream cannot be read by several threads, the
+ * Verification::EAGER mode verifies the local headers serially.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the initialization fails. The function verifies
+ * that the input stream represents what is considered a valid zip file.
+ *
+ * \param[in] is  The input stream with the zip file data.
+ * \param[in] options  The options used to open the zip file.
+ * \param[in] s_off  Offset relative to the start of the file, that
+ *                   indicates the beginning of the zip data in the file.
+ * \param[in] e_off  Offset relative to the end of the file, that
+ *                   indicates the end of the zip data in the file.
+ *                   The offset is a positive number, even though the
+ *                   offset goes toward the beginning of the file.
+ */
+ZipFile::ZipFile(std::istream & is, OpenOptions const & options, offset_t s_off, offset_t e_off)
+    : m_vs(s_off, e_off)
+    , m_options(options)
+{
+    init(is);
+}
+
+
+/** \brief Initialize the ZipFile from the specified input stream.
+ *
+ * This function finishes the initialization of the ZipFile from the
+ * constructor. It is 100% private.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the initialization fails. The function verifies
+ * that the input stream represents what is considered a valid zip file.
+ *
+ * \param[in] is  The input stream used to read the ZipFile.
+ */
+void ZipFile::init(std::istream & is)
+{
+    // Find and read the End of Central Directory.
+    //
+    // It is expected to be within the last 64Kb + 22 bytes of the file
+    // so we read that much at once and search it backward; if not found
+    // there (i.e. data was appended to the archive), we continue with
+    // the previous window and so on
+    //
+    m_vs.vseekg(is, 0, std::ios::end);
+    offset_t const zip_size(m_vs.vtellg(is));
+    if(zip_size < 0)
+    {
+        throw IOException("Invalid virtual file endings.");
+    }
+
+    ZipEndOfCentralDirectory eocd;
+    offset_t eocd_offset(0);
+    bool found(false);
+    for(offset_t scan_end(zip_size); !found && scan_end > 0; )
+    {
+        offset_t const start(std::max<offset_t>(0, scan_end - g_end_of_central_directory_window));
+        offset_t const stop(std::min(zip_size, scan_end + g_end_of_central_directory_window));
+        buffer_t tail;
+        m_vs.vseekg(is, start, std::ios::beg);
+        zipRead(is, tail, stop - start);
+
+        for(size_t end(scan_end - start);;)
+        {
+            size_t const pos(findEndOfCentralDirectorySignature(tail, end));
+            if(pos == std::string::npos)
+            {
+                break;
+            }
+            if(eocd.read(tail, pos))
+            {
+                eocd_offset = start + pos;
+                found = true;
+                break;
+            }
+            end = pos;
+        }
+
+        scan_end = start;
+    }
+    if(!found)
+    {
+        throw FileCollectionException("Unable to find zip structure: End-of-central-directory");
+    }
+
+    // Zip64 archives have a locator right before the End of Central
+    // Directory giving the position of the Zip64 End of Central Directory
+    // which has the 64 bit number of entries, size, and offset
+    //
+    if(eocd_offset >= g_zip64_locator_size)
+    {
+        buffer_t locator;
+        m_vs.vseekg(is, eocd_offset - g_zip64_locator_size, std::ios::beg);
+        zipRead(is, locator, g_zip64_locator_size);
+        if(eocd.readZip64Locator(locator, 0))
+        {
+            bool zip64(false);
+            if(eocd.getZip64Offset() + g_zip64_end_of_central_directory_size <= eocd_offset - g_zip64_locator_size)
+            {
+                buffer_t record;
+                m_vs.vseekg(is, eocd.getZip64Offset(), std::ios::beg);
+                zipRead(is, record, g_zip64_end_of_central_directory_size);
+                zip64 = eocd.readZip64(record, 0);
+            }
+
+            // a locator signature found by chance in a classic archive
+            // is fine as long as the archive does not need Zip64
+            //
+            if(!zip64
+            && eocd.needsZip64())
+            {
+                throw FileCollectionException("Zip64 End of Central Directory not found or invalid.");
+            }
+        }
+    }
+
+    // keep the position of the Central Directory and the comment
+    // for appendCollectionToArchive()
+    //
+    m_central_directory_offset = eocd.getOffset();
+    m_comment = eocd.getComment();
+
+    // Make sure the Central Directory fits in the file before we
+    // allocate a buffer for it
+    //
+    if(static_cast<offset_t>(eocd.getOffset() + eocd.getCentralDirectorySize()) > zip_size)
+    {
+        throw FileCollectionException("Zip file consistency problem. Zip file data fields are inconsistent with zip file layout.");
+    }
+
+    // Read the entire Central Directory with one I/O and then parse
+    // the entries from memory
+    //
+    // The End of Central Directory which follows is included (up to
+    // its maximum size) so an entry which goes past the declared size
+    // gets caught by consistency check #1 instead of an EOF error
+    //
+    size_t const central_directory_size(eocd.getCentralDirectorySize());
+    size_t const read_size(std::min(
+                  static_cast<size_t>(zip_size - eocd.getOffset())
+                , central_directory_size + 22 + 65535));
+    buffer_t central_directory;
+    m_vs.vseekg(is, eocd.getOffset(), std::ios::beg);
+    zipRead(is, central_directory, read_size);
+
+    size_t const max_entry(eocd.getCount());
+    size_t pos(0);
+    if(m_options.getLazyEntries())
+    {
+        std::shared_ptr<ZipCatalog> catalog(std::make_shared<ZipCatalog>(std::move(central_directory), max_entry));
+        pos = catalog->getCentralDirectorySize();
+        m_catalog = catalog;
+    }
+    else
+    {
+        m_entries.resize(max_entry);
+        for(size_t entry_num(0); entry_num < max_entry; ++entry_num)
+        {
+            std::shared_ptr<ZipCentralDirectoryEntry> entry(std::make_shared<ZipCentralDirectoryEntry>());
+            entry->read(central_directory, pos);
+            m_entries[entry_num] = entry;
+        }
+    }
+
+    // Consistency check #1:
+    // The entries use exactly the Central Directory size
+    //
+    if(pos != central_directory_size)
+    {
+        throw FileCollectionException("Zip file consistency problem. Zip file data fields are inconsistent with zip file layout.");
+    }
+
+    // Cache the position of the data of each entry when the streams
+    // share our file
+    //
+    if(m_file != nullptr
+    && m_options.getAccess() != Access::STREAM)
+    {
+        m_data_offsets = std::make_shared<data_offsets_t>(m_catalog != nullptr ? m_catalog->size() : m_entries.size());
+    }
+
+    // Remember which entries were verified once if requested
+    //
+    if(m_options.getCRCVerification() == CRCVerification::FIRST_READ)
+    {
+        m_data_verified = std::make_shared<verified_t>(m_catalog != nullptr ? m_catalog->size() : m_entries.size());
+    }
+
+    // Keep a seek index per entry if requested
+    //
+    if(m_options.getSeekIndexSpan() > 0)
+    {
+        m_inflate_indexes = std::make_shared<inflate_indexes_t>();
+        m_inflate_indexes->m_indexes.resize(m_catalog != nullptr ? m_catalog->size() : m_entries.size());
+    }
+
+    // Consistency check #2:
+    // Are local headers consistent with CD headers?
+    //
+    verifyEntries(is);
+
+    // build the name index now so lookups do not have to
+    // (in lazy entries mode, the catalog has its own index)
+    //
+    indexEntries();
+
+    // we are all good!
+    m_valid = true;
+}
+
+
+/** \brief Verify the local headers.
+ *
+ * This function verifies that the local headers match the Central
+ * Directory entries as defined by the verification mode found in the
+ * options.
+ *
+ * In Verification::EAGER mode, all the entries are verified now. If
+ * the archive was opened from a file, the work is shared between
+ * several threads, each reading the headers with positional reads.
+ * The exception raised is always the one of the first invalid entry,
+ * just as if the entries had been verified one after the other.
+ *
+ * In Verification::LAZY mode, the function allocates the flags used
+ * to remember which entries were verified.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if a local header does not match its
+ * Central Directory entry.
+ *
+ * \param[in] is  The input stream used to read the ZipFile.
+ */
+void ZipFile::verifyEntries(std::istream & is)
+{
+    switch(m_options.getVerification())
+    {
+    case Verification::EAGER:
+        break;
+
+    case Verification::LAZY:
+        m_verified = std::make_shared<verified_t>(m_catalog != nullptr ? m_catalog->size() : m_entries.size());
+        return;
+
+    case Verification::NONE:
+        return;
+
+    }
+
+    size_t const max_entry(m_catalog != nullptr ? m_catalog->size() : m_entries.size());
+    if(m_file == nullptr)
+    {
+        for(size_t idx(0); idx < max_entry; ++idx)
+        {
+            verifyLocalHeader(is, m_vs, *getArchiveEntry(idx));
+        }
+        return;
+    }
+
+    size_t threads(m_options.getVerificationThreads());
+    if(threads == 0)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    threads = std::min(threads, (max_entry + g_minimum_entries_per_thread - 1) / g_minimum_entries_per_thread);
+    if(threads <= 1)
+    {
+        for(size_t idx(0); idx < max_entry; ++idx)
+        {
+            setDataOffset(idx, verifyLocalHeader(*m_file, m_vs.startOffset(), *getArchiveEntry(idx)));
+        }
+        return;
+    }
+
+    // each thread verifies a contiguous range of entries; a thread stops
+    // as soon as a thread with a lower range failed since its own error
+    // would not be reported anyway
+    //
+    std::vector<std::exception_ptr> errors(threads);
+    std::atomic<size_t> first_failure(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for(size_t t(0); t < threads; ++t)
+    {
+        size_t const start(max_entry * t / threads);
+        size_t const end(max_entry * (t + 1) / threads);
+        workers.emplace_back([this, t, start, end, &errors, &first_failure]()
+            {
+                try
+                {
+                    for(size_t idx(start); idx < end && first_failure.load() > t; ++idx)
+                    {
+                        setDataOffset(idx, verifyLocalHeader(*m_file, m_vs.startOffset(), *getArchiveEntry(idx)));
+                    }
+                }
+                catch(...)
+                {
+                    errors[t] = std::current_exception();
+                    size_t expected(first_failure.load());
+                    while(expected > t
+                       && !first_failure.compare_exchange_weak(expected, t))
+                    {
+                    }
+                }
+            });
+    }
+    for(auto & w : workers)
+    {
+        w.join();
+    }
+
+    for(auto const & e : errors)
+    {
+        if(e != nullptr)
+        {
+            std::rethrow_exception(e);
+        }
+    }
+}
+
+
+/** \brief Verify the local header of one entry.
+ *
+ * This function is used in Verification::LAZY mode to verify the local
+ * header of the entry at index \p idx the first time it gets accessed.
+ * Once verified, the entry is marked as such and the function returns
+ * immediately on further calls.
+ *
+ * Entries that were added with addEntry() are not verified.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the local header does not match its
+ * Central Directory entry.
+ *
+ * \param[in] idx  The index of the entry to verify.
+ * \param[in] entry  The entry to verify.
+ */
+void ZipFile::verifyEntry(size_t idx, FileEntry const & entry)
+{
+    if(m_verified == nullptr
+    || idx >= m_verified->size()
+    || (*m_verified)[idx].load())
+    {
+        return;
+    }
+
+    if(m_file != nullptr)
+    {
+        setDataOffset(idx, verifyLocalHeader(*m_file, m_vs.startOffset(), entry));
+    }
+    else
+    {
+        std::ifstream is(m_filename, std::ios::in | std::ios::binary);
+        if(!is)
+        {
+            throw IOException("Error opening Zip archive file for reading in binary mode.");
+        }
+        verifyLocalHeader(is, m_vs, entry);
+    }
+
+    (*m_verified)[idx].store(true);
+}
+
+
+/** \brief Save the position of the data of an entry.
+ *
+ * This function saves the position of the data of the entry at index
+ * \p idx once its local header was read, so the streams returned by
+ * getInputStream() do not have to read the local header again.
+ *
+ * The function does nothing if the positions are not cached (i.e. in
+ * Access::STREAM mode) or \p data is 0.
+ *
+ * \param[in] idx  The index of the entry.
+ * \param[in] data  The position of the data of that entry.
+ */
+void ZipFile::setDataOffset(size_t idx, offset_t data) const
+{
+    if(m_data_offsets != nullptr
+    && idx < m_data_offsets->size()
+    && data != 0)
+    {
+        (*m_data_offsets)[idx].store(data);
+    }
+}
+
+
+/** \brief Get the position of the data of an entry.
+ *
+ * This function returns the position of the data of the entry at
+ * index \p idx. The first time, the local header gets read to
+ * determine that position.
+ *
+ * \param[in] idx  The index of the entry.
+ * \param[in] entry  The entry.
+ *
+ * \return The position of the data in the file.
+ */
+offset_t ZipFile::getDataOffset(size_t idx, FileEntry const & entry) const
+{
+    offset_t data((*m_data_offsets)[idx].load());
+    if(data == 0)
+    {
+        ZipLocalEntry zlh;
+        data = readLocalHeader(*m_file, m_vs.startOffset(), entry, zlh);
+        setDataOffset(idx, data);
+    }
+
+    return data;
+}
+
+
+/** \brief Get the seek index of an entry.
+ *
+ * This function returns the seek index of the entry at index \p idx.
+ * The index gets created the first time this function is called for
+ * that entry.
+ *
+ * The function returns nullptr if no seek indexes are kept (see
+ * OpenOptions::setSeekIndexSpan()), \p idx is not an entry of the
+ * archive, or the entry is not DEFLATED.
+ *
+ * \param[in] idx  The index of the entry.
+ * \param[in] entry  The entry.
+ *
+ * \return The seek index of the entry or nullptr.
+ */
+InflateIndex::pointer_t ZipFile::getInflateIndex(size_t idx, FileEntry const & entry) const
+{
+    if(m_inflate_indexes == nullptr
+    || idx >= m_inflate_indexes->m_indexes.size()
+    || entry.getMethod() != StorageMethod::DEFLATED)
+    {
+        return InflateIndex::pointer_t();
+    }
+
+    std::lock_guard<std::mutex> lock(m_inflate_indexes->m_mutex);
+    InflateIndex::pointer_t & index(m_inflate_indexes->m_indexes[idx]);
+    if(index == nullptr)
+    {
+        index = std::make_shared<InflateIndex>(m_options.getSeekIndexSpan());
+    }
+    return index;
+}
+
+
+/** \brief Check whether the data of an entry has to be verified.
+ *
+ * This function returns true if the data of the entry at index \p idx
+ * has to be verified against its CRC-32 and size when read.
+ *
+ * \param[in] idx  The index of the entry.
+ *
+ * \return true if the data has to be verified.
+ */
+bool ZipFile::mustVerifyData(size_t idx) const
+{
+    switch(m_options.getCRCVerification())
+    {
+    case CRCVerification::NONE:
+        return false;
+
+    case CRCVerification::ALWAYS:
+        return true;
+
+    case CRCVerification::FIRST_READ:
+        return m_data_verified == nullptr
+            || idx >= m_data_verified->size()
+            || !(*m_data_verified)[idx].load();
+
+    }
+
+    return true; // LCOV_EXCL_LINE
+}
+
+
+/** \brief Mark the data of an entry as verified.
+ *
+ * In CRCVerification::FIRST_READ mode, this function marks the data of
+ * the entry at index \p idx as verified so it does not get verified
+ * again.
+ *
+ * \param[in] idx  The index of the entry.
+ */
+void ZipFile::setDataVerified(size_t idx) const
+{
+    if(m_data_verified != nullptr
+    && idx < m_data_verified->size())
+    {
+        (*m_data_verified)[idx].store(true);
+    }
+}
+
+
+/** \brief Retrieve an entry read from the archive.
+ *
+ * This function returns the entry at index \p idx in the Central
+ * Directory. In lazy entries mode, the entry gets created from the
+ * catalog.
+ *
+ * \param[in] idx  The index of the entry in the Central Directory.
+ *
+ * \return The entry at index \p idx.
+ */
+FileEntry::pointer_t ZipFile::getArchiveEntry(size_t idx) const
+{
+    if(m_catalog != nullptr)
+    {
+        return m_catalog->getEntry(idx);
+    }
+    return m_entries[idx];
+}
+
+
+/** \brief Search for an entry and its index.
+ *
+ * This function searches for the entry named \p name. The entries
+ * found in the archive come first. In lazy entries mode, the entries
+ * added with addEntry() follow the catalog entries and their index
+ * starts at the size of the catalog.
+ *
+ * \param[in] name  A string containing the name of the entry to get.
+ * \param[in] matchpath  How the name of the entry is compared with \p name.
+ * \param[out] idx  The index of the entry found.
+ *
+ * \return A shared pointer to the found entry or nullptr.
+ */
+FileEntry::pointer_t ZipFile::findEntry(std::string_view name, MatchPath matchpath, size_t & idx) const
+{
+    mustBeValid();
+
+    if(m_catalog != nullptr)
+    {
+        idx = m_catalog->find(name, matchpath);
+        if(idx != g_no_entry)
+        {
+            return m_catalog->getEntry(idx);
+        }
+
+        size_t const added(findEntryIndex(name, matchpath));
+        if(added == g_no_entry)
+        {
+            return FileEntry::pointer_t();
+        }
+        idx = m_catalog->size() + added;
+        return m_entries[added];
+    }
+
+    idx = findEntryIndex(name, matchpath);
+    return idx == g_no_entry ? FileEntry::pointer_t() : m_entries[idx];
+}
+
+
+/** \brief Create a clone of this ZipFile.
+ *
+ * This function creates a heap allocated clone of the ZipFile object.
+ *
+ * \return A shared pointer to a copy of this ZipFile object.
+ */
+FileCollection::pointer_t ZipFile::clone() const
+{
+    return FileCollection::pointer_t(std::make_shared<ZipFile>(*this));
+}
+
+
+/** \brief Clean up the ZipFile object.
+ *
+ * The destructor ensures that any ZipFile data gets flushed
+ * out before returning.
+ */
+ZipFile::~ZipFile()
+{
+    close();
+}
+
+
+/** \brief Close the ZipFile.
+ *
+ * This function releases the entries and the catalog and marks the
+ * ZipFile as invalid.
+ */
+void ZipFile::close()
+{
+    m_catalog.reset();
+    m_verified.reset();
+    m_data_verified.reset();
+    m_data_offsets.reset();
+    m_inflate_indexes.reset();
+    m_file.reset();
+
+    FileCollection::close();
+}
+
+
+/** \brief Retrieve the entries of the ZipFile.
+ *
+ * This function returns a vector with all the entries of the ZipFile.
+ *
+ * In lazy entries mode, this function creates a FileEntry for each
+ * entry in the catalog. The entries added with addEntry() follow.
+ *
+ * \return A vector with the entries of this ZipFile.
+ */
+FileEntry::vector_t ZipFile::entries() const
+{
+    if(m_catalog == nullptr)
+    {
+        return FileCollection::entries();
+    }
+
+    mustBeValid();
+
+    size_t const max_entry(m_catalog->size());
+    FileEntry::vector_t result;
+    result.reserve(max_entry + m_entries.size());
+    for(size_t idx(0); idx < max_entry; ++idx)
+    {
+        result.push_back(m_catalog->getEntry(idx));
+    }
+    result += m_entries;
+
+    return result;
+}
+
+
+/** \brief Get an entry from the ZipFile.
+ *
+ * This function returns the entry named \p name. See
+ * FileCollection::getEntry() for details.
+ *
+ * In lazy entries mode, the entry gets created from the catalog.
+ *
+ * \param[in] name  A string containing the name of the entry to get.
+ * \param[in] matchpath  Specify MatchPath::MATCH, if the path should match
+ *                       as well, specify MatchPath::IGNORE, if the path
+ *                       should be ignored.
+ *
+ * \return A shared pointer to the found entry. The returned pointer
+ *         is null if no entry is found.
+ */
+FileEntry::pointer_t ZipFile::getEntry(std::string_view name, MatchPath matchpath) const
+{
+    size_t idx(0);
+    return findEntry(name, matchpath, idx);
+}
+
+
+/** \brief Retrieve the number of entries.
+ *
+ * This function returns the number of entries in the ZipFile.
+ *
+ * \return The number of entries.
+ */
+size_t ZipFile::size() const
+{
+    mustBeValid();
+
+    return (m_catalog != nullptr ? m_catalog->size() : 0) + m_entries.size();
+}
+
+
+/** \brief Retrieve a pointer to a file in the Zip archive.
+ *
+ * This function returns a shared pointer to an istream defined from the
+ * named entry, which gives you access to the corresponding file defined
+ * in the Zip archive.
+ *
+ * The function returns nullptr if there is no entry with the
+ * specified name in this ZipFile.
+ *
+ * Note that the function returns a smart pointer to an istream. The
+ * ZipFile class does not hold that pointer meaning that
+ * if you call getInputStream() multiple times with the same
+ * \p entry_name parameter, you get different istream instance each
+ * time.
+ *
+ * By default the \p entry_name parameter is expected to match the full
+ * path and filename (MatchPath::MATCH). If you are looking for a file
+ * and want to ignore the path, set the matchpath parameter
+ * to MatchPath::IGNORE.
+ *
+ * \note
+ * If the file is compressed inside the Zip archive, this input stream
+ * returns the uncompressed data transparently to you (outside of the
+ * time it takes to decompress the data, of course.)
+ *
+ * \note
+ * In Verification::LAZY mode, the local header of the entry gets
+ * verified the first time this function is called for that entry.
+ *
+ * \note
+ * When the data gets verified (see OpenOptions::setCRCVerification()),
+ * reaching the end of the data of an entry with an invalid CRC-32 or
+ * size sets the badbit of the returned stream.
+ *
+ * \note
+ * The returned stream supports seekg() and tellg(). Seeking in a
+ * DEFLATED entry inflates the data from the start or, when a seek index
+ * span was set in the OpenOptions, from the nearest access point.
+ *
+ * \exception FileCollectionException
+ * In Verification::LAZY mode, this exception is raised if the local
+ * header of the entry does not match its Central Directory entry.
+ *
+ * \param[in] entry_name  The name of the file to search in the collection.
+ * \param[in] matchpath  Whether the full path or just the filename is matched.
+ *
+ * \return A shared pointer to an open istream for the specified entry.
+ *
+ * \sa CollectionCollection
+ * \sa DirectoryCollection
+ * \sa FileCollection
+ */
+ZipFile::stream_pointer_t ZipFile::getInputStream(std::string const & entry_name, MatchPath matchpath)
+{
+    mustBeValid();
+
+    // TODO: see whether we could make the handling of the StreamEntry
+    //       non-special
+    //
+    size_t idx(0);
+    FileEntry::pointer_t entry(findEntry(entry_name, matchpath, idx));
+    if(entry == nullptr)
+    {
+        // no entry with that name (and match) available
+        return nullptr;
+    }
+
+    StreamEntry::pointer_t stream(std::dynamic_pointer_cast<StreamEntry>(entry));
+    if(stream != nullptr)
+    {
+        stream_pointer_t zis(std::make_shared<ZipInputStream>(stream->getStream()));
+        return zis;
+    }
+
+    verifyEntry(idx, *entry);
+
+    std::shared_ptr<ZipInputStream> zis;
+    if(m_data_offsets != nullptr
+    && idx < m_data_offsets->size())
+    {
+        zis = std::make_shared<ZipInputStream>(m_file, *entry, getDataOffset(idx, *entry), getInflateIndex(idx, *entry), m_options.getIOPolicy());
+    }
+    else
+    {
+        zis = std::make_shared<ZipInputStream>(m_filename, entry->getEntryOffset() + m_vs.startOffset(), getInflateIndex(idx, *entry), m_options.getIOPolicy(), entry.get());
+    }
+
+    if(mustVerifyData(idx))
+    {
+        // the callback keeps the flags alive so it can be called
+        // after this ZipFile is gone
+        //
+        verified_pointer_t verified(m_data_verified);
+        zis->verifyData([verified, idx]() noexcept
+            {
+                if(verified != nullptr
+                && idx < verified->size())
+                {
+                    (*verified)[idx].store(true);
+                }
+            });
+    }
+
+    return zis;
+}
+
+
+/** \brief Get an input stream to read the compressed data of an entry.
+ *
+ * This function returns an istream which reads the data of the named
+ * entry as it is saved in the Zip archive, i.e. without decompressing
+ * it. The stream returns exactly getCompressedSize() bytes.
+ *
+ * This is used to copy entries from one archive to another without
+ * decompressing and compressing their data again (see
+ * ZipOutputStream::putRawEntry()).
+ *
+ * The function returns nullptr if there is no entry with the
+ * specified name in this ZipFile.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the local header of the entry does not
+ * match its Central Directory entry or the data of the entry is not
+ * found in a file.
+ *
+ * \param[in] entry_name  The name of the file to search in the collection.
+ * \param[in] matchpath  Whether the full path or just the filename is matched.
+ *
+ * \return A shared pointer to an open istream for the compressed data.
+ *
+ * \sa getInputStream()
+ */
+ZipFile::stream_pointer_t ZipFile::getRawInputStream(std::string const & entry_name, MatchPath matchpath)
+{
+    mustBeValid();
+
+    size_t idx(0);
+    FileEntry::pointer_t entry(findEntry(entry_name, matchpath, idx));
+    if(entry == nullptr)
+    {
+        return nullptr;
+    }
+
+    if(std::dynamic_pointer_cast<StreamEntry>(entry) != nullptr)
+    {
+        throw FileCollectionException("ZipFile::getRawInputStream(): the compressed data of \"" + entry_name + "\" is not available.");
+    }
+
+    verifyEntry(idx, *entry);
+
+    // find the data of the entry
+    //
+    offset_t data(0);
+    RandomAccessFile::pointer_t file;
+    if(m_data_offsets != nullptr
+    && idx < m_data_offsets->size())
+    {
+        file = m_file;
+        data = getDataOffset(idx, *entry);
+    }
+    else
+    {
+        file = m_file != nullptr ? m_file : std::make_shared<RandomAccessFile>(m_filename);
+        ZipLocalEntry zlh;
+        data = readLocalHeader(*file, m_vs.startOffset(), *entry, zlh);
+    }
+
+    // the compressed data is read as if it were STORED
+    //
+    ZipLocalEntry raw(*entry);
+    raw.setMethod(StorageMethod::STORED);
+    raw.setSize(entry->getCompressedSize());
+    raw.setCompressedSize(entry->getCompressedSize());
+    return std::make_shared<ZipInputStream>(file, raw, data, InflateIndex::pointer_t(), m_options.getIOPolicy());
+}
+
+
+/** \brief Read the data of an entry in a buffer.
+ *
+ * This function reads the whole uncompressed data of the named entry
+ * in \p buffer. The size of the data is known from the Central
+ * Directory so no intermediate buffers are used: STORED data is read
+ * (or copied from the mapping in Access::MEMORY_MAP mode) directly to
+ * \p buffer and DEFLATED data is inflated to \p buffer in one call.
+ * This is much faster than reading small entries through the stream
+ * returned by getInputStream().
+ *
+ * \exception FileCollectionException
+ * This exception is raised if no entry is named \p entry_name.
+ *
+ * \exception InvalidException
+ * This exception is raised if \p size is smaller than the size of the
+ * entry.
+ *
+ * \exception IOException
+ * This exception is raised if the data cannot be read or inflated or,
+ * when the data gets verified (see OpenOptions::setCRCVerification()),
+ * its CRC-32 does not match the entry.
+ *
+ * \param[in] entry_name  The name of the file to read.
+ * \param[out] buffer  The buffer receiving the data.
+ * \param[in] size  The size of \p buffer.
+ * \param[in] matchpath  Whether the full path or just the filename is matched.
+ *
+ * \return The size of the entry, which is the number of bytes written
+ *         to \p buffer.
+ *
+ * \sa getInputStream()
+ */
+size_t ZipFile::readEntry(std::string const & entry_name, void * buffer, size_t size, MatchPath matchpath)
+{
+    mustBeValid();
+
+    size_t idx(0);
+    FileEntry::pointer_t entry(findEntry(entry_name, matchpath, idx));
+    if(entry == nullptr)
+    {
+        throw FileCollectionException("ZipFile::readEntry(): entry \"" + entry_name + "\" not found.");
+    }
+
+    size_t const uncompressed_size(entry->getSize());
+    if(uncompressed_size > size)
+    {
+        throw InvalidException("ZipFile::readEntry(): buffer too small for entry \"" + entry_name + "\".");
+    }
+
+    readEntryData(idx, entry, buffer);
+    return uncompressed_size;
+}
+
+
+/** \brief Read the data of an entry.
+ *
+ * This function reads the whole uncompressed data of the named entry
+ * and returns it in a buffer allocated once with the size found in
+ * the Central Directory. See the other readEntry() function for details.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if no entry is named \p entry_name.
+ *
+ * \exception IOException
+ * This exception is raised if the data cannot be read or inflated.
+ *
+ * \param[in] entry_name  The name of the file to read.
+ * \param[in] matchpath  Whether the full path or just the filename is matched.
+ *
+ * \return A buffer with the data of the entry.
+ */
+FileEntry::buffer_t ZipFile::readEntry(std::string const & entry_name, MatchPath matchpath)
+{
+    mustBeValid();
+
+    size_t idx(0);
+    FileEntry::pointer_t entry(findEntry(entry_name, matchpath, idx));
+    if(entry == nullptr)
+    {
+        throw FileCollectionException("ZipFile::readEntry(): entry \"" + entry_name + "\" not found.");
+    }
+
+    FileEntry::buffer_t result(entry->getSize());
+    readEntryData(idx, entry, result.data());
+    return result;
+}
+
+
+/** \brief Read the data of an entry in a buffer.
+ *
+ * This function reads the whole uncompressed data of \p entry in
+ * \p buffer which must be at least the size of the entry. Both
+ * readEntry() functions use it once they found the entry so its name
+ * gets searched only once.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the entry uses an unsupported compression
+ * method or its STORED sizes differ.
+ *
+ * \exception IOException
+ * This exception is raised if the data cannot be read or decompressed
+ * or its CRC-32 does not match the entry.
+ *
+ * \param[in] idx  The index of the entry in the archive.
+ * \param[in] entry  The entry to read.
+ * \param[out] buffer  The buffer receiving the data.
+ */
+void ZipFile::readEntryData(size_t idx, FileEntry::pointer_t entry, void * buffer)
+{
+    size_t const uncompressed_size(entry->getSize());
+
+    StreamEntry::pointer_t stream(std::dynamic_pointer_cast<StreamEntry>(entry));
+    if(stream != nullptr)
+    {
+        ZipInputStream zis(stream->getStream());
+        zis.read(reinterpret_cast<char *>(buffer), uncompressed_size);
+        if(static_cast<size_t>(zis.gcount()) != uncompressed_size)
+        {
+            throw IOException("ZipFile::readEntry(): EOF reached while reading entry.");
+        }
+        return;
+    }
+
+    verifyEntry(idx, *entry);
+
+    // find the data of the entry
+    //
+    offset_t data(0);
+    RandomAccessFile::pointer_t file;
+    if(m_data_offsets != nullptr
+    && idx < m_data_offsets->size())
+    {
+        file = m_file;
+        data = getDataOffset(idx, *entry);
+    }
+    else
+    {
+        file = m_file != nullptr ? m_file : std::make_shared<RandomAccessFile>(m_filename);
+        ZipLocalEntry zlh;
+        data = readLocalHeader(*file, m_vs.startOffset(), *entry, zlh);
+    }
+
+    size_t const compressed_size(entry->getCompressedSize());
+    switch(entry->getMethod())
+    {
+    case StorageMethod::STORED:
+        if(compressed_size != uncompressed_size)
+        {
+            throw FileCollectionException("ZipFile::readEntry(): the compressed and uncompressed sizes of a STORED entry differ.");
+        }
+        if(file->data() != nullptr)
+        {
+            if(data + static_cast<offset_t>(uncompressed_size) > file->size())
+            {
+                throw IOException("ZipFile::readEntry(): EOF reached while reading entry.");
+            }
+            memcpy(buffer, file->data() + data, uncompressed_size);
+        }
+        else if(file->read(data, buffer, uncompressed_size) != uncompressed_size)
+        {
+            throw IOException("ZipFile::readEntry(): EOF reached while reading entry.");
+        }
+        break;
+
+    case StorageMethod::DEFLATED:
+        if(file->data() != nullptr)
+        {
+            if(data + static_cast<offset_t>(compressed_size) > file->size())
+            {
+                throw IOException("ZipFile::readEntry(): EOF reached while reading entry.");
+            }
+            inflateBuffer(file->data() + data, compressed_size, buffer, uncompressed_size);
+        }
+        else
+        {
+            buffer_t compressed;
+            file->read(data, compressed, compressed_size);
+            inflateBuffer(reinterpret_cast<char const *>(compressed.data()), compressed.size(), buffer, uncompressed_size);
+        }
+        break;
+
+    default:
+    {
+        Codec::pointer_t codec(Codec::getCodec(entry->getMethod()));
+        if(codec == nullptr)
+        {
+            throw FileCollectionException("Unsupported compression format");
+        }
+        if(file->data() != nullptr)
+        {
+            if(data + static_cast<offset_t>(compressed_size) > file->size())
+            {
+                throw IOException("ZipFile::readEntry(): EOF reached while reading entry.");
+            }
+            decompressBuffer(*codec, file->data() + data, compressed_size, buffer, uncompressed_size);
+        }
+        else
+        {
+            buffer_t compressed;
+            file->read(data, compressed, compressed_size);
+            decompressBuffer(*codec, reinterpret_cast<char const *>(compressed.data()), compressed.size(), buffer, uncompressed_size);
+        }
+        break;
+    }
+
+    }
+
+    if(mustVerifyData(idx))
+    {
+        if(updateCRC32(0, buffer, uncompressed_size) != entry->getCrc())
+        {
+            throw IOException("ZipFile::readEntry(): the CRC-32 of the data of \"" + entry->getName() + "\" does not match its entry.");
+        }
+        setDataVerified(idx);
+    }
+
+}
+
+
+/** \brief Create a Zip archive from the specified FileCollection.
+ *
+ * This function is expected to be used with a DirectoryCollection
+ * that you created to save the collection in an archive.
+ *
+ * The entries are compressed one after the other. See the other
+ * saveCollectionToArchive() function to compress them in parallel.
+ *
+ * \param[in,out] os  The output stream where the Zip archive is saved.
+ * \param[in] collection  The collection to save in this output stream.
+ * \param[in] zip_comment  The global comment of the Zip archive.
+ */
+void ZipFile::saveCollectionToArchive(
+      std::ostream & os
+    , FileCollection & collection
+    , std::string const & zip_comment)
+{
+    saveCollectionToArchive(os, collection, zip_comment, SaveOptions());
+}
+
+
+/** \brief Create a Zip archive from the specified FileCollection.
+ *
+ * This function saves the \p collection in \p os using the specified
+ * \p options.
+ *
+ * When more than one thread is used, worker threads compress the
+ * entries in memory buffers while the calling thread writes them in
+ * the order of the collection. The resulting archive is byte for byte
+ * the same as the one created with a single thread. Entries larger
+ * than the buffer limit are not buffered; the calling thread compresses
+ * them directly to \p os when their turn comes. At most two buffers per
+ * thread are kept in memory at once.
+ *
+ * When a block size is defined, the deflated entries are cut in blocks
+ * which get compressed in parallel too. This is mainly useful for an
+ * archive with one very large entry.
+ *
+ * With DeflateBackend::LIBDEFLATE, the entries up to the buffer limit
+ * are deflated with libdeflate, whether they are compressed by a worker
+ * or by the calling thread, so the archive does not depend on the
+ * number of threads either.
+ *
+ * With a compression policy, the method and level of each entry are
+ * chosen when it gets saved. When the policy store fallback is on,
+ * the entries up to the buffer limit are compressed in memory first
+ * so they can be saved as STORED if they did not get smaller.
+ *
+ * In streaming mode (see SaveOptions::setStreaming()) \p os does not
+ * need to support seeking. The entries up to the buffer limit are
+ * compressed in memory first and the larger ones get a data descriptor.
+ *
+ * The getInputStream() function of the \p collection gets called from
+ * the worker threads so it has to be thread safe. It is for all the
+ * collections offered by the library.
+ *
+ * \param[in,out] os  The output stream where the Zip archive is saved.
+ * \param[in] collection  The collection to save in this output stream.
+ * \param[in] zip_comment  The global comment of the Zip archive.
+ * \param[in] options  The options used to save the archive.
+ */
+void ZipFile::saveCollectionToArchive(
+      std::ostream & os
+    , FileCollection & collection
+    , std::string const & zip_comment
+    , SaveOptions const & options)
+{
+    try
+    {
+        ZipOutputStream output_stream(os, options.getIOPolicy());
+
+        output_stream.setComment(zip_comment);
+        if(options.getStreaming())
+        {
+            output_stream.setStreaming(true);
+        }
+
+        saveEntries(output_stream, collection, collection.entries(), options);
+
+        // clean up manually so we can get any exception
+        // (so we avoid having exceptions gobbled by the destructor)
+        output_stream.closeEntry();
+        output_stream.finish();
+        output_stream.close();
+    }
+    catch(...)
+    {
+        os.setstate(std::ios::failbit);
+        throw;
+    }
+}
+
+
+/** \brief Append the entries of a collection to an existing Zip archive.
+ *
+ * This function appends the entries of \p collection to the Zip archive
+ * named \p filename using the default options. See the other
+ * appendCollectionToArchive() function for details.
+ *
+ * \param[in] filename  The name of the Zip archive to append to.
+ * \param[in] collection  The collection to append to the archive.
+ */
+void ZipFile::appendCollectionToArchive(
+      std::string const & filename
+    , FileCollection & collection)
+{
+    appendCollectionToArchive(filename, collection, SaveOptions());
+}
+
+
+/** \brief Append the entries of a collection to an existing Zip archive.
+ *
+ * This function adds the entries of \p collection to the Zip archive
+ * named \p filename without rewriting it. The local headers and data
+ * of the entries already in the archive are kept as is. The new entries
+ * get written where the Central Directory of the archive started and a
+ * new Central Directory with the existing entries followed by the new
+ * ones is written at the end. The time it takes therefore depends on
+ * the size of the new entries, not on the size of the archive.
+ *
+ * An entry of \p collection with the same name as an existing entry
+ * replaces it. The data of the old entry remains in the archive but
+ * it is not referenced by the Central Directory anymore.
+ *
+ * The global comment of the archive is kept.
+ *
+ * The \p options are used as by saveCollectionToArchive().
+ *
+ * \warning
+ * The Central Directory of the archive gets overwritten by the new
+ * entries. If this function fails, the archive is not valid anymore.
+ *
+ * \exception IOException
+ * This exception is raised if the archive cannot be read or written.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if \p filename is not a valid Zip archive.
+ *
+ * \param[in] filename  The name of the Zip archive to append to.
+ * \param[in] collection  The collection to append to the archive.
+ * \param[in] options  The options used to save the new entries.
+ */
+void ZipFile::appendCollectionToArchive(
+      std::string const & filename
+    , FileCollection & collection
+    , SaveOptions const & options)
+{
+    FileEntry::vector_t const entries(collection.entries());
+
+    // only the Central Directory is needed, the local headers and the
+    // data do not get read
+    //
+    OpenOptions open_options;
+    open_options.setVerification(Verification::NONE);
+    open_options.setIOPolicy(options.getIOPolicy());
+    ZipFile zf(filename, open_options);
+
+    std::unordered_set<std::string> names;
+    for(auto const & entry : entries)
+    {
+        names.insert(entry->getName());
+    }
+    FileEntry::vector_t existing;
+    for(auto const & entry : zf.entries())
+    {
+        if(names.find(entry->getName()) == names.end())
+        {
+            existing.push_back(entry);
+        }
+    }
+    offset_t const central_directory_offset(zf.m_central_directory_offset);
+    std::string const comment(zf.m_comment);
+    zf.close();
+
+    std::fstream os(filename, std::ios::in | std::ios::out | std::ios::binary);
+    if(!os.seekp(central_directory_offset))
+    {
+        throw IOException("ZipFile::appendCollectionToArchive(): could not open \"" + filename + "\" for writing.");
+    }
+
+    {
+        ZipOutputStream output_stream(os, options.getIOPolicy());
+
+        output_stream.setComment(comment);
+        if(options.getStreaming())
+        {
+            output_stream.setStreaming(true);
+        }
+        output_stream.addExistingEntries(existing);
+
+        saveEntries(output_stream, collection, entries, options);
+
+        // clean up manually so we can get any exception
+        // (so we avoid having exceptions gobbled by the destructor)
+        output_stream.closeEntry();
+        output_stream.finish();
+        output_stream.close();
+    }
+
+    // the new archive can be smaller than the old one, for example if
+    // data followed its End of Central Directory
+    //
+    offset_t const size(os.tellp());
+    os.close();
+    if(!os)
+    {
+        throw IOException("ZipFile::appendCollectionToArchive(): could not write \"" + filename + "\".");   // LCOV_EXCL_LINE
+    }
+    if(static_cast<offset_t>(std::filesystem::file_size(filename)) > size)
+    {
+        std::filesystem::resize_file(filename, size);
+    }
+}
+
+
+/** \brief Merge the entries of several Zip archives in a new archive.
+ *
+ * This function saves the entries of all the Zip archives named in
+ * \p filenames to \p os. The compressed data of each entry is copied
+ * as is, it does not get decompressed and compressed again (see
+ * getRawInputStream()).
+ *
+ * When several archives include an entry with the same name, only the
+ * first one is saved.
+ *
+ * When a \p filter is defined, it gets called with each entry and only
+ * the entries for which it returns true are saved.
+ *
+ * \exception IOException
+ * This exception is raised if an archive cannot be read or the output
+ * cannot be written.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if one of the files is not a valid Zip
+ * archive.
+ *
+ * \param[in,out] os  The output stream where the Zip archive is saved.
+ * \param[in] filenames  The names of the Zip archives to merge.
+ * \param[in] filter  The function selecting the entries to save or nullptr.
+ */
+void ZipFile::mergeArchives(
+      std::ostream & os
+    , std::vector<std::string> const & filenames
+    , entry_filter_t const & filter)
+{
+    try
+    {
+        ZipOutputStream output_stream(os);
+
+        std::unordered_set<std::string> names;
+        for(auto const & filename : filenames)
+        {
+            ZipFile zf(filename);
+            for(auto const & entry : zf.entries())
+            {
+                if(filter != nullptr
+                && !filter(*entry))
+                {
+                    continue;
+                }
+                if(names.insert(entry->getName()).second)
                 {
-                    // copy the file content to the output
-                    //
-                    output_stream << is->rdbuf();
+                    output_stream.putRawEntry(zf, entry);
                 }
             }
         }
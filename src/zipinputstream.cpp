@@ -29,6 +29,10 @@
 
 #include "zipinputstream.hpp"
 
+#include "memorystreambuf.hpp"
+#include "randomaccessstreambuf.hpp"
+
+#include <algorithm>
 #include <fstream>
 
 
@@ -58,12 +62,18 @@ namespace zipios
  *
  * \param[in] filename  The name of a valid zip file.
  * \param[in] pos position to reposition the istream to before reading.
+ * \param[in] index  The index of access points used to seek in deflated
+ *                   data or nullptr.
+ * \param[in] policy  The I/O policy defining the size of the buffers.
+ * \param[in] entry  The Central Directory entry of the file to read, used
+ *                   when the local header has a trailing data descriptor,
+ *                   or nullptr.
  */
-ZipInputStream::ZipInputStream(std::string const & filename, std::streampos pos)
+ZipInputStream::ZipInputStream(std::string const & filename, std::streampos pos, InflateIndex::pointer_t index, IOPolicy const & policy, FileEntry const * entry)
     : std::istream(nullptr)
     , m_ifs(std::make_unique<std::ifstream>(filename, std::ios::in | std::ios::binary))
     , m_ifs_ref(*m_ifs)
-    , m_izf(std::make_unique<ZipInputStreambuf>(m_ifs_ref.rdbuf(), pos))
+    , m_izf(std::make_unique<ZipInputStreambuf>(m_ifs_ref.rdbuf(), pos, index, policy.getInputBufferSize(), entry))
 {
     // properly initialize the stream with the newly allocated buffer
     init(m_izf.get());
@@ -80,6 +90,73 @@ ZipInputStream::ZipInputStream(std::istream & is)
 }
 
 
+/** \brief Initialize a ZipInputStream from a shared file.
+ *
+ * This constructor creates a ZIP file stream reading the data of
+ * \p entry directly from \p file. The data starts at position
+ * \p data_pos so the local header is not read again.
+ *
+ * When \p file is memory mapped, the data is read from the mapping.
+ * Otherwise it is read with positional reads so any number of streams
+ * can share the same \p file, from any thread.
+ *
+ * The stream keeps a reference to \p file so it remains valid for as
+ * long as the stream exists.
+ *
+ * \param[in] file  The zip file.
+ * \param[in] entry  The Central Directory entry of the file to read.
+ * \param[in] data_pos  The position of the data of the file to read.
+ * \param[in] index  The index of access points used to seek in deflated
+ *                   data or nullptr.
+ * \param[in] policy  The I/O policy defining the size of the buffers and
+ *                    the read-ahead.
+ */
+ZipInputStream::ZipInputStream(RandomAccessFile::pointer_t file, FileEntry const & entry, std::streampos data_pos, InflateIndex::pointer_t index, IOPolicy const & policy)
+    : std::istream(nullptr)
+    , m_file(file)
+    , m_buf(m_file->data() != nullptr
+                ? static_cast<std::unique_ptr<std::streambuf>>(std::make_unique<MemoryStreambuf>(m_file->data(), m_file->size()))
+                : static_cast<std::unique_ptr<std::streambuf>>(std::make_unique<RandomAccessStreambuf>(m_file, policy.getInputBufferSize(), policy.getReadAhead())))
+    , m_ifs(std::make_unique<std::istream>(m_buf.get()))
+    , m_ifs_ref(*m_ifs)
+    , m_izf(std::make_unique<ZipInputStreambuf>(m_buf.get(), entry, data_pos, index, policy.getInputBufferSize()))
+{
+    // a memory mapped file gets a single hint for the start of the data
+    //
+    if(m_file->data() != nullptr
+    && policy.getReadAhead() > 0)
+    {
+        m_file->willNeed(data_pos, std::min(static_cast<size_t>(entry.getCompressedSize()), policy.getReadAhead()));
+    }
+
+    // properly initialize the stream with the newly allocated buffer
+    init(m_izf.get());
+}
+
+
+/** \brief Initialize a ZipInputStream to read an archive sequentially.
+ *
+ * This constructor creates a ZIP file stream reading the local header
+ * found at the current position of \p inbuf and then the data that
+ * follows it. Once the end of the data was read, \p inbuf is positioned
+ * right after that data so the next local header can be read.
+ *
+ * \param[in] inbuf  The streambuf positioned on a local header.
+ * \param[in] policy  The I/O policy defining the size of the buffers.
+ *
+ * \sa ZipStreamReader
+ */
+ZipInputStream::ZipInputStream(PushbackStreambuf * inbuf, IOPolicy const & policy)
+    : std::istream(nullptr)
+    , m_ifs(std::make_unique<std::istream>(inbuf))
+    , m_ifs_ref(*m_ifs)
+    , m_izf(std::make_unique<ZipInputStreambuf>(inbuf, policy.getInputBufferSize()))
+{
+    // properly initialize the stream with the newly allocated buffer
+    init(m_izf.get());
+}
+
+
 /** \brief Clean up the input stream.
  *
  * The destructor ensures that all resources used by the class get
@@ -90,6 +167,34 @@ ZipInputStream::~ZipInputStream()
 }
 
 
+/** \brief Verify the data read from the stream.
+ *
+ * This function turns on the verification of the CRC-32 and size of
+ * the data. It has to be called before reading.
+ *
+ * \param[in] callback  A function called once the data was verified
+ *                      successfully.
+ *
+ * \sa ZipInputStreambuf::verifyData()
+ */
+void ZipInputStream::verifyData(ZipInputStreambuf::verified_callback_t callback)
+{
+    m_izf->verifyData(callback);
+}
+
+
+/** \brief Retrieve the entry being read.
+ *
+ * \return The local header of the entry being read.
+ *
+ * \sa ZipInputStreambuf::getEntry()
+ */
+FileEntry const & ZipInputStream::getEntry() const
+{
+    return m_izf->getEntry();
+}
+
+
 } // zipios namespace
 
 // Local Variables:
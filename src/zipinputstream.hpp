@@ -34,6 +34,10 @@
 
 #include "zipinputstreambuf.hpp"
 
+#include "randomaccessfile.hpp"
+
+#include "zipios/iopolicy.hpp"
+
 
 namespace zipios
 {
@@ -43,14 +47,21 @@ namespace zipios
 class ZipInputStream : public std::istream
 {
 public:
-                                        ZipInputStream(std::string const & filename, std::streampos pos = 0);
+                                        ZipInputStream(std::string const & filename, std::streampos pos = 0, InflateIndex::pointer_t index = InflateIndex::pointer_t(), IOPolicy const & policy = IOPolicy(), FileEntry const * entry = nullptr);
                                         ZipInputStream(std::istream & is);
+                                        ZipInputStream(RandomAccessFile::pointer_t file, FileEntry const & entry, std::streampos data_pos, InflateIndex::pointer_t index = InflateIndex::pointer_t(), IOPolicy const & policy = IOPolicy());
+                                        ZipInputStream(PushbackStreambuf * inbuf, IOPolicy const & policy = IOPolicy());
                                         ZipInputStream(ZipInputStream const & rhs) = delete;
     virtual                             ~ZipInputStream() override;
 
     ZipInputStream &                    operator = (ZipInputStream const & rhs) = delete;
 
+    void                                verifyData(ZipInputStreambuf::verified_callback_t callback = ZipInputStreambuf::verified_callback_t());
+    FileEntry const &                   getEntry() const;
+
 private:
+    RandomAccessFile::pointer_t         m_file = RandomAccessFile::pointer_t();
+    std::unique_ptr<std::streambuf>     m_buf = std::unique_ptr<std::streambuf>();
     std::unique_ptr<std::istream>       m_ifs = std::unique_ptr<std::istream>();
     std::istream &                      m_ifs_ref;
     std::unique_ptr<ZipInputStreambuf>  m_izf = std::unique_ptr<ZipInputStreambuf>();
@@ -27,9 +27,14 @@
 
 #include "zipinputstreambuf.hpp"
 
+#include "crc32.hpp"
+#include "memorystreambuf.hpp"
+
 #include "zipios/zipiosexceptions.hpp"
 
 #include <algorithm>
+#include <cstring>
+#include <limits>
 
 
 namespace zipios
@@ -41,7 +46,7 @@ namespace zipios
  *
  * The ZipInputStreambuf class is a Zip input streambuf filter that
  * automatically decompresses input data that was compressed using
- * the zlib library.
+ * the zlib library or one of the registered codecs (see Codec).
  */
 
 
@@ -50,12 +55,28 @@ namespace zipios
  * This ZipInputStreambuf constructor initializes the buffer from the
  * user specified buffer.
  *
+ * When \p inbuf is a MemoryStreambuf, the data of the entry is read in
+ * place: the data of a STORED entry is returned as is and the data of
+ * a DEFLATED entry is inflated without being copied to an input buffer.
+ *
+ * When the local header has a trailing data descriptor, its CRC and sizes
+ * are not defined. They are then taken from \p entry, the Central
+ * Directory entry of the same file.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the local header has a trailing data
+ * descriptor and \p entry is nullptr.
+ *
  * \param[in,out] inbuf  The streambuf to use for input.
  * \param[in] start_pos  A position to reset the inbuf to before reading.
  *                       Specify -1 to read from the current position.
+ * \param[in] index  The index of access points used to seek in DEFLATED
+ *                   data or nullptr.
+ * \param[in] buffer_size  The size of the input buffers.
+ * \param[in] entry  The Central Directory entry or nullptr.
  */
-ZipInputStreambuf::ZipInputStreambuf(std::streambuf * inbuf, offset_t start_pos)
-    : InflateInputStreambuf(inbuf, start_pos)
+ZipInputStreambuf::ZipInputStreambuf(std::streambuf * inbuf, offset_t start_pos, InflateIndex::pointer_t index, size_t buffer_size, FileEntry const * entry)
+    : InflateInputStreambuf(inbuf, start_pos, buffer_size)
 {
     // read the zip local header
     std::istream is(m_inbuf); // istream does not destroy the streambuf.
@@ -65,28 +86,267 @@ ZipInputStreambuf::ZipInputStreambuf(std::streambuf * inbuf, offset_t start_pos)
     m_current_entry.read(is);
     if(m_current_entry.isValid() && m_current_entry.hasTrailingDataDescriptor())
     {
-        throw FileCollectionException("Trailing data descriptor in zip file not supported");
+        if(entry == nullptr)
+        {
+            throw FileCollectionException("Trailing data descriptor in zip file not supported without its Central Directory entry");
+        }
+        m_current_entry.setCrc(entry->getCrc());
+        m_current_entry.setSize(entry->getSize());
+        m_current_entry.setCompressedSize(entry->getCompressedSize());
+    }
+
+    prepareData(index);
+}
+
+
+/** \brief Initialize a ZipInputStreambuf from a known entry.
+ *
+ * This constructor initializes the buffer to read the data of \p entry
+ * which starts at position \p data_pos in \p inbuf. The local header is
+ * not read again. This is used once the position of the data is known.
+ *
+ * The \p entry is expected to be the Central Directory entry. Its
+ * method and size are used to read the data.
+ *
+ * \param[in,out] inbuf  The streambuf to use for input.
+ * \param[in] entry  The entry to read.
+ * \param[in] data_pos  The position of the data in \p inbuf.
+ * \param[in] index  The index of access points used to seek in DEFLATED
+ *                   data or nullptr.
+ * \param[in] buffer_size  The size of the input buffers.
+ */
+ZipInputStreambuf::ZipInputStreambuf(std::streambuf * inbuf, FileEntry const & entry, offset_t data_pos, InflateIndex::pointer_t index, size_t buffer_size)
+    : InflateInputStreambuf(inbuf, data_pos, buffer_size)
+    , m_current_entry(entry)
+{
+    // the ZipLocalEntry copy constructor does not copy the compressed
+    // size, which the codecs need to know where the data ends
+    //
+    m_current_entry.setCompressedSize(entry.getCompressedSize());
+
+    prepareData(index);
+}
+
+
+/** \brief Initialize a ZipInputStreambuf to read an archive sequentially.
+ *
+ * This constructor reads the local header found at the current position
+ * of \p inbuf and gets ready to read the data that follows. It is used
+ * to read the entries one after another from an input which cannot seek,
+ * such as a pipe or a socket (see ZipStreamReader).
+ *
+ * When the local header has a trailing data descriptor, the sizes and
+ * CRC of the data are not known. The end of the data is then found by
+ * the decompressor or, for STORED entries, by searching for the data
+ * descriptor (see scanStored()). The data descriptor is read once the
+ * end of the data is reached and getEntry() then returns the actual
+ * sizes and CRC.
+ *
+ * The input read past the end of the data is given back to \p inbuf so
+ * once the end of the data was reached, \p inbuf is positioned right
+ * after the data and its data descriptor.
+ *
+ * \param[in,out] inbuf  The streambuf to use for input.
+ * \param[in] buffer_size  The size of the input buffers.
+ */
+ZipInputStreambuf::ZipInputStreambuf(PushbackStreambuf * inbuf, size_t buffer_size)
+    : InflateInputStreambuf(inbuf, -1, buffer_size)
+    , m_pushback(inbuf)
+{
+    // read the zip local header
+    std::istream is(m_inbuf); // istream does not destroy the streambuf.
+    is.exceptions(std::ios::eofbit | std::ios::failbit | std::ios::badbit);
+
+    // if the read fails in any way it will throw
+    m_current_entry.read(is);
+    m_data_position = m_pushback->getPosition();
+    m_data_descriptor = m_current_entry.hasTrailingDataDescriptor();
+
+    // with a data descriptor, an empty DEFLATED entry (see prepareData())
+    // is detected by the descriptor signature coming first since it
+    // cannot be the start of a valid deflate stream
+    //
+    if(m_data_descriptor
+    && m_current_entry.getMethod() == StorageMethod::DEFLATED)
+    {
+        char signature[4];
+        std::streamsize const g(m_pushback->sgetn(signature, sizeof(signature)));
+        m_pushback->pushback(signature, g > 0 ? g : 0);
+        m_empty = g == sizeof(signature)
+               && memcmp(signature, "PK\x07\x08", sizeof(signature)) == 0;
     }
 
+    prepareData(InflateIndex::pointer_t());
+}
+
+
+/** \brief Prepare the buffers to read the data.
+ *
+ * This function gets the buffers ready to read the data of the current
+ * entry. The input streambuf is expected to be positioned at the start
+ * of the data.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if the compression method is not supported,
+ * which means it is not STORED or DEFLATED and no Codec is registered
+ * for it.
+ *
+ * \param[in] index  The index used to seek in DEFLATED data or nullptr.
+ */
+void ZipInputStreambuf::prepareData(InflateIndex::pointer_t index)
+{
+    // when the archive is in memory, the data gets accessed in place
+    //
+    MemoryStreambuf * memory(dynamic_cast<MemoryStreambuf *>(m_inbuf));
+
     switch(m_current_entry.getMethod())
     {
     case StorageMethod::DEFLATED:
+        // the ZipOutputStreambuf writes no compressed data at all for
+        // empty DEFLATED entries; the inflate stream would then read
+        // whatever follows so these get detected here
+        //
+        if(!m_data_descriptor
+        && m_current_entry.getCompressedSize() == 0)
+        {
+            m_empty = true;
+        }
         reset() ; // reset inflatestream data structures
+        if(memory != nullptr)
+        {
+            setInput(memory->current(), memory->remaining());
+        }
+        setIndex(index);
 //std::cerr << "deflated" << std::endl;
         break;
 
     case StorageMethod::STORED:
-        m_remain = m_current_entry.getSize();
+        // with a data descriptor the size is not known, m_remain
+        // becomes 0 once the data descriptor is found
+        //
+        m_remain = m_data_descriptor ? 1 : m_current_entry.getSize();
+        if(memory != nullptr)
+        {
+            // the get area is the data itself, it is never written to
+            //
+            offset_t const size(std::min(m_remain, static_cast<offset_t>(memory->remaining())));
+            char * ptr(const_cast<char *>(memory->current()));
+            setg(ptr, ptr, ptr + size);
+            m_remain = 0;
+            m_in_place = true;
+            break;
+        }
+        m_data_start = m_inbuf->pubseekoff(0, std::ios::cur, std::ios::in);
         // Force underflow on first read:
-        setg(&m_outvec[0], &m_outvec[0] + getBufferSize(), &m_outvec[0] + getBufferSize());
+        setg(&m_outvec[0], &m_outvec[0] + m_outvec.size(), &m_outvec[0] + m_outvec.size());
 //std::cerr << "stored" << std::endl;
         break;
 
     default:
-        // file not supported... sorry!
-        throw FileCollectionException("Unsupported compression format");
+        m_codec = Codec::getCodec(m_current_entry.getMethod());
+        if(m_codec == nullptr)
+        {
+            // file not supported... sorry!
+            throw FileCollectionException("Unsupported compression format");
+        }
+        CodecPool::getBuffer(m_codec_invec, m_outvec.size());
+        if(memory != nullptr)
+        {
+            m_codec_memory = memory->current();
+            m_codec_memory_size = std::min(m_current_entry.getCompressedSize(), memory->remaining());
+        }
+        else
+        {
+            m_data_start = m_inbuf->pubseekoff(0, std::ios::cur, std::ios::in);
+        }
+        startCodec();
+        break;
+
+    }
+}
+
+
+/** \brief Start decompressing the data of a codec entry.
+ *
+ * This function creates a new decompressor and gets ready to read the
+ * compressed data from the start. The input streambuf is expected to
+ * be positioned at the start of the data.
+ */
+void ZipInputStreambuf::startCodec()
+{
+    m_decompressor = m_codec->createDecompressor();
+    m_codec_input = m_codec_memory;
+    m_codec_input_size = m_codec_memory_size;
+    if(m_codec_memory != nullptr)
+    {
+        m_remain = 0;
+    }
+    else if(m_data_descriptor)
+    {
+        // the compressed size is not known, the codec finds the end
+        //
+        m_remain = std::numeric_limits<offset_t>::max();
+    }
+    else
+    {
+        m_remain = m_current_entry.getCompressedSize();
+    }
+    m_codec_position = 0;
+    m_codec_end = false;
 
+    // Force underflow on first read:
+    setg(&m_outvec[0], &m_outvec[0] + m_outvec.size(), &m_outvec[0] + m_outvec.size());
+}
+
+
+/** \brief Decompress the next chunk of data of a codec entry.
+ *
+ * This function fills m_outvec with the next chunk of data returned
+ * by the decompressor. The compressed data is read up to the
+ * compressed size of the entry.
+ *
+ * \exception IOException
+ * This exception is raised if the compressed data ends before the
+ * decompressor is done.
+ *
+ * \return The next character or EOF.
+ */
+std::streambuf::int_type ZipInputStreambuf::decompress()
+{
+    char * output(&m_outvec[0]);
+    size_t output_size(m_outvec.size());
+    while(output_size > 0 && !m_codec_end)
+    {
+        if(m_codec_input_size == 0)
+        {
+            if(m_remain == 0)
+            {
+                throw IOException("ZipInputStreambuf::underflow(): the compressed data of \""
+                                + m_current_entry.getName()
+                                + "\" ended early.");
+            }
+            std::streamsize const g(m_inbuf->sgetn(&m_codec_invec[0], std::min(m_remain, static_cast<offset_t>(m_codec_invec.size()))));
+            if(g <= 0)
+            {
+                throw IOException("ZipInputStreambuf::underflow(): EOF reached while reading the compressed data of \""
+                                + m_current_entry.getName()
+                                + "\".");
+            }
+            m_remain -= g;
+            m_codec_input = &m_codec_invec[0];
+            m_codec_input_size = g;
+        }
+        m_codec_end = m_decompressor->decompress(m_codec_input, m_codec_input_size, output, output_size);
     }
+
+    offset_t const size(output - &m_outvec[0]);
+    m_codec_position += size;
+    setg(&m_outvec[0], &m_outvec[0], output);
+    if(size == 0)
+    {
+        return traits_type::eof();
+    }
+    return traits_type::to_int_type(*gptr());
 }
 
 
@@ -107,6 +367,234 @@ ZipInputStreambuf::ZipInputStreambuf(std::streambuf * inbuf, offset_t start_pos)
  */
 ZipInputStreambuf::~ZipInputStreambuf()
 {
+    CodecPool::releaseBuffer(m_codec_invec);
+}
+
+
+/** \brief Verify the data read from this buffer.
+ *
+ * This function turns on the verification of the data. The CRC-32 of
+ * the data is computed as it gets read and, once the end of the data
+ * is reached, the CRC-32 and the size are compared against those of
+ * the entry. If they do not match, underflow() throws an IOException,
+ * which sets the badbit of the istream (or gets rethrown if the istream
+ * exceptions include the badbit).
+ *
+ * This function has to be called before reading the data. Seeking
+ * turns the verification off since the data is then not read
+ * sequentially anymore.
+ *
+ * \param[in] callback  A function called once the data was verified
+ *                      successfully.
+ */
+void ZipInputStreambuf::verifyData(verified_callback_t callback)
+{
+    m_verify = true;
+    m_crc32 = 0;
+    m_verified_size = 0;
+    m_verified_callback = callback;
+}
+
+
+/** \brief Retrieve the entry being read.
+ *
+ * This function returns the local header of the entry being read. When
+ * the entry is read sequentially and has a data descriptor, the sizes
+ * and CRC are only valid once the end of the data was reached.
+ *
+ * \return The entry being read.
+ */
+FileEntry const & ZipInputStreambuf::getEntry() const
+{
+    return m_current_entry;
+}
+
+
+/** \brief Check the data once all of it was read.
+ *
+ * This function compares the CRC-32 and size of the data read against
+ * the entry.
+ *
+ * \exception IOException
+ * This exception is raised if the CRC-32 or the size do not match.
+ */
+void ZipInputStreambuf::checkData()
+{
+    if(m_in_place)
+    {
+        // the data was read directly from the get area
+        //
+        m_crc32 = updateCRC32(0, eback(), egptr() - eback());
+        m_verified_size = egptr() - eback();
+    }
+
+    if(m_verified_size != static_cast<offset_t>(m_current_entry.getSize())
+    || m_crc32 != m_current_entry.getCrc())
+    {
+        OutputStringStream msgs;
+        msgs << "ZipInputStreambuf::underflow(): the "
+             << (m_verified_size != static_cast<offset_t>(m_current_entry.getSize()) ? "size" : "CRC-32")
+             << " of the data of \""
+             << m_current_entry.getName()
+             << "\" does not match its entry.";
+        throw IOException(msgs.str());
+    }
+
+    m_verify = false;
+    if(m_verified_callback)
+    {
+        m_verified_callback();
+    }
+}
+
+
+/** \brief Read the data of a STORED entry followed by a data descriptor.
+ *
+ * The size of the data is not known so the data gets searched for the
+ * signature of the data descriptor. A signature marks the end of the
+ * data only if the CRC-32 and sizes that follow it match the data found
+ * before it. This requires the data descriptor to include its signature,
+ * which it does with all the known implementations.
+ *
+ * The bytes which may be the start of the data descriptor are given back
+ * to the input streambuf and read again on the next call.
+ *
+ * \exception IOException
+ * This exception is raised if the input ends before the data descriptor
+ * is found.
+ *
+ * \return The number of bytes now available in the get area, 0 once the
+ *         end of the data is reached.
+ */
+std::streamsize ZipInputStreambuf::scanStored()
+{
+    if(m_remain == 0)
+    {
+        return 0;
+    }
+
+    // the whole data descriptor has to fit in the scan window, the
+    // input buffer size of the IOPolicy can be as small as 1 byte
+    //
+    size_t const field_size(m_current_entry.isZip64() ? 8 : 4);
+    size_t const descriptor_size(8 + field_size * 2);
+    if(m_outvec.size() < descriptor_size)
+    {
+        m_outvec.resize(descriptor_size);
+    }
+
+    char * const data(&m_outvec[0]);
+    std::streamsize const g(m_inbuf->sgetn(data, m_outvec.size()));
+    size_t const size(g > 0 ? g : 0);
+
+    auto read = [data](size_t pos, size_t bytes)
+    {
+        uint64_t value(0);
+        for(size_t idx(bytes); idx > 0; --idx)
+        {
+            value = (value << 8) | static_cast<unsigned char>(data[pos + idx - 1]);
+        }
+        return value;
+    };
+
+    FileEntry::crc32_t crc(m_scan_crc32);
+    size_t crc_pos(0);
+    size_t end(0);
+    for(;; ++end)
+    {
+        if(end + descriptor_size > size)
+        {
+            if(size < m_outvec.size())
+            {
+                throw IOException("ZipInputStreambuf::underflow(): EOF reached while searching the data descriptor of \""
+                                + m_current_entry.getName()
+                                + "\".");
+            }
+
+            // the last bytes may be the start of the data descriptor
+            //
+            end = size - descriptor_size + 1;
+            break;
+        }
+        if(read(end, 4) == 0x08074b50
+        && read(end + 8, field_size) == static_cast<uint64_t>(m_scan_size + end)
+        && read(end + 8 + field_size, field_size) == static_cast<uint64_t>(m_scan_size + end))
+        {
+            crc = updateCRC32(crc, data + crc_pos, end - crc_pos);
+            crc_pos = end;
+            if(read(end + 4, 4) == crc)
+            {
+                m_remain = 0;
+                break;
+            }
+        }
+    }
+
+    m_pushback->pushback(data + end, size - end);
+    m_scan_crc32 = updateCRC32(crc, data + crc_pos, end - crc_pos);
+    m_scan_size += end;
+    setg(data, data, data + end);
+
+    return end;
+}
+
+
+/** \brief Handle the end of the data.
+ *
+ * When the entry is read sequentially, the input read past the end of
+ * the data is given back to the input streambuf and the data descriptor,
+ * if any, gets read. Then the data gets verified if requested.
+ *
+ * \exception IOException
+ * This exception is raised if the size of the compressed data does not
+ * match the entry or if the verification fails.
+ */
+void ZipInputStreambuf::endData()
+{
+    if(m_pushback != nullptr
+    && !m_data_end)
+    {
+        m_data_end = true;
+
+        switch(m_current_entry.getMethod())
+        {
+        case StorageMethod::DEFLATED:
+        {
+            std::string_view const unused(getUnusedInput());
+            m_pushback->pushback(unused.data(), unused.size());
+        }
+            break;
+
+        case StorageMethod::STORED:
+            // the STORED data is never read past its end
+            break;
+
+        default:
+            m_pushback->pushback(m_codec_input, m_codec_input_size);
+            m_codec_input_size = 0;
+            break;
+
+        }
+
+        offset_t const compressed_size(m_pushback->getPosition() - m_data_position);
+        if(m_data_descriptor)
+        {
+            std::istream is(m_inbuf); // istream does not destroy the streambuf.
+            is.exceptions(std::ios::eofbit | std::ios::failbit | std::ios::badbit);
+            m_current_entry.readDataDescriptor(is);
+        }
+        if(compressed_size != static_cast<offset_t>(m_current_entry.getCompressedSize()))
+        {
+            throw IOException("ZipInputStreambuf::underflow(): the size of the compressed data of \""
+                            + m_current_entry.getName()
+                            + "\" does not match its entry.");
+        }
+    }
+
+    if(m_verify)
+    {
+        checkData();
+    }
 }
 
 
@@ -121,35 +609,256 @@ ZipInputStreambuf::~ZipInputStreambuf()
  */
 std::streambuf::int_type ZipInputStreambuf::underflow()
 {
+    if(m_data_end)
+    {
+        // the input past the data belongs to the next entry
+        //
+        endData();
+        return traits_type::eof();
+    }
+
     switch(m_current_entry.getMethod())
     {
     case StorageMethod::DEFLATED:
+    {
         // inflate class takes care of it in this case
-        return InflateInputStreambuf::underflow();
+        std::streambuf::int_type const c(m_empty
+                    ? traits_type::eof()
+                    : InflateInputStreambuf::underflow());
+        if(c == traits_type::eof())
+        {
+            endData();
+        }
+        else if(m_verify)
+        {
+            m_crc32 = updateCRC32(m_crc32, eback(), egptr() - eback());
+            m_verified_size += egptr() - eback();
+        }
+        return c;
+    }
 
     case StorageMethod::STORED:
     {
         // Ok, we are STORED, so we handle it ourselves.
-        offset_t const num_b(std::min(m_remain, static_cast<offset_t>(getBufferSize())));
-        std::streamsize const g(m_inbuf->sgetn(&m_outvec[0], num_b));
-        setg(&m_outvec[0], &m_outvec[0], &m_outvec[0] + g);
-        m_remain -= g;
+        if(m_in_place)
+        {
+            // the get area is the whole data, keep it so we can seek back
+            //
+            if(m_verify)
+            {
+                checkData();
+            }
+            return traits_type::eof();
+        }
+        std::streamsize g(0);
+        if(m_data_descriptor)
+        {
+            g = scanStored();
+        }
+        else
+        {
+            offset_t const num_b(std::min(m_remain, static_cast<offset_t>(m_outvec.size())));
+            g = m_inbuf->sgetn(&m_outvec[0], num_b);
+            setg(&m_outvec[0], &m_outvec[0], &m_outvec[0] + g);
+            m_remain -= g;
+        }
         if(g > 0)
         {
+            if(m_verify)
+            {
+                m_crc32 = updateCRC32(m_crc32, &m_outvec[0], g);
+                m_verified_size += g;
+            }
+
             // we got some data, return it
             return traits_type::to_int_type(*gptr());
         }
 
         // documentation says to return EOF if no data available
+        endData();
         return traits_type::eof();
     }
 
+    default:
+    {
+        // the constructor made sure a codec exists
+        //
+        std::streambuf::int_type const c(decompress());
+        if(c == traits_type::eof())
+        {
+            endData();
+        }
+        else if(m_verify)
+        {
+            m_crc32 = updateCRC32(m_crc32, eback(), egptr() - eback());
+            m_verified_size += egptr() - eback();
+        }
+        return c;
+    }
+
+    }
+}
+
+
+/** \brief Change the position in the uncompressed data.
+ *
+ * This function moves the current position by \p off bytes relative
+ * to the start, the current position, or the end of the uncompressed
+ * data of the entry.
+ *
+ * STORED data is seeked directly. DEFLATED data gets inflated from
+ * the nearest access point of the index, if any, or from the start of
+ * the data when going backward (see InflateInputStreambuf::seekInflated()).
+ * The data of the other methods gets decompressed by their Codec from
+ * the start of the data when going backward.
+ *
+ * \param[in] off  The offset to move by.
+ * \param[in] dir  The position \p off is relative to.
+ * \param[in] which  Only std::ios_base::in is supported.
+ *
+ * \return The new position or -1 if the position is not valid or the
+ *         input cannot be seeked.
+ */
+ZipInputStreambuf::pos_type ZipInputStreambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which)
+{
+    if((which & std::ios_base::in) == 0)
+    {
+        return pos_type(off_type(-1));
+    }
+
+    offset_t const size(m_current_entry.getSize());
+    offset_t current(0);
+    switch(m_current_entry.getMethod())
+    {
+    case StorageMethod::DEFLATED:
+        current = getInflatedPosition();
+        break;
+
+    case StorageMethod::STORED:
+        current = m_in_place
+                    ? gptr() - eback()
+                    : size - m_remain - (egptr() - gptr());
+        break;
+
+    default:
+        current = m_codec_position - (egptr() - gptr());
+        break;
+
+    }
+
+    offset_t position(off);
+    switch(dir)
+    {
+    case std::ios_base::beg:
+        break;
+
+    case std::ios_base::cur:
+        position += current;
+        break;
+
+    case std::ios_base::end:
+        position += size;
+        break;
+
     default: // LCOV_EXCL_LINE
-        // This should NEVER be reached or the constructor let something
-        // go through that should not have gone through
-        throw std::logic_error("ZipInputStreambuf::underflow(): unknown storage method"); // LCOV_EXCL_LINE
+        return pos_type(off_type(-1)); // LCOV_EXCL_LINE
+
+    }
+
+    if(position < 0 || position > size)
+    {
+        return pos_type(off_type(-1));
+    }
+    if(position == current)
+    {
+        return pos_type(position);
+    }
 
+    // the data is not read sequentially anymore
+    //
+    m_verify = false;
+
+    if(m_current_entry.getMethod() == StorageMethod::DEFLATED)
+    {
+        if(!seekInflated(position))
+        {
+            return pos_type(off_type(-1));
+        }
+        return pos_type(position);
     }
+
+    if(m_codec != nullptr)
+    {
+        // the position is in the current buffer
+        //
+        offset_t const start_of_buffer(m_codec_position - (egptr() - eback()));
+        if(position >= start_of_buffer
+        && position <= m_codec_position)
+        {
+            setg(eback(), egptr() - (m_codec_position - position), egptr());
+            return pos_type(position);
+        }
+
+        // going backward means decompressing from the start again
+        //
+        if(position < current)
+        {
+            if(m_codec_memory == nullptr
+            && (m_data_start < 0
+                || m_inbuf->pubseekpos(m_data_start, std::ios::in) == std::streampos(-1)))
+            {
+                return pos_type(off_type(-1));
+            }
+            startCodec();
+        }
+
+        // skip the data up to position
+        //
+        for(;;)
+        {
+            if(position <= m_codec_position)
+            {
+                setg(eback(), egptr() - (m_codec_position - position), egptr());
+                return pos_type(position);
+            }
+            if(traits_type::eq_int_type(decompress(), traits_type::eof()))
+            {
+                return pos_type(off_type(-1));
+            }
+        }
+    }
+
+    if(m_in_place)
+    {
+        setg(eback(), eback() + position, egptr());
+        return pos_type(position);
+    }
+
+    if(m_data_start < 0
+    || m_inbuf->pubseekpos(m_data_start + position, std::ios::in) == std::streampos(-1))
+    {
+        return pos_type(off_type(-1));
+    }
+    m_remain = size - position;
+    setg(&m_outvec[0], &m_outvec[0], &m_outvec[0]);
+
+    return pos_type(position);
+}
+
+
+/** \brief Change the position in the uncompressed data.
+ *
+ * This function moves the current position to \p pos bytes from the
+ * start of the uncompressed data of the entry.
+ *
+ * \param[in] pos  The new position.
+ * \param[in] which  Only std::ios_base::in is supported.
+ *
+ * \return The new position or -1 if the position is not valid.
+ */
+ZipInputStreambuf::pos_type ZipInputStreambuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
 }
 
 
@@ -31,9 +31,14 @@
  */
 
 #include "inflateinputstreambuf.hpp"
+#include "pushbackstreambuf.hpp"
 
 #include "ziplocalentry.hpp"
 
+#include "zipios/codec.hpp"
+
+#include <functional>
+
 
 namespace zipios
 {
@@ -42,18 +47,61 @@ namespace zipios
 class ZipInputStreambuf : public InflateInputStreambuf
 {
 public:
-                            ZipInputStreambuf(std::streambuf * inbuf, offset_t start_pos = -1);
+    typedef std::function<void()>   verified_callback_t;
+
+                            ZipInputStreambuf(std::streambuf * inbuf, offset_t start_pos = -1, InflateIndex::pointer_t index = InflateIndex::pointer_t(), size_t buffer_size = getBufferSize(), FileEntry const * entry = nullptr);
+                            ZipInputStreambuf(std::streambuf * inbuf, FileEntry const & entry, offset_t data_pos, InflateIndex::pointer_t index = InflateIndex::pointer_t(), size_t buffer_size = getBufferSize());
+                            ZipInputStreambuf(PushbackStreambuf * inbuf, size_t buffer_size = getBufferSize());
                             ZipInputStreambuf(ZipInputStreambuf const & src) = delete;
     ZipInputStreambuf &     operator = (ZipInputStreambuf const & rhs) = delete;
     virtual                 ~ZipInputStreambuf() override;
 
+    void                    verifyData(verified_callback_t callback = verified_callback_t());
+    FileEntry const &       getEntry() const;
+
 protected:
     virtual std::streambuf::int_type    underflow() override;
+    virtual pos_type        seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which = std::ios_base::in) override;
+    virtual pos_type        seekpos(pos_type pos, std::ios_base::openmode which = std::ios_base::in) override;
 
 private:
+    void                    prepareData(InflateIndex::pointer_t index);
+    void                    checkData();
+    void                    endData();
+    std::streamsize         scanStored();
+    void                    startCodec();
+    std::streambuf::int_type
+                            decompress();
+
     ZipLocalEntry           m_current_entry = ZipLocalEntry();
-    offset_t                m_remain = 0;     // For STORED entry only. the number of bytes that
-                                              // has not been put in the m_outvec yet.
+    offset_t                m_remain = 0;     // For STORED and codec entries only. the number of bytes
+                                              // that has not been read from m_inbuf yet.
+    offset_t                m_data_start = -1;  // For STORED and codec entries only. -1 if not seekable
+    bool                    m_in_place = false; // For STORED entry only. get area is the data
+    bool                    m_verify = false;
+    FileEntry::crc32_t      m_crc32 = 0;
+    offset_t                m_verified_size = 0;
+    verified_callback_t     m_verified_callback = verified_callback_t();
+
+    // for entries using a Codec
+    Codec::pointer_t        m_codec = Codec::pointer_t();
+    Decompressor::pointer_t m_decompressor = Decompressor::pointer_t();
+    std::vector<char>       m_codec_invec = std::vector<char>();
+    char const *            m_codec_memory = nullptr;
+    size_t                  m_codec_memory_size = 0;
+    char const *            m_codec_input = nullptr;
+    size_t                  m_codec_input_size = 0;
+    offset_t                m_codec_position = 0;
+    bool                    m_codec_end = false;
+
+    // for entries read sequentially
+    PushbackStreambuf *     m_pushback = nullptr;
+    offset_t                m_data_position = 0;
+    bool                    m_data_descriptor = false; // the sizes and CRC follow the data
+    bool                    m_data_end = false;
+    bool                    m_empty = false; // DEFLATED entry without any compressed data
+    FileEntry::crc32_t      m_scan_crc32 = 0;
+    offset_t                m_scan_size = 0;
 };
 
 
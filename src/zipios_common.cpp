@@ -31,6 +31,8 @@
 
 #include "zipios/zipiosexceptions.hpp"
 
+#include <algorithm>
+
 
 namespace zipios
 {
@@ -71,6 +73,28 @@ char const g_separator = '/';
  */
 
 
+void zipRead(std::istream & is, uint64_t & value)
+{
+    unsigned char buf[sizeof(value)];
+
+    if(!is.read(reinterpret_cast<char *>(buf), sizeof(value)))
+    {
+        throw IOException("an I/O error while reading zip archive data from file.");
+    }
+    if(is.gcount() != sizeof(value))
+    {
+        throw IOException("EOF or an I/O error while reading zip archive data from file."); // LCOV_EXCL_LINE
+    }
+
+    // zip data is always in little endian
+    value = 0;
+    for(size_t idx(sizeof(value)); idx > 0; --idx)
+    {
+        value = (value << 8) | buf[idx - 1];
+    }
+}
+
+
 void zipRead(std::istream & is, uint32_t & value)
 {
     unsigned char buf[sizeof(value)];
@@ -163,6 +187,23 @@ void zipRead(std::istream & is, std::string & str, ssize_t const count)
 }
 
 
+void zipRead(buffer_t const & is, size_t & pos, uint64_t & value)
+{
+    if(pos + sizeof(value) > is.size())
+    {
+        throw IOException("EOF reached while reading zip archive data from file.");
+    }
+
+    value = 0;
+    for(size_t idx(sizeof(value)); idx > 0; --idx)
+    {
+        value = (value << 8) | is[pos + idx - 1];
+    }
+
+    pos += sizeof(value);
+}
+
+
 void zipRead(buffer_t const & is, size_t & pos, uint32_t & value)
 {
     if(pos + sizeof(value) > is.size())
@@ -234,6 +275,165 @@ void zipRead(buffer_t const & is, size_t & pos, std::string & str, ssize_t const
 }
 
 
+/** \brief Read the Zip64 extended information extra field.
+ *
+ * Zip64 archives save the sizes and offset which do not fit in 32 bits
+ * in an extra field (header ID 0x0001). The 32 bit field of the header
+ * is then set to 0xFFFFFFFF and the extra field includes the 64 bit
+ * value. Only the values set to 0xFFFFFFFF are included, in this order:
+ * uncompressed size, compressed size, offset of the local header.
+ *
+ * This function replaces the values equal to 0xFFFFFFFF with the
+ * values found in the Zip64 extra field.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if one of the values is 0xFFFFFFFF and the
+ * extra field does not include a Zip64 extended information field.
+ *
+ * \exception IOException
+ * This exception is raised if the Zip64 extra field does not include
+ * all the values set to 0xFFFFFFFF or an extra field goes past the end
+ * of the \p extra buffer.
+ *
+ * \param[in] extra  The extra field of the header.
+ * \param[in] extra_size  The size of the extra field.
+ * \param[in,out] uncompressed_size  The uncompressed size of the entry.
+ * \param[in,out] compressed_size  The compressed size of the entry.
+ * \param[in,out] offset  The offset of the local header of the entry.
+ */
+void zipReadZip64ExtraField(
+      unsigned char const * extra
+    , size_t extra_size
+    , uint64_t & uncompressed_size
+    , uint64_t & compressed_size
+    , uint64_t & offset)
+{
+    uint64_t const sentinel(0xFFFFFFFF);
+    if(uncompressed_size != sentinel
+    && compressed_size != sentinel
+    && offset != sentinel)
+    {
+        return;
+    }
+
+    auto read16 = [extra](size_t pos)
+    {
+        return static_cast<uint16_t>(extra[pos] | (extra[pos + 1] << 8));
+    };
+
+    size_t pos(0);
+    while(pos + 4 <= extra_size)
+    {
+        uint16_t const id(read16(pos));
+        size_t const size(read16(pos + 2));
+        pos += 4;
+        if(pos + size > extra_size)
+        {
+            throw IOException("EOF reached while reading the extra field of a zip archive entry.");
+        }
+        if(id == 0x0001)
+        {
+            size_t const end(pos + size);
+            for(uint64_t * value : { &uncompressed_size, &compressed_size, &offset })
+            {
+                if(*value != sentinel)
+                {
+                    continue;
+                }
+                if(pos + 8 > end)
+                {
+                    throw IOException("the Zip64 extended information extra field is too small.");
+                }
+                *value = 0;
+                for(size_t idx(8); idx > 0; --idx)
+                {
+                    *value = (*value << 8) | extra[pos + idx - 1];
+                }
+                pos += 8;
+            }
+            return;
+        }
+        pos += size;
+    }
+
+    throw FileCollectionException("Zip64 value without a Zip64 extended information field");
+}
+
+
+/** \brief Create an extra field with a Zip64 extended information field.
+ *
+ * This function returns a copy of \p extra_field without any Zip64
+ * extended information extra field (header ID 0x0001) followed by
+ * a new Zip64 field with the 64 bit \p values, in the order they have
+ * to be saved. When \p values is empty, no Zip64 field gets added.
+ *
+ * Removing the existing Zip64 field makes sure that an entry read from
+ * a Zip64 archive does not end up with two such fields once saved.
+ *
+ * \param[in] extra_field  The extra field of the entry.
+ * \param[in] values  The values to save in the Zip64 field.
+ *
+ * \return The extra field to save in the header.
+ */
+buffer_t zipMakeZip64ExtraField(buffer_t const & extra_field, std::vector<uint64_t> const & values)
+{
+    buffer_t result;
+    result.reserve(extra_field.size() + 4 + values.size() * 8);
+
+    size_t pos(0);
+    while(pos + 4 <= extra_field.size())
+    {
+        uint16_t const id(extra_field[pos] | (extra_field[pos + 1] << 8));
+        size_t const size(extra_field[pos + 2] | (extra_field[pos + 3] << 8));
+        size_t const end(std::min(pos + 4 + size, extra_field.size()));
+        if(id != 0x0001)
+        {
+            result.insert(result.end(), extra_field.begin() + pos, extra_field.begin() + end);
+        }
+        pos = end;
+    }
+    result.insert(result.end(), extra_field.begin() + pos, extra_field.end());
+
+    if(!values.empty())
+    {
+        size_t const size(values.size() * 8);
+        result.push_back(0x01);
+        result.push_back(0x00);
+        result.push_back(static_cast<unsigned char>(size));
+        result.push_back(static_cast<unsigned char>(size >> 8));
+        for(uint64_t const v : values)
+        {
+            for(int shift(0); shift < 64; shift += 8)
+            {
+                result.push_back(static_cast<unsigned char>(v >> shift));
+            }
+        }
+    }
+
+    return result;
+}
+
+
+void zipWrite(std::ostream & os, uint64_t const & value)
+{
+    char buf[sizeof(value)];
+
+    buf[0] = value >>  0;
+    buf[1] = value >>  8;
+    buf[2] = value >> 16;
+    buf[3] = value >> 24;
+    buf[4] = value >> 32;
+    buf[5] = value >> 40;
+    buf[6] = value >> 48;
+    buf[7] = value >> 56;
+
+    if(!os.write(buf, sizeof(value)))
+    {
+        throw IOException("an I/O error occurred while writing to a zip archive file.");
+    }
+}
+
+
 void zipWrite(std::ostream & os, uint32_t const & value)
 {
     char buf[sizeof(value)];
@@ -98,18 +98,25 @@ typedef std::ostringstream OutputStringStream;
 typedef std::vector<unsigned char>      buffer_t;
 
 
+void     zipRead(std::istream & is, uint64_t & value);
 void     zipRead(std::istream & is, uint32_t & value);
 void     zipRead(std::istream & is, uint16_t & value);
 void     zipRead(std::istream & is, uint8_t &  value);
 void     zipRead(std::istream & is, buffer_t & buffer, ssize_t const count);
 void     zipRead(std::istream & is, std::string & str, ssize_t const count);
 
+void     zipRead(buffer_t const & is, size_t & pos, uint64_t & value);
 void     zipRead(buffer_t const & is, size_t & pos, uint32_t & value);
 void     zipRead(buffer_t const & is, size_t & pos, uint16_t & value);
 void     zipRead(buffer_t const & is, size_t & pos, uint8_t &  value);
 void     zipRead(buffer_t const & is, size_t & pos, buffer_t & buffer, ssize_t const count);
 void     zipRead(buffer_t const & is, size_t & pos, std::string & str, ssize_t const count);
 
+void     zipReadZip64ExtraField(unsigned char const * extra, size_t extra_size, uint64_t & uncompressed_size, uint64_t & compressed_size, uint64_t & offset);
+
+buffer_t zipMakeZip64ExtraField(buffer_t const & extra_field, std::vector<uint64_t> const & values);
+
+void     zipWrite(std::ostream & os, uint64_t const & value);
 void     zipWrite(std::ostream & os, uint32_t const & value);
 void     zipWrite(std::ostream & os, uint16_t const & value);
 void     zipWrite(std::ostream & os, uint8_t const &  value);
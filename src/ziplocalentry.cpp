@@ -62,15 +62,27 @@ uint32_t const      g_signature = 0x04034b50;
 /** \brief A bit in the general purpose flags.
  *
  * This mask is used to know whether the size and CRC are saved in
- * the header or after the header. At this time Zipios does not
- * support such trailing data as it makes use of the compressed
- * and uncompressed sizes to properly stream the output data.
+ * the header or after the data, in a data descriptor. The
+ * ZipOutputStreambuf uses data descriptors when it cannot seek back
+ * to the header once the data was written.
  *
  * This is bit 3. (see point 4.4.4 in doc/zip-format.txt)
  */
 uint16_t const      g_trailing_data_descriptor = 1 << 3;
 
 
+/** \brief The signature of a data descriptor.
+ *
+ * The signature of the data descriptor is optional but recommended.
+ * Zipios always writes it.
+ *
+ * \code
+ * "PK 7.8"
+ * \endcode
+ */
+uint32_t const      g_data_descriptor_signature = 0x08074b50;
+
+
 /** \brief ZipLocalEntry Header
  *
  * This structure shows how the header of the ZipLocalEntry is defined.
@@ -148,13 +160,11 @@ ZipLocalEntry::ZipLocalEntry(FileEntry const & src)
  *
  * \return A new ZipLocalEntry which is a clone of this ZipLocalEntry object.
  */
-FileEntry::pointer_t ZipLocalEntry::clone() const // LCOV_EXCL_LINE
+FileEntry::pointer_t ZipLocalEntry::clone() const
 {
-    // It makes sense to keep the clone() function for this class
-    // but since it is internal and never allocated as is (we use
-    // the ZipCentralDirectoryEntry instead) it is marked as
-    // non-reachable by the coverage tests
-    return std::make_shared<ZipLocalEntry>(*this); // LCOV_EXCL_LINE
+    // the ZipStreamReader returns copies of the local headers
+    //
+    return std::make_shared<ZipLocalEntry>(*this);
 }
 
 
@@ -194,6 +204,10 @@ bool ZipLocalEntry::isDirectory() const
  * This function is also used to compare ZipCDirEntry since none
  * of the additional field participate in the comparison.
  *
+ * \note
+ * When this entry uses a trailing data descriptor, the CRC, sizes, and
+ * version needed to extract are not compared.
+ *
  * \param[in] file_entry  The file entry to compare this against.
  *
  * \return true if both FileEntry objects are considered equal.
@@ -205,6 +219,20 @@ bool ZipLocalEntry::isEqual(FileEntry const & file_entry) const
     {
         return false;
     }
+    if(hasTrailingDataDescriptor())
+    {
+        // the local header was written before the CRC and sizes were
+        // known, they are saved in the data descriptor instead and the
+        // version may have changed if the entry ended up needing Zip64
+        //
+        return m_filename                 == ze->m_filename
+            && m_comment                  == ze->m_comment
+            && m_unix_time                == ze->m_unix_time
+            && m_compress_method          == ze->m_compress_method
+            && m_valid                    == ze->m_valid
+            && m_general_purpose_bitfield == ze->m_general_purpose_bitfield
+            && m_is_directory             == ze->m_is_directory;
+    }
     return FileEntry::isEqual(file_entry)
         && m_extract_version          == ze->m_extract_version
         && m_general_purpose_bitfield == ze->m_general_purpose_bitfield
@@ -243,7 +271,7 @@ size_t ZipLocalEntry::getHeaderSize() const
     // not be portable so we use a hard coded value (yuck!)
     return 30 /* sizeof(ZipLocalEntryHeader) */
          + m_filename.length() + (m_is_directory ? 1 : 0)
-         + m_extra_field.size();
+         + getLocalExtraField().size();
 }
 
 
@@ -294,11 +322,8 @@ void ZipLocalEntry::setCrc(uint32_t crc)
  *      uncompressed size               -- 32 or 64 bit
  * \endcode
  *
- * When a trailing data buffer is defined, the header has the compressed
- * and uncompressed sizes set to zero.
- *
- * \note
- * Zipios does not support such a scheme.
+ * When a trailing data buffer is defined, the header has the CRC and
+ * the compressed and uncompressed sizes set to zero.
  *
  * \return true if this file makes use of a trailing data buffer.
  */
@@ -308,11 +333,137 @@ bool ZipLocalEntry::hasTrailingDataDescriptor() const
 }
 
 
+/** \brief Define whether the entry uses a trailing data descriptor.
+ *
+ * This function sets or clears bit 3 of the general purpose flags.
+ * When set, write() saves zeroes in place of the CRC and sizes and
+ * writeDataDescriptor() has to be called once the data was written.
+ *
+ * \param[in] descriptor  Whether the entry uses a data descriptor.
+ */
+void ZipLocalEntry::setTrailingDataDescriptor(bool descriptor)
+{
+    if(descriptor)
+    {
+        m_general_purpose_bitfield |= g_trailing_data_descriptor;
+    }
+    else
+    {
+        m_general_purpose_bitfield &= ~g_trailing_data_descriptor;
+    }
+}
+
+
+/** \brief Retrieve the version needed to extract this entry.
+ *
+ * This function returns the version of the Zip specification needed
+ * to extract this entry, multiplied by 10 (i.e. 20 for version 2.0).
+ *
+ * \return The version needed to extract the entry.
+ */
+uint16_t ZipLocalEntry::getExtractVersion() const
+{
+    return m_extract_version;
+}
+
+
+/** \brief Change the version needed to extract this entry.
+ *
+ * Entries compressed with a method added in later versions of the
+ * Zip specification have to declare that version. For example, an
+ * entry compressed with zstd needs version 6.3, so 63.
+ *
+ * \param[in] version  The version needed to extract the entry.
+ */
+void ZipLocalEntry::setExtractVersion(uint16_t version)
+{
+    m_extract_version = version;
+}
+
+
+/** \brief Check whether the local header uses the Zip64 extensions.
+ *
+ * The local header of an entry saves its sizes in the Zip64 extended
+ * information extra field when one of them does not fit in 32 bits
+ * or when setZip64() was called with true.
+ *
+ * \return true if the local header of this entry uses Zip64.
+ */
+bool ZipLocalEntry::isZip64() const
+{
+    return m_zip64
+        || m_compressed_size   >= 0xFFFFFFFF
+        || m_uncompressed_size >= 0xFFFFFFFF;
+}
+
+
+/** \brief Force the use of the Zip64 extensions in the local header.
+ *
+ * The local header is written before the data of the entry and once
+ * more with the final sizes. Both headers must have the same size so
+ * an entry which may end up larger than 4Gb has to use Zip64 from the
+ * start. The ZipOutputStreambuf calls this function with true when
+ * the size of the entry, as known before compression, requires it.
+ *
+ * \param[in] zip64  Whether the local header has to use Zip64.
+ */
+void ZipLocalEntry::setZip64(bool zip64)
+{
+    m_zip64 = zip64;
+}
+
+
+/** \brief Retrieve the version needed to extract saved in the headers.
+ *
+ * Entries which use the Zip64 extensions in their local header need
+ * version 4.5 or better. The central directory uses the same version
+ * so both headers match.
+ *
+ * \return The version needed to extract to write in the headers.
+ */
+uint16_t ZipLocalEntry::getWriteExtractVersion() const
+{
+    if(isZip64()
+    && m_extract_version < g_zip64_format_version)
+    {
+        return g_zip64_format_version;
+    }
+    return m_extract_version;
+}
+
+
+/** \brief Retrieve the extra field saved in the local header.
+ *
+ * This function returns the extra field of the entry with the Zip64
+ * extended information extra field added when isZip64() is true. In
+ * the local header, that field always includes both sizes.
+ *
+ * \return The extra field of the local header.
+ */
+buffer_t ZipLocalEntry::getLocalExtraField() const
+{
+    std::vector<uint64_t> values;
+    if(isZip64())
+    {
+        // with a data descriptor the sizes are not known yet
+        //
+        bool const descriptor(hasTrailingDataDescriptor());
+        values.push_back(descriptor ? 0 : m_uncompressed_size);
+        values.push_back(descriptor ? 0 : m_compressed_size);
+    }
+    return zipMakeZip64ExtraField(m_extra_field, values);
+}
+
+
 /** \brief Read one local entry from \p is.
  *
  * This function verifies that the input stream starts with a local entry
  * signature. If so, it reads the input stream for a complete local entry.
  *
+ * The fixed size part of the header and the variable size part (the
+ * filename and extra field) are read with one call each and then parsed
+ * with the read() function working on a buffer.
+ *
  * Calling this function first marks the FileEntry object as invalid. If
  * the read succeeds in full, then the entry is again marked as valid.
  *
@@ -343,6 +494,65 @@ void ZipLocalEntry::read(std::istream & is)
         throw IOException("ZipLocalEntry::read() expected a signature but got some other data");
     }
 
+    buffer_t header;
+    zipRead(is, header, 30 - sizeof(signature));
+
+    uint16_t filename_len(0);
+    uint16_t extra_field_len(0);
+    size_t pos(26 - sizeof(signature));
+    zipRead(header, pos, filename_len);
+    zipRead(header, pos, extra_field_len);
+
+    buffer_t variable;
+    zipRead(is, variable, filename_len + extra_field_len);
+    header += variable;
+
+    pos = 0;
+    readFields(header, pos);
+}
+
+
+/** \brief Read one local entry from a buffer.
+ *
+ * This function verifies that the buffer at \p pos starts with a local
+ * entry signature. If so, it parses a complete local entry. On return,
+ * \p pos points right after the local entry header.
+ *
+ * Calling this function first marks the FileEntry object as invalid. If
+ * the read succeeds in full, then the entry is again marked as valid.
+ *
+ * \exception IOException
+ * This exception is raised if the signature is not valid or the buffer
+ * is too small to include the entire header.
+ *
+ * \param[in] is  The buffer to read from.
+ * \param[in,out] pos  The position of the local header in \p is.
+ */
+void ZipLocalEntry::read(buffer_t const & is, size_t & pos)
+{
+    m_valid = false; // set to true upon successful completion.
+
+    uint32_t signature(0);
+    zipRead(is, pos, signature);                        // 32
+    if(g_signature != signature)
+    {
+        throw IOException("ZipLocalEntry::read() expected a signature but got some other data");
+    }
+
+    readFields(is, pos);
+}
+
+
+/** \brief Parse the fields of a local entry header.
+ *
+ * This function parses the local entry header found in \p is at
+ * \p pos, right after the signature which the caller already verified.
+ *
+ * \param[in] is  The buffer to read from.
+ * \param[in,out] pos  The position of the header fields in \p is.
+ */
+void ZipLocalEntry::readFields(buffer_t const & is, size_t & pos)
+{
     uint16_t compress_method(0);
     uint32_t dosdatetime(0);
     uint32_t compressed_size(0);
@@ -352,21 +562,29 @@ void ZipLocalEntry::read(std::istream & is)
     std::string filename;
 
     // See the ZipLocalEntryHeader for more details
-    zipRead(is, m_extract_version);                 // 16
-    zipRead(is, m_general_purpose_bitfield);        // 16
-    zipRead(is, compress_method);                   // 16
-    zipRead(is, dosdatetime);                       // 32
-    zipRead(is, m_crc_32);                          // 32
-    zipRead(is, compressed_size);                   // 32
-    zipRead(is, uncompressed_size);                 // 32
-    zipRead(is, filename_len);                      // 16
-    zipRead(is, extra_field_len);                   // 16
-    zipRead(is, filename, filename_len);            // string
-    zipRead(is, m_extra_field, extra_field_len);    // buffer
-    /** \todo add support for zip64, some of those parameters
-     *        may be 0xFFFFF...FFFF in which case the 64 bit
-     *        header should be read
-     */
+    zipRead(is, pos, m_extract_version);                // 16
+    zipRead(is, pos, m_general_purpose_bitfield);       // 16
+    zipRead(is, pos, compress_method);                  // 16
+    zipRead(is, pos, dosdatetime);                      // 32
+    zipRead(is, pos, m_crc_32);                         // 32
+    zipRead(is, pos, compressed_size);                  // 32
+    zipRead(is, pos, uncompressed_size);                // 32
+    zipRead(is, pos, filename_len);                     // 16
+    zipRead(is, pos, extra_field_len);                  // 16
+    zipRead(is, pos, filename, filename_len);           // string
+    zipRead(is, pos, m_extra_field, extra_field_len);   // buffer
+
+    // sizes of 0xFFFFFFFF are defined in the Zip64 extra field
+    //
+    uint64_t size(uncompressed_size);
+    uint64_t csize(compressed_size);
+    uint64_t offset(0);
+    zipReadZip64ExtraField(m_extra_field.data(), m_extra_field.size(), size, csize, offset);
+
+    // the sizes of the data descriptor are on 64 bits when the local
+    // header includes a Zip64 extended information extra field
+    //
+    m_zip64 = zipMakeZip64ExtraField(m_extra_field, std::vector<uint64_t>()).size() != m_extra_field.size();
 
     // the FilePath() will remove the trailing slash so make sure
     // to defined the m_is_directory ahead of time!
@@ -376,8 +594,8 @@ void ZipLocalEntry::read(std::istream & is)
     DOSDateTime t;
     t.setDOSDateTime(dosdatetime);
     m_unix_time = t.getUnixTimestamp();
-    m_compressed_size = compressed_size;
-    m_uncompressed_size = uncompressed_size;
+    m_compressed_size = csize;
+    m_uncompressed_size = size;
     m_filename = FilePath(filename);
 
     m_valid = true;
@@ -397,27 +615,13 @@ void ZipLocalEntry::read(std::istream & is)
  */
 void ZipLocalEntry::write(std::ostream & os)
 {
-    if(m_filename.length()  > 0x10000
-    || m_extra_field.size() > 0x10000)
+    buffer_t const extra_field(getLocalExtraField());
+    if(m_filename.length() > 0x10000
+    || extra_field.size()  > 0x10000)
     {
         throw InvalidStateException("ZipLocalEntry::write(): file name or extra field too large to save in a Zip file.");
     }
 
-    /** todo: add support for 64 bit zip archive
-     */
-#if INTPTR_MAX != INT32_MAX
-    if(m_compressed_size   >= 0x100000000UL
-    || m_uncompressed_size >= 0x100000000UL)
-    {
-        // these are really big files, we do not currently test such so ignore in coverage
-        //
-        // Note: The compressed size is known at the end, we seek back to
-        //       this header and re-save it with the info; thus the error
-        //       is caught then if it was not out of bounds earlier.
-        throw InvalidStateException("The size of this file is too large to fit in a 32 bit zip archive."); // LCOV_EXCL_LINE
-    }
-#endif
-
     std::string filename(m_filename);
     if(m_is_directory)
     {
@@ -433,24 +637,122 @@ void ZipLocalEntry::write(std::ostream & os)
     DOSDateTime t;
     t.setUnixTimestamp(m_unix_time);
     std::uint32_t dosdatetime(t.getDOSDateTime());       // type could use DOSDateTime::dosdatetime_t
-    std::uint32_t compressed_size(m_compressed_size);
-    std::uint32_t uncompressed_size(m_uncompressed_size);
+    bool const descriptor(hasTrailingDataDescriptor());
+    std::uint16_t extract_version(getWriteExtractVersion());
+    std::uint32_t crc_32(descriptor ? 0 : m_crc_32);
+    std::uint32_t compressed_size(isZip64() ? 0xFFFFFFFF : (descriptor ? 0 : m_compressed_size));
+    std::uint32_t uncompressed_size(isZip64() ? 0xFFFFFFFF : (descriptor ? 0 : m_uncompressed_size));
     std::uint16_t filename_len(filename.length());
-    std::uint16_t extra_field_len(m_extra_field.size());
+    std::uint16_t extra_field_len(extra_field.size());
 
     // See the ZipLocalEntryHeader for more details
     zipWrite(os, g_signature);                  // 32
-    zipWrite(os, m_extract_version);            // 16
+    zipWrite(os, extract_version);              // 16
     zipWrite(os, m_general_purpose_bitfield);   // 16
     zipWrite(os, compress_method);              // 16
     zipWrite(os, dosdatetime);                  // 32
-    zipWrite(os, m_crc_32);                     // 32
+    zipWrite(os, crc_32);                       // 32
     zipWrite(os, compressed_size);              // 32
     zipWrite(os, uncompressed_size);            // 32
     zipWrite(os, filename_len);                 // 16
     zipWrite(os, extra_field_len);              // 16
     zipWrite(os, filename);                     // string
-    zipWrite(os, m_extra_field);                // buffer
+    zipWrite(os, extra_field);                  // buffer
+}
+
+
+/** \brief Write the data descriptor of this entry to \p os.
+ *
+ * This function writes the data descriptor which follows the data of
+ * entries saved with hasTrailingDataDescriptor() set to true. It
+ * includes the CRC and the sizes of the entry.
+ *
+ * The sizes are saved on 64 bits when the local header was written
+ * with a Zip64 extended information extra field (see setZip64()) and
+ * on 32 bits otherwise. Readers decide the size of the data descriptor
+ * from that extra field so the two have to match.
+ *
+ * \exception InvalidStateException
+ * This exception is raised if the sizes do not fit in 32 bits and the
+ * local header was written without the Zip64 extra field.
+ *
+ * \exception IOException
+ * If an error occurs while writing to the output stream, the function
+ * throws an IOException.
+ *
+ * \param[in] os  The output stream where the data descriptor is written.
+ */
+void ZipLocalEntry::writeDataDescriptor(std::ostream & os)
+{
+    if(!m_zip64
+    && (m_compressed_size >= 0xFFFFFFFF || m_uncompressed_size >= 0xFFFFFFFF))
+    {
+        throw InvalidStateException("ZipLocalEntry::writeDataDescriptor(): the entry is too large for its local header, set its size before calling putNextEntry() so it uses Zip64.");
+    }
+
+    zipWrite(os, g_data_descriptor_signature);  // 32
+    zipWrite(os, m_crc_32);                     // 32
+    if(m_zip64)
+    {
+        std::uint64_t const compressed_size(m_compressed_size);
+        std::uint64_t const uncompressed_size(m_uncompressed_size);
+        zipWrite(os, compressed_size);          // 64
+        zipWrite(os, uncompressed_size);        // 64
+    }
+    else
+    {
+        std::uint32_t const compressed_size(m_compressed_size);
+        std::uint32_t const uncompressed_size(m_uncompressed_size);
+        zipWrite(os, compressed_size);          // 32
+        zipWrite(os, uncompressed_size);        // 32
+    }
+}
+
+
+/** \brief Read the data descriptor of this entry from \p is.
+ *
+ * This function reads the data descriptor which follows the data of
+ * entries with hasTrailingDataDescriptor() set to true and saves the
+ * CRC and sizes it includes in this entry.
+ *
+ * The signature of the data descriptor is optional. It is skipped when
+ * present. The sizes are read on 64 bits when the local header of the
+ * entry has a Zip64 extended information extra field.
+ *
+ * \exception IOException
+ * This exception is raised if the data descriptor cannot be read.
+ *
+ * \param[in] is  The input stream positioned right after the data.
+ */
+void ZipLocalEntry::readDataDescriptor(std::istream & is)
+{
+    uint32_t crc_32(0);
+    zipRead(is, crc_32);                        // 32
+    if(crc_32 == g_data_descriptor_signature)
+    {
+        zipRead(is, crc_32);                    // 32
+    }
+    m_crc_32 = crc_32;
+    m_has_crc_32 = true;
+
+    if(isZip64())
+    {
+        uint64_t compressed_size(0);
+        uint64_t uncompressed_size(0);
+        zipRead(is, compressed_size);           // 64
+        zipRead(is, uncompressed_size);         // 64
+        m_compressed_size = compressed_size;
+        m_uncompressed_size = uncompressed_size;
+    }
+    else
+    {
+        uint32_t compressed_size(0);
+        uint32_t uncompressed_size(0);
+        zipRead(is, compressed_size);           // 32
+        zipRead(is, uncompressed_size);         // 32
+        m_compressed_size = compressed_size;
+        m_uncompressed_size = uncompressed_size;
+    }
 }
 
 
@@ -44,6 +44,7 @@ class ZipLocalEntry : public FileEntry
 public:
     // Zip file format version
     static uint16_t const       g_zip_format_version = 20; // 2.0
+    static uint16_t const       g_zip64_format_version = 45; // 4.5
 
                                 ZipLocalEntry();
                                 ZipLocalEntry(FileEntry const & src);
@@ -58,15 +59,28 @@ public:
     virtual void                setCrc(crc32_t crc) override;
 
     bool                        hasTrailingDataDescriptor() const;
+    void                        setTrailingDataDescriptor(bool descriptor);
+    uint16_t                    getExtractVersion() const;
+    void                        setExtractVersion(uint16_t version);
+    bool                        isZip64() const;
+    void                        setZip64(bool zip64);
 
     virtual void                read(std::istream & is) override;
+    void                        read(buffer_t const & is, size_t & pos);
     virtual void                write(std::ostream & os) override;
+    void                        readDataDescriptor(std::istream & is);
+    void                        writeDataDescriptor(std::ostream & os);
 
 protected:
+    void                        readFields(buffer_t const & is, size_t & pos);
+    uint16_t                    getWriteExtractVersion() const;
+    buffer_t                    getLocalExtraField() const;
+
     uint16_t                    m_extract_version = g_zip_format_version;
     uint16_t                    m_general_purpose_bitfield = 0;
     bool                        m_is_directory = false;
     size_t                      m_compressed_size = 0;
+    bool                        m_zip64 = false;
 };
 
 
@@ -29,6 +29,9 @@
 #include "zipoutputstream.hpp"
 #include "zipcentraldirectoryentry.hpp"
 
+#include "zipios/zipfile.hpp"
+#include "zipios/zipiosexceptions.hpp"
+
 #include <fstream>
 
 
@@ -50,9 +53,10 @@ namespace zipios
  * be used to save Zip data to a file.
  *
  * \param[in] os  The output stream to use to write the Zip archive.
+ * \param[in] policy  The I/O policy defining the size of the output buffers.
  */
-ZipOutputStream::ZipOutputStream(std::ostream & os)
-    : m_ozf(std::make_unique<ZipOutputStreambuf>(os.rdbuf()))
+ZipOutputStream::ZipOutputStream(std::ostream & os, IOPolicy const & policy)
+    : m_ozf(std::make_unique<ZipOutputStreambuf>(os.rdbuf(), policy.getOutputBufferSize()))
 {
     init(m_ozf.get());
 }
@@ -140,6 +144,105 @@ void ZipOutputStream::putNextEntry(FileEntry::pointer_t entry)
 }
 
 
+/** \brief Add an entry which was already compressed.
+ *
+ * This function saves an entry for which the local header and the
+ * compressed data were already generated, for example by another
+ * ZipOutputStream writing to a memory buffer. The \p entry must be
+ * the ZipCentralDirectoryEntry that was used to generate \p data.
+ *
+ * \param[in] entry  The entry to add to the output stream.
+ * \param[in] data  The local header and the compressed data of the entry.
+ *
+ * \sa ZipOutputStreambuf::putBufferedEntry()
+ */
+void ZipOutputStream::putBufferedEntry(FileEntry::pointer_t entry, std::string const & data)
+{
+    m_ozf->putBufferedEntry(entry, data);
+}
+
+
+/** \brief Copy an entry from another archive without recompressing it.
+ *
+ * This function saves \p entry, an entry of \p zf, with its compressed
+ * data copied as is from \p zf. The data does not get decompressed and
+ * compressed again and the method, CRC-32, and sizes of the entry are
+ * kept. This is much faster than putNextEntry() when merging or
+ * filtering archives.
+ *
+ * The \p entry itself is not modified; a copy gets added to the
+ * output stream.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if \p zf has no entry named like \p entry.
+ *
+ * \param[in,out] zf  The archive the entry comes from.
+ * \param[in] entry  The entry of \p zf to copy.
+ *
+ * \sa ZipFile::getRawInputStream()
+ * \sa ZipOutputStreambuf::putRawEntry()
+ */
+void ZipOutputStream::putRawEntry(ZipFile & zf, FileEntry::pointer_t entry)
+{
+    ZipFile::stream_pointer_t data(zf.getRawInputStream(entry->getName()));
+    if(data == nullptr)
+    {
+        throw FileCollectionException("ZipOutputStream::putRawEntry(): entry \"" + entry->getName() + "\" not found.");
+    }
+
+    // the entry of the ZipFile must not change
+    //
+    FileEntry::pointer_t copy;
+    if(dynamic_cast<ZipCentralDirectoryEntry *>(entry.get()) != nullptr)
+    {
+        copy = entry->clone();
+    }
+    else
+    {
+        copy = std::make_shared<ZipCentralDirectoryEntry>(*entry);
+    }
+    copy->setCompressedSize(entry->getCompressedSize());
+
+    m_ozf->putRawEntry(copy, *data);
+}
+
+
+/** \brief Add the entries already found in the output.
+ *
+ * This function is used to append entries to an existing archive. The
+ * \p entries are the Central Directory entries of the archive and the
+ * output stream is expected to be positioned where its Central
+ * Directory started. The \p entries get saved in the new Central
+ * Directory before the entries added to this output stream.
+ *
+ * \param[in] entries  The Central Directory entries of the archive.
+ *
+ * \sa ZipOutputStreambuf::addExistingEntries()
+ */
+void ZipOutputStream::addExistingEntries(FileEntry::vector_t const & entries)
+{
+    m_ozf->addExistingEntries(entries);
+}
+
+
+/** \brief Compress large entries in parallel.
+ *
+ * This function cuts the data of the deflated entries in blocks of
+ * \p block_size bytes which get compressed by \p threads threads.
+ * Entries smaller than one block are saved as without this option.
+ * It applies to the entries added with putNextEntry() after this call.
+ *
+ * \param[in] block_size  The size of the blocks, 0 to turn it off.
+ * \param[in] threads  The number of threads, 0 for one per hardware thread.
+ *
+ * \sa DeflateOutputStreambuf::setBlockSize()
+ */
+void ZipOutputStream::setBlockSize(size_t block_size, size_t threads)
+{
+    m_ozf->setBlockSize(block_size, threads);
+}
+
+
 /** \brief Set the global comment.
  *
  * This function is used to setup the Global Comment of the Zip archive
@@ -156,6 +259,48 @@ void ZipOutputStream::setComment(std::string const & comment)
 }
 
 
+/** \brief Set the size limit of entries deflated as a whole.
+ *
+ * DEFLATED entries up to \p limit bytes get deflated in one call with
+ * libdeflate when available.
+ *
+ * \param[in] limit  The size of the largest entry deflated as a whole.
+ *
+ * \sa ZipOutputStreambuf::setWholeBufferLimit()
+ */
+void ZipOutputStream::setWholeBufferLimit(size_t limit)
+{
+    m_ozf->setWholeBufferLimit(limit);
+}
+
+
+/** \brief Write the archive without seeking back.
+ *
+ * In streaming mode, each entry is followed by a data descriptor
+ * instead of having its local header rewritten so the output stream
+ * does not need to support seeking. The mode is turned on automatically
+ * when the output stream cannot tell its position.
+ *
+ * \param[in] streaming  Whether to write the archive in streaming mode.
+ *
+ * \sa ZipOutputStreambuf::setStreaming()
+ */
+void ZipOutputStream::setStreaming(bool streaming)
+{
+    m_ozf->setStreaming(streaming);
+}
+
+
+/** \brief Check whether the archive is written in streaming mode.
+ *
+ * \return true if the entries get written with a data descriptor.
+ */
+bool ZipOutputStream::isStreaming() const
+{
+    return m_ozf->isStreaming();
+}
+
+
 } // zipios namespace
 
 // Local Variables:
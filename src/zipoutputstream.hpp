@@ -32,23 +32,33 @@
 
 #include "zipoutputstreambuf.hpp"
 
+#include "zipios/iopolicy.hpp"
+
 
 namespace zipios
 {
 
+class ZipFile;
 class ZipOutputStreambuf;
 
 class ZipOutputStream : public std::ostream
 {
 public:
-                    ZipOutputStream(std::ostream & os);
+                    ZipOutputStream(std::ostream & os, IOPolicy const & policy = IOPolicy());
     virtual         ~ZipOutputStream();
 
+    void            addExistingEntries(FileEntry::vector_t const & entries);
     void            closeEntry();
     void            close();
     void            finish();
     void            putNextEntry(FileEntry::pointer_t entry);
+    void            putBufferedEntry(FileEntry::pointer_t entry, std::string const & data);
+    void            putRawEntry(ZipFile & zf, FileEntry::pointer_t entry);
+    void            setBlockSize(size_t block_size, size_t threads = 1);
     void            setComment(std::string const & comment);
+    void            setWholeBufferLimit(size_t limit);
+    void            setStreaming(bool streaming);
+    bool            isStreaming() const;
 
 private:
     std::unique_ptr<ZipOutputStreambuf> m_ozf = std::unique_ptr<ZipOutputStreambuf>();
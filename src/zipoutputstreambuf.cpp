@@ -30,6 +30,9 @@
 
 #include "zipios/zipiosexceptions.hpp"
 
+#include "countingoutputstreambuf.hpp"
+#include "crc32.hpp"
+#include "deflatebackend.hpp"
 #include "ziplocalentry.hpp"
 #include "zipendofcentraldirectory.hpp"
 
@@ -42,6 +45,16 @@ namespace
 {
 
 
+/** \brief Size from which the local headers use Zip64.
+ *
+ * The local header is written before the data and the compressed size
+ * may end up slightly larger than the uncompressed size. Entries with
+ * an uncompressed size close enough to 4Gb therefore use Zip64 from
+ * the start.
+ */
+size_t const g_zip64_threshold = 0xFFFFFFFF - 0xFFFFFFFF / 256;
+
+
 /** \brief Helper function used to write the central directory.
  *
  * When you create a Zip archive, it includes a central directory where
@@ -90,11 +103,19 @@ void writeZipCentralDirectory(
  * Note that a new initialized ZipOutputStreambuf is not ready to
  * accept data, putNextEntry() must be invoked at least once first.
  *
+ * When \p outbuf cannot tell its position, as with a pipe or a socket,
+ * the streambuf starts in streaming mode (see setStreaming()).
+ *
  * \param[in] outbuf  The streambuf to use for output.
+ * \param[in] buffer_size  The size of the output buffers.
  */
-ZipOutputStreambuf::ZipOutputStreambuf(std::streambuf * outbuf)
-    : DeflateOutputStreambuf(outbuf)
+ZipOutputStreambuf::ZipOutputStreambuf(std::streambuf * outbuf, size_t buffer_size)
+    : DeflateOutputStreambuf(outbuf, buffer_size)
 {
+    if(m_outbuf->pubseekoff(0, std::ios::cur, std::ios::out) == std::streampos(-1))
+    {
+        setStreaming(true);
+    }
 }
 
 
@@ -121,6 +142,41 @@ ZipOutputStreambuf::~ZipOutputStreambuf()
     catch(...)
     {
     }
+
+    // the counter gets destroyed before our base class
+    //
+    if(m_counter != nullptr)
+    {
+        m_outbuf = m_counter->getOutputStreambuf();
+    }
+}
+
+
+/** \brief Add entries which are already saved in the output.
+ *
+ * When appending to an existing archive, its local headers and data
+ * are kept as is and the output is positioned where its Central
+ * Directory started. This function adds the Central Directory entries
+ * of that archive so they get saved in the new Central Directory, in
+ * front of the entries added with putNextEntry() and putBufferedEntry().
+ *
+ * The \p entries are expected to be ZipCentralDirectoryEntry objects
+ * with a valid entry offset.
+ *
+ * \exception InvalidStateException
+ * The existing entries have to be added before any other entry.
+ *
+ * \param[in] entries  The entries found in the Central Directory of
+ *                     the archive.
+ */
+void ZipOutputStreambuf::addExistingEntries(FileEntry::vector_t const & entries)
+{
+    if(!m_entries.empty())
+    {
+        throw InvalidStateException("ZipOutputStreambuf::addExistingEntries(): the existing entries must be added before any other entry.");
+    }
+
+    m_entries = entries;
 }
 
 
@@ -136,16 +192,26 @@ void ZipOutputStreambuf::closeEntry()
         return;
     }
 
-    switch(m_compression_level)
+    if(m_compressor != nullptr)
     {
-    case FileEntry::COMPRESSION_LEVEL_NONE:
         overflow(); // flush
-        break;
+        m_compressor->compress(nullptr, 0, true, m_compressed);
+        writeCompressed();
+        m_compressor.reset();
+    }
+    else
+    {
+        switch(m_compression_level)
+        {
+        case FileEntry::COMPRESSION_LEVEL_NONE:
+            overflow(); // flush
+            break;
 
-    default:
-        closeStream();
-        break;
+        default:
+            closeStream();
+            break;
 
+        }
     }
 
     updateEntryHeaderInfo();
@@ -193,6 +259,20 @@ void ZipOutputStreambuf::finish()
  * If a previous entry was still open, the function calls closeEntry()
  * first.
  *
+ * Entries using a method other than STORED and DEFLATED get compressed
+ * with the Codec registered for that method.
+ *
+ * DEFLATED entries of known size up to the whole buffer limit (see
+ * setWholeBufferLimit()) get deflated in one call with libdeflate when
+ * available.
+ *
+ * Entries with a size close to or over 4Gb get a Zip64 local header.
+ * Since the local header cannot grow once the data follows it, the size
+ * of large entries must be set before calling this function.
+ *
+ * \exception FileCollectionException
+ * This exception is raised if no codec supports the method of \p entry.
+ *
  * \param[in] entry  The entry to be saved and made current.
  */
 void ZipOutputStreambuf::putNextEntry(FileEntry::pointer_t entry)
@@ -210,17 +290,48 @@ void ZipOutputStreambuf::putNextEntry(FileEntry::pointer_t entry)
         // get the user defined compression level
         m_compression_level = entry->getLevel();
     }
+
+    if(m_compression_level != FileEntry::COMPRESSION_LEVEL_NONE
+    && entry->getMethod() != StorageMethod::DEFLATED)
+    {
+        Codec::pointer_t codec(Codec::getCodec(entry->getMethod()));
+        if(codec == nullptr)
+        {
+            throw FileCollectionException("Unsupported compression format");
+        }
+        m_compressor = codec->createCompressor(m_compression_level);
+        static_cast<ZipLocalEntry *>(entry.get())->setExtractVersion(codec->getExtractVersion());
+    }
+    else if(m_compression_level != FileEntry::COMPRESSION_LEVEL_NONE
+         && m_whole_buffer_limit > 0
+         && entry->getSize() <= m_whole_buffer_limit)
+    {
+        // this returns nullptr when libdeflate is not available in which
+        // case zlib gets used as usual
+        //
+        m_compressor = createWholeBufferCompressor(getDeflateLevel(m_compression_level));
+    }
+
     m_overflown_bytes = 0;
-    switch(m_compression_level)
+    if(m_compressor != nullptr)
     {
-    case FileEntry::COMPRESSION_LEVEL_NONE:
-        setp(&m_invec[0], &m_invec[0] + getBufferSize());
-        break;
+        // the codec compresses the data in overflow()
+        //
+        setp(&m_invec[0], &m_invec[0] + m_invec.size());
+    }
+    else
+    {
+        switch(m_compression_level)
+        {
+        case FileEntry::COMPRESSION_LEVEL_NONE:
+            setp(&m_invec[0], &m_invec[0] + m_invec.size());
+            break;
 
-    default:
-        init(m_compression_level);
-        break;
+        default:
+            init(m_compression_level);
+            break;
 
+        }
     }
 
     m_entries.push_back(entry);
@@ -229,6 +340,8 @@ void ZipOutputStreambuf::putNextEntry(FileEntry::pointer_t entry)
 
     // Update entry header info
     entry->setEntryOffset(os.tellp());
+    static_cast<ZipLocalEntry *>(entry.get())->setZip64(entry->getSize() >= g_zip64_threshold);
+    static_cast<ZipLocalEntry *>(entry.get())->setTrailingDataDescriptor(isStreaming());
     /** \TODO
      * Rethink the design as we have to force a call to the correct
      * write() function?
@@ -239,6 +352,93 @@ void ZipOutputStreambuf::putNextEntry(FileEntry::pointer_t entry)
 }
 
 
+/** \brief Save an entry which was already compressed.
+ *
+ * This function saves an entry for which the local header and the
+ * compressed data were already generated, in general by another
+ * ZipOutputStreambuf writing to a memory buffer. This is how entries
+ * get compressed in parallel.
+ *
+ * The \p data buffer is written as is. The offset of \p entry is set
+ * to the current position and the entry is added to the Central
+ * Directory. All the other fields of the entry (sizes, CRC-32, etc.)
+ * are expected to already match \p data.
+ *
+ * If a previous entry was still open, the function calls closeEntry()
+ * first.
+ *
+ * \exception IOException
+ * This exception is raised if the data cannot be written.
+ *
+ * \param[in] entry  The entry to be saved.
+ * \param[in] data  The local header and the compressed data of the entry.
+ */
+void ZipOutputStreambuf::putBufferedEntry(FileEntry::pointer_t entry, std::string const & data)
+{
+    closeEntry();
+
+    std::ostream os(m_outbuf);
+    entry->setEntryOffset(os.tellp());
+    m_entries.push_back(entry);
+
+    if(m_outbuf->sputn(data.data(), data.size()) != static_cast<std::streamsize>(data.size()))
+    {
+        throw IOException("ZipOutputStreambuf::putBufferedEntry(): write to buffer failed.");
+    }
+}
+
+
+/** \brief Save an entry with data compressed by another archive.
+ *
+ * This function saves \p entry with the compressed data read from
+ * \p data as is. The method, CRC-32, and sizes of \p entry are
+ * expected to match that data, which is the case when copying an
+ * entry from one archive to another.
+ *
+ * The local header gets written with the final sizes and CRC-32, so
+ * no data descriptor is necessary even in streaming mode.
+ *
+ * If a previous entry was still open, the function calls closeEntry()
+ * first.
+ *
+ * \exception IOException
+ * This exception is raised if \p data ends before the compressed size
+ * of \p entry was read or the data cannot be written.
+ *
+ * \param[in] entry  The entry to be saved.
+ * \param[in,out] data  The stream returning the compressed data.
+ */
+void ZipOutputStreambuf::putRawEntry(FileEntry::pointer_t entry, std::istream & data)
+{
+    closeEntry();
+
+    std::ostream os(m_outbuf);
+    entry->setEntryOffset(os.tellp());
+    static_cast<ZipLocalEntry *>(entry.get())->setZip64(false);
+    static_cast<ZipLocalEntry *>(entry.get())->setTrailingDataDescriptor(false);
+    static_cast<ZipLocalEntry *>(entry.get())->ZipLocalEntry::write(os);
+    m_entries.push_back(entry);
+
+    std::vector<char> buffer(m_invec.size());
+    for(offset_t remain(entry->getCompressedSize()); remain > 0; )
+    {
+        std::streamsize const size(std::min(remain, static_cast<offset_t>(buffer.size())));
+        std::streamsize const g(data.rdbuf()->sgetn(buffer.data(), size));
+        if(g <= 0)
+        {
+            throw IOException("ZipOutputStreambuf::putRawEntry(): EOF reached while reading the data of \""
+                            + entry->getName()
+                            + "\".");
+        }
+        if(m_outbuf->sputn(buffer.data(), g) != g)
+        {
+            throw IOException("ZipOutputStreambuf::putRawEntry(): write to buffer failed."); // LCOV_EXCL_LINE
+        }
+        remain -= g;
+    }
+}
+
+
 /** \brief Set the archive comment.
  *
  * This function saves a global comment for the Zip archive.
@@ -257,6 +457,85 @@ void ZipOutputStreambuf::setComment(std::string const & comment)
 }
 
 
+/** \brief Set the size limit of entries deflated as a whole.
+ *
+ * libdeflate compresses faster and better than zlib but it only works
+ * on whole buffers. This function sets the size of the largest
+ * DEFLATED entry which gets kept in memory and deflated with libdeflate
+ * when putNextEntry() is called. The size of the entry must be known
+ * at that time.
+ *
+ * The default is 0 meaning that all the entries get deflated with zlib.
+ * The deflated data differs between both libraries so the archives are
+ * only identical when created with the same limit.
+ *
+ * When libdeflate is not available, the limit is ignored.
+ *
+ * \param[in] limit  The size of the largest entry deflated as a whole.
+ */
+void ZipOutputStreambuf::setWholeBufferLimit(size_t limit)
+{
+    m_whole_buffer_limit = limit;
+}
+
+
+/** \brief Write the archive without seeking back.
+ *
+ * By default, the local header of each entry gets written again once
+ * its data was written since the CRC and sizes are only known then.
+ * This requires an output which supports seeking.
+ *
+ * In streaming mode, the local headers are written only once, with
+ * bit 3 of the general purpose flags set, and a data descriptor with
+ * the CRC and sizes follows the data of each entry. The positions are
+ * counted as the data gets written so the output does not need to
+ * support seeking at all. It can be a pipe, a socket, etc.
+ *
+ * Entries added with putBufferedEntry() already have their final local
+ * header and are not affected.
+ *
+ * \exception InvalidStateException
+ * The mode cannot be changed once entries were added.
+ *
+ * \param[in] streaming  Whether to write the archive in streaming mode.
+ */
+void ZipOutputStreambuf::setStreaming(bool streaming)
+{
+    if(streaming == isStreaming())
+    {
+        return;
+    }
+    if(!m_entries.empty())
+    {
+        throw InvalidStateException("ZipOutputStreambuf::setStreaming(): the streaming mode cannot be changed once entries were added.");
+    }
+
+    if(streaming)
+    {
+        std::streampos const pos(m_outbuf->pubseekoff(0, std::ios::cur, std::ios::out));
+        m_counter = std::make_unique<CountingOutputStreambuf>(m_outbuf, pos == std::streampos(-1) ? 0 : static_cast<offset_t>(pos));
+        m_outbuf = m_counter.get();
+    }
+    else
+    {
+        m_outbuf = m_counter->getOutputStreambuf();
+        m_counter.reset();
+    }
+}
+
+
+/** \brief Check whether the streambuf is in streaming mode.
+ *
+ * \return true if the entries get written with a data descriptor.
+ *
+ * \sa setStreaming()
+ */
+bool ZipOutputStreambuf::isStreaming() const
+{
+    return m_counter != nullptr;
+}
+
+
 //
 // Protected and private methods
 //
@@ -279,13 +558,29 @@ int ZipOutputStreambuf::overflow(int c)
 {
     std::size_t const size(pptr() - pbase());
     m_overflown_bytes += size;
+    if(m_compressor != nullptr)
+    {
+        m_crc32 = updateCRC32(m_crc32, &m_invec[0], size);
+        m_compressor->compress(&m_invec[0], size, false, m_compressed);
+        writeCompressed();
+        setp(&m_invec[0], &m_invec[0] + m_invec.size());
+
+        if(c != EOF)
+        {
+            *pptr() = c;
+            pbump(1);
+        }
+
+        return 0;
+    }
+
     switch(m_compression_level)
     {
     case FileEntry::COMPRESSION_LEVEL_NONE:
     {
         // Ok, we are STORED, so we handle it ourselves to avoid "side
         // effects" from zlib, which adds markers every now and then.
-        m_crc32 = crc32(m_crc32, reinterpret_cast<Bytef const *>(&m_invec[0]), size); // update crc32
+        m_crc32 = updateCRC32(m_crc32, &m_invec[0], size); // update crc32
         size_t const bc(m_outbuf->sputn(&m_invec[0], size));
         if(size != bc)
         {
@@ -294,7 +589,7 @@ int ZipOutputStreambuf::overflow(int c)
             // inside the same loop in ZipFile::saveCollectionToArchive()
             throw IOException("ZipOutputStreambuf::overflow(): write to buffer failed."); // LCOV_EXCL_LINE
         }
-        setp(&m_invec[0], &m_invec[0] + getBufferSize());
+        setp(&m_invec[0], &m_invec[0] + m_invec.size());
 
         if(c != EOF)
         {
@@ -328,6 +623,29 @@ int ZipOutputStreambuf::sync() // LCOV_EXCL_LINE
 
 
 
+/** \brief Write the data compressed by the codec.
+ *
+ * This function writes the data found in m_compressed to the output
+ * and clears the buffer.
+ *
+ * \exception IOException
+ * This exception is raised if the data cannot be written.
+ */
+void ZipOutputStreambuf::writeCompressed()
+{
+    if(!m_compressed.empty())
+    {
+        std::streamsize const size(m_compressed.size());
+        if(m_outbuf->sputn(m_compressed.data(), size) != size)
+        {
+            throw IOException("ZipOutputStreambuf::writeCompressed(): write to buffer failed."); // LCOV_EXCL_LINE
+        }
+        m_compressed.clear();
+    }
+}
+
+
+
 /** \brief Mark the current entry as closed.
  *
  * After the putNextEntry() call and saving of the file content, the
@@ -337,7 +655,7 @@ int ZipOutputStreambuf::sync() // LCOV_EXCL_LINE
 void ZipOutputStreambuf::setEntryClosedState()
 {
     m_open_entry = false;
-    m_crc32 = crc32(0, nullptr, 0);
+    m_crc32 = 0;
 
     /** \FIXME
      * Update put pointers to trigger overflow on write. Overflow
@@ -356,6 +674,17 @@ void ZipOutputStreambuf::setEntryClosedState()
  * \li The uncompressed size of the entry
  * \li The compressed size of the entry
  * \li The CRC32 of the input file (before the compression)
+ *
+ * In streaming mode, the header is not written again. Instead, a data
+ * descriptor with these parameters is written after the data. That
+ * descriptor uses 64 bit sizes only when the local header includes a
+ * Zip64 extra field.
+ *
+ * \exception InvalidStateException
+ * This exception is raised if the entry ends up needing Zip64 when its
+ * local header was written without it, i.e. the size of the entry was
+ * not set to its final size before putNextEntry() was called. This
+ * applies to the streaming mode as well.
  */
 void ZipOutputStreambuf::updateEntryHeaderInfo()
 {
@@ -365,17 +694,33 @@ void ZipOutputStreambuf::updateEntryHeaderInfo()
     }
 
     std::ostream os(m_outbuf);
-    int const curr_pos(os.tellp());
+    std::streampos const curr_pos(os.tellp());
 
     // update fields in m_entries.back()
     FileEntry::pointer_t entry(m_entries.back());
-    entry->setSize(getSize());
-    entry->setCrc(getCrc32());
     /** \TODO
      * Rethink the design as we have to force a call to the correct
      * getHeaderSize() function?
      */
-    entry->setCompressedSize(curr_pos - entry->getEntryOffset() - static_cast<ZipLocalEntry *>(entry.get())->ZipLocalEntry::getHeaderSize());
+    size_t const header_size(static_cast<ZipLocalEntry *>(entry.get())->ZipLocalEntry::getHeaderSize());
+    entry->setSize(getSize());
+    entry->setCrc(getCrc32());
+    entry->setCompressedSize(curr_pos - entry->getEntryOffset() - header_size);
+
+    if(isStreaming())
+    {
+        // the CRC and sizes follow the data
+        //
+        static_cast<ZipLocalEntry *>(entry.get())->writeDataDescriptor(os);
+        return;
+    }
+
+    // the new header has to fit exactly where the old one was written
+    //
+    if(static_cast<ZipLocalEntry *>(entry.get())->ZipLocalEntry::getHeaderSize() != header_size)
+    {
+        throw InvalidStateException("ZipOutputStreambuf::updateEntryHeaderInfo(): the entry is too large for its local header, set its size before calling putNextEntry() so it uses Zip64.");
+    }
 
     // write ZipLocalEntry header to header position
     os.seekp(entry->getEntryOffset());
@@ -29,9 +29,10 @@
  * This class is used to save files in a Zip archive.
  */
 
+#include "countingoutputstreambuf.hpp"
 #include "deflateoutputstreambuf.hpp"
 
-#include "zipios/fileentry.hpp"
+#include "zipios/codec.hpp"
 
 
 namespace zipios
@@ -41,17 +42,23 @@ namespace zipios
 class ZipOutputStreambuf : public DeflateOutputStreambuf
 {
 public:
-                                ZipOutputStreambuf(std::streambuf * outbuf);
+                                ZipOutputStreambuf(std::streambuf * outbuf, size_t buffer_size = getBufferSize());
                                 ZipOutputStreambuf(ZipOutputStreambuf const & rhs) = delete;
     virtual                     ~ZipOutputStreambuf();
 
     ZipOutputStreambuf &        operator = (ZipOutputStreambuf const & rhs) = delete;
 
+    void                        addExistingEntries(FileEntry::vector_t const & entries);
     void                        closeEntry();
     void                        close();
     void                        finish();
     void                        putNextEntry(FileEntry::pointer_t entry);
+    void                        putBufferedEntry(FileEntry::pointer_t entry, std::string const & data);
+    void                        putRawEntry(FileEntry::pointer_t entry, std::istream & data);
     void                        setComment(std::string const & comment);
+    void                        setWholeBufferLimit(size_t limit);
+    void                        setStreaming(bool streaming);
+    bool                        isStreaming() const;
 
 protected:
     virtual int                 overflow(int c = EOF) override;
@@ -60,10 +67,16 @@ protected:
 private:
     void                        setEntryClosedState();
     void                        updateEntryHeaderInfo();
+    void                        writeCompressed();
 
     std::string                 m_zip_comment = std::string();
     FileEntry::vector_t         m_entries = FileEntry::vector_t();
     FileEntry::CompressionLevel m_compression_level = FileEntry::COMPRESSION_LEVEL_DEFAULT;
+    Compressor::pointer_t       m_compressor = Compressor::pointer_t();
+    std::vector<char>           m_compressed = std::vector<char>();
+    size_t                      m_whole_buffer_limit = 0;
+    std::unique_ptr<CountingOutputStreambuf>
+                                m_counter = std::unique_ptr<CountingOutputStreambuf>();
     bool                        m_open_entry = false;
     bool                        m_open = true;
 };
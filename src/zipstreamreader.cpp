@@ -0,0 +1,276 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of zipios::ZipStreamReader.
+ *
+ * This file implements the sequential reader of Zip archives.
+ */
+
+#include "zipios/zipstreamreader.hpp"
+
+#include "zipios/zipiosexceptions.hpp"
+
+#include "pushbackstreambuf.hpp"
+#include "zipinputstream.hpp"
+#include "zipios_common.hpp"
+
+#include <vector>
+
+
+namespace zipios
+{
+
+
+namespace
+{
+
+
+/** \brief The signature of a local header.
+ *
+ * This value represents the signature of a Zip archive Local Entry
+ * Header. It has to match the one found in ziplocalentry.cpp.
+ */
+uint32_t const  g_local_header_signature = 0x04034b50;
+
+
+/** \brief The signatures found at the start of split archives.
+ *
+ * An archive which was meant to be split but fit in a single segment
+ * may start with one of these markers. They are skipped.
+ */
+uint32_t const  g_split_signature = 0x08074b50;
+uint32_t const  g_single_segment_signature = 0x30304b50;
+
+
+/** \brief The signatures of the blocks which follow the entries.
+ *
+ * The entries are followed by the Central Directory, possibly preceded
+ * by an archive extra data record. An empty archive only has its End of
+ * Central Directory, possibly preceded by the Zip64 records.
+ */
+uint32_t const  g_end_signatures[] =
+{
+    0x02014b50,     // Central Directory entry
+    0x06054b50,     // End of Central Directory
+    0x06064b50,     // Zip64 End of Central Directory
+    0x07064b50,     // Zip64 End of Central Directory locator
+    0x08064b50,     // archive extra data record
+    0x05054b50,     // digital signature
+};
+
+
+} // no name namespace
+
+
+
+/** \class ZipStreamReader
+ * \brief Read a Zip archive sequentially.
+ *
+ * The ZipFile class reads the Central Directory found at the end of
+ * the archive first so it needs an input which supports seeking. The
+ * ZipStreamReader instead reads the local headers one after another
+ * from the start of the archive. It can therefore process an archive
+ * as it arrives through a pipe or a socket, starting with the first
+ * entry before the end of the archive was received.
+ *
+ * \code
+ *      zipios::ZipStreamReader reader(std::cin);
+ *      for(zipios::FileEntry::pointer_t entry(reader.getNextEntry());
+ *          entry != nullptr;
+ *          entry = reader.getNextEntry())
+ *      {
+ *          zipios::ZipStreamReader::stream_pointer_t is(reader.getInputStream());
+ *          ...read the data of entry from *is...
+ *      }
+ * \endcode
+ *
+ * The entries which have a trailing data descriptor, such as the ones
+ * saved by a ZipOutputStream writing to a pipe, are supported. The end
+ * of their data is found by the decompressor or, for STORED entries,
+ * by searching the data descriptor. Their sizes and CRC are only known
+ * once all of their data was read.
+ *
+ * The data of each entry is verified against its CRC-32 and size. The
+ * Central Directory is not read so the information only found there,
+ * such as the comments, is not available.
+ */
+
+
+/** \brief Initialize the reader.
+ *
+ * The reader starts reading \p is at its current position which is
+ * expected to be the start of a Zip archive. The reader does not
+ * take ownership of \p is which has to remain valid for as long as
+ * the reader exists.
+ *
+ * \param[in] is  The input stream to read the archive from.
+ * \param[in] policy  The I/O policy defining the size of the buffers.
+ */
+ZipStreamReader::ZipStreamReader(std::istream & is, IOPolicy const & policy)
+    : m_policy(policy)
+    , m_input(std::make_unique<PushbackStreambuf>(is.rdbuf(), policy.getInputBufferSize()))
+{
+}
+
+
+/** \brief Clean up the reader.
+ *
+ * The input stream of the current entry, if still referenced, cannot
+ * be used anymore once the reader is gone.
+ */
+ZipStreamReader::~ZipStreamReader()
+{
+}
+
+
+/** \brief Move to the next entry.
+ *
+ * This function skips whatever remains of the data of the current
+ * entry and reads the local header of the next entry. The data of
+ * that entry can then be read with the stream returned by
+ * getInputStream().
+ *
+ * When the local header of the entry has a trailing data descriptor,
+ * the sizes and CRC of the returned entry are updated once the end of
+ * its data was reached.
+ *
+ * \exception IOException
+ * This exception is raised if the input does not include a valid
+ * local header or the end of the entries, if the input ends early,
+ * or if the data of the current entry does not match its CRC-32 or
+ * size.
+ *
+ * \return The next entry or nullptr once all the entries were read.
+ */
+FileEntry::pointer_t ZipStreamReader::getNextEntry()
+{
+    closeEntry();
+    if(m_end)
+    {
+        return FileEntry::pointer_t();
+    }
+
+    std::istream is(m_input.get()); // istream does not destroy the streambuf.
+
+    uint32_t signature(0);
+    zipRead(is, signature);
+    if(m_input->getPosition() == sizeof(signature)
+    && (signature == g_split_signature || signature == g_single_segment_signature))
+    {
+        zipRead(is, signature);
+    }
+
+    for(auto const end_signature : g_end_signatures)
+    {
+        if(signature == end_signature)
+        {
+            m_end = true;
+            return FileEntry::pointer_t();
+        }
+    }
+    if(signature != g_local_header_signature)
+    {
+        throw IOException("ZipStreamReader::getNextEntry(): expected a local header signature but got some other data.");
+    }
+
+    // the stream reads the local header
+    //
+    char const header_signature[4] = { 'P', 'K', '\x03', '\x04' };
+    m_input->pushback(header_signature, sizeof(header_signature));
+    offset_t const position(m_input->getPosition());
+
+    m_stream = std::make_shared<ZipInputStream>(m_input.get(), m_policy);
+    m_entry = m_stream->getEntry().clone();
+    m_entry->setEntryOffset(position);
+
+    // once verified, the entry gets the sizes and CRC found in the
+    // data descriptor
+    //
+    FileEntry::pointer_t entry(m_entry);
+    ZipInputStream * stream(m_stream.get());
+    m_stream->verifyData([entry, stream]()
+        {
+            FileEntry const & local(stream->getEntry());
+            entry->setCrc(local.getCrc());
+            entry->setCompressedSize(local.getCompressedSize());
+            entry->setSize(local.getSize());
+        });
+
+    return m_entry;
+}
+
+
+/** \brief Retrieve the input stream of the current entry.
+ *
+ * This function returns the stream used to read the data of the entry
+ * last returned by getNextEntry(). The stream has to be read before
+ * getNextEntry() gets called again.
+ *
+ * \return The input stream of the current entry or nullptr if there is
+ *         no current entry.
+ */
+ZipStreamReader::stream_pointer_t ZipStreamReader::getInputStream() const
+{
+    return m_stream;
+}
+
+
+/** \brief Skip the rest of the current entry.
+ *
+ * This function reads whatever remains of the data of the current
+ * entry so the input is positioned on the next local header. It gets
+ * called by getNextEntry().
+ *
+ * \exception IOException
+ * This exception is raised if the data of the entry is not valid.
+ */
+void ZipStreamReader::closeEntry()
+{
+    if(m_stream == nullptr)
+    {
+        return;
+    }
+
+    std::shared_ptr<ZipInputStream> stream(m_stream);
+    m_stream.reset();
+    m_entry.reset();
+
+    // read through the streambuf so the errors are not hidden in the
+    // state of the istream
+    //
+    std::streambuf * buf(stream->rdbuf());
+    std::vector<char> data(m_policy.getInputBufferSize());
+    while(buf->sgetn(data.data(), data.size()) > 0)
+    {
+    }
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef ZIPIOS_ZLIBBACKEND_HPP
+#define ZIPIOS_ZLIBBACKEND_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief The zlib API used by the library.
+ *
+ * The library streams data through the zlib API. By default this is
+ * the classic zlib. When compiled with the ZIPIOS_ZLIB_NG CMake option,
+ * the native API of zlib-ng is used instead. The native API has the
+ * same functions with a "zng_" prefix so this header maps the zlib names
+ * used by the library to the zlib-ng names.
+ *
+ * Always include this header instead of \<zlib.h> in the library.
+ */
+
+#include "zipios/zipios-config.hpp"
+
+#ifdef ZIPIOS_ZLIB_NG
+
+#include <zlib-ng.h>
+
+#include <cstdint>
+
+typedef zng_stream          z_stream;
+typedef uint8_t             Bytef;
+typedef uint32_t            uInt;
+
+#define crc32               zng_crc32
+#define crc32_combine       zng_crc32_combine
+#define deflate             zng_deflate
+#define deflateBound        zng_deflateBound
+#define deflateEnd          zng_deflateEnd
+#define deflateInit2        zng_deflateInit2
+#define deflateParams       zng_deflateParams
+#define deflateReset        zng_deflateReset
+#define deflateSetDictionary zng_deflateSetDictionary
+#define inflate             zng_inflate
+#define inflateEnd          zng_inflateEnd
+#define inflateInit2        zng_inflateInit2
+#define inflatePrime        zng_inflatePrime
+#define inflateReset        zng_inflateReset
+#define inflateSetDictionary zng_inflateSetDictionary
+#define zError              zng_zError
+
+#else
+
+#include <zlib.h>
+
+#endif
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
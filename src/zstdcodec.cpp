@@ -0,0 +1,470 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Implementation of the Zstandard codec.
+ *
+ * The zstd library is loaded at runtime so the library does not
+ * depend on it. When it is not installed, entries compressed with
+ * zstd cannot be read or written but everything else works as usual.
+ */
+
+#include "zstdcodec.hpp"
+
+#include "zipios/zipiosexceptions.hpp"
+
+#include "dynamiclibrary.hpp"
+#include "zipios_common.hpp"
+
+
+namespace zipios
+{
+
+
+namespace
+{
+
+
+/** \brief The parts of the zstd API used by the codec.
+ *
+ * These declarations match the stable API found in zstd.h (version
+ * 1.4.0 and newer).
+ */
+struct ZSTD_CCtx;
+struct ZSTD_DCtx;
+
+struct ZSTD_inBuffer
+{
+    void const *    src;
+    size_t          size;
+    size_t          pos;
+};
+
+struct ZSTD_outBuffer
+{
+    void *          dst;
+    size_t          size;
+    size_t          pos;
+};
+
+int const   ZSTD_c_compressionLevel = 100;
+int const   ZSTD_e_continue = 0;
+int const   ZSTD_e_end = 2;
+
+
+/** \brief The level used by default.
+ *
+ * This is ZSTD_CLEVEL_DEFAULT.
+ */
+int const   g_default_level = 3;
+
+
+/** \brief The highest level used.
+ *
+ * The levels above 19 use a lot more memory to compress and to
+ * decompress so they are not used.
+ */
+int const   g_smallest_level = 19;
+
+
+/** \brief The zstd library functions.
+ *
+ * The library is loaded once, the first time the codec gets created.
+ * It is never unloaded.
+ */
+struct zstd_library_t
+{
+                zstd_library_t();
+
+    bool        isValid() const;
+
+    ZSTD_CCtx * (*m_createCCtx)() = nullptr;
+    size_t      (*m_freeCCtx)(ZSTD_CCtx *) = nullptr;
+    size_t      (*m_CCtx_setParameter)(ZSTD_CCtx *, int, int) = nullptr;
+    size_t      (*m_compressStream2)(ZSTD_CCtx *, ZSTD_outBuffer *, ZSTD_inBuffer *, int) = nullptr;
+    size_t      (*m_CStreamOutSize)() = nullptr;
+    ZSTD_DCtx * (*m_createDCtx)() = nullptr;
+    size_t      (*m_freeDCtx)(ZSTD_DCtx *) = nullptr;
+    size_t      (*m_decompressStream)(ZSTD_DCtx *, ZSTD_outBuffer *, ZSTD_inBuffer *) = nullptr;
+    unsigned    (*m_isError)(size_t) = nullptr;
+    char const *(*m_getErrorName)(size_t) = nullptr;
+};
+
+
+/** \brief Load the zstd library.
+ *
+ * This constructor searches for the zstd library and loads the
+ * functions used by the codec.
+ */
+zstd_library_t::zstd_library_t()
+{
+    DynamicLibrary const library({
+#ifdef ZIPIOS_WINDOWS
+            "libzstd.dll",
+            "zstd.dll",
+#elif defined(__APPLE__)
+            "libzstd.1.dylib",
+            "libzstd.dylib",
+#else
+            "libzstd.so.1",
+            "libzstd.so",
+#endif
+        });
+
+    library.load("ZSTD_createCCtx",         m_createCCtx);
+    library.load("ZSTD_freeCCtx",           m_freeCCtx);
+    library.load("ZSTD_CCtx_setParameter",  m_CCtx_setParameter);
+    library.load("ZSTD_compressStream2",    m_compressStream2);
+    library.load("ZSTD_CStreamOutSize",     m_CStreamOutSize);
+    library.load("ZSTD_createDCtx",         m_createDCtx);
+    library.load("ZSTD_freeDCtx",           m_freeDCtx);
+    library.load("ZSTD_decompressStream",   m_decompressStream);
+    library.load("ZSTD_isError",            m_isError);
+    library.load("ZSTD_getErrorName",       m_getErrorName);
+}
+
+
+/** \brief Check whether all the functions were found.
+ *
+ * \return true if the library was loaded and has all the functions.
+ */
+bool zstd_library_t::isValid() const
+{
+    return m_createCCtx != nullptr
+        && m_freeCCtx != nullptr
+        && m_CCtx_setParameter != nullptr
+        && m_compressStream2 != nullptr
+        && m_CStreamOutSize != nullptr
+        && m_createDCtx != nullptr
+        && m_freeDCtx != nullptr
+        && m_decompressStream != nullptr
+        && m_isError != nullptr
+        && m_getErrorName != nullptr;
+}
+
+
+/** \brief Retrieve the zstd library.
+ *
+ * \return The functions of the zstd library.
+ */
+zstd_library_t const & getLibrary()
+{
+    static zstd_library_t const library;
+    return library;
+}
+
+
+/** \brief Throw if a zstd function failed.
+ *
+ * \exception IOException
+ * This exception is raised if \p result is a zstd error code.
+ *
+ * \param[in] result  The value returned by a zstd function.
+ * \param[in] function  The name of the function to use in the error.
+ */
+void checkResult(size_t result, char const * function)
+{
+    zstd_library_t const & zstd(getLibrary());
+    if(zstd.m_isError(result) != 0)
+    {
+        OutputStringStream msgs;
+        msgs << function << ": zstd failed: " << zstd.m_getErrorName(result);
+        throw IOException(msgs.str());
+    }
+}
+
+
+class ZstdCompressor
+    : public Compressor
+{
+public:
+                            ZstdCompressor(int level);
+    virtual                 ~ZstdCompressor() override;
+
+    virtual void            compress(char const * data, size_t size, bool finish, std::vector<char> & output) override;
+
+private:
+    ZSTD_CCtx *             m_cctx = nullptr;
+};
+
+
+/** \brief Create a zstd compression context.
+ *
+ * \exception IOException
+ * This exception is raised if the context cannot be created.
+ *
+ * \param[in] level  The zstd compression level.
+ */
+ZstdCompressor::ZstdCompressor(int level)
+    : m_cctx(getLibrary().m_createCCtx())
+{
+    if(m_cctx == nullptr)
+    {
+        throw IOException("ZstdCompressor(): could not create a zstd compression context."); // LCOV_EXCL_LINE
+    }
+    checkResult(getLibrary().m_CCtx_setParameter(m_cctx, ZSTD_c_compressionLevel, level), "ZstdCompressor()");
+}
+
+
+/** \brief Free the compression context.
+ */
+ZstdCompressor::~ZstdCompressor()
+{
+    getLibrary().m_freeCCtx(m_cctx);
+}
+
+
+/** \brief Compress data with zstd.
+ *
+ * See Compressor::compress() for details.
+ *
+ * \param[in] data  The data to compress.
+ * \param[in] size  The number of bytes at \p data.
+ * \param[in] finish  Whether this is the last chunk of data.
+ * \param[in,out] output  The buffer where the compressed data gets appended.
+ */
+void ZstdCompressor::compress(char const * data, size_t size, bool finish, std::vector<char> & output)
+{
+    zstd_library_t const & zstd(getLibrary());
+    size_t const chunk(zstd.m_CStreamOutSize());
+
+    ZSTD_inBuffer in{ data, size, 0 };
+    for(;;)
+    {
+        size_t const used(output.size());
+        output.resize(used + chunk);
+        ZSTD_outBuffer out{ output.data() + used, chunk, 0 };
+        size_t const remaining(zstd.m_compressStream2(m_cctx, &out, &in, finish ? ZSTD_e_end : ZSTD_e_continue));
+        output.resize(used + out.pos);
+        checkResult(remaining, "ZstdCompressor::compress()");
+
+        if(finish ? remaining == 0 : in.pos >= in.size)
+        {
+            break;
+        }
+    }
+}
+
+
+class ZstdDecompressor
+    : public Decompressor
+{
+public:
+                            ZstdDecompressor();
+    virtual                 ~ZstdDecompressor() override;
+
+    virtual bool            decompress(char const * & input, size_t & input_size, char * & output, size_t & output_size) override;
+
+private:
+    ZSTD_DCtx *             m_dctx = nullptr;
+};
+
+
+/** \brief Create a zstd decompression context.
+ *
+ * \exception IOException
+ * This exception is raised if the context cannot be created.
+ */
+ZstdDecompressor::ZstdDecompressor()
+    : m_dctx(getLibrary().m_createDCtx())
+{
+    if(m_dctx == nullptr)
+    {
+        throw IOException("ZstdDecompressor(): could not create a zstd decompression context."); // LCOV_EXCL_LINE
+    }
+}
+
+
+/** \brief Free the decompression context.
+ */
+ZstdDecompressor::~ZstdDecompressor()
+{
+    getLibrary().m_freeDCtx(m_dctx);
+}
+
+
+/** \brief Decompress zstd data.
+ *
+ * See Decompressor::decompress() for details.
+ *
+ * \param[in,out] input  The compressed data.
+ * \param[in,out] input_size  The number of bytes available at \p input.
+ * \param[in,out] output  The buffer receiving the uncompressed data.
+ * \param[in,out] output_size  The number of bytes available at \p output.
+ *
+ * \return true once the end of the zstd frame was reached.
+ */
+bool ZstdDecompressor::decompress(char const * & input, size_t & input_size, char * & output, size_t & output_size)
+{
+    zstd_library_t const & zstd(getLibrary());
+    for(;;)
+    {
+        ZSTD_inBuffer in{ input, input_size, 0 };
+        ZSTD_outBuffer out{ output, output_size, 0 };
+        size_t const hint(zstd.m_decompressStream(m_dctx, &out, &in));
+        checkResult(hint, "ZstdDecompressor::decompress()");
+
+        input += in.pos;
+        input_size -= in.pos;
+        output += out.pos;
+        output_size -= out.pos;
+
+        if(hint == 0)
+        {
+            // the frame is complete and fully flushed
+            //
+            return true;
+        }
+        if(input_size == 0
+        || output_size == 0
+        || (in.pos == 0 && out.pos == 0))
+        {
+            return false;
+        }
+    }
+}
+
+
+class ZstdCodec
+    : public Codec
+{
+public:
+    virtual StorageMethod   getMethod() const override;
+    virtual std::string     getName() const override;
+    virtual uint16_t        getExtractVersion() const override;
+    virtual Compressor::pointer_t
+                            createCompressor(FileEntry::CompressionLevel level) const override;
+    virtual Decompressor::pointer_t
+                            createDecompressor() const override;
+};
+
+
+/** \brief The Zstandard method.
+ *
+ * \return StorageMethod::ZSTD.
+ */
+StorageMethod ZstdCodec::getMethod() const
+{
+    return StorageMethod::ZSTD;
+}
+
+
+/** \brief The name of the codec.
+ *
+ * \return "zstd".
+ */
+std::string ZstdCodec::getName() const
+{
+    return "zstd";
+}
+
+
+/** \brief The version needed to extract zstd entries.
+ *
+ * The zstd method was added in version 6.3.7 of the Zip specification.
+ *
+ * \return 63.
+ */
+uint16_t ZstdCodec::getExtractVersion() const
+{
+    return 63;
+}
+
+
+/** \brief Create a zstd compressor.
+ *
+ * The levels 1 to 100 of the FileEntry are mapped linearly to the
+ * zstd levels 1 to 19.
+ *
+ * \param[in] level  The compression level of the entry.
+ *
+ * \return A new compressor.
+ */
+Compressor::pointer_t ZstdCodec::createCompressor(FileEntry::CompressionLevel level) const
+{
+    int zlevel(g_default_level);
+    switch(level)
+    {
+    case FileEntry::COMPRESSION_LEVEL_DEFAULT:
+        break;
+
+    case FileEntry::COMPRESSION_LEVEL_SMALLEST:
+        zlevel = g_smallest_level;
+        break;
+
+    case FileEntry::COMPRESSION_LEVEL_FASTEST:
+        zlevel = 1;
+        break;
+
+    default:
+        if(level < FileEntry::COMPRESSION_LEVEL_MINIMUM
+        || level > FileEntry::COMPRESSION_LEVEL_MAXIMUM)
+        {
+            throw std::logic_error("the compression level must be defined between -3 and 100, see the zipios/fileentry.hpp for a list of valid levels."); // LCOV_EXCL_LINE
+        }
+        zlevel = (level - 1) * (g_smallest_level - 1) / 99 + 1;
+        break;
+
+    }
+
+    return std::make_unique<ZstdCompressor>(zlevel);
+}
+
+
+/** \brief Create a zstd decompressor.
+ *
+ * \return A new decompressor.
+ */
+Decompressor::pointer_t ZstdCodec::createDecompressor() const
+{
+    return std::make_unique<ZstdDecompressor>();
+}
+
+
+} // no name namespace
+
+
+/** \brief Create the Zstandard codec.
+ *
+ * This function loads the zstd library and creates the codec of
+ * StorageMethod::ZSTD.
+ *
+ * \return The codec or nullptr if the zstd library is not available.
+ */
+Codec::pointer_t createZstdCodec()
+{
+    if(!getLibrary().isValid())
+    {
+        return Codec::pointer_t(); // LCOV_EXCL_LINE
+    }
+    return std::make_shared<ZstdCodec>();
+}
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
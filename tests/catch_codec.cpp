@@ -0,0 +1,337 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc.,  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ *
+ * Zipios unit tests for the compression codec registry.
+ */
+
+#include "catch_main.hpp"
+
+#include <zipios/codec.hpp>
+#include <zipios/directorycollection.hpp>
+#include <zipios/directoryentry.hpp>
+#include <zipios/zipfile.hpp>
+#include <zipios/zipiosexceptions.hpp>
+
+#include <fstream>
+#include <map>
+
+#include <string.h>
+
+
+namespace
+{
+
+
+// a codec used to test the registry: the data is saved in chunks
+// preceded by their size and XOR'ed with 0x5A, a chunk of size 0
+// marks the end of the data
+//
+class test_xor_codec
+    : public zipios::Codec
+{
+public:
+    class compressor_t
+        : public zipios::Compressor
+    {
+    public:
+        virtual void compress(char const * data, size_t size, bool finish, std::vector<char> & output) override
+        {
+            if(size > 0)
+            {
+                writeChunk(data, size, output);
+            }
+            if(finish)
+            {
+                writeChunk(nullptr, 0, output);
+            }
+        }
+
+    private:
+        void writeChunk(char const * data, size_t size, std::vector<char> & output)
+        {
+            uint32_t const length(size);
+            output.insert(output.end(), reinterpret_cast<char const *>(&length), reinterpret_cast<char const *>(&length) + sizeof(length));
+            for(size_t idx(0); idx < size; ++idx)
+            {
+                output.push_back(data[idx] ^ 0x5A);
+            }
+        }
+    };
+
+    class decompressor_t
+        : public zipios::Decompressor
+    {
+    public:
+        virtual bool decompress(char const * & input, size_t & input_size, char * & output, size_t & output_size) override
+        {
+            while(input_size > 0)
+            {
+                if(f_header_size < sizeof(f_length))
+                {
+                    reinterpret_cast<char *>(&f_length)[f_header_size] = *input;
+                    ++f_header_size;
+                    ++input;
+                    --input_size;
+                    if(f_header_size == sizeof(f_length) && f_length == 0)
+                    {
+                        return true;
+                    }
+                    continue;
+                }
+                if(output_size == 0)
+                {
+                    break;
+                }
+                *output = *input ^ 0x5A;
+                ++output;
+                --output_size;
+                ++input;
+                --input_size;
+                --f_length;
+                if(f_length == 0)
+                {
+                    f_header_size = 0;
+                }
+            }
+            return false;
+        }
+
+    private:
+        uint32_t            f_length = 0;
+        size_t              f_header_size = 0;
+    };
+
+    virtual zipios::StorageMethod getMethod() const override
+    {
+        return zipios::StorageMethod::LZ77;
+    }
+
+    virtual std::string getName() const override
+    {
+        return "xor";
+    }
+
+    virtual uint16_t getExtractVersion() const override
+    {
+        return 45;
+    }
+
+    virtual zipios::Compressor::pointer_t createCompressor(zipios::FileEntry::CompressionLevel level) const override
+    {
+        static_cast<void>(level);
+        return std::make_unique<compressor_t>();
+    }
+
+    virtual zipios::Decompressor::pointer_t createDecompressor() const override
+    {
+        return std::make_unique<decompressor_t>();
+    }
+};
+
+
+} // no name namespace
+
+
+CATCH_TEST_CASE("compression codecs", "[ZipFile][Codec]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/codecs");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/tree/sub").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    std::map<std::string, std::string> files;
+    for(int i(0); i < 40000; ++i)
+    {
+        files["large.txt"] += "line " + std::to_string(rand() % 500) + " of the log\n";
+    }
+    for(int i(0); i < 3000; ++i)
+    {
+        files["sub/random.bin"] += static_cast<char>(rand());
+    }
+    files["small.txt"] = "a small file\n";
+    files["sub/empty.txt"] = std::string();
+    for(auto const & f : files)
+    {
+        std::ofstream os("tree/" + f.first, std::ios::out | std::ios::binary);
+        os << f.second;
+    }
+
+    auto save = [](std::string const & filename, zipios::StorageMethod method, size_t threads)
+    {
+        zipios::DirectoryCollection collection("tree");
+        collection.setMethod(0, method, method);
+        zipios::ZipFile::SaveOptions options;
+        options.setThreads(threads);
+        std::ofstream os(filename, std::ios::out | std::ios::binary);
+        zipios::ZipFile::saveCollectionToArchive(os, collection, "codecs", options);
+    };
+
+
+    auto check = [&files](std::string const & filename, zipios::StorageMethod method)
+    {
+        for(auto const access : { zipios::ZipFile::Access::STREAM, zipios::ZipFile::Access::POSITIONAL_READ, zipios::ZipFile::Access::MEMORY_MAP })
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setAccess(access);
+            options.setCRCVerification(zipios::ZipFile::CRCVerification::ALWAYS);
+            zipios::ZipFile zf(filename, options);
+            for(auto const & f : files)
+            {
+                std::string const name("tree/" + f.first);
+                zipios::FileEntry::pointer_t entry(zf.getEntry(name));
+                CATCH_REQUIRE(entry != nullptr);
+                CATCH_REQUIRE(entry->getMethod() == method);
+                CATCH_REQUIRE(entry->getSize() == f.second.length());
+
+                zipios::ZipFile::stream_pointer_t is(zf.getInputStream(name));
+                CATCH_REQUIRE(is != nullptr);
+                std::string const data(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{});
+                CATCH_REQUIRE(data == f.second);
+
+                zipios::FileEntry::buffer_t const buffer(zf.readEntry(name));
+                CATCH_REQUIRE(std::string(buffer.begin(), buffer.end()) == f.second);
+
+                // seek backward and forward
+                //
+                if(f.second.length() > 100)
+                {
+                    is->clear();
+                    is->seekg(10);
+                    CATCH_REQUIRE(is->tellg() == 10);
+                    char buf[20];
+                    is->read(buf, sizeof(buf));
+                    CATCH_REQUIRE(std::string(buf, sizeof(buf)) == f.second.substr(10, sizeof(buf)));
+                    is->seekg(-50, std::ios::end);
+                    is->read(buf, sizeof(buf));
+                    CATCH_REQUIRE(std::string(buf, sizeof(buf)) == f.second.substr(f.second.length() - 50, sizeof(buf)));
+                    is->seekg(5, std::ios::beg);
+                    is->read(buf, sizeof(buf));
+                    CATCH_REQUIRE(std::string(buf, sizeof(buf)) == f.second.substr(5, sizeof(buf)));
+                }
+            }
+        }
+    };
+
+    CATCH_START_SECTION("the registry")
+    {
+        CATCH_REQUIRE(zipios::Codec::getCodec(zipios::StorageMethod::BZIP2) == nullptr);
+        CATCH_REQUIRE_THROWS_AS(zipios::Codec::registerCodec(zipios::Codec::pointer_t()), zipios::InvalidException);
+
+        zipios::DirectoryEntry entry(zipios::FilePath("tree/small.txt"));
+        CATCH_REQUIRE_THROWS_AS(entry.setMethod(zipios::StorageMethod::LZ77), zipios::InvalidStateException);
+        zipios::Codec::registerCodec(std::make_shared<test_xor_codec>());
+        CATCH_REQUIRE(zipios::Codec::getCodec(zipios::StorageMethod::LZ77)->getName() == "xor");
+        entry.setMethod(zipios::StorageMethod::LZ77);
+        CATCH_REQUIRE(entry.getMethod() == zipios::StorageMethod::LZ77);
+
+        save("xor.zip", zipios::StorageMethod::LZ77, 1);
+        check("xor.zip", zipios::StorageMethod::LZ77);
+
+        zipios::Codec::unregisterCodec(zipios::StorageMethod::LZ77);
+        CATCH_REQUIRE(zipios::Codec::getCodec(zipios::StorageMethod::LZ77) == nullptr);
+        zipios::ZipFile zf("xor.zip");
+        CATCH_REQUIRE_THROWS_AS(zf.getInputStream("tree/small.txt"), zipios::FileCollectionException);
+        CATCH_REQUIRE_THROWS_AS(zf.readEntry("tree/small.txt"), zipios::FileCollectionException);
+        CATCH_REQUIRE_THROWS_AS(entry.setMethod(zipios::StorageMethod::LZ77), zipios::InvalidStateException);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("zstd entries")
+    {
+        zipios::Codec::pointer_t zstd(zipios::Codec::getCodec(zipios::StorageMethod::ZSTD));
+        if(zstd == nullptr)
+        {
+            // LCOV_EXCL_START
+            std::cerr << "warning: the zstd library is not available, zstd entries not tested." << std::endl;
+            return;
+            // LCOV_EXCL_STOP
+        }
+        CATCH_REQUIRE(zstd->getName() == "zstd");
+        CATCH_REQUIRE(zstd->getExtractVersion() == 63);
+
+        save("zstd.zip", zipios::StorageMethod::ZSTD, 1);
+        check("zstd.zip", zipios::StorageMethod::ZSTD);
+
+        // the output does not depend on the number of threads
+        //
+        std::string const expected(zipios_test::read_file("zstd.zip"));
+        save("zstd-threads.zip", zipios::StorageMethod::ZSTD, 4);
+        CATCH_REQUIRE(zipios_test::read_file("zstd-threads.zip") == expected);
+
+        // find the compressed data of large.txt
+        //
+        size_t const name(expected.find("tree/large.txt"));
+        CATCH_REQUIRE(name != std::string::npos);
+        size_t const header(name - 30);
+        uint16_t extra_len(0);
+        memcpy(&extra_len, expected.data() + header + 28, sizeof(extra_len));
+        uint16_t extract_version(0);
+        memcpy(&extract_version, expected.data() + header + 4, sizeof(extract_version));
+        CATCH_REQUIRE(extract_version == 63);
+        size_t const data(header + 30 + 14 + extra_len);
+        zipios::FileEntry::pointer_t entry(zipios::ZipFile("zstd.zip").getEntry("tree/large.txt"));
+        CATCH_REQUIRE(entry != nullptr);
+        CATCH_REQUIRE(entry->getCompressedSize() < files["large.txt"].length() / 3);
+
+        // the data is a standard zstd frame
+        //
+        if(system("zstd --version >/dev/null 2>&1") == 0)
+        {
+            {
+                std::ofstream os("large.zst", std::ios::out | std::ios::binary);
+                os << expected.substr(data, entry->getCompressedSize());
+            }
+            CATCH_REQUIRE(system("zstd -dqf large.zst -o large.out") == 0);
+            CATCH_REQUIRE(zipios_test::read_file("large.out") == files["large.txt"]);
+        }
+
+        // a broken entry
+        //
+        std::string broken(expected);
+        for(size_t idx(0); idx < 200; ++idx)
+        {
+            broken[data + 20 + idx] = static_cast<char>(0xFF);
+        }
+        {
+            std::ofstream os("broken.zip", std::ios::out | std::ios::binary);
+            os << broken;
+        }
+        zipios::ZipFile zf("broken.zip");
+        CATCH_REQUIRE_THROWS_AS(zf.readEntry("tree/large.txt"), zipios::IOException);
+        zipios::ZipFile::stream_pointer_t is(zf.getInputStream("tree/large.txt"));
+        is->exceptions(std::ios::badbit);
+        CATCH_REQUIRE_THROWS_AS(std::string(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{}), zipios::IOException);
+    }
+    CATCH_END_SECTION()
+}
+
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
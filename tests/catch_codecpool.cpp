@@ -0,0 +1,267 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc.,  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ *
+ * Zipios unit tests for the pool of zlib streams and buffers.
+ */
+
+#include "catch_main.hpp"
+
+#include <zipios/directoryentry.hpp>
+#include <zipios/zipfile.hpp>
+
+#include <src/codecpool.hpp>
+#include <src/zipcentraldirectoryentry.hpp>
+#include <src/zipoutputstream.hpp>
+
+#include <fstream>
+#include <thread>
+
+
+CATCH_TEST_CASE("codec_pool", "[CodecPool]")
+{
+    CATCH_START_SECTION("streams are reused")
+    {
+        zipios::CodecPool::clear();
+        CATCH_REQUIRE(zipios::CodecPool::availableInflateStreams() == 0);
+        CATCH_REQUIRE(zipios::CodecPool::availableDeflateStreams() == 0);
+        CATCH_REQUIRE(zipios::CodecPool::availableBuffers() == 0);
+
+        z_stream * inflate_stream(nullptr);
+        {
+            zipios::CodecPool::stream_pointer_t zs(zipios::CodecPool::getInflateStream());
+            inflate_stream = zs.get();
+            CATCH_REQUIRE(zipios::CodecPool::availableInflateStreams() == 0);
+        }
+        CATCH_REQUIRE(zipios::CodecPool::availableInflateStreams() == 1);
+        {
+            zipios::CodecPool::stream_pointer_t zs(zipios::CodecPool::getInflateStream());
+            CATCH_REQUIRE(zs.get() == inflate_stream);
+            CATCH_REQUIRE(zipios::CodecPool::availableInflateStreams() == 0);
+        }
+        CATCH_REQUIRE(zipios::CodecPool::availableInflateStreams() == 1);
+        CATCH_REQUIRE(zipios::CodecPool::availableDeflateStreams() == 0);
+
+        // the pool does not grow past its limit
+        //
+        {
+            std::vector<zipios::CodecPool::stream_pointer_t> streams;
+            for(size_t idx(0); idx < zipios::CodecPool::MAX_STREAMS + 5; ++idx)
+            {
+                streams.push_back(zipios::CodecPool::getInflateStream());
+            }
+            CATCH_REQUIRE(zipios::CodecPool::availableInflateStreams() == 0);
+        }
+        CATCH_REQUIRE(zipios::CodecPool::availableInflateStreams() == zipios::CodecPool::MAX_STREAMS);
+
+        zipios::CodecPool::clear();
+        CATCH_REQUIRE(zipios::CodecPool::availableInflateStreams() == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("reused deflate streams use the new level")
+    {
+        std::string data;
+        for(int i(0); i < 10000; ++i)
+        {
+            data += "some text " + std::to_string(rand() % 100) + "\n";
+        }
+
+        auto compress = [&data](z_stream * zs)
+        {
+            std::vector<Bytef> out(deflateBound(zs, data.size()));
+            zs->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+            zs->avail_in = data.size();
+            zs->next_out = out.data();
+            zs->avail_out = out.size();
+            CATCH_REQUIRE(deflate(zs, Z_FINISH) == Z_STREAM_END);
+            return std::string(reinterpret_cast<char *>(out.data()), out.size() - zs->avail_out);
+        };
+
+        std::string expected;
+        {
+            z_stream zs = z_stream();
+            CATCH_REQUIRE(deflateInit2(&zs, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+            expected = compress(&zs);
+            deflateEnd(&zs);
+        }
+
+        zipios::CodecPool::clear();
+        z_stream * deflate_stream(nullptr);
+        {
+            zipios::CodecPool::stream_pointer_t zs(zipios::CodecPool::getDeflateStream(Z_BEST_COMPRESSION));
+            deflate_stream = zs.get();
+            CATCH_REQUIRE(compress(zs.get()) != expected);
+        }
+        CATCH_REQUIRE(zipios::CodecPool::availableDeflateStreams() == 1);
+        {
+            zipios::CodecPool::stream_pointer_t zs(zipios::CodecPool::getDeflateStream(Z_BEST_SPEED));
+            CATCH_REQUIRE(zs.get() == deflate_stream);
+            CATCH_REQUIRE(compress(zs.get()) == expected);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("buffers are reused by size")
+    {
+        zipios::CodecPool::clear();
+
+        std::vector<char> buffer;
+        zipios::CodecPool::getBuffer(buffer, 100);
+        CATCH_REQUIRE(buffer.size() == 100);
+        char const * ptr(buffer.data());
+        zipios::CodecPool::releaseBuffer(buffer);
+        CATCH_REQUIRE(buffer.empty());
+        CATCH_REQUIRE(zipios::CodecPool::availableBuffers() == 1);
+
+        zipios::CodecPool::getBuffer(buffer, 200);
+        CATCH_REQUIRE(buffer.size() == 200);
+        CATCH_REQUIRE(zipios::CodecPool::availableBuffers() == 1);
+
+        std::vector<char> other;
+        zipios::CodecPool::getBuffer(other, 100);
+        CATCH_REQUIRE(other.size() == 100);
+        CATCH_REQUIRE(other.data() == ptr);
+        CATCH_REQUIRE(zipios::CodecPool::availableBuffers() == 0);
+
+        zipios::CodecPool::releaseBuffer(buffer);
+        zipios::CodecPool::releaseBuffer(other);
+        CATCH_REQUIRE(zipios::CodecPool::availableBuffers() == 2);
+
+        // too large for the pool
+        //
+        zipios::CodecPool::getBuffer(buffer, zipios::CodecPool::MAX_BUFFER_BYTES + 1);
+        zipios::CodecPool::releaseBuffer(buffer);
+        CATCH_REQUIRE(zipios::CodecPool::availableBuffers() == 2);
+
+        zipios::CodecPool::clear();
+        CATCH_REQUIRE(zipios::CodecPool::availableBuffers() == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("archive streams borrow from the pool")
+    {
+        std::string const filename(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/codec-pool.zip");
+
+        std::vector<std::string> contents;
+        for(int i(0); i < 20; ++i)
+        {
+            std::string content;
+            int const size(rand() % 3000 + 100);
+            for(int j(0); j < size; ++j)
+            {
+                content += static_cast<char>('a' + rand() % 4);
+            }
+            contents.push_back(content);
+        }
+
+        // one deflate stream is used for all the entries
+        //
+        zipios::CodecPool::clear();
+        {
+            std::ofstream os(filename, std::ios::out | std::ios::binary);
+            zipios::ZipOutputStream zos(os);
+            for(size_t i(0); i < contents.size(); ++i)
+            {
+                zipios::DirectoryEntry const source(zipios::FilePath("file" + std::to_string(i) + ".txt"));
+                zipios::FileEntry::pointer_t entry(std::make_shared<zipios::ZipCentralDirectoryEntry>(source));
+                entry->setUnixTime(time(nullptr));
+                entry->setMethod(zipios::StorageMethod::DEFLATED);
+                zos.putNextEntry(entry);
+                zos << contents[i];
+                CATCH_REQUIRE(zipios::CodecPool::availableDeflateStreams() == 0);
+            }
+            zos.closeEntry();
+            zos.finish();
+        }
+        CATCH_REQUIRE(zipios::CodecPool::availableDeflateStreams() == 1);
+        CATCH_REQUIRE(zipios::CodecPool::availableBuffers() == 2);
+
+        for(auto const access : { zipios::ZipFile::Access::STREAM, zipios::ZipFile::Access::POSITIONAL_READ, zipios::ZipFile::Access::MEMORY_MAP })
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setAccess(access);
+            zipios::ZipFile zf(filename, options);
+
+            zipios::CodecPool::clear();
+            for(int repeat(0); repeat < 3; ++repeat)
+            {
+                for(size_t i(0); i < contents.size(); ++i)
+                {
+                    zipios::ZipFile::stream_pointer_t is(zf.getInputStream("file" + std::to_string(i) + ".txt"));
+                    CATCH_REQUIRE(is != nullptr);
+                    std::string const data(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{});
+                    CATCH_REQUIRE(data == contents[i]);
+                }
+                CATCH_REQUIRE(zipios::CodecPool::availableInflateStreams() == 1);
+                CATCH_REQUIRE(zipios::CodecPool::availableBuffers() == 2);
+            }
+
+            // several threads at once
+            //
+            std::vector<std::thread> threads;
+            std::atomic<size_t> errors(0);
+            for(int t(0); t < 4; ++t)
+            {
+                threads.emplace_back([&zf, &contents, &errors]()
+                    {
+                        for(int repeat(0); repeat < 10; ++repeat)
+                        {
+                            for(size_t i(0); i < contents.size(); ++i)
+                            {
+                                zipios::ZipFile::stream_pointer_t is(zf.getInputStream("file" + std::to_string(i) + ".txt"));
+                                std::string const data(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{});
+                                if(data != contents[i])
+                                {
+                                    ++errors;
+                                }
+                                zipios::FileEntry::buffer_t const buffer(zf.readEntry("file" + std::to_string(i) + ".txt"));
+                                if(std::string(buffer.begin(), buffer.end()) != contents[i])
+                                {
+                                    ++errors;
+                                }
+                            }
+                        }
+                    });
+            }
+            for(auto & t : threads)
+            {
+                t.join();
+            }
+            CATCH_REQUIRE(errors == 0);
+            CATCH_REQUIRE(zipios::CodecPool::availableInflateStreams() >= 1);
+            CATCH_REQUIRE(zipios::CodecPool::availableInflateStreams() <= 8);  // 4 threads x (stream + readEntry())
+        }
+
+        unlink(filename.c_str());
+    }
+    CATCH_END_SECTION()
+}
+
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
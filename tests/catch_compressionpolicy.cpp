@@ -0,0 +1,299 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc.,  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ *
+ * Zipios unit tests for the CompressionPolicy class.
+ */
+
+#include "catch_main.hpp"
+
+#include <zipios/compressionpolicy.hpp>
+#include <zipios/directorycollection.hpp>
+#include <zipios/directoryentry.hpp>
+#include <zipios/zipfile.hpp>
+
+#include <fstream>
+#include <map>
+
+
+CATCH_TEST_CASE("compression policy", "[ZipFile][DirectoryCollection][CompressionPolicy]")
+{
+    CATCH_START_SECTION("glob patterns")
+    {
+        CATCH_REQUIRE(zipios::CompressionPolicy::matchPattern("*.jpg", "photo.jpg"));
+        CATCH_REQUIRE(zipios::CompressionPolicy::matchPattern("*.jpg", "images/photo.JPG"));
+        CATCH_REQUIRE(zipios::CompressionPolicy::matchPattern("*.jp?g", "a/b/photo.jpeg"));
+        CATCH_REQUIRE(zipios::CompressionPolicy::matchPattern("*", "a/b/c"));
+        CATCH_REQUIRE(zipios::CompressionPolicy::matchPattern("a*b*c", "aXXbYYbZc"));
+        CATCH_REQUIRE(zipios::CompressionPolicy::matchPattern("images/*", "images/a/photo.png"));
+        CATCH_REQUIRE_FALSE(zipios::CompressionPolicy::matchPattern("images/*", "other/images/photo.png"));
+        CATCH_REQUIRE_FALSE(zipios::CompressionPolicy::matchPattern("*.jpg", "photo.jpg.txt"));
+        CATCH_REQUIRE_FALSE(zipios::CompressionPolicy::matchPattern("?.txt", "ab.txt"));
+        CATCH_REQUIRE_FALSE(zipios::CompressionPolicy::matchPattern("a*b*c", "aXXbYYbZ"));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("entropy and signatures")
+    {
+        CATCH_REQUIRE(zipios::CompressionPolicy::entropy(nullptr, 0) == Approx(0.0));
+        std::string const same(1000, 'a');
+        CATCH_REQUIRE(zipios::CompressionPolicy::entropy(same.data(), same.size()) == Approx(0.0));
+        std::string all;
+        for(int i(0); i < 256 * 4; ++i)
+        {
+            all += static_cast<char>(i);
+        }
+        CATCH_REQUIRE(zipios::CompressionPolicy::entropy(all.data(), all.size()) == Approx(8.0));
+        std::string const text("the quick brown fox jumps over the lazy dog and keeps running");
+        CATCH_REQUIRE(zipios::CompressionPolicy::entropy(text.data(), text.size()) < 5.0);
+
+        CATCH_REQUIRE(zipios::CompressionPolicy::isCompressedFormat("\xFF\xD8\xFF\xE0", 4));
+        CATCH_REQUIRE(zipios::CompressionPolicy::isCompressedFormat("\x89PNG\r\n\x1A\n....", 12));
+        CATCH_REQUIRE(zipios::CompressionPolicy::isCompressedFormat("\x1F\x8B\x08", 3));
+        CATCH_REQUIRE(zipios::CompressionPolicy::isCompressedFormat("RIFF\x10\x00\x00\x00WEBPVP8 ", 16));
+        CATCH_REQUIRE_FALSE(zipios::CompressionPolicy::isCompressedFormat("RIFF", 4));
+        CATCH_REQUIRE_FALSE(zipios::CompressionPolicy::isCompressedFormat("\x89PN", 3));
+        CATCH_REQUIRE_FALSE(zipios::CompressionPolicy::isCompressedFormat(text.data(), text.size()));
+        CATCH_REQUIRE_FALSE(zipios::CompressionPolicy::isCompressedFormat(nullptr, 0));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("policy accessors")
+    {
+        zipios::FileEntry::CompressionLevel const default_level(zipios::FileEntry::COMPRESSION_LEVEL_DEFAULT);
+        zipios::FileEntry::CompressionLevel const none_level(zipios::FileEntry::COMPRESSION_LEVEL_NONE);
+        zipios::FileEntry::CompressionLevel const smallest_level(zipios::FileEntry::COMPRESSION_LEVEL_SMALLEST);
+
+        zipios::CompressionPolicy policy;
+        CATCH_REQUIRE(policy.getMethod() == zipios::StorageMethod::DEFLATED);
+        CATCH_REQUIRE(policy.getLevel() == default_level);
+        CATCH_REQUIRE(policy.getStoreLimit() == 0);
+        CATCH_REQUIRE(policy.getSampleSize() == 4096);
+        CATCH_REQUIRE(policy.getEntropyThreshold() == Approx(7.5));
+        CATCH_REQUIRE(policy.getDetectFormats());
+        CATCH_REQUIRE(policy.getStoreFallback());
+
+        policy.setCompression(zipios::StorageMethod::STORED, zipios::FileEntry::COMPRESSION_LEVEL_SMALLEST);
+        CATCH_REQUIRE(policy.getMethod() == zipios::StorageMethod::STORED);
+        CATCH_REQUIRE(policy.getLevel() == none_level);
+        policy.setCompression(zipios::StorageMethod::DEFLATED, zipios::FileEntry::COMPRESSION_LEVEL_SMALLEST);
+        CATCH_REQUIRE(policy.getLevel() == smallest_level);
+        policy.setStoreLimit(100);
+        CATCH_REQUIRE(policy.getStoreLimit() == 100);
+        policy.setSampleSize(64);
+        CATCH_REQUIRE(policy.getSampleSize() == 64);
+        policy.setEntropyThreshold(9.0);
+        CATCH_REQUIRE(policy.getEntropyThreshold() == Approx(9.0));
+        policy.setDetectFormats(false);
+        CATCH_REQUIRE_FALSE(policy.getDetectFormats());
+        policy.setStoreFallback(false);
+        CATCH_REQUIRE_FALSE(policy.getStoreFallback());
+
+        zipios::ZipFile::SaveOptions options;
+        CATCH_REQUIRE(options.getCompressionPolicy() == nullptr);
+        zipios::CompressionPolicy::pointer_t p(std::make_shared<zipios::CompressionPolicy>());
+        options.setCompressionPolicy(p);
+        CATCH_REQUIRE(options.getCompressionPolicy() == p);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("apply() decisions")
+    {
+        zipios::CompressionPolicy policy;
+        policy.setStoreLimit(10);
+        policy.addRule("*.raw", zipios::StorageMethod::STORED, zipios::FileEntry::COMPRESSION_LEVEL_SMALLEST);
+        policy.addRule("*.gz", zipios::StorageMethod::DEFLATED, zipios::FileEntry::COMPRESSION_LEVEL_FASTEST);
+
+        std::string const text("Zip archives are composed of local headers and data.");
+        auto decide = [&policy](
+                      std::string const & name
+                    , size_t size
+                    , std::string const & sample
+                    , zipios::StorageMethod method
+                    , zipios::FileEntry::CompressionLevel level)
+        {
+            zipios::FilePath const path(name);
+            zipios::DirectoryEntry entry(path);
+            entry.setSize(size);
+            policy.apply(entry, sample.data(), sample.size());
+            return entry.getMethod() == method && entry.getLevel() == level;
+        };
+
+        // rules come first, even for small or compressed data
+        //
+        CATCH_REQUIRE(decide("a/b.raw", 1000, text, zipios::StorageMethod::STORED, zipios::FileEntry::COMPRESSION_LEVEL_NONE));
+        CATCH_REQUIRE(decide("b.gz", 5, "\x1F\x8B\x08", zipios::StorageMethod::DEFLATED, zipios::FileEntry::COMPRESSION_LEVEL_FASTEST));
+
+        // then the store limit, signatures, and entropy
+        //
+        CATCH_REQUIRE(decide("small.txt", 10, text, zipios::StorageMethod::STORED, zipios::FileEntry::COMPRESSION_LEVEL_NONE));
+        CATCH_REQUIRE(decide("photo.bin", 1000, "\xFF\xD8\xFF\xE0", zipios::StorageMethod::STORED, zipios::FileEntry::COMPRESSION_LEVEL_NONE));
+        std::string random;
+        for(int i(0); i < 4096; ++i)
+        {
+            random += static_cast<char>(rand());
+        }
+        CATCH_REQUIRE(decide("random.bin", 4096, random, zipios::StorageMethod::STORED, zipios::FileEntry::COMPRESSION_LEVEL_NONE));
+        CATCH_REQUIRE(decide("text.txt", 1000, text, zipios::StorageMethod::DEFLATED, zipios::FileEntry::COMPRESSION_LEVEL_DEFAULT));
+
+        policy.setDetectFormats(false);
+        policy.setEntropyThreshold(9.0);
+        CATCH_REQUIRE(decide("photo.bin", 1000, "\xFF\xD8\xFF\xE0", zipios::StorageMethod::DEFLATED, zipios::FileEntry::COMPRESSION_LEVEL_DEFAULT));
+        CATCH_REQUIRE(decide("random.bin", 4096, random, zipios::StorageMethod::DEFLATED, zipios::FileEntry::COMPRESSION_LEVEL_DEFAULT));
+
+        policy.clearRules();
+        CATCH_REQUIRE(decide("a/b.raw", 1000, text, zipios::StorageMethod::DEFLATED, zipios::FileEntry::COMPRESSION_LEVEL_DEFAULT));
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("saving with a policy")
+    {
+        std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/compression-policy");
+
+        zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+        CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/tree/img " + top_dir + "/tree/doc").c_str()) == 0);
+        zipios_test::safe_chdir cwd(top_dir);
+
+
+        std::string text;
+        for(int i(0); i < 2000; ++i)
+        {
+            text += "line " + std::to_string(i) + " of some very compressible text\n";
+        }
+        std::string random;
+        for(int i(0); i < 30000; ++i)
+        {
+            random += static_cast<char>(rand());
+        }
+        zipios_test::write_file("tree/doc/a.txt", text);
+        zipios_test::write_file("tree/doc/keep.log", text);
+        zipios_test::write_file("tree/doc/empty.txt", "");
+        zipios_test::write_file("tree/img/photo.jpg", "\xFF\xD8\xFF\xE0" + text);
+        zipios_test::write_file("tree/img/noise.bin", random);
+        zipios_test::write_file("tree/img/noise.dat", random);
+
+        zipios::CompressionPolicy::pointer_t policy(std::make_shared<zipios::CompressionPolicy>());
+        policy->addRule("*.log", zipios::StorageMethod::STORED);
+
+        // with a high threshold the random data gets deflated and the
+        // store fallback has to save it as STORED
+        //
+        policy->addRule("*.dat", zipios::StorageMethod::DEFLATED);
+
+        auto save = [](std::string const & filename, zipios::ZipFile::SaveOptions const & options)
+        {
+            zipios::DirectoryCollection collection("tree");
+            std::ofstream os(filename, std::ios::out | std::ios::binary);
+            zipios::ZipFile::saveCollectionToArchive(os, collection, "policy", options);
+        };
+
+        zipios::ZipFile::SaveOptions options;
+        options.setCompressionPolicy(policy);
+        save("policy.zip", options);
+        std::string const expected(zipios_test::read_file("policy.zip"));
+        CATCH_REQUIRE(system("unzip -tq policy.zip >/dev/null") == 0);
+
+        std::map<std::string, zipios::StorageMethod> const methods =
+        {
+            { "tree/doc/a.txt",         zipios::StorageMethod::DEFLATED },
+            { "tree/doc/keep.log",      zipios::StorageMethod::STORED },
+            { "tree/doc/empty.txt",     zipios::StorageMethod::STORED },
+            { "tree/img/photo.jpg",     zipios::StorageMethod::STORED },
+            { "tree/img/noise.bin",     zipios::StorageMethod::STORED },
+            { "tree/img/noise.dat",     zipios::StorageMethod::STORED },
+        };
+        {
+            zipios::ZipFile zf("policy.zip");
+            for(auto const & m : methods)
+            {
+                zipios::FileEntry::pointer_t entry(zf.getEntry(m.first));
+                CATCH_REQUIRE(entry != nullptr);
+                CATCH_REQUIRE(entry->getMethod() == m.second);
+                zipios::FileEntry::buffer_t const data(zf.readEntry(m.first));
+                CATCH_REQUIRE(std::string(data.begin(), data.end()) == zipios_test::read_file(m.first));
+            }
+        }
+
+        // the output does not depend on the number of threads
+        //
+        for(size_t const threads : { 2, 4 })
+        {
+            options.setThreads(threads);
+            save("parallel.zip", options);
+            CATCH_REQUIRE(zipios_test::read_file("parallel.zip") == expected);
+        }
+
+        // without the fallback the random data remains DEFLATED and
+        // larger than the original
+        //
+        policy->setStoreFallback(false);
+        for(size_t const threads : { 1, 3 })
+        {
+            options.setThreads(threads);
+            save("no-fallback.zip", options);
+            CATCH_REQUIRE(system("unzip -tq no-fallback.zip >/dev/null") == 0);
+            zipios::ZipFile zf("no-fallback.zip");
+            zipios::FileEntry::pointer_t entry(zf.getEntry("tree/img/noise.dat"));
+            CATCH_REQUIRE(entry != nullptr);
+            CATCH_REQUIRE(entry->getMethod() == zipios::StorageMethod::DEFLATED);
+            CATCH_REQUIRE(entry->getCompressedSize() >= entry->getSize());
+            zipios::FileEntry::buffer_t const data(zf.readEntry("tree/img/noise.dat"));
+            CATCH_REQUIRE(std::string(data.begin(), data.end()) == random);
+        }
+
+        // the policy does not change the entries of the saved collection
+        //
+        zipios::CompressionPolicy::pointer_t store(std::make_shared<zipios::CompressionPolicy>());
+        store->addRule("*", zipios::StorageMethod::STORED);
+        zipios::ZipFile::SaveOptions store_options;
+        store_options.setCompressionPolicy(store);
+        for(size_t const threads : { 1, 3 })
+        {
+            store_options.setThreads(threads);
+            zipios::ZipFile source("no-fallback.zip");
+            {
+                std::ofstream os("stored.zip", std::ios::out | std::ios::binary);
+                zipios::ZipFile::saveCollectionToArchive(os, source, "stored", store_options);
+            }
+            CATCH_REQUIRE(source.getEntry("tree/doc/a.txt")->getMethod() == zipios::StorageMethod::DEFLATED);
+            CATCH_REQUIRE(source.getEntry("tree/img/noise.dat")->getMethod() == zipios::StorageMethod::DEFLATED);
+
+            zipios::ZipFile zf("stored.zip");
+            zipios::FileEntry::pointer_t entry(zf.getEntry("tree/doc/a.txt"));
+            CATCH_REQUIRE(entry != nullptr);
+            CATCH_REQUIRE(entry->getMethod() == zipios::StorageMethod::STORED);
+            zipios::FileEntry::buffer_t const data(zf.readEntry("tree/doc/a.txt"));
+            CATCH_REQUIRE(std::string(data.begin(), data.end()) == text);
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
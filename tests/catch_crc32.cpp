@@ -0,0 +1,117 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc.,  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ *
+ * Zipios unit tests for the CRC-32 functions.
+ */
+
+#include "catch_main.hpp"
+
+#include <src/crc32.hpp>
+
+#include <cstring>
+
+#include <zlib.h>
+
+
+CATCH_TEST_CASE("crc32", "[crc32]")
+{
+    CATCH_START_SECTION("crc32 of known values")
+    {
+        std::string const name(zipios::getCRC32Implementation());
+        CATCH_REQUIRE((name == "pclmul" || name == "slice-by-16"));
+
+        CATCH_REQUIRE(zipios::updateCRC32(0, nullptr, 0) == 0);
+        CATCH_REQUIRE(zipios::updateCRC32(123, nullptr, 10) == 123);
+        CATCH_REQUIRE(zipios::updateCRC32(0, "", 0) == 0);
+        CATCH_REQUIRE(zipios::updateCRC32(0, "123456789", 9) == 0xCBF43926);
+        CATCH_REQUIRE(zipios::updateCRC32Portable(0, "123456789", 9) == 0xCBF43926);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("crc32 matches zlib for all sizes and alignments")
+    {
+        std::vector<unsigned char> data(64 * 1024 + 32);
+        for(auto & c : data)
+        {
+            c = static_cast<unsigned char>(rand());
+        }
+
+        for(size_t size(0); size < 2048; ++size)
+        {
+            size_t const offset(rand() % 16);
+            uint32_t const expected(crc32(0, data.data() + offset, size));
+            CATCH_REQUIRE(zipios::updateCRC32(0, data.data() + offset, size) == expected);
+            CATCH_REQUIRE(zipios::updateCRC32Portable(0, data.data() + offset, size) == expected);
+        }
+
+        uint32_t const expected(crc32(0, data.data() + 3, data.size() - 3));
+        CATCH_REQUIRE(zipios::updateCRC32(0, data.data() + 3, data.size() - 3) == expected);
+        CATCH_REQUIRE(zipios::updateCRC32Portable(0, data.data() + 3, data.size() - 3) == expected);
+
+        // computed in several calls
+        //
+        uint32_t crc(0);
+        for(size_t pos(3); pos < data.size(); )
+        {
+            size_t const size(std::min(static_cast<size_t>(rand() % 5000), data.size() - pos));
+            crc = zipios::updateCRC32(crc, data.data() + pos, size);
+            pos += size;
+        }
+        CATCH_REQUIRE(crc == expected);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("combine crc32")
+    {
+        std::vector<unsigned char> data(100 * 1024);
+        for(auto & c : data)
+        {
+            c = static_cast<unsigned char>(rand());
+        }
+        uint32_t const expected(zipios::updateCRC32(0, data.data(), data.size()));
+
+        for(int i(0); i < 100; ++i)
+        {
+            size_t const split(i == 0 ? 0 : i == 1 ? data.size() : rand() % data.size());
+            uint32_t const crc1(zipios::updateCRC32(0, data.data(), split));
+            uint32_t const crc2(zipios::updateCRC32(0, data.data() + split, data.size() - split));
+            CATCH_REQUIRE(zipios::combineCRC32(crc1, crc2, data.size() - split) == expected);
+            CATCH_REQUIRE(zipios::combineCRC32(crc1, crc2, data.size() - split) == crc32_combine(crc1, crc2, data.size() - split));
+        }
+
+        // very large sizes
+        //
+        zipios::offset_t const large(0x123456789LL);
+        CATCH_REQUIRE(zipios::combineCRC32(0x12345678, 0x9ABCDEF0, large) == crc32_combine64(0x12345678, 0x9ABCDEF0, large));
+    }
+    CATCH_END_SECTION()
+}
+
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
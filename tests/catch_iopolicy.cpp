@@ -0,0 +1,210 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc.,  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ *
+ * Zipios unit tests for the IOPolicy buffer sizes.
+ */
+
+#include "catch_main.hpp"
+
+#include <zipios/directorycollection.hpp>
+#include <zipios/iopolicy.hpp>
+#include <zipios/zipfile.hpp>
+
+#include <src/gzipoutputstream.hpp>
+
+#include <fstream>
+
+
+CATCH_TEST_CASE("I/O policy buffer sizes", "[ZipFile][DirectoryCollection][IOPolicy]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/io-policy");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/tree").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    std::string large;
+    for(int i(0); i < 20000; ++i)
+    {
+        large += "record " + std::to_string(rand() % 1000) + "\n";
+    }
+    for(int i(0); i < 50000; ++i)
+    {
+        large += static_cast<char>(rand());
+    }
+    {
+        std::ofstream os("tree/large.bin", std::ios::out | std::ios::binary);
+        os << large;
+        std::ofstream os_small("tree/small.txt", std::ios::out | std::ios::binary);
+        os_small << "small file\n";
+    }
+
+
+    // count the writes to the output
+    //
+    class counting_streambuf
+        : public std::stringbuf
+    {
+    public:
+        size_t      m_writes = 0;
+
+    protected:
+        virtual std::streamsize xsputn(char const * s, std::streamsize count) override
+        {
+            ++m_writes;
+            return std::stringbuf::xsputn(s, count);
+        }
+    };
+
+    auto save = [](std::ostream & os, zipios::StorageMethod method, zipios::IOPolicy const & policy)
+    {
+        zipios::DirectoryCollection collection("tree");
+        collection.setMethod(1000, zipios::StorageMethod::STORED, method);
+        zipios::ZipFile::SaveOptions options;
+        options.setIOPolicy(policy);
+        CATCH_REQUIRE(options.getIOPolicy().getOutputBufferSize() == policy.getOutputBufferSize());
+        zipios::ZipFile::saveCollectionToArchive(os, collection, "policy", options);
+    };
+
+    CATCH_START_SECTION("policy defaults and limits")
+    {
+        zipios::IOPolicy policy;
+        CATCH_REQUIRE(policy.getInputBufferSize() == zipios::getBufferSize());
+        CATCH_REQUIRE(policy.getOutputBufferSize() == zipios::getBufferSize());
+        CATCH_REQUIRE(policy.getReadAhead() == 0);
+
+        policy.setInputBufferSize(0);
+        CATCH_REQUIRE(policy.getInputBufferSize() == 1);
+        policy.setOutputBufferSize(0);
+        CATCH_REQUIRE(policy.getOutputBufferSize() == 1);
+        policy.setInputBufferSize(1024 * 1024);
+        CATCH_REQUIRE(policy.getInputBufferSize() == 1024 * 1024);
+        policy.setOutputBufferSize(65536);
+        CATCH_REQUIRE(policy.getOutputBufferSize() == 65536);
+        policy.setReadAhead(4 * 1024 * 1024);
+        CATCH_REQUIRE(policy.getReadAhead() == 4 * 1024 * 1024);
+
+        zipios::ZipFile::OpenOptions options;
+        CATCH_REQUIRE(options.getIOPolicy().getInputBufferSize() == zipios::getBufferSize());
+        options.setIOPolicy(policy);
+        CATCH_REQUIRE(options.getIOPolicy().getInputBufferSize() == 1024 * 1024);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("the output does not depend on the buffer size")
+    {
+        for(auto const method : { zipios::StorageMethod::STORED, zipios::StorageMethod::DEFLATED })
+        {
+            std::ostringstream expected(std::ios::out | std::ios::binary);
+            save(expected, method, zipios::IOPolicy());
+
+            for(size_t const size : { 1, 100, 65536, 1024 * 1024 })
+            {
+                zipios::IOPolicy policy;
+                policy.setOutputBufferSize(size);
+                std::ostringstream os(std::ios::out | std::ios::binary);
+                save(os, method, policy);
+                CATCH_REQUIRE(os.str() == expected.str());
+            }
+        }
+
+        // larger buffers mean fewer writes
+        //
+        counting_streambuf small_buffers;
+        std::ostream small_os(&small_buffers);
+        save(small_os, zipios::StorageMethod::STORED, zipios::IOPolicy());
+
+        zipios::IOPolicy policy;
+        policy.setOutputBufferSize(1024 * 1024);
+        counting_streambuf large_buffers;
+        std::ostream large_os(&large_buffers);
+        save(large_os, zipios::StorageMethod::STORED, policy);
+
+        CATCH_REQUIRE(large_buffers.str() == small_buffers.str());
+        CATCH_REQUIRE(large_buffers.m_writes < small_buffers.m_writes);
+
+        // gzip streams too
+        //
+        std::ostringstream gz_default(std::ios::out | std::ios::binary);
+        std::ostringstream gz_policy(std::ios::out | std::ios::binary);
+        {
+            zipios::GZIPOutputStream gz(gz_default, zipios::FileEntry::COMPRESSION_LEVEL_DEFAULT);
+            gz << large;
+            gz.finish();
+        }
+        {
+            zipios::IOPolicy gz_io;
+            gz_io.setOutputBufferSize(3);
+            zipios::GZIPOutputStream gz(gz_policy, zipios::FileEntry::COMPRESSION_LEVEL_DEFAULT, gz_io);
+            gz << large;
+            gz.finish();
+        }
+        CATCH_REQUIRE(gz_policy.str() == gz_default.str());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("entries read with any buffer size")
+    {
+        for(auto const method : { zipios::StorageMethod::STORED, zipios::StorageMethod::DEFLATED })
+        {
+            {
+                std::ofstream os("policy.zip", std::ios::out | std::ios::binary);
+                save(os, method, zipios::IOPolicy());
+            }
+
+            for(auto const access : { zipios::ZipFile::Access::STREAM, zipios::ZipFile::Access::POSITIONAL_READ, zipios::ZipFile::Access::MEMORY_MAP })
+            for(size_t const size : { 1, 7, 65536, 1024 * 1024 })
+            for(size_t const read_ahead : { 0, 100000 })
+            {
+                zipios::IOPolicy policy;
+                policy.setInputBufferSize(size);
+                policy.setReadAhead(read_ahead);
+                zipios::ZipFile::OpenOptions options;
+                options.setAccess(access);
+                options.setIOPolicy(policy);
+                zipios::ZipFile zf("policy.zip", options);
+
+                zipios::ZipFile::stream_pointer_t is(zf.getInputStream("tree/large.bin"));
+                CATCH_REQUIRE(is != nullptr);
+                std::string const data(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{});
+                CATCH_REQUIRE(data == large);
+
+                is = zf.getInputStream("tree/small.txt");
+                CATCH_REQUIRE(is != nullptr);
+                std::string const small(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{});
+                CATCH_REQUIRE(small == zipios_test::read_file("tree/small.txt"));
+            }
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
@@ -33,6 +33,91 @@
 
 #include "catch_main.hpp"
 
+#include <filesystem>
+#include <fstream>
+
+
+
+namespace zipios_test
+{
+
+
+/** \brief Read a whole file in a string.
+ *
+ * \param[in] filename  The name of the file to read.
+ *
+ * \return The content of the file or an empty string if it cannot be read.
+ */
+std::string read_file(std::string const & filename)
+{
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+
+/** \brief Create or overwrite a file with the specified data.
+ *
+ * \param[in] filename  The name of the file to write.
+ * \param[in] data  The content of the file.
+ */
+void write_file(std::string const & filename, std::string const & data)
+{
+    std::ofstream out(filename, std::ios::out | std::ios::binary);
+    out << data;
+}
+
+
+/** \brief Generate random data.
+ *
+ * When \p letters is 0, the data is made of any bytes. Otherwise it
+ * is made of the first \p letters lowercase letters which makes it
+ * more or less compressible.
+ *
+ * \param[in] size  The number of bytes to generate.
+ * \param[in] letters  The number of letters to use or 0.
+ *
+ * \return The random data.
+ */
+std::string random_data(size_t size, int letters)
+{
+    std::string result;
+    result.reserve(size);
+    for(size_t idx(0); idx < size; ++idx)
+    {
+        result += static_cast<char>(letters == 0 ? rand() : 'a' + rand() % letters);
+    }
+    return result;
+}
+
+
+/** \brief Create a tree of files.
+ *
+ * This function creates the \p dirs directories and \p count files
+ * named "f<idx>.txt" spread over them in turn. The \p content callback
+ * returns the data of each file.
+ *
+ * \param[in] dirs  The directories receiving the files.
+ * \param[in] count  The number of files to create.
+ * \param[in] content  The callback returning the data of file \p idx.
+ */
+void create_tree(
+          std::vector<std::string> const & dirs
+        , int count
+        , std::function<std::string(int idx)> const & content)
+{
+    for(auto const & d : dirs)
+    {
+        std::filesystem::create_directories(d);
+    }
+    for(int idx(0); idx < count; ++idx)
+    {
+        write_file(dirs[idx % dirs.size()] + "/f" + std::to_string(idx) + ".txt", content(idx));
+    }
+}
+
+
+} // zipios_test namespace
+
 
 
 int main(int argc, char *argv[])
@@ -34,8 +34,10 @@
 
 #include <catch2/snapcatch2.hpp>
 
+#include <functional>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 #include <limits.h>
 
@@ -144,6 +146,15 @@ private:
 };
 
 
+std::string read_file(std::string const & filename);
+void write_file(std::string const & filename, std::string const & data);
+std::string random_data(size_t size, int letters = 0);
+void create_tree(
+          std::vector<std::string> const & dirs
+        , int count
+        , std::function<std::string(int idx)> const & content);
+
+
 } // zipios_test namespace
 
 // Local Variables:
@@ -0,0 +1,190 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc.,  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ *
+ * Zipios unit tests for the parallel block deflate of large entries.
+ */
+
+#include "catch_main.hpp"
+
+#include <zipios/directorycollection.hpp>
+#include <zipios/zipfile.hpp>
+
+#include <src/gzipoutputstream.hpp>
+
+#include <fstream>
+
+#include <string.h>
+#include <zlib.h>
+
+
+CATCH_TEST_CASE("parallel block deflate", "[ZipFile][DirectoryCollection][GZIP]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/block-deflate");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/tree").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    // text which compresses well, so back references across blocks
+    // matter, followed by binary data
+    //
+    std::string large;
+    for(int i(0); i < 60000; ++i)
+    {
+        large += "line " + std::to_string(rand() % 500) + " of the log\n";
+    }
+    for(int i(0); i < 100000; ++i)
+    {
+        large += static_cast<char>(rand());
+    }
+    std::string const small("a small gzip file which fits in one block\n");
+
+    auto gzip = [](std::string const & data, size_t block_size, size_t threads)
+    {
+        std::ostringstream os(std::ios::out | std::ios::binary);
+        {
+            zipios::GZIPOutputStream gz(os, zipios::FileEntry::COMPRESSION_LEVEL_DEFAULT);
+            gz.setBlockSize(block_size, threads);
+            gz.write(data.data(), data.size());
+            gz.finish();
+        }
+        return os.str();
+    };
+
+    auto gunzip = [](std::string const & data)
+    {
+        z_stream zs = z_stream();
+        CATCH_REQUIRE(inflateInit2(&zs, 16 + MAX_WBITS) == Z_OK);
+        std::string result;
+        std::vector<char> buffer(65536);
+        zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+        zs.avail_in = data.size();
+        int err(Z_OK);
+        while(err == Z_OK)
+        {
+            zs.next_out = reinterpret_cast<Bytef *>(buffer.data());
+            zs.avail_out = buffer.size();
+            err = inflate(&zs, Z_NO_FLUSH);
+            result.append(buffer.data(), buffer.size() - zs.avail_out);
+        }
+        CATCH_REQUIRE(err == Z_STREAM_END);
+        CATCH_REQUIRE(zs.avail_in == 0);
+        inflateEnd(&zs);
+        return result;
+    };
+
+    CATCH_START_SECTION("gzip streams compressed in blocks")
+    {
+        std::string const serial(gzip(large, 0, 1));
+        CATCH_REQUIRE(gunzip(serial) == large);
+
+        std::string const blocks(gzip(large, 65536, 1));
+        CATCH_REQUIRE(blocks != serial);
+        CATCH_REQUIRE(gunzip(blocks) == large);
+
+        // the trailer has the CRC-32 and size of the data
+        //
+        uint32_t const crc(crc32(0, reinterpret_cast<Bytef const *>(large.data()), large.size()));
+        uint32_t trailer[2];
+        memcpy(trailer, blocks.data() + blocks.length() - 8, 8);
+        CATCH_REQUIRE(trailer[0] == crc);
+        CATCH_REQUIRE(trailer[1] == large.size());
+
+        // the dictionary keeps the ratio close to a single stream
+        //
+        CATCH_REQUIRE(blocks.length() < serial.length() + serial.length() / 50);
+
+        for(size_t const threads : { 2, 3, 0 })
+        {
+            CATCH_REQUIRE(gzip(large, 65536, threads) == blocks);
+        }
+
+        // blocks smaller than the dictionary
+        //
+        CATCH_REQUIRE(gunzip(gzip(large, 1000, 4)) == large);
+
+        // data which fits in one block gives the usual output
+        //
+        CATCH_REQUIRE(gzip(small, 65536, 4) == gzip(small, 0, 1));
+        CATCH_REQUIRE(gunzip(gzip(small, 65536, 4)) == small);
+        CATCH_REQUIRE(gzip(large, large.size(), 4) == serial);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("zip entries compressed in blocks")
+    {
+        {
+            std::ofstream os("tree/large.txt", std::ios::out | std::ios::binary);
+            os << large;
+            std::ofstream os_small("tree/small.txt", std::ios::out | std::ios::binary);
+            os_small << small;
+        }
+
+
+        auto save = [](std::string const & filename, zipios::ZipFile::SaveOptions const & options)
+        {
+            zipios::DirectoryCollection collection("tree");
+            collection.setMethod(1000, zipios::StorageMethod::STORED, zipios::StorageMethod::DEFLATED);
+            std::ofstream os(filename, std::ios::out | std::ios::binary);
+            zipios::ZipFile::saveCollectionToArchive(os, collection, "blocks", options);
+        };
+
+        zipios::ZipFile::SaveOptions options;
+        CATCH_REQUIRE(options.getBlockSize() == 0);
+        options.setBlockSize(131072);
+        CATCH_REQUIRE(options.getBlockSize() == 131072);
+        save("one.zip", options);
+        std::string const expected(zipios_test::read_file("one.zip"));
+        CATCH_REQUIRE(system("unzip -tq one.zip >/dev/null") == 0);
+
+        for(size_t const threads : { 2, 4 })
+        for(size_t const limit : { 16 * 1024 * 1024, 1000 })
+        {
+            options.setThreads(threads);
+            options.setBufferLimit(limit);
+            save("blocks.zip", options);
+            CATCH_REQUIRE(zipios_test::read_file("blocks.zip") == expected);
+        }
+
+        zipios::ZipFile zf("blocks.zip");
+        zipios::FileEntry::buffer_t const data(zf.readEntry("tree/large.txt"));
+        CATCH_REQUIRE(std::string(data.begin(), data.end()) == large);
+        zipios::FileEntry::pointer_t entry(zf.getEntry("tree/large.txt"));
+        CATCH_REQUIRE(entry->getMethod() == zipios::StorageMethod::DEFLATED);
+        CATCH_REQUIRE(entry->getSize() == large.size());
+        CATCH_REQUIRE(entry->getCrc() == crc32(0, reinterpret_cast<Bytef const *>(large.data()), large.size()));
+        zipios::FileEntry::buffer_t const small_data(zf.readEntry("tree/small.txt"));
+        CATCH_REQUIRE(std::string(small_data.begin(), small_data.end()) == small);
+    }
+    CATCH_END_SECTION()
+}
+
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
@@ -27,12 +27,22 @@
 #include "catch_main.hpp"
 
 #include <zipios/zipfile.hpp>
+#include <zipios/codec.hpp>
 #include <zipios/directorycollection.hpp>
+#include <zipios/directoryentry.hpp>
 #include <zipios/zipiosexceptions.hpp>
+#include <zipios/zipstreamreader.hpp>
 #include <zipios/dosdatetime.hpp>
 
+#include <src/deflatebackend.hpp>
+#include <src/zipcentraldirectoryentry.hpp>
+#include <src/zipoutputstream.hpp>
+
 #include <algorithm>
+#include <atomic>
 #include <fstream>
+#include <map>
+#include <thread>
 
 #include <unistd.h>
 #include <string.h>
@@ -856,13 +866,16 @@ CATCH_SCENARIO("use Zipios to create zip archives with 1 or 3 files each", "[Zip
                 dc.addEntry(other_entry);
             }
 
-            CATCH_THEN("the creating of the zip archive fails: too many file entries")
+            CATCH_THEN("the zip archive gets created with a Zip64 End of Central Directory")
             {
                 zipios_test::auto_unlink_t remove_zip("file.zip", true);
                 {
                     std::ofstream out("file.zip", std::ios::out | std::ios::binary);
-                    CATCH_REQUIRE_THROWS_AS(zipios::ZipFile::saveCollectionToArchive(out, dc), zipios::InvalidStateException);
+                    zipios::ZipFile::saveCollectionToArchive(out, dc);
                 }
+
+                zipios::ZipFile zf("file.zip");
+                CATCH_REQUIRE(zf.size() == static_cast<size_t>(max + 1));
             }
         }
     }
@@ -1391,6 +1404,42 @@ CATCH_TEST_CASE("Valid and Invalid ZipFile Archives", "[ZipFile][FileCollection]
     }
     CATCH_END_SECTION()
 
+    CATCH_START_SECTION("create files with a central directory going past the end of the file")
+    {
+        for(int i(0); i < 10; ++i)
+        {
+            zipios_test::auto_unlink_t auto_unlink("file.zip", true);
+            {
+                std::ofstream os("file.zip", std::ios::out | std::ios::binary);
+
+                central_directory_header_t cdh;
+                cdh.m_filename = "invalid";
+                cdh.write(os);
+
+                end_of_central_directory_t eocd;
+                eocd.m_file_count = 1;
+                eocd.m_total_count = 1;
+                if(i & 1)
+                {
+                    // the size is too large
+                    eocd.m_central_directory_size = 46 + 7 + 22 + rand() % 1000 + 1;
+                }
+                else
+                {
+                    // the offset is too large
+                    eocd.m_central_directory_offset = rand() % 1000 + 1;
+                    eocd.m_central_directory_size = 46 + 7 + 22;
+                }
+                eocd.write(os);
+            }
+
+            CATCH_REQUIRE_THROWS_AS([&](){
+                        zipios::ZipFile zf("file.zip");
+                    }(), zipios::FileCollectionException);
+        }
+    }
+    CATCH_END_SECTION()
+
     CATCH_START_SECTION("create files with one an unsupported compression method")
     {
         for(int i(0); i < 10; ++i)
@@ -1465,7 +1514,7 @@ CATCH_TEST_CASE("Valid and Invalid ZipFile Archives", "[ZipFile][FileCollection]
                 end_of_central_directory_t eocd;
 
                 // use a valid compression method
-                lh.m_flags |= 1 << 3;  // <-- testing that trailing data is not supported!
+                lh.m_flags |= 1 << 3;  // <-- testing that trailing data is supported
                 lh.m_compression_method = static_cast<uint16_t>(g_supported_storage_methods[rand() % (sizeof(g_supported_storage_methods) / sizeof(g_supported_storage_methods[0]))]);
                 lh.m_filename = "invalid";
                 lh.write(os);
@@ -1483,8 +1532,10 @@ CATCH_TEST_CASE("Valid and Invalid ZipFile Archives", "[ZipFile][FileCollection]
                 eocd.write(os);
             }
 
+            // the sizes and CRC come from the Central Directory
+            //
             zipios::ZipFile zf("file.zip");
-            CATCH_REQUIRE_THROWS_AS(zf.getInputStream("invalid"), zipios::FileCollectionException);
+            CATCH_REQUIRE(zf.getInputStream("invalid") != nullptr);
         }
     }
     CATCH_END_SECTION()
@@ -1742,14 +1793,2309 @@ CATCH_TEST_CASE("saveCollectionToArchive_with_DirectoryCollection", "[ZipFile][D
 }
 
 
-CATCH_TEST_CASE("test_memory_input_stream", "[ZipFile][MemoryStream]")
+CATCH_TEST_CASE("ZipFile getEntry with identical basenames", "[ZipFile][FileCollection]")
 {
-    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/memory-test");
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/lookup-test");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir).c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    // many directories with the same file names so MatchPath::IGNORE
+    // has to pick the first one
+    //
+    int const count(rand() % 20 + 10);
+    for(int i(1); i <= count; ++i)
+    {
+        std::string const dir("lookup/dir" + std::to_string(i));
+        CATCH_REQUIRE(system(("mkdir -p " + dir).c_str()) == 0);
+        std::ofstream file_a(dir + "/a.txt", std::ios::out | std::ios::binary);
+        file_a << "a" << i << "\n";
+        std::ofstream file_b(dir + "/file" + std::to_string(i) + ".txt", std::ios::out | std::ios::binary);
+        file_b << "b" << i << "\n";
+    }
+    CATCH_REQUIRE(system("zip -r lookup.zip lookup >/dev/null") == 0);
+
+    zipios::ZipFile zf("lookup.zip");
+    zipios::FileEntry::vector_t const v(zf.entries());
+    CATCH_REQUIRE(v.size() == zf.size());
+
+    // every full name returns the entry with that name
+    //
+    zipios::FileEntry::pointer_t first_a;
+    for(auto const & e : v)
+    {
+        zipios::FileEntry::pointer_t found(zf.getEntry(e->getName()));
+        CATCH_REQUIRE(found == e);
+        if(first_a == nullptr && e->getFileName() == "a.txt")
+        {
+            first_a = e;
+        }
+    }
+    CATCH_REQUIRE(first_a != nullptr);
+
+    // the first "a.txt" in the central directory order is returned
+    //
+    CATCH_REQUIRE(zf.getEntry("a.txt", zipios::FileCollection::MatchPath::IGNORE) == first_a);
+    CATCH_REQUIRE(zf.getEntry("a.txt", zipios::FileCollection::MatchPath::MATCH) == nullptr);
+    CATCH_REQUIRE(zf.getEntry("file1.txt", zipios::FileCollection::MatchPath::IGNORE)->getName() == "lookup/dir1/file1.txt");
+    CATCH_REQUIRE(zf.getEntry("lookup/dir1/file1.txt")->getFileName() == "file1.txt");
+    CATCH_REQUIRE(zf.getEntry("lookup/dir1/file1", zipios::FileCollection::MatchPath::MATCH) == nullptr);
+    CATCH_REQUIRE(zf.getEntry("missing.txt", zipios::FileCollection::MatchPath::IGNORE) == nullptr);
+
+    // a copy has its own index
+    //
+    {
+        zipios::ZipFile copy(zf);
+        zipios::FileEntry::pointer_t copy_a(copy.getEntry("a.txt", zipios::FileCollection::MatchPath::IGNORE));
+        CATCH_REQUIRE(copy_a != nullptr);
+        CATCH_REQUIRE(copy_a != first_a);
+        CATCH_REQUIRE(copy_a->getName() == first_a->getName());
+    }
+
+    // entries added after the index was built are found too and a
+    // duplicate full name does not hide the first entry
+    //
+    zipios::DirectoryEntry extra(zipios::FilePath("lookup/dir1/a.txt"));
+    zf.addEntry(extra);
+    zipios::FileEntry::pointer_t dup(zf.getEntry("lookup/dir1/a.txt"));
+    CATCH_REQUIRE(std::find(v.begin(), v.end(), dup) != v.end());
+
+    zipios::DirectoryEntry added(zipios::FilePath("lookup/new/z.txt"));
+    zf.addEntry(added);
+    CATCH_REQUIRE(zf.getEntry("z.txt", zipios::FileCollection::MatchPath::IGNORE)->getName() == "lookup/new/z.txt");
+
+    // the index is up to date once addEntry() returns so several
+    // threads can search the collection at the same time
+    //
+    {
+        zipios::DirectoryEntry last(zipios::FilePath("lookup/new/last.txt"));
+        zf.addEntry(last);
+
+        zipios::ZipFile const & czf(zf);
+        std::atomic<int> errors(0);
+        std::vector<std::thread> threads;
+        for(int t(0); t < 4; ++t)
+        {
+            threads.emplace_back([&czf, &v, &first_a, &errors]()
+                {
+                    for(auto const & e : v)
+                    {
+                        if(czf.getEntry(e->getName()) != e)
+                        {
+                            ++errors;
+                        }
+                    }
+                    if(czf.getEntry("a.txt", zipios::FileCollection::MatchPath::IGNORE) != first_a
+                    || czf.getEntry("last.txt", zipios::FileCollection::MatchPath::IGNORE) == nullptr)
+                    {
+                        ++errors;
+                    }
+                });
+        }
+        for(auto & t : threads)
+        {
+            t.join();
+        }
+        CATCH_REQUIRE(errors == 0);
+    }
+
+    // closing clears the index
+    //
+    zf.close();
+    CATCH_REQUIRE_THROWS_AS(zf.getEntry("a.txt", zipios::FileCollection::MatchPath::IGNORE), zipios::InvalidStateException);
+}
+
+
+CATCH_TEST_CASE("ZipFile local header verification modes", "[ZipFile][FileCollection]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/verification-test");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/verify").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    // enough files for the verification to use several threads
+    //
+    int const count(rand() % 300 + 300);
+    for(int i(1); i <= count; ++i)
+    {
+        std::ofstream file("verify/f" + std::to_string(i) + ".txt", std::ios::out | std::ios::binary);
+        file << "file #" << i << "\n";
+    }
+    CATCH_REQUIRE(system("zip -r verify.zip verify >/dev/null") == 0);
+
+    zipios::ZipFile::Verification const modes[] =
+    {
+        zipios::ZipFile::Verification::EAGER,
+        zipios::ZipFile::Verification::LAZY,
+        zipios::ZipFile::Verification::NONE,
+    };
+
+    CATCH_START_SECTION("all modes can read a valid archive")
+    {
+        for(auto const m : modes)
+        {
+            for(size_t threads(0); threads <= 4; threads += 2)
+            {
+                zipios::ZipFile::OpenOptions options;
+                CATCH_REQUIRE(options.getVerification() == zipios::ZipFile::Verification::EAGER);
+                CATCH_REQUIRE(options.getVerificationThreads() == 0);
+                options.setVerification(m);
+                options.setVerificationThreads(threads);
+                CATCH_REQUIRE(options.getVerification() == m);
+                CATCH_REQUIRE(options.getVerificationThreads() == threads);
+
+                zipios::ZipFile zf("verify.zip", options);
+                CATCH_REQUIRE(zf.size() == static_cast<size_t>(count + 1));
+                for(int i(1); i <= count; i += 37)
+                {
+                    zipios::ZipFile::stream_pointer_t is(zf.getInputStream("verify/f" + std::to_string(i) + ".txt"));
+                    CATCH_REQUIRE(is != nullptr);
+                    std::string line;
+                    std::getline(*is, line);
+                    CATCH_REQUIRE(line == "file #" + std::to_string(i));
+                }
+            }
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("a corrupt local header is caught as expected by each mode")
+    {
+        // find the entry to corrupt
+        //
+        int const bad(rand() % count + 1);
+        std::string const bad_name("verify/f" + std::to_string(bad) + ".txt");
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setVerification(zipios::ZipFile::Verification::NONE);
+            zipios::ZipFile zf("verify.zip", options);
+            zipios::FileEntry::pointer_t entry(zf.getEntry(bad_name));
+            CATCH_REQUIRE(entry != nullptr);
+
+            // change the last letter of the filename in the local header
+            //
+            std::fstream f("verify.zip", std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(entry->getEntryOffset() + static_cast<std::streamoff>(30 + bad_name.length() - 1));
+            f.put('X');
+        }
+
+        for(size_t threads(0); threads <= 4; threads += 2)
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setVerificationThreads(threads);
+            CATCH_REQUIRE_THROWS_AS([&](){
+                        zipios::ZipFile zf("verify.zip", options);
+                    }(), zipios::FileCollectionException);
+        }
+
+        {
+            std::ifstream in("verify.zip", std::ios::in | std::ios::binary);
+            CATCH_REQUIRE_THROWS_AS([&](){
+                        zipios::ZipFile zf(in, zipios::ZipFile::OpenOptions());
+                    }(), zipios::FileCollectionException);
+        }
+
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setVerification(zipios::ZipFile::Verification::LAZY);
+            zipios::ZipFile zf("verify.zip", options);
+            int const good(bad == 1 ? 2 : bad - 1);
+            CATCH_REQUIRE(zf.getInputStream("verify/f" + std::to_string(good) + ".txt") != nullptr);
+            CATCH_REQUIRE_THROWS_AS(zf.getInputStream(bad_name), zipios::FileCollectionException);
+            CATCH_REQUIRE_THROWS_AS(zf.getInputStream(bad_name), zipios::FileCollectionException);
+            CATCH_REQUIRE(zf.getInputStream("verify/f" + std::to_string(good) + ".txt") != nullptr);
+        }
+
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setVerification(zipios::ZipFile::Verification::NONE);
+            zipios::ZipFile zf("verify.zip", options);
+            zipios::ZipFile::stream_pointer_t is(zf.getInputStream(bad_name));
+            CATCH_REQUIRE(is != nullptr);
+            std::string line;
+            std::getline(*is, line);
+            CATCH_REQUIRE(line == "file #" + std::to_string(bad));
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("ZipFile lazy entries", "[ZipFile][FileCollection]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/lazy-test");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
     CATCH_REQUIRE(system(("mkdir -p " + top_dir).c_str()) == 0);
     zipios_test::safe_chdir cwd(top_dir);
 
+    int const count(rand() % 20 + 10);
+    for(int i(1); i <= count; ++i)
+    {
+        std::string const dir("lazy/dir" + std::to_string(i));
+        CATCH_REQUIRE(system(("mkdir -p " + dir).c_str()) == 0);
+        std::ofstream file_a(dir + "/a.txt", std::ios::out | std::ios::binary);
+        file_a << "a" << i << "\n";
+        std::ofstream file_b(dir + "/file" + std::to_string(i) + ".txt", std::ios::out | std::ios::binary);
+        file_b << "b" << i << "\n";
+    }
+    CATCH_REQUIRE(system("zip -r lazy.zip lazy >/dev/null") == 0);
+
+    CATCH_START_SECTION("lazy entries match the eager entries")
+    {
+        zipios::ZipFile::OpenOptions options;
+        CATCH_REQUIRE_FALSE(options.getLazyEntries());
+        options.setLazyEntries(true);
+        CATCH_REQUIRE(options.getLazyEntries());
+
+        zipios::ZipFile eager("lazy.zip");
+        zipios::ZipFile lazy("lazy.zip", options);
+        CATCH_REQUIRE(lazy.isValid());
+        CATCH_REQUIRE(lazy.size() == eager.size());
+
+        zipios::FileEntry::vector_t const ve(eager.entries());
+        zipios::FileEntry::vector_t const vl(lazy.entries());
+        CATCH_REQUIRE(ve.size() == vl.size());
+        for(size_t idx(0); idx < ve.size(); ++idx)
+        {
+            CATCH_REQUIRE(ve[idx]->isEqual(*vl[idx]));
+            CATCH_REQUIRE(vl[idx]->isEqual(*ve[idx]));
+
+            zipios::FileEntry::pointer_t found(lazy.getEntry(ve[idx]->getName()));
+            CATCH_REQUIRE(found != nullptr);
+            CATCH_REQUIRE(found->isEqual(*ve[idx]));
+
+            if(!ve[idx]->isDirectory())
+            {
+                zipios::ZipFile::stream_pointer_t ise(eager.getInputStream(ve[idx]->getName()));
+                zipios::ZipFile::stream_pointer_t isl(lazy.getInputStream(ve[idx]->getName()));
+                CATCH_REQUIRE(ise != nullptr);
+                CATCH_REQUIRE(isl != nullptr);
+                std::string le, ll;
+                std::getline(*ise, le);
+                std::getline(*isl, ll);
+                CATCH_REQUIRE(le == ll);
+            }
+        }
+
+        CATCH_REQUIRE(lazy.getEntry("a.txt", zipios::FileCollection::MatchPath::IGNORE)->getName()
+                   == eager.getEntry("a.txt", zipios::FileCollection::MatchPath::IGNORE)->getName());
+        CATCH_REQUIRE(lazy.getEntry("a.txt", zipios::FileCollection::MatchPath::MATCH) == nullptr);
+        CATCH_REQUIRE(lazy.getEntry("lazy/dir1")->isDirectory());
+        CATCH_REQUIRE(lazy.getEntry("dir1", zipios::FileCollection::MatchPath::IGNORE)->isDirectory());
+        CATCH_REQUIRE(lazy.getEntry("missing.txt", zipios::FileCollection::MatchPath::IGNORE) == nullptr);
+        CATCH_REQUIRE(lazy.getInputStream("missing.txt") == nullptr);
+
+        // entries added by hand come after the archive entries
+        //
+        zipios::DirectoryEntry extra(zipios::FilePath("lazy/dir1/a.txt"));
+        lazy.addEntry(extra);
+        CATCH_REQUIRE(lazy.size() == eager.size() + 1);
+        CATCH_REQUIRE(lazy.entries().size() == eager.size() + 1);
+        CATCH_REQUIRE(lazy.getEntry("lazy/dir1/a.txt")->isEqual(*eager.getEntry("lazy/dir1/a.txt")));
+        CATCH_REQUIRE(lazy.getEntry("lazy/dir1/a.txt", zipios::FileCollection::MatchPath::MATCH) != nullptr);
+
+        lazy.close();
+        CATCH_REQUIRE_FALSE(lazy.isValid());
+        CATCH_REQUIRE_THROWS_AS(lazy.size(), zipios::InvalidStateException);
+        CATCH_REQUIRE_THROWS_AS(lazy.entries(), zipios::InvalidStateException);
+        CATCH_REQUIRE_THROWS_AS(lazy.getEntry("a.txt"), zipios::InvalidStateException);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("lazy entries with each verification mode")
+    {
+        zipios::ZipFile::Verification const modes[] =
+        {
+            zipios::ZipFile::Verification::EAGER,
+            zipios::ZipFile::Verification::LAZY,
+            zipios::ZipFile::Verification::NONE,
+        };
+        for(auto const m : modes)
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setLazyEntries(true);
+            options.setVerification(m);
+            options.setVerificationThreads(2);
+            zipios::ZipFile zf("lazy.zip", options);
+            for(int i(1); i <= count; ++i)
+            {
+                zipios::ZipFile::stream_pointer_t is(zf.getInputStream("file" + std::to_string(i) + ".txt", zipios::FileCollection::MatchPath::IGNORE));
+                CATCH_REQUIRE(is != nullptr);
+                std::string line;
+                std::getline(*is, line);
+                CATCH_REQUIRE(line == "b" + std::to_string(i));
+            }
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("ZipFile End of Central Directory search", "[ZipFile][FileCollection]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/eocd-test");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/eocd").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    {
+        std::ofstream file("eocd/data.txt", std::ios::out | std::ios::binary);
+        file << "the data\n";
+    }
+
+    CATCH_START_SECTION("a large archive comment")
+    {
+        // the comment is read from stdin
+        //
+        {
+            std::ofstream comment("comment.txt", std::ios::out | std::ios::binary);
+            for(int i(0); i < 6000; ++i)
+            {
+                comment << "comment-" << (i % 10);
+            }
+            comment << "\n";
+        }
+        CATCH_REQUIRE(system("zip -r -z comment.zip eocd <comment.txt >/dev/null") == 0);
+
+        zipios::ZipFile zf("comment.zip");
+        CATCH_REQUIRE(zf.size() == 2);
+        zipios::ZipFile::stream_pointer_t is(zf.getInputStream("eocd/data.txt"));
+        CATCH_REQUIRE(is != nullptr);
+        std::string line;
+        std::getline(*is, line);
+        CATCH_REQUIRE(line == "the data");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("data appended after the archive")
+    {
+        CATCH_REQUIRE(system("zip -r appended.zip eocd >/dev/null") == 0);
+
+        // more than one search window of junk
+        //
+        {
+            std::ofstream os("appended.zip", std::ios::out | std::ios::binary | std::ios::app);
+            for(int i(0); i < 200000; ++i)
+            {
+                os << static_cast<char>(i % 2 == 0 ? 'P' : 'K');
+            }
+        }
+
+        zipios::ZipFile zf("appended.zip");
+        CATCH_REQUIRE(zf.size() == 2);
+        zipios::ZipFile::stream_pointer_t is(zf.getInputStream("eocd/data.txt"));
+        CATCH_REQUIRE(is != nullptr);
+        std::string line;
+        std::getline(*is, line);
+        CATCH_REQUIRE(line == "the data");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("no End of Central Directory")
+    {
+        {
+            std::ofstream os("junk.zip", std::ios::out | std::ios::binary);
+            for(int i(0); i < 100000; ++i)
+            {
+                os << "PK\x05";
+            }
+        }
+
+        CATCH_REQUIRE_THROWS_AS([&](){
+                    zipios::ZipFile zf("junk.zip");
+                }(), zipios::FileCollectionException);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("ZipFile shared file access modes", "[ZipFile][FileCollection]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/mmap-test");
+
     zipios_test::auto_unlink_t auto_unlink(top_dir, true);
 
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/mmap").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    // text files get DEFLATED, the .bin files are STORED; some files
+    // are larger than the internal buffers
+    //
+    int const count(rand() % 20 + 10);
+    for(int i(1); i <= count; ++i)
+    {
+        std::ofstream text("mmap/f" + std::to_string(i) + ".txt", std::ios::out | std::ios::binary);
+        std::ofstream bin("mmap/f" + std::to_string(i) + ".bin", std::ios::out | std::ios::binary);
+        int const lines(i % 3 == 0 ? rand() % 20000 + 1000 : rand() % 10 + 1);
+        for(int j(0); j < lines; ++j)
+        {
+            text << "line " << j << " of file #" << i << "\n";
+            bin << static_cast<char>(rand());
+        }
+    }
+    CATCH_REQUIRE(system("zip -r -n .bin mmap.zip mmap >/dev/null") == 0);
+
+    auto read_all = [](zipios::ZipFile & zf, std::string const & name)
+    {
+        zipios::ZipFile::stream_pointer_t is(zf.getInputStream(name));
+        CATCH_REQUIRE(is != nullptr);
+        std::string data;
+        char buf[1000];
+        while(is->read(buf, sizeof(buf)) || is->gcount() > 0)
+        {
+            data.append(buf, is->gcount());
+        }
+        return data;
+    };
+
+    zipios::ZipFile::Access const accesses[] =
+    {
+        zipios::ZipFile::Access::POSITIONAL_READ,
+        zipios::ZipFile::Access::MEMORY_MAP,
+    };
+
+    CATCH_START_SECTION("shared file access modes return the same data")
+    {
+        zipios::ZipFile::Verification const modes[] =
+        {
+            zipios::ZipFile::Verification::EAGER,
+            zipios::ZipFile::Verification::LAZY,
+            zipios::ZipFile::Verification::NONE,
+        };
+        for(auto const a : accesses)
+        for(auto const m : modes)
+        {
+            zipios::ZipFile::OpenOptions options;
+            CATCH_REQUIRE(options.getAccess() == zipios::ZipFile::Access::STREAM);
+            options.setAccess(a);
+            CATCH_REQUIRE(options.getAccess() == a);
+            options.setVerification(m);
+            options.setVerificationThreads(2);
+            options.setLazyEntries(m == zipios::ZipFile::Verification::LAZY);
+
+            zipios::ZipFile stream("mmap.zip");
+            zipios::ZipFile mapped("mmap.zip", options);
+            CATCH_REQUIRE(mapped.size() == stream.size());
+
+            bool has_stored(false);
+            bool has_deflated(false);
+            for(auto const & e : stream.entries())
+            {
+                if(e->isDirectory())
+                {
+                    continue;
+                }
+                has_stored |= e->getMethod() == zipios::StorageMethod::STORED;
+                has_deflated |= e->getMethod() == zipios::StorageMethod::DEFLATED;
+                std::string const expected(read_all(stream, e->getName()));
+                CATCH_REQUIRE(expected.length() == e->getSize());
+                CATCH_REQUIRE(read_all(mapped, e->getName()) == expected);
+
+                // the second time the position of the data is known
+                //
+                CATCH_REQUIRE(read_all(mapped, e->getName()) == expected);
+            }
+            CATCH_REQUIRE(has_stored);
+            CATCH_REQUIRE(has_deflated);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("streams remain valid after the ZipFile is gone")
+    {
+        for(auto const a : accesses)
+        {
+            zipios::ZipFile::stream_pointer_t is;
+            {
+                zipios::ZipFile::OpenOptions options;
+                options.setAccess(a);
+                zipios::ZipFile zf("mmap.zip", options);
+                is = zf.getInputStream("mmap/f1.txt");
+                zf.close();
+            }
+            CATCH_REQUIRE(is != nullptr);
+            std::string line;
+            std::getline(*is, line);
+            CATCH_REQUIRE(line == "line 0 of file #1");
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("many threads reading from one ZipFile")
+    {
+        for(auto const a : accesses)
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setAccess(a);
+            options.setVerification(zipios::ZipFile::Verification::LAZY);
+            zipios::ZipFile zf("mmap.zip", options);
+
+            std::vector<std::string> expected(count + 1);
+            {
+                zipios::ZipFile stream("mmap.zip");
+                for(int i(1); i <= count; ++i)
+                {
+                    expected[i] = read_all(stream, "mmap/f" + std::to_string(i) + ".txt");
+                }
+            }
+
+            std::atomic<int> errors(0);
+            std::vector<std::thread> threads;
+            for(int t(0); t < 4; ++t)
+            {
+                threads.emplace_back([&, t]()
+                    {
+                        for(int repeat(0); repeat < 3; ++repeat)
+                        {
+                            for(int i(1 + t); i <= count; i += 2)
+                            {
+                                zipios::ZipFile::stream_pointer_t is(zf.getInputStream("mmap/f" + std::to_string(i) + ".txt"));
+                                std::string data;
+                                char buf[1000];
+                                while(is->read(buf, sizeof(buf)) || is->gcount() > 0)
+                                {
+                                    data.append(buf, is->gcount());
+                                }
+                                if(data != expected[i])
+                                {
+                                    ++errors;
+                                }
+                            }
+                        }
+                    });
+            }
+            for(auto & th : threads)
+            {
+                th.join();
+            }
+            CATCH_REQUIRE(errors.load() == 0);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("invalid files")
+    {
+        zipios::ZipFile::OpenOptions options;
+        options.setAccess(zipios::ZipFile::Access::MEMORY_MAP);
+
+        CATCH_REQUIRE_THROWS_AS([&](){
+                    zipios::ZipFile zf("missing.zip", options);
+                }(), zipios::IOException);
+
+        {
+            std::ofstream empty("empty.zip", std::ios::out | std::ios::binary);
+        }
+        CATCH_REQUIRE_THROWS_AS([&](){
+                    zipios::ZipFile zf("empty.zip", options);
+                }(), zipios::FileCollectionException);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("ZipFile seekable entry streams", "[ZipFile][FileCollection]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/seek-test");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/seek").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    // a large text file gets DEFLATED in many blocks, the .bin is STORED
+    //
+    std::string text_data;
+    std::string bin_data;
+    {
+        std::ofstream text("seek/large.txt", std::ios::out | std::ios::binary);
+        std::ofstream bin("seek/large.bin", std::ios::out | std::ios::binary);
+        for(int j(0); j < 100000; ++j)
+        {
+            std::string const line("line " + std::to_string(j) + " has value " + std::to_string(rand()) + "\n");
+            text << line;
+            text_data += line;
+        }
+        for(int j(0); j < 300000; ++j)
+        {
+            char const c(static_cast<char>(rand()));
+            bin << c;
+            bin_data += c;
+        }
+    }
+    CATCH_REQUIRE(system("zip -r -n .bin seek.zip seek >/dev/null") == 0);
+
+    auto check_seeks = [](zipios::ZipFile & zf, std::string const & name, std::string const & expected)
+    {
+        zipios::ZipFile::stream_pointer_t is(zf.getInputStream(name));
+        CATCH_REQUIRE(is != nullptr);
+        CATCH_REQUIRE(is->tellg() == 0);
+
+        // the end of the data
+        //
+        is->seekg(0, std::ios::end);
+        CATCH_REQUIRE(is->tellg() == static_cast<std::streamoff>(expected.length()));
+        CATCH_REQUIRE(is->get() == std::char_traits<char>::eof());
+        is->clear();
+
+        // random positions, forward and backward
+        //
+        char buf[256];
+        for(int i(0); i < 50; ++i)
+        {
+            std::streamoff const pos(rand() % (expected.length() - sizeof(buf)));
+            is->seekg(pos);
+            CATCH_REQUIRE(is->tellg() == pos);
+            CATCH_REQUIRE(is->read(buf, sizeof(buf)));
+            CATCH_REQUIRE(std::string(buf, sizeof(buf)) == expected.substr(pos, sizeof(buf)));
+            CATCH_REQUIRE(is->tellg() == static_cast<std::streamoff>(pos + sizeof(buf)));
+
+            // relative to the current position
+            //
+            std::streamoff const back(rand() % (pos + sizeof(buf)));
+            is->seekg(-back, std::ios::cur);
+            CATCH_REQUIRE(is->tellg() == static_cast<std::streamoff>(pos + sizeof(buf) - back));
+            CATCH_REQUIRE(is->get() == static_cast<unsigned char>(expected[pos + sizeof(buf) - back]));
+        }
+
+        // the start again
+        //
+        is->seekg(0, std::ios::beg);
+        CATCH_REQUIRE(is->read(buf, sizeof(buf)));
+        CATCH_REQUIRE(std::string(buf, sizeof(buf)) == expected.substr(0, sizeof(buf)));
+
+        // invalid positions fail
+        //
+        is->seekg(-1, std::ios::beg);
+        CATCH_REQUIRE(is->fail());
+        is->clear();
+        is->seekg(1, std::ios::end);
+        CATCH_REQUIRE(is->fail());
+        is->clear();
+    };
+
+    zipios::ZipFile::Access const accesses[] =
+    {
+        zipios::ZipFile::Access::STREAM,
+        zipios::ZipFile::Access::POSITIONAL_READ,
+        zipios::ZipFile::Access::MEMORY_MAP,
+    };
+
+    CATCH_START_SECTION("seek without an index")
+    {
+        for(auto const a : accesses)
+        {
+            zipios::ZipFile::OpenOptions options;
+            CATCH_REQUIRE(options.getSeekIndexSpan() == 0);
+            options.setAccess(a);
+            zipios::ZipFile zf("seek.zip", options);
+
+            CATCH_REQUIRE(zf.getEntry("seek/large.txt")->getMethod() == zipios::StorageMethod::DEFLATED);
+            CATCH_REQUIRE(zf.getEntry("seek/large.bin")->getMethod() == zipios::StorageMethod::STORED);
+
+            check_seeks(zf, "seek/large.txt", text_data);
+            check_seeks(zf, "seek/large.bin", bin_data);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("seek with an index")
+    {
+        for(auto const a : accesses)
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setAccess(a);
+            options.setSeekIndexSpan(64 * 1024);
+            CATCH_REQUIRE(options.getSeekIndexSpan() == 64 * 1024);
+            zipios::ZipFile zf("seek.zip", options);
+
+            check_seeks(zf, "seek/large.txt", text_data);
+            check_seeks(zf, "seek/large.bin", bin_data);
+
+            // the second stream reuses the index built by the first one
+            //
+            check_seeks(zf, "seek/large.txt", text_data);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("seek index shared by many threads")
+    {
+        zipios::ZipFile::OpenOptions options;
+        options.setAccess(zipios::ZipFile::Access::MEMORY_MAP);
+        options.setSeekIndexSpan(32 * 1024);
+        zipios::ZipFile zf("seek.zip", options);
+
+        std::atomic<int> errors(0);
+        std::vector<std::thread> threads;
+        for(int t(0); t < 4; ++t)
+        {
+            threads.emplace_back([&zf, &text_data, &errors, t]()
+                {
+                    zipios::ZipFile::stream_pointer_t is(zf.getInputStream("seek/large.txt"));
+                    char buf[100];
+                    for(int i(0); i < 20; ++i)
+                    {
+                        std::streamoff const pos((text_data.length() - sizeof(buf)) / 20 * ((i * 7 + t) % 20));
+                        is->seekg(pos);
+                        if(!is->read(buf, sizeof(buf))
+                        || std::string(buf, sizeof(buf)) != text_data.substr(pos, sizeof(buf)))
+                        {
+                            ++errors;
+                        }
+                    }
+                });
+        }
+        for(auto & t : threads)
+        {
+            t.join();
+        }
+        CATCH_REQUIRE(errors == 0);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("ZipFile read whole entries", "[ZipFile][FileCollection]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/read-entry-test");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/read").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    // text files get DEFLATED, the .bin files are STORED, some are empty
+    //
+    int const count(rand() % 20 + 10);
+    for(int i(0); i <= count; ++i)
+    {
+        std::ofstream text("read/f" + std::to_string(i) + ".txt", std::ios::out | std::ios::binary);
+        std::ofstream bin("read/f" + std::to_string(i) + ".bin", std::ios::out | std::ios::binary);
+        int const lines(i == 0 ? 0 : i % 3 == 0 ? rand() % 20000 + 1000 : rand() % 10 + 1);
+        for(int j(0); j < lines; ++j)
+        {
+            text << "line " << j << " of file #" << i << "\n";
+            bin << static_cast<char>(rand());
+        }
+    }
+    CATCH_REQUIRE(system("zip -r -n .bin read.zip read >/dev/null") == 0);
+
+    auto read_all = [](zipios::ZipFile & zf, std::string const & name)
+    {
+        zipios::ZipFile::stream_pointer_t is(zf.getInputStream(name));
+        CATCH_REQUIRE(is != nullptr);
+        std::string data;
+        char buf[1000];
+        while(is->read(buf, sizeof(buf)) || is->gcount() > 0)
+        {
+            data.append(buf, is->gcount());
+        }
+        return data;
+    };
+
+    zipios::ZipFile::Access const accesses[] =
+    {
+        zipios::ZipFile::Access::STREAM,
+        zipios::ZipFile::Access::POSITIONAL_READ,
+        zipios::ZipFile::Access::MEMORY_MAP,
+    };
+
+    CATCH_START_SECTION("readEntry() returns the same data as the streams")
+    {
+        for(auto const a : accesses)
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setAccess(a);
+            zipios::ZipFile zf("read.zip", options);
+
+            bool has_empty(false);
+            for(auto const & e : zf.entries())
+            {
+                if(e->isDirectory())
+                {
+                    continue;
+                }
+                has_empty |= e->getSize() == 0;
+                std::string const expected(read_all(zf, e->getName()));
+
+                zipios::FileEntry::buffer_t const data(zf.readEntry(e->getName()));
+                CATCH_REQUIRE(std::string(data.begin(), data.end()) == expected);
+
+                // a larger buffer is fine, only the entry size is used
+                //
+                std::vector<char> buffer(expected.length() + 10, '*');
+                CATCH_REQUIRE(zf.readEntry(e->getName(), buffer.data(), buffer.size()) == expected.length());
+                CATCH_REQUIRE(std::string(buffer.data(), expected.length()) == expected);
+                CATCH_REQUIRE(buffer[expected.length()] == '*');
+            }
+            CATCH_REQUIRE(has_empty);
+
+            // the basename can be used too
+            //
+            zipios::FileEntry::buffer_t const data(zf.readEntry("f1.txt", zipios::FileCollection::MatchPath::IGNORE));
+            CATCH_REQUIRE(std::string(data.begin(), data.end()) == read_all(zf, "read/f1.txt"));
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("readEntry() errors")
+    {
+        for(auto const a : accesses)
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setAccess(a);
+            zipios::ZipFile zf("read.zip", options);
+
+            CATCH_REQUIRE_THROWS_AS(zf.readEntry("read/missing.txt"), zipios::FileCollectionException);
+
+            char buf[1];
+            CATCH_REQUIRE_THROWS_AS(zf.readEntry("read/missing.txt", buf, sizeof(buf)), zipios::FileCollectionException);
+            CATCH_REQUIRE_THROWS_AS(zf.readEntry("read/f3.txt", buf, sizeof(buf)), zipios::InvalidException);
+
+            zf.close();
+            CATCH_REQUIRE_THROWS_AS(zf.readEntry("read/f1.txt"), zipios::InvalidStateException);
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("ZipFile CRC-32 verification", "[ZipFile][FileCollection]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/crc-test");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/crc").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    // a.txt gets DEFLATED and b.bin is STORED, both get an invalid
+    // CRC-32; c.txt is valid
+    //
+    for(auto const & name : { "crc/a.txt", "crc/b.bin", "crc/c.txt" })
+    {
+        std::ofstream os(name, std::ios::out | std::ios::binary);
+        for(int j(0); j < 5000; ++j)
+        {
+            os << "line " << j << " of " << name << "\n";
+        }
+    }
+    CATCH_REQUIRE(system("zip -r -n .bin crc.zip crc >/dev/null") == 0);
+    {
+        std::string data;
+        {
+            std::ifstream in("crc.zip", std::ios::in | std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        for(auto const & name : { "crc/a.txt", "crc/b.bin" })
+        {
+            // the first name is in the local header, the last in the
+            // Central Directory (the STORED data includes the name too)
+            //
+            std::string::size_type const local(data.find(name));
+            std::string::size_type const central(data.rfind(name));
+            CATCH_REQUIRE(local != std::string::npos);
+            CATCH_REQUIRE(central != std::string::npos);
+            data[local - 30 + 14] ^= 1;
+            data[central - 46 + 16] ^= 1;
+        }
+        std::ofstream out("crc.zip", std::ios::out | std::ios::binary | std::ios::trunc);
+        out << data;
+    }
+
+    // read a whole entry; returns false if the stream failed
+    //
+    auto read_all = [](zipios::ZipFile & zf, std::string const & name, bool exceptions = false)
+    {
+        zipios::ZipFile::stream_pointer_t is(zf.getInputStream(name));
+        CATCH_REQUIRE(is != nullptr);
+        if(exceptions)
+        {
+            is->exceptions(std::ios::badbit);
+        }
+        char buf[1000];
+        while(is->read(buf, sizeof(buf)) || is->gcount() > 0);
+        return !is->bad();
+    };
+
+    zipios::ZipFile::Access const accesses[] =
+    {
+        zipios::ZipFile::Access::STREAM,
+        zipios::ZipFile::Access::POSITIONAL_READ,
+        zipios::ZipFile::Access::MEMORY_MAP,
+    };
+
+    CATCH_START_SECTION("no verification by default")
+    {
+        for(auto const a : accesses)
+        {
+            zipios::ZipFile::OpenOptions options;
+            CATCH_REQUIRE(options.getCRCVerification() == zipios::ZipFile::CRCVerification::NONE);
+            options.setAccess(a);
+            zipios::ZipFile zf("crc.zip", options);
+
+            CATCH_REQUIRE(zf.getEntry("crc/a.txt")->getMethod() == zipios::StorageMethod::DEFLATED);
+            CATCH_REQUIRE(zf.getEntry("crc/b.bin")->getMethod() == zipios::StorageMethod::STORED);
+
+            CATCH_REQUIRE(read_all(zf, "crc/a.txt"));
+            CATCH_REQUIRE(read_all(zf, "crc/b.bin"));
+            CATCH_REQUIRE(read_all(zf, "crc/c.txt"));
+            CATCH_REQUIRE(zf.readEntry("crc/a.txt").size() == zf.getEntry("crc/a.txt")->getSize());
+            CATCH_REQUIRE(zf.readEntry("crc/b.bin").size() == zf.getEntry("crc/b.bin")->getSize());
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("invalid CRC-32 detected")
+    {
+        zipios::ZipFile::CRCVerification const modes[] =
+        {
+            zipios::ZipFile::CRCVerification::ALWAYS,
+            zipios::ZipFile::CRCVerification::FIRST_READ,
+        };
+        for(auto const a : accesses)
+        for(auto const m : modes)
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setAccess(a);
+            options.setCRCVerification(m);
+            CATCH_REQUIRE(options.getCRCVerification() == m);
+            zipios::ZipFile zf("crc.zip", options);
+
+            // twice: invalid entries never get trusted
+            //
+            for(int i(0); i < 2; ++i)
+            {
+                CATCH_REQUIRE_FALSE(read_all(zf, "crc/a.txt"));
+                CATCH_REQUIRE_FALSE(read_all(zf, "crc/b.bin"));
+                CATCH_REQUIRE(read_all(zf, "crc/c.txt"));
+
+                CATCH_REQUIRE_THROWS_AS(read_all(zf, "crc/a.txt", true), zipios::IOException);
+                CATCH_REQUIRE_THROWS_AS(read_all(zf, "crc/b.bin", true), zipios::IOException);
+                CATCH_REQUIRE(read_all(zf, "crc/c.txt", true));
+
+                CATCH_REQUIRE_THROWS_AS(zf.readEntry("crc/a.txt"), zipios::IOException);
+                CATCH_REQUIRE_THROWS_AS(zf.readEntry("crc/b.bin"), zipios::IOException);
+                CATCH_REQUIRE(zf.readEntry("crc/c.txt").size() == zf.getEntry("crc/c.txt")->getSize());
+            }
+
+            // seeking turns the verification off
+            //
+            for(auto const & name : { "crc/a.txt", "crc/b.bin" })
+            {
+                zipios::ZipFile::stream_pointer_t is(zf.getInputStream(name));
+                is->seekg(10);
+                is->seekg(0);
+                char buf[1000];
+                while(is->read(buf, sizeof(buf)) || is->gcount() > 0);
+                CATCH_REQUIRE_FALSE(is->bad());
+            }
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("saveCollectionToArchive in parallel", "[ZipFile][DirectoryCollection]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/parallel-save");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir).c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    // a mix of empty, small, and large files, text and binary
+    //
+    zipios_test::create_tree({ "tree", "tree/a", "tree/a/b", "tree/c" }, 60, [](int i)
+        {
+            int const size(i % 7 == 0 ? 0 : i % 11 == 0 ? rand() % 300000 + 50000 : rand() % 5000 + 1);
+            return zipios_test::random_data(size, i % 5 == 0 ? 0 : (i % 3 == 0 ? 3 : 26));
+        });
+
+
+    auto save = [](std::string const & filename, zipios::ZipFile::SaveOptions const * options)
+    {
+        zipios::DirectoryCollection collection("tree");
+        collection.setMethod(1000, zipios::StorageMethod::STORED, zipios::StorageMethod::DEFLATED);
+        std::ofstream os(filename, std::ios::out | std::ios::binary);
+        if(options == nullptr)
+        {
+            zipios::ZipFile::saveCollectionToArchive(os, collection, "parallel save");
+        }
+        else
+        {
+            zipios::ZipFile::saveCollectionToArchive(os, collection, "parallel save", *options);
+        }
+    };
+
+    save("serial.zip", nullptr);
+    std::string const expected(zipios_test::read_file("serial.zip"));
+    CATCH_REQUIRE(system("unzip -tq serial.zip >/dev/null") == 0);
+
+    CATCH_START_SECTION("parallel output is identical to the serial output")
+    {
+        zipios::ZipFile::SaveOptions options;
+        CATCH_REQUIRE(options.getThreads() == 1);
+        CATCH_REQUIRE(options.getBufferLimit() == 16 * 1024 * 1024);
+
+        save("one.zip", &options);
+        CATCH_REQUIRE(zipios_test::read_file("one.zip") == expected);
+
+        for(size_t const threads : { 2, 4, 0 })
+        for(size_t const limit : { 16 * 1024 * 1024, 20000, 0 })
+        {
+            options.setThreads(threads);
+            CATCH_REQUIRE(options.getThreads() == threads);
+            options.setBufferLimit(limit);
+            CATCH_REQUIRE(options.getBufferLimit() == limit);
+
+            save("parallel.zip", &options);
+            CATCH_REQUIRE(zipios_test::read_file("parallel.zip") == expected);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("parallel output can be read back")
+    {
+        zipios::ZipFile::SaveOptions options;
+        options.setThreads(3);
+        options.setBufferLimit(100000);
+        save("parallel.zip", &options);
+        CATCH_REQUIRE(system("unzip -tq parallel.zip >/dev/null") == 0);
+
+        zipios::ZipFile zf("parallel.zip");
+        zipios::DirectoryCollection collection("tree");
+        CATCH_REQUIRE(zf.size() == collection.size());
+        for(auto const & e : collection.entries())
+        {
+            zipios::FileEntry::pointer_t entry(zf.getEntry(e->getName()));
+            CATCH_REQUIRE(entry != nullptr);
+            if(!e->isDirectory())
+            {
+                zipios::FileEntry::buffer_t const data(zf.readEntry(e->getName()));
+                CATCH_REQUIRE(std::string(data.begin(), data.end()) == zipios_test::read_file(e->getName()));
+            }
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("deflate backends", "[ZipFile][DirectoryCollection]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/deflate-backends");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir).c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    zipios_test::create_tree({ "tree", "tree/a", "tree/b" }, 30, [](int i)
+        {
+            int const size(i % 7 == 0 ? rand() % 300000 + 100000 : rand() % 20000 + 2000);
+            return zipios_test::random_data(size, i % 4 == 0 ? 0 : (i % 2 == 0 ? 4 : 26));
+        });
+
+
+    auto save = [](std::string const & filename, zipios::ZipFile::SaveOptions const & options)
+    {
+        zipios::DirectoryCollection collection("tree");
+        collection.setMethod(1000, zipios::StorageMethod::STORED, zipios::StorageMethod::DEFLATED);
+        collection.setLevel(100000, zipios::FileEntry::COMPRESSION_LEVEL_SMALLEST, zipios::FileEntry::COMPRESSION_LEVEL_DEFAULT);
+        std::ofstream os(filename, std::ios::out | std::ios::binary);
+        zipios::ZipFile::saveCollectionToArchive(os, collection, "deflate backends", options);
+    };
+
+    auto verify = [](std::string const & filename)
+    {
+        CATCH_REQUIRE(system(("unzip -tq " + filename + " >/dev/null").c_str()) == 0);
+
+        zipios::ZipFile zf(filename);
+        zipios::DirectoryCollection collection("tree");
+        CATCH_REQUIRE(zf.size() == collection.size());
+        for(auto const & e : collection.entries())
+        {
+            if(e->isDirectory())
+            {
+                continue;
+            }
+            std::string const expected(zipios_test::read_file(e->getName()));
+
+            // readEntry() inflates with libdeflate when available and
+            // the streams always use zlib
+            //
+            zipios::FileEntry::buffer_t const data(zf.readEntry(e->getName()));
+            CATCH_REQUIRE(std::string(data.begin(), data.end()) == expected);
+
+            zipios::ZipFile::stream_pointer_t is(zf.getInputStream(e->getName()));
+            CATCH_REQUIRE(is != nullptr);
+            CATCH_REQUIRE(std::string(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>()) == expected);
+        }
+    };
+
+    zipios::ZipFile::SaveOptions zlib_options;
+    save("zlib.zip", zlib_options);
+    std::string const zlib_archive(zipios_test::read_file("zlib.zip"));
+    verify("zlib.zip");
+
+    CATCH_START_SECTION("the default backend is zlib")
+    {
+        zipios::ZipFile::SaveOptions options;
+        CATCH_REQUIRE(options.getDeflateBackend() == zipios::ZipFile::DeflateBackend::ZLIB);
+        options.setDeflateBackend(zipios::ZipFile::DeflateBackend::ZLIB);
+        CATCH_REQUIRE(options.getDeflateBackend() == zipios::ZipFile::DeflateBackend::ZLIB);
+        options.setThreads(4);
+        save("zlib-parallel.zip", options);
+        CATCH_REQUIRE(zipios_test::read_file("zlib-parallel.zip") == zlib_archive);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("libdeflate output does not depend on the number of threads")
+    {
+        for(size_t const limit : { 16 * 1024 * 1024, 50000 })
+        {
+            zipios::ZipFile::SaveOptions options;
+            options.setDeflateBackend(zipios::ZipFile::DeflateBackend::LIBDEFLATE);
+            CATCH_REQUIRE(options.getDeflateBackend() == zipios::ZipFile::DeflateBackend::LIBDEFLATE);
+            options.setBufferLimit(limit);
+            save("libdeflate.zip", options);
+            std::string const expected(zipios_test::read_file("libdeflate.zip"));
+            verify("libdeflate.zip");
+
+            // without libdeflate the zlib backend gets used
+            //
+            CATCH_REQUIRE((expected == zlib_archive) == !zipios::hasLibdeflate());
+
+            for(size_t const threads : { 2, 4, 0 })
+            {
+                options.setThreads(threads);
+                save("libdeflate-parallel.zip", options);
+                CATCH_REQUIRE(zipios_test::read_file("libdeflate-parallel.zip") == expected);
+            }
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("whole buffer inflate errors")
+    {
+        if(zipios::hasLibdeflate())
+        {
+            std::string const data(zipios_test::read_file("tree/f1.txt"));
+            std::vector<char> deflated;
+            zipios::Compressor::pointer_t compressor(zipios::createWholeBufferCompressor(Z_BEST_SPEED));
+            CATCH_REQUIRE(compressor != nullptr);
+            compressor->compress(data.data(), data.size(), true, deflated);
+            std::vector<char> out(data.size() + 1);
+
+            CATCH_REQUIRE(zipios::inflateWholeBuffer(deflated.data(), deflated.size(), out.data(), data.size()));
+            CATCH_REQUIRE(std::string(out.data(), data.size()) == data);
+
+            // the size must match exactly
+            //
+            CATCH_REQUIRE_THROWS_AS(zipios::inflateWholeBuffer(deflated.data(), deflated.size(), out.data(), data.size() + 1), zipios::IOException);
+            CATCH_REQUIRE_THROWS_AS(zipios::inflateWholeBuffer(deflated.data(), deflated.size(), out.data(), data.size() - 1), zipios::IOException);
+
+            std::string const invalid(100, '\xFF');
+            CATCH_REQUIRE_THROWS_AS(zipios::inflateWholeBuffer(invalid.data(), invalid.size(), out.data(), data.size()), zipios::IOException);
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("Zip64 archives", "[ZipFile][FileCollection][Zip64]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/zip64");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/tree").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+
+    auto verify = [](std::string const & filename, std::map<std::string, std::string> const & expected)
+    {
+        for(auto const access : { zipios::ZipFile::Access::STREAM, zipios::ZipFile::Access::POSITIONAL_READ, zipios::ZipFile::Access::MEMORY_MAP })
+        {
+            for(auto const lazy : { false, true })
+            {
+                zipios::ZipFile::OpenOptions options;
+                options.setAccess(access);
+                options.setLazyEntries(lazy);
+                zipios::ZipFile zf(filename, options);
+                CATCH_REQUIRE(zf.size() == expected.size());
+                for(auto const & e : expected)
+                {
+                    zipios::FileEntry::pointer_t entry(zf.getEntry(e.first));
+                    CATCH_REQUIRE(entry != nullptr);
+                    CATCH_REQUIRE(entry->getSize() == e.second.size());
+
+                    zipios::FileEntry::buffer_t const data(zf.readEntry(e.first));
+                    CATCH_REQUIRE(std::string(data.begin(), data.end()) == e.second);
+
+                    zipios::ZipFile::stream_pointer_t is(zf.getInputStream(e.first));
+                    CATCH_REQUIRE(is != nullptr);
+                    CATCH_REQUIRE(std::string(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>()) == e.second);
+                }
+            }
+        }
+    };
+
+    // build a Zip64 archive with one stored entry by hand, all the sizes,
+    // offsets, and counts that can be are saved in the Zip64 structures
+    //
+    auto put = [](std::string & out, uint64_t value, int size)
+    {
+        for(int i(0); i < size; ++i)
+        {
+            out += static_cast<char>(value >> (i * 8));
+        }
+    };
+
+    std::string const name("hello.txt");
+    std::string const content("Hello Zip64!\n");
+    uint32_t const crc(crc32(0, reinterpret_cast<Bytef const *>(content.data()), content.length()));
+
+    auto build = [&](bool with_record, int extra_size)
+    {
+        std::string zip;
+
+        put(zip, 0x04034b50, 4);                // local header
+        put(zip, 45, 2);
+        put(zip, 0, 2);
+        put(zip, 0, 2);                         // STORED
+        put(zip, 0x00210000, 4);                // 1980/1/1
+        put(zip, crc, 4);
+        put(zip, 0xFFFFFFFF, 4);
+        put(zip, 0xFFFFFFFF, 4);
+        put(zip, name.length(), 2);
+        put(zip, 20, 2);
+        zip += name;
+        put(zip, 0x0001, 2);
+        put(zip, 16, 2);
+        put(zip, content.length(), 8);
+        put(zip, content.length(), 8);
+        zip += content;
+
+        uint64_t const central_directory_offset(zip.length());
+        put(zip, 0x02014b50, 4);                // central directory entry
+        put(zip, 45, 2);
+        put(zip, 45, 2);
+        put(zip, 0, 2);
+        put(zip, 0, 2);
+        put(zip, 0x00210000, 4);
+        put(zip, crc, 4);
+        put(zip, 0xFFFFFFFF, 4);
+        put(zip, 0xFFFFFFFF, 4);
+        put(zip, name.length(), 2);
+        put(zip, 4 + extra_size, 2);
+        put(zip, 0, 2);
+        put(zip, 0, 2);
+        put(zip, 0, 2);
+        put(zip, 0, 4);
+        put(zip, 0xFFFFFFFF, 4);
+        zip += name;
+        put(zip, 0x0001, 2);
+        put(zip, extra_size, 2);
+        std::string extra;
+        put(extra, content.length(), 8);
+        put(extra, content.length(), 8);
+        put(extra, 0, 8);
+        zip += extra.substr(0, extra_size);
+        uint64_t const central_directory_size(zip.length() - central_directory_offset);
+
+        uint64_t const zip64_offset(zip.length());
+        if(with_record)
+        {
+            put(zip, 0x06064b50, 4);            // zip64 end of central directory
+            put(zip, 44, 8);
+            put(zip, 45, 2);
+            put(zip, 45, 2);
+            put(zip, 0, 4);
+            put(zip, 0, 4);
+            put(zip, 1, 8);
+            put(zip, 1, 8);
+            put(zip, central_directory_size, 8);
+            put(zip, central_directory_offset, 8);
+        }
+
+        put(zip, 0x07064b50, 4);                // zip64 locator
+        put(zip, 0, 4);
+        put(zip, zip64_offset, 8);
+        put(zip, 1, 4);
+
+        put(zip, 0x06054b50, 4);                // end of central directory
+        put(zip, 0, 2);
+        put(zip, 0, 2);
+        put(zip, 0xFFFF, 2);
+        put(zip, 0xFFFF, 2);
+        put(zip, 0xFFFFFFFF, 4);
+        put(zip, 0xFFFFFFFF, 4);
+        put(zip, 0, 2);
+
+        return zip;
+    };
+
+    CATCH_START_SECTION("hand made Zip64 archive")
+    {
+        zipios_test::write_file("hand.zip", build(true, 24));
+        CATCH_REQUIRE(system("unzip -tq hand.zip >/dev/null") == 0);
+        verify("hand.zip", { { name, content } });
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Zip64 archive created by zip -fz")
+    {
+        std::map<std::string, std::string> expected;
+        for(int i(0); i < 10; ++i)
+        {
+            std::string data;
+            int const size(rand() % 20000 + (i == 0 ? 0 : 1));
+            for(int j(0); j < size; ++j)
+            {
+                data += static_cast<char>(i % 2 == 0 ? rand() : 'a' + rand() % 4);
+            }
+            std::string const filename("tree/f" + std::to_string(i) + ".txt");
+            zipios_test::write_file(filename, data);
+            expected[filename] = data;
+        }
+        CATCH_REQUIRE(system("rm -f forced.zip && zip -q -fz -D -r forced.zip tree") == 0);
+        verify("forced.zip", expected);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("embedded Zip64 archive with a 64 bit start offset")
+    {
+        std::string data("some executable code\n");
+        uint64_t const start(data.length());
+        data += build(true, 24);
+        put(data, start, 8);
+        put(data, 0xFFFFFFFF, 4);
+        zipios_test::write_file("embedded.bin", data);
+
+        zipios::FileCollection::pointer_t zf(zipios::ZipFile::openEmbeddedZipFile("embedded.bin"));
+        CATCH_REQUIRE(zf->size() == 1);
+        zipios::ZipFile::stream_pointer_t is(zf->getInputStream(name));
+        CATCH_REQUIRE(is != nullptr);
+        CATCH_REQUIRE(std::string(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>()) == content);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("missing Zip64 End of Central Directory")
+    {
+        zipios_test::write_file("no-record.zip", build(false, 24));
+        CATCH_REQUIRE_THROWS_AS(zipios::ZipFile("no-record.zip"), zipios::FileCollectionException);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("truncated Zip64 extra field")
+    {
+        zipios_test::write_file("truncated.zip", build(true, 16));
+        for(auto const lazy : { false, true })
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setLazyEntries(lazy);
+            CATCH_REQUIRE_THROWS_AS(zipios::ZipFile("truncated.zip", options), zipios::IOException);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("Zip64 values without a Zip64 extra field")
+    {
+        // rename the Zip64 extra field of the central directory entry
+        //
+        std::string zip(build(true, 24));
+        size_t const pos(zip.find(std::string("PK\x01\x02", 4)));
+        CATCH_REQUIRE(pos != std::string::npos);
+        CATCH_REQUIRE(zip[pos + 46 + name.length()] == 0x01);
+        zip[pos + 46 + name.length()] = 0x7F;
+        zipios_test::write_file("no-field.zip", zip);
+        for(auto const lazy : { false, true })
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setLazyEntries(lazy);
+            CATCH_REQUIRE_THROWS_AS(zipios::ZipFile("no-field.zip", options), zipios::FileCollectionException);
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("Zip64 writing", "[ZipFile][Zip64]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/zip64-writing");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir).c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+
+    auto make_entry = [](std::string const & name)
+    {
+        zipios::FilePath const path(name);
+        zipios::DirectoryEntry const source(path);
+        zipios::FileEntry::pointer_t entry(std::make_shared<zipios::ZipCentralDirectoryEntry>(source));
+        entry->setUnixTime(1600000000);
+        entry->setMethod(zipios::StorageMethod::STORED);
+        return entry;
+    };
+
+    std::string const zip64_record("PK\x06\x06", 4);
+
+    CATCH_START_SECTION("small archives stay classic")
+    {
+        std::ostringstream os(std::ios::out | std::ios::binary);
+        {
+            zipios::ZipOutputStream zos(os);
+            for(int i(0); i < 10; ++i)
+            {
+                zos.putNextEntry(make_entry("file" + std::to_string(i) + ".txt"));
+                zos << "content of file #" << i << "\n";
+            }
+            zos.finish();
+        }
+        std::string const zip(os.str());
+        CATCH_REQUIRE(zip.find(zip64_record) == std::string::npos);
+        CATCH_REQUIRE(zip[4] == 20);
+        CATCH_REQUIRE(zip[5] == 0);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("headers with sizes and offsets over 4Gb")
+    {
+        uint64_t const size(5ULL * 1024 * 1024 * 1024);
+        uint64_t const compressed_size(4ULL * 1024 * 1024 * 1024 + 123);
+        uint64_t const offset(6ULL * 1024 * 1024 * 1024);
+
+        // an existing Zip64 field gets replaced, other fields are kept
+        //
+        zipios::FileEntry::buffer_t const extra{
+                  0x01, 0x00, 0x08, 0x00, 1, 2, 3, 4, 5, 6, 7, 8
+                , 0x34, 0x12, 0x02, 0x00, 0xAA, 0xBB
+            };
+
+        zipios::FilePath const path("huge.bin");
+        zipios::DirectoryEntry const source(path);
+        zipios::ZipCentralDirectoryEntry entry(source);
+        entry.setUnixTime(1600000000);
+        entry.setSize(size);
+        entry.setCompressedSize(compressed_size);
+        entry.setEntryOffset(offset);
+        entry.setExtra(extra);
+        CATCH_REQUIRE(entry.isZip64());
+
+        {
+            std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+            entry.write(ss);
+            CATCH_REQUIRE(ss.str().length() == entry.getHeaderSize());
+            CATCH_REQUIRE(ss.str()[6] == 45);
+
+            zipios::ZipCentralDirectoryEntry central;
+            central.read(ss);
+            CATCH_REQUIRE(central.getSize() == size);
+            CATCH_REQUIRE(central.getCompressedSize() == compressed_size);
+            CATCH_REQUIRE(static_cast<uint64_t>(central.getEntryOffset()) == offset);
+            CATCH_REQUIRE(central.getExtractVersion() == 45);
+            zipios::FileEntry::buffer_t const saved(central.getExtra());
+            CATCH_REQUIRE(saved.size() == 6 + 4 + 24);
+            CATCH_REQUIRE(std::equal(saved.begin(), saved.begin() + 6, extra.begin() + 12));
+        }
+
+        {
+            std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+            entry.zipios::ZipLocalEntry::write(ss);
+            CATCH_REQUIRE(ss.str().length() == entry.zipios::ZipLocalEntry::getHeaderSize());
+
+            zipios::ZipLocalEntry local;
+            local.read(ss);
+            CATCH_REQUIRE(local.getSize() == size);
+            CATCH_REQUIRE(local.getCompressedSize() == compressed_size);
+            CATCH_REQUIRE(local.getExtractVersion() == 45);
+            CATCH_REQUIRE(local.getExtra().size() == 6 + 4 + 16);
+        }
+
+        // small entries do not get a Zip64 field
+        //
+        entry.setSize(100);
+        entry.setCompressedSize(100);
+        entry.setEntryOffset(100);
+        CATCH_REQUIRE_FALSE(entry.isZip64());
+        {
+            std::stringstream ss(std::ios::in | std::ios::out | std::ios::binary);
+            entry.write(ss);
+            zipios::ZipCentralDirectoryEntry central;
+            central.read(ss);
+            CATCH_REQUIRE(central.getExtractVersion() == 20);
+            CATCH_REQUIRE(central.getExtra() == zipios::FileEntry::buffer_t(extra.begin() + 12, extra.end()));
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("more than 65535 entries")
+    {
+        size_t const count(70000);
+        {
+            std::ofstream os("many.zip", std::ios::out | std::ios::binary);
+            zipios::ZipOutputStream zos(os);
+            for(size_t i(0); i < count; ++i)
+            {
+                zos.putNextEntry(make_entry("f" + std::to_string(i)));
+                zos << i;
+            }
+            zos.finish();
+        }
+        CATCH_REQUIRE(zipios_test::read_file("many.zip").find(zip64_record) != std::string::npos);
+        CATCH_REQUIRE(system("unzip -tq many.zip >/dev/null") == 0);
+
+        for(auto const lazy : { false, true })
+        {
+            zipios::ZipFile::OpenOptions options;
+            options.setLazyEntries(lazy);
+            zipios::ZipFile zf("many.zip", options);
+            CATCH_REQUIRE(zf.size() == count);
+            for(size_t const i : { size_t(0), size_t(65535), size_t(65536), count - 1 })
+            {
+                zipios::FileEntry::buffer_t const data(zf.readEntry("f" + std::to_string(i)));
+                CATCH_REQUIRE(std::string(data.begin(), data.end()) == std::to_string(i));
+            }
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("local header of an entry announced as huge")
+    {
+        std::string const content("not that big after all\n");
+        {
+            std::ofstream os("announced.zip", std::ios::out | std::ios::binary);
+            zipios::ZipOutputStream zos(os);
+            zipios::FileEntry::pointer_t entry(make_entry("big.txt"));
+            entry->setMethod(zipios::StorageMethod::DEFLATED);
+            entry->setSize(5ULL * 1024 * 1024 * 1024);
+            zos.putNextEntry(entry);
+            zos << content;
+            zos.putNextEntry(make_entry("small.txt"));
+            zos << content;
+            zos.finish();
+        }
+        std::string const zip(zipios_test::read_file("announced.zip"));
+        CATCH_REQUIRE(zip[4] == 45);
+        CATCH_REQUIRE(zip.substr(18, 8) == std::string(8, '\xFF'));
+        CATCH_REQUIRE(zip.find(zip64_record) == std::string::npos);
+        CATCH_REQUIRE(system("unzip -tq announced.zip >/dev/null") == 0);
+
+        zipios::ZipFile zf("announced.zip");
+        CATCH_REQUIRE(zf.size() == 2);
+        for(auto const & name : { "big.txt", "small.txt" })
+        {
+            zipios::FileEntry::buffer_t const data(zf.readEntry(name));
+            CATCH_REQUIRE(std::string(data.begin(), data.end()) == content);
+            zipios::ZipFile::stream_pointer_t is(zf.getInputStream(name));
+            CATCH_REQUIRE(std::string(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>()) == content);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("entries past 4Gb in a sparse file")
+    {
+        zipios::offset_t const start(5LL * 1024 * 1024 * 1024);
+        {
+            std::ofstream os("sparse.zip", std::ios::out | std::ios::binary);
+            os.seekp(start);
+            zipios::ZipOutputStream zos(os);
+            for(int i(0); i < 5; ++i)
+            {
+                zos.putNextEntry(make_entry("file" + std::to_string(i) + ".txt"));
+                zos << "data of file #" << i << "\n";
+            }
+            zos.finish();
+        }
+        CATCH_REQUIRE(system("unzip -tq sparse.zip >/dev/null") == 0);
+
+        for(auto const access : { zipios::ZipFile::Access::STREAM, zipios::ZipFile::Access::POSITIONAL_READ, zipios::ZipFile::Access::MEMORY_MAP })
+        {
+            for(auto const lazy : { false, true })
+            {
+                zipios::ZipFile::OpenOptions options;
+                options.setAccess(access);
+                options.setLazyEntries(lazy);
+                zipios::ZipFile zf("sparse.zip", options);
+                CATCH_REQUIRE(zf.size() == 5);
+                for(int i(0); i < 5; ++i)
+                {
+                    std::string const name("file" + std::to_string(i) + ".txt");
+                    zipios::FileEntry::pointer_t entry(zf.getEntry(name));
+                    CATCH_REQUIRE(entry->getEntryOffset() >= start);
+                    zipios::FileEntry::buffer_t const data(zf.readEntry(name));
+                    CATCH_REQUIRE(std::string(data.begin(), data.end()) == "data of file #" + std::to_string(i) + "\n");
+                }
+            }
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("streaming ZipOutputStream", "[ZipFile][ZipOutputStream]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/streaming");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/tree/sub").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    // a sink which, like a pipe, cannot tell its position
+    //
+    class pipe_streambuf
+        : public std::streambuf
+    {
+    public:
+        std::string const & str() const
+        {
+            return f_data;
+        }
+
+    protected:
+        virtual int_type overflow(int_type c) override
+        {
+            if(c != traits_type::eof())
+            {
+                f_data += static_cast<char>(c);
+            }
+            return traits_type::not_eof(c);
+        }
+
+        virtual std::streamsize xsputn(char const * s, std::streamsize n) override
+        {
+            f_data.append(s, n);
+            return n;
+        }
+
+    private:
+        std::string f_data = std::string();
+    };
+
+    auto make_entry = [](std::string const & name, zipios::StorageMethod method)
+    {
+        zipios::FilePath const path(name);
+        zipios::DirectoryEntry const source(path);
+        zipios::FileEntry::pointer_t entry(std::make_shared<zipios::ZipCentralDirectoryEntry>(source));
+        entry->setUnixTime(1600000000);
+        entry->setMethod(method);
+        return entry;
+    };
+
+
+    std::string const data_descriptor("PK\x07\x08", 4);
+
+    std::map<std::string, std::string> contents;
+    for(int i(0); i < 5; ++i)
+    {
+        std::string content;
+        int const size(rand() % 5000 + (i == 0 ? 0 : 100));
+        for(int j(0); j < size; ++j)
+        {
+            content += static_cast<char>(i % 2 == 0 ? 'a' + rand() % 4 : rand());
+        }
+        contents["file" + std::to_string(i) + ".bin"] = content;
+    }
+
+    auto write_archive = [&](std::ostream & os, bool streaming)
+    {
+        zipios::ZipOutputStream zos(os);
+        if(streaming)
+        {
+            zos.setStreaming(true);
+        }
+        CATCH_REQUIRE(zos.isStreaming());
+        int i(0);
+        for(auto const & c : contents)
+        {
+            zos.putNextEntry(make_entry(c.first, i % 3 == 1 ? zipios::StorageMethod::STORED : zipios::StorageMethod::DEFLATED));
+            zos << c.second;
+            ++i;
+        }
+        CATCH_REQUIRE_THROWS_AS(zos.setStreaming(false), zipios::InvalidStateException);
+        zos.closeEntry();
+        zos.finish();
+    };
+
+    auto check_archive = [&](std::string const & filename)
+    {
+        CATCH_REQUIRE(system(("unzip -tq " + filename + " >/dev/null").c_str()) == 0);
+
+        for(auto const access : { zipios::ZipFile::Access::STREAM, zipios::ZipFile::Access::POSITIONAL_READ, zipios::ZipFile::Access::MEMORY_MAP })
+        {
+            for(auto const lazy : { false, true })
+            {
+                zipios::ZipFile::OpenOptions options;
+                options.setAccess(access);
+                options.setLazyEntries(lazy);
+                options.setVerification(zipios::ZipFile::Verification::EAGER);
+                zipios::ZipFile zf(filename, options);
+                for(auto const & c : contents)
+                {
+                    zipios::ZipFile::stream_pointer_t is(zf.getInputStream(c.first));
+                    CATCH_REQUIRE(is != nullptr);
+                    std::string const data(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{});
+                    CATCH_REQUIRE(data == c.second);
+
+                    zipios::FileEntry::buffer_t const buffer(zf.readEntry(c.first));
+                    CATCH_REQUIRE(std::string(buffer.begin(), buffer.end()) == c.second);
+                }
+            }
+        }
+    };
+
+    CATCH_START_SECTION("a non-seekable output gets data descriptors")
+    {
+        pipe_streambuf sink;
+        {
+            std::ostream os(&sink);
+            write_archive(os, false);
+        }
+        std::string const zip(sink.str());
+
+        // bit 3 of the general purpose flags of the first local header
+        //
+        CATCH_REQUIRE(zip.substr(0, 4) == std::string("PK\x03\x04", 4));
+        CATCH_REQUIRE((zip[6] & 0x08) != 0);
+        CATCH_REQUIRE(zip.find(data_descriptor) != std::string::npos);
+
+        // the same archive as with a seekable output in streaming mode
+        //
+        std::ostringstream seekable(std::ios::out | std::ios::binary);
+        write_archive(seekable, true);
+        CATCH_REQUIRE(seekable.str() == zip);
+
+        zipios_test::write_file("streamed.zip", zip);
+        check_archive("streamed.zip");
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("the streaming mode cannot change once entries were added")
+    {
+        std::ostringstream os(std::ios::out | std::ios::binary);
+        zipios::ZipOutputStream zos(os);
+        CATCH_REQUIRE_FALSE(zos.isStreaming());
+        zos.putNextEntry(make_entry("file.txt", zipios::StorageMethod::DEFLATED));
+        zos << "some data\n";
+        CATCH_REQUIRE_THROWS_AS(zos.setStreaming(true), zipios::InvalidStateException);
+        CATCH_REQUIRE_FALSE(zos.isStreaming());
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("saving a collection in streaming mode")
+    {
+        for(auto const & c : contents)
+        {
+            zipios_test::write_file("tree/" + c.first, c.second);
+        }
+        contents["sub/large.txt"] = std::string(20000, 'z');
+        zipios_test::write_file("tree/sub/large.txt", contents["sub/large.txt"]);
+
+        zipios::DirectoryCollection collection("tree");
+
+        std::string expected;
+        for(auto const threads : { 1, 4 })
+        {
+            zipios::ZipFile::SaveOptions options;
+            options.setThreads(threads);
+            options.setBufferLimit(3000);
+            options.setStreaming(true);
+
+            pipe_streambuf sink;
+            std::ostream os(&sink);
+            zipios::ZipFile::saveCollectionToArchive(os, collection, "streamed", options);
+            CATCH_REQUIRE(os);
+
+            // only the entries larger than the buffer limit have a
+            // data descriptor
+            //
+            std::string const zip(sink.str());
+            CATCH_REQUIRE(zip.find(data_descriptor) != std::string::npos);
+            if(expected.empty())
+            {
+                expected = zip;
+            }
+            else
+            {
+                CATCH_REQUIRE(zip == expected);
+            }
+        }
+
+        zipios_test::write_file("collection.zip", expected);
+        CATCH_REQUIRE(system("unzip -tq collection.zip >/dev/null") == 0);
+
+        zipios::ZipFile zf("collection.zip");
+        for(auto const & c : contents)
+        {
+            zipios::ZipFile::stream_pointer_t is(zf.getInputStream("tree/" + c.first));
+            CATCH_REQUIRE(is != nullptr);
+            std::string const data(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{});
+            CATCH_REQUIRE(data == c.second);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("entries close to 4Gb get a Zip64 local header and data descriptor")
+    {
+        std::string content;
+        for(int i(0); i < 100; ++i)
+        {
+            content += "line " + std::to_string(i) + " of a fake large entry\n";
+        }
+
+        pipe_streambuf sink;
+        {
+            std::ostream os(&sink);
+            zipios::ZipOutputStream zos(os);
+
+            // fake a size so the local header uses Zip64 with a small entry
+            //
+            zipios::FileEntry::pointer_t entry(make_entry("zip64.txt", zipios::StorageMethod::DEFLATED));
+            entry->setSize(0xFFFFFFFF - 100);
+            zos.putNextEntry(entry);
+            zos << content;
+            zos.closeEntry();
+            zos.finish();
+        }
+        std::string const zip(sink.str());
+
+        // the local header has a Zip64 extra field with zero sizes
+        //
+        size_t const name_length(static_cast<unsigned char>(zip[26]) | (static_cast<unsigned char>(zip[27]) << 8));
+        CATCH_REQUIRE(name_length == 9);
+        CATCH_REQUIRE(zip.substr(30 + name_length, 4) == std::string("\x01\x00\x10\x00", 4));
+        CATCH_REQUIRE(zip.substr(30 + name_length + 4, 16) == std::string(16, '\0'));
+
+        // and the data descriptor uses 64 bit sizes
+        //
+        size_t const pos(zip.find(data_descriptor));
+        CATCH_REQUIRE(pos != std::string::npos);
+        CATCH_REQUIRE(zip.substr(pos + 4 + 4 + 8 + 8, 4) == std::string("PK\x01\x02", 4));
+
+        zipios_test::write_file("zip64.zip", zip);
+        CATCH_REQUIRE(system("unzip -tq zip64.zip >/dev/null") == 0);
+
+        zipios::ZipFile zf("zip64.zip");
+        zipios::FileEntry::buffer_t const buffer(zf.readEntry("zip64.txt"));
+        CATCH_REQUIRE(std::string(buffer.begin(), buffer.end()) == content);
+
+        std::istringstream in(zip, std::ios::in | std::ios::binary);
+        zipios::ZipStreamReader reader(in);
+        zipios::FileEntry::pointer_t entry(reader.getNextEntry());
+        CATCH_REQUIRE(entry != nullptr);
+        zipios::ZipStreamReader::stream_pointer_t is(reader.getInputStream());
+        CATCH_REQUIRE(is != nullptr);
+        std::string const data(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{});
+        CATCH_REQUIRE(data == content);
+        CATCH_REQUIRE(entry->getSize() == content.length());
+        CATCH_REQUIRE(reader.getNextEntry() == nullptr);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("entries growing past 4Gb need a Zip64 local header")
+    {
+        // fake sizes over 4Gb on an entry which local header was
+        // written without the Zip64 extra field
+        //
+        zipios::ZipLocalEntry local;
+        local.setTrailingDataDescriptor(true);
+        local.setSize(0x100000000ULL);
+        local.setCompressedSize(0x100000010ULL);
+
+        std::ostringstream os(std::ios::out | std::ios::binary);
+        CATCH_REQUIRE_THROWS_AS(local.writeDataDescriptor(os), zipios::InvalidStateException);
+        CATCH_REQUIRE(os.str().empty());
+
+        local.setZip64(true);
+        local.writeDataDescriptor(os);
+        CATCH_REQUIRE(os.str().length() == 4 + 4 + 8 + 8);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("append to an archive", "[ZipFile][DirectoryCollection]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/append");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/first/tree/sub " + top_dir + "/second/tree/sub").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+
+
+    // the first archive has a.txt, b.txt, and sub/c.txt; the update
+    // replaces b.txt and adds sub/d.txt
+    //
+    std::map<std::string, std::string> first;
+    std::map<std::string, std::string> second;
+    for(int i(0); i < 5000; ++i)
+    {
+        first["tree/a.txt"] += "line " + std::to_string(rand() % 100) + " of a\n";
+        second["tree/sub/d.txt"] += "line " + std::to_string(rand() % 100) + " of d\n";
+    }
+    first["tree/b.txt"] = "the old b\n";
+    first["tree/sub/c.txt"] = std::string(3000, 'c');
+    second["tree/b.txt"] = "the new b\n";
+    for(auto const & f : first)
+    {
+        zipios_test::write_file("first/" + f.first, f.second);
+    }
+    for(auto const & f : second)
+    {
+        zipios_test::write_file("second/" + f.first, f.second);
+    }
+
+    std::map<std::string, std::string> expected(second);
+    expected.insert(first.begin(), first.end());
+
+    std::string const filename(top_dir + "/archive.zip");
+    std::string const comment("the archive comment");
+    std::string const central_directory("PK\x01\x02", 4);
+
+    auto create_archive = [&]()
+    {
+        zipios_test::safe_chdir first_dir("first");
+        zipios::DirectoryCollection collection("tree");
+        std::ofstream os(filename, std::ios::out | std::ios::binary);
+        zipios::ZipFile::saveCollectionToArchive(os, collection, comment);
+    };
+
+    auto check_archive = [&]()
+    {
+        CATCH_REQUIRE(system(("unzip -tq " + filename + " >/dev/null").c_str()) == 0);
+
+        zipios::ZipFile zf(filename);
+        size_t files(0);
+        for(auto const & entry : zf.entries())
+        {
+            if(entry->isDirectory())
+            {
+                continue;
+            }
+            auto const it(expected.find(entry->getName()));
+            CATCH_REQUIRE(it != expected.end());
+            zipios::ZipFile::stream_pointer_t is(zf.getInputStream(entry->getName()));
+            CATCH_REQUIRE(is != nullptr);
+            std::string const data(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{});
+            CATCH_REQUIRE(data == it->second);
+            ++files;
+        }
+        CATCH_REQUIRE(files == expected.size());
+
+        // "tree" and "tree/sub" are not duplicated
+        //
+        CATCH_REQUIRE(zf.size() == expected.size() + 2);
+
+        std::string const zip(zipios_test::read_file(filename));
+        CATCH_REQUIRE(zip.substr(zip.length() - comment.length()) == comment);
+    };
+
+    CATCH_START_SECTION("new entries are written where the Central Directory was")
+    {
+        for(auto const threads : { 1, 4 })
+        {
+            for(auto const streaming : { false, true })
+            {
+                create_archive();
+                std::string const original(zipios_test::read_file(filename));
+                std::string::size_type const offset(original.find(central_directory));
+                CATCH_REQUIRE(offset != std::string::npos);
+
+                {
+                    zipios_test::safe_chdir second_dir("second");
+                    zipios::DirectoryCollection collection("tree");
+                    zipios::ZipFile::SaveOptions options;
+                    options.setThreads(threads);
+                    options.setStreaming(streaming);
+                    zipios::ZipFile::appendCollectionToArchive(filename, collection, options);
+                }
+
+                // the existing data was not touched
+                //
+                std::string const appended(zipios_test::read_file(filename));
+                CATCH_REQUIRE(appended.substr(0, offset) == original.substr(0, offset));
+                CATCH_REQUIRE(appended.find(central_directory) > offset);
+
+                check_archive();
+            }
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("data following the archive gets removed")
+    {
+        create_archive();
+        {
+            std::ofstream os(filename, std::ios::out | std::ios::binary | std::ios::app);
+            os << std::string(10000, 'g');
+        }
+
+        {
+            zipios_test::safe_chdir second_dir("second");
+            zipios::DirectoryCollection collection("tree");
+            zipios::ZipFile::appendCollectionToArchive(filename, collection);
+        }
+
+        std::string const appended(zipios_test::read_file(filename));
+        CATCH_REQUIRE(appended.find(std::string(100, 'g')) == std::string::npos);
+
+        check_archive();
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("invalid archives")
+    {
+        zipios::DirectoryCollection collection("second/tree");
+        CATCH_REQUIRE_THROWS_AS(zipios::ZipFile::appendCollectionToArchive(top_dir + "/missing.zip", collection), zipios::IOException);
+
+        zipios_test::write_file("not-a-zip.zip", std::string(1000, 'x'));
+        CATCH_REQUIRE_THROWS_AS(zipios::ZipFile::appendCollectionToArchive("not-a-zip.zip", collection), zipios::FileCollectionException);
+        CATCH_REQUIRE(zipios_test::read_file("not-a-zip.zip") == std::string(1000, 'x'));
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("raw entry copy", "[ZipFile][ZipOutputStream]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/raw-copy");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/tree/sub").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    std::map<std::string, std::string> files;
+    for(int i(0); i < 20000; ++i)
+    {
+        files["tree/large.txt"] += "line " + std::to_string(rand() % 300) + " of the file\n";
+    }
+    for(int i(0); i < 2000; ++i)
+    {
+        files["tree/sub/random.bin"] += static_cast<char>(rand());
+    }
+    files["tree/small.txt"] = "a small file\n";
+    files["tree/sub/empty.txt"] = std::string();
+    for(auto const & f : files)
+    {
+        std::ofstream os(f.first, std::ios::out | std::ios::binary);
+        os << f.second;
+    }
+
+    // the source archive uses all the methods available
+    //
+    std::vector<zipios::StorageMethod> methods{ zipios::StorageMethod::DEFLATED, zipios::StorageMethod::STORED };
+    if(zipios::Codec::getCodec(zipios::StorageMethod::ZSTD) != nullptr)
+    {
+        methods.push_back(zipios::StorageMethod::ZSTD);
+    }
+
+    auto read_data = [](std::istream & is)
+    {
+        return std::string(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    };
+
+    CATCH_START_SECTION("entries are copied as is")
+    {
+        for(auto const method : methods)
+        {
+            std::string const source(top_dir + "/source.zip");
+            {
+                zipios::DirectoryCollection collection("tree");
+                collection.setMethod(0, method, method);
+                std::ofstream os(source, std::ios::out | std::ios::binary);
+                zipios::ZipFile::saveCollectionToArchive(os, collection);
+            }
+
+            for(auto const access : { zipios::ZipFile::Access::STREAM, zipios::ZipFile::Access::POSITIONAL_READ, zipios::ZipFile::Access::MEMORY_MAP })
+            {
+                for(auto const lazy : { false, true })
+                {
+                    for(auto const streaming : { false, true })
+                    {
+                        zipios::ZipFile::OpenOptions options;
+                        options.setAccess(access);
+                        options.setLazyEntries(lazy);
+                        zipios::ZipFile zf(source, options);
+
+                        // the raw data is the data found in the archive
+                        //
+                        zipios::FileEntry::pointer_t large(zf.getEntry("tree/large.txt"));
+                        CATCH_REQUIRE(large != nullptr);
+                        zipios::ZipFile::stream_pointer_t raw(zf.getRawInputStream("tree/large.txt"));
+                        CATCH_REQUIRE(raw != nullptr);
+                        std::string const compressed(read_data(*raw));
+                        CATCH_REQUIRE(compressed.length() == large->getCompressedSize());
+                        CATCH_REQUIRE((compressed == files["tree/large.txt"]) == (method == zipios::StorageMethod::STORED));
+                        CATCH_REQUIRE(zf.getRawInputStream("tree/missing.txt") == nullptr);
+
+                        std::string const target(top_dir + "/target.zip");
+                        {
+                            std::ofstream os(target, std::ios::out | std::ios::binary);
+                            zipios::ZipOutputStream zos(os);
+                            zos.setStreaming(streaming);
+                            zipios::FileEntry::vector_t const entries(zf.entries());
+                            for(auto const & entry : entries)
+                            {
+                                zos.putRawEntry(zf, entry);
+                            }
+                            zos.closeEntry();
+                            zos.finish();
+                        }
+
+                        // the source entries did not change
+                        //
+                        CATCH_REQUIRE(zf.getEntry("tree/large.txt")->getEntryOffset() == large->getEntryOffset());
+
+                        // the copy is exactly as valid as the source (unzip
+                        // does not like the empty DEFLATED entries which
+                        // have no compressed data at all)
+                        //
+                        CATCH_REQUIRE(system(("unzip -tq " + target + " >/dev/null 2>&1").c_str())
+                                   == system(("unzip -tq " + source + " >/dev/null 2>&1").c_str()));
+
+                        zipios::ZipFile copy(target);
+                        CATCH_REQUIRE(copy.size() == zf.size());
+                        for(auto const & entry : zf.entries())
+                        {
+                            zipios::FileEntry::pointer_t e(copy.getEntry(entry->getName()));
+                            CATCH_REQUIRE(e != nullptr);
+                            CATCH_REQUIRE(e->getMethod() == entry->getMethod());
+                            CATCH_REQUIRE(e->getCrc() == entry->getCrc());
+                            CATCH_REQUIRE(e->getSize() == entry->getSize());
+                            CATCH_REQUIRE(e->getCompressedSize() == entry->getCompressedSize());
+                            if(!entry->isDirectory())
+                            {
+                                zipios::ZipFile::stream_pointer_t is(copy.getInputStream(entry->getName()));
+                                CATCH_REQUIRE(read_data(*is) == files[entry->getName()]);
+                                zipios::FileEntry::buffer_t const buffer(copy.readEntry(entry->getName()));
+                                CATCH_REQUIRE(std::string(buffer.begin(), buffer.end()) == files[entry->getName()]);
+                            }
+                        }
+                        raw = copy.getRawInputStream("tree/large.txt");
+                        CATCH_REQUIRE(read_data(*raw) == compressed);
+                    }
+                }
+            }
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("entries which are not part of the archive")
+    {
+        std::string const source(top_dir + "/source.zip");
+        {
+            zipios::DirectoryCollection collection("tree");
+            std::ofstream os(source, std::ios::out | std::ios::binary);
+            zipios::ZipFile::saveCollectionToArchive(os, collection);
+        }
+        zipios::ZipFile zf(source);
+
+        std::ostringstream os(std::ios::out | std::ios::binary);
+        zipios::ZipOutputStream zos(os);
+        zipios::DirectoryEntry const other(zipios::FilePath("tree/other.txt"));
+        zipios::FileEntry::pointer_t entry(std::make_shared<zipios::ZipCentralDirectoryEntry>(other));
+        CATCH_REQUIRE_THROWS_AS(zos.putRawEntry(zf, entry), zipios::FileCollectionException);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("merging archives")
+    {
+        // the second archive has a different version of small.txt
+        //
+        std::string const first(top_dir + "/first.zip");
+        {
+            zipios::DirectoryCollection collection("tree");
+            collection.setMethod(0, zipios::StorageMethod::DEFLATED, zipios::StorageMethod::DEFLATED);
+            std::ofstream os(first, std::ios::out | std::ios::binary);
+            zipios::ZipFile::saveCollectionToArchive(os, collection);
+        }
+        std::string const second(top_dir + "/second.zip");
+        {
+            std::ofstream os("tree/small.txt", std::ios::out | std::ios::binary);
+            os << "another small file\n";
+        }
+        {
+            std::ofstream os("tree/extra.txt", std::ios::out | std::ios::binary);
+            os << "an extra file\n";
+        }
+        {
+            zipios::DirectoryCollection collection("tree");
+            collection.setMethod(0, zipios::StorageMethod::STORED, zipios::StorageMethod::STORED);
+            std::ofstream os(second, std::ios::out | std::ios::binary);
+            zipios::ZipFile::saveCollectionToArchive(os, collection);
+        }
+
+        std::string const merged(top_dir + "/merged.zip");
+        {
+            std::ofstream os(merged, std::ios::out | std::ios::binary);
+            zipios::ZipFile::mergeArchives(os, { first, second });
+            CATCH_REQUIRE(os);
+        }
+        {
+            zipios::ZipFile zf(merged);
+            zipios::ZipFile source(first);
+            CATCH_REQUIRE(zf.size() == source.size() + 1);
+            zipios::FileEntry::buffer_t const small(zf.readEntry("tree/small.txt"));
+            CATCH_REQUIRE(std::string(small.begin(), small.end()) == files["tree/small.txt"]);
+            zipios::FileEntry::buffer_t const extra(zf.readEntry("tree/extra.txt"));
+            CATCH_REQUIRE(std::string(extra.begin(), extra.end()) == "an extra file\n");
+            CATCH_REQUIRE(zf.getEntry("tree/large.txt")->getMethod() == zipios::StorageMethod::DEFLATED);
+        }
+
+        // only the entries accepted by the filter get saved
+        //
+        {
+            std::ofstream os(merged, std::ios::out | std::ios::binary);
+            zipios::ZipFile::mergeArchives(
+                      os
+                    , { second, first }
+                    , [](zipios::FileEntry const & entry)
+                      {
+                          return entry.getName().find(".txt") != std::string::npos;
+                      });
+        }
+        {
+            zipios::ZipFile zf(merged);
+            CATCH_REQUIRE(zf.size() == 4);
+            CATCH_REQUIRE(zf.getEntry("tree/sub/random.bin") == nullptr);
+            zipios::FileEntry::buffer_t const small(zf.readEntry("tree/small.txt"));
+            CATCH_REQUIRE(std::string(small.begin(), small.end()) == "another small file\n");
+            CATCH_REQUIRE(zf.getEntry("tree/large.txt")->getMethod() == zipios::StorageMethod::STORED);
+        }
+
+        std::ostringstream os(std::ios::out | std::ios::binary);
+        CATCH_REQUIRE_THROWS_AS(zipios::ZipFile::mergeArchives(os, { first, top_dir + "/missing.zip" }), zipios::IOException);
+        CATCH_REQUIRE_FALSE(os);
+    }
+    CATCH_END_SECTION()
+}
+
+
+CATCH_TEST_CASE("test_memory_input_stream", "[ZipFile][MemoryStream]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/memory-test");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir).c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
     std::stringstream ss;
     ss << "content of the file\n";
     CATCH_REQUIRE(ss.tellp() == 20);
@@ -0,0 +1,383 @@
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc.,  51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ *
+ * Zipios unit tests for the ZipStreamReader class.
+ */
+
+#include "catch_main.hpp"
+
+#include <zipios/codec.hpp>
+#include <zipios/directorycollection.hpp>
+#include <zipios/directoryentry.hpp>
+#include <zipios/iopolicy.hpp>
+#include <zipios/zipfile.hpp>
+#include <zipios/zipiosexceptions.hpp>
+#include <zipios/zipstreamreader.hpp>
+
+#include <src/zipcentraldirectoryentry.hpp>
+#include <src/zipoutputstream.hpp>
+
+#include <fstream>
+#include <map>
+
+#include <zlib.h>
+
+
+CATCH_TEST_CASE("ZipStreamReader", "[ZipFile][ZipStreamReader]")
+{
+    std::string const top_dir(SNAP_CATCH2_NAMESPACE::g_tmp_dir() + "/stream-reader");
+
+    zipios_test::auto_unlink_t auto_unlink(top_dir, true);
+
+    CATCH_REQUIRE(system(("mkdir -p " + top_dir + "/tree/sub").c_str()) == 0);
+    zipios_test::safe_chdir cwd(top_dir);
+
+    // a source which, like a pipe, cannot seek and returns the data
+    // in small chunks
+    //
+    class pipe_streambuf
+        : public std::streambuf
+    {
+    public:
+        pipe_streambuf(std::string const & data)
+            : f_data(data)
+        {
+        }
+
+    protected:
+        virtual int_type underflow() override
+        {
+            if(f_pos >= f_data.length())
+            {
+                return traits_type::eof();
+            }
+            size_t const size(std::min(static_cast<size_t>(rand() % 1000 + 1), f_data.length() - f_pos));
+            char * ptr(const_cast<char *>(f_data.data()) + f_pos);
+            setg(ptr, ptr, ptr + size);
+            f_pos += size;
+            return traits_type::to_int_type(*gptr());
+        }
+
+    private:
+        std::string f_data = std::string();
+        size_t      f_pos = 0;
+    };
+
+
+    std::map<std::string, std::string> files;
+    for(int i(0); i < 40000; ++i)
+    {
+        files["large.txt"] += "line " + std::to_string(rand() % 500) + " of the log\n";
+    }
+    for(int i(0); i < 3000; ++i)
+    {
+        files["sub/random.bin"] += static_cast<char>(rand());
+    }
+    files["small.txt"] = "a small file\n";
+    files["sub/empty.txt"] = std::string();
+    for(auto const & f : files)
+    {
+        std::ofstream os("tree/" + f.first, std::ios::out | std::ios::binary);
+        os << f.second;
+    }
+
+    // read all the entries and check their data
+    //
+    auto check = [&files](std::string const & zip)
+    {
+        pipe_streambuf source(zip);
+        std::istream in(&source);
+        zipios::ZipStreamReader reader(in);
+        CATCH_REQUIRE(reader.getInputStream() == nullptr);
+
+        size_t found(0);
+        for(zipios::FileEntry::pointer_t entry(reader.getNextEntry());
+            entry != nullptr;
+            entry = reader.getNextEntry())
+        {
+            zipios::ZipStreamReader::stream_pointer_t is(reader.getInputStream());
+            CATCH_REQUIRE(is != nullptr);
+            std::string const data(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{});
+            CATCH_REQUIRE_FALSE(is->bad());
+            if(entry->isDirectory())
+            {
+                CATCH_REQUIRE(data.empty());
+                continue;
+            }
+
+            std::string const name(entry->getName());
+            CATCH_REQUIRE(name.substr(0, 5) == "tree/");
+            auto const it(files.find(name.substr(5)));
+            CATCH_REQUIRE(it != files.end());
+            CATCH_REQUIRE(data == it->second);
+
+            // once read, the sizes and CRC found in a data descriptor
+            // are available too
+            //
+            CATCH_REQUIRE(entry->getSize() == it->second.length());
+            CATCH_REQUIRE(entry->getCrc() == crc32(0L, reinterpret_cast<Bytef const *>(it->second.data()), it->second.length()));
+            ++found;
+        }
+        CATCH_REQUIRE(found == files.size());
+
+        // the end remains the end
+        //
+        CATCH_REQUIRE(reader.getNextEntry() == nullptr);
+        CATCH_REQUIRE(reader.getInputStream() == nullptr);
+    };
+
+    std::string const data_descriptor("PK\x07\x08", 4);
+
+    CATCH_START_SECTION("archives saved by the library")
+    {
+        std::vector<zipios::StorageMethod> methods{ zipios::StorageMethod::DEFLATED, zipios::StorageMethod::STORED };
+        if(zipios::Codec::getCodec(zipios::StorageMethod::ZSTD) != nullptr)
+        {
+            methods.push_back(zipios::StorageMethod::ZSTD);
+        }
+        for(auto const method : methods)
+        {
+            for(auto const streaming : { false, true })
+            {
+                zipios::DirectoryCollection collection("tree");
+                collection.setMethod(0, method, method);
+
+                zipios::ZipFile::SaveOptions options;
+                options.setStreaming(streaming);
+                options.setBufferLimit(1000);
+                std::ostringstream os(std::ios::out | std::ios::binary);
+                zipios::ZipFile::saveCollectionToArchive(os, collection, "stream reader", options);
+                std::string const zip(os.str());
+                CATCH_REQUIRE((zip.find(data_descriptor) != std::string::npos) == streaming);
+
+                check(zip);
+            }
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("archives streamed by Info-ZIP")
+    {
+        for(auto const & options : { "", "-0", "-fz" })
+        {
+            std::string const filename(std::string("infozip") + options + ".zip");
+            CATCH_REQUIRE(system((std::string("zip -q -r ") + options + " - tree | cat > " + filename).c_str()) == 0);
+            std::string const zip(zipios_test::read_file(filename));
+            CATCH_REQUIRE(zip.find(data_descriptor) != std::string::npos);
+
+            check(zip);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("empty DEFLATED entries followed by a data descriptor")
+    {
+        std::ostringstream os(std::ios::out | std::ios::binary);
+        {
+            zipios::ZipOutputStream zos(os);
+            zos.setStreaming(true);
+            for(auto const & name : { "tree/empty.txt", "tree/small.txt" })
+            {
+                zipios::DirectoryEntry const source{zipios::FilePath(name)};
+                zipios::FileEntry::pointer_t entry(std::make_shared<zipios::ZipCentralDirectoryEntry>(source));
+                entry->setUnixTime(1600000000);
+                entry->setMethod(zipios::StorageMethod::DEFLATED);
+                zos.putNextEntry(entry);
+                if(std::string(name) == "tree/small.txt")
+                {
+                    zos << files["small.txt"];
+                }
+            }
+            zos.closeEntry();
+            zos.finish();
+        }
+
+        pipe_streambuf source(os.str());
+        std::istream in(&source);
+        zipios::ZipStreamReader reader(in);
+        zipios::FileEntry::pointer_t entry(reader.getNextEntry());
+        CATCH_REQUIRE(entry != nullptr);
+        CATCH_REQUIRE(entry->getName() == "tree/empty.txt");
+        std::string data(std::istreambuf_iterator<char>(*reader.getInputStream()), std::istreambuf_iterator<char>{});
+        CATCH_REQUIRE(data.empty());
+        CATCH_REQUIRE(entry->getSize() == 0);
+
+        entry = reader.getNextEntry();
+        CATCH_REQUIRE(entry != nullptr);
+        CATCH_REQUIRE(entry->getName() == "tree/small.txt");
+        data = std::string(std::istreambuf_iterator<char>(*reader.getInputStream()), std::istreambuf_iterator<char>{});
+        CATCH_REQUIRE(data == files["small.txt"]);
+
+        CATCH_REQUIRE(reader.getNextEntry() == nullptr);
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("STORED entries followed by a data descriptor with tiny input buffers")
+    {
+        // the second entry fakes a size close to 4Gb so its data
+        // descriptor uses 64 bit sizes (24 bytes instead of 16)
+        //
+        std::ostringstream os(std::ios::out | std::ios::binary);
+        {
+            zipios::ZipOutputStream zos(os);
+            zos.setStreaming(true);
+            for(auto const & name : { "tree/small.txt", "tree/sub/random.bin" })
+            {
+                zipios::DirectoryEntry const source{zipios::FilePath(name)};
+                zipios::FileEntry::pointer_t entry(std::make_shared<zipios::ZipCentralDirectoryEntry>(source));
+                entry->setUnixTime(1600000000);
+                entry->setMethod(zipios::StorageMethod::STORED);
+                if(std::string(name) == "tree/sub/random.bin")
+                {
+                    entry->setSize(0xFFFFFFFF - 100);
+                }
+                zos.putNextEntry(entry);
+                zos << files[std::string(name).substr(5)];
+            }
+            zos.closeEntry();
+            zos.finish();
+        }
+        std::string const zip(os.str());
+
+        for(size_t const size : { 1, 8, 15, 16, 23, 24, 8192 })
+        {
+            zipios::IOPolicy policy;
+            policy.setInputBufferSize(size);
+
+            std::istringstream in(zip, std::ios::in | std::ios::binary);
+            zipios::ZipStreamReader reader(in, policy);
+            for(auto const & name : { "small.txt", "sub/random.bin" })
+            {
+                zipios::FileEntry::pointer_t entry(reader.getNextEntry());
+                CATCH_REQUIRE(entry != nullptr);
+                CATCH_REQUIRE(entry->getName() == std::string("tree/") + name);
+                std::string const data(std::istreambuf_iterator<char>(*reader.getInputStream()), std::istreambuf_iterator<char>{});
+                CATCH_REQUIRE(data == files[name]);
+                CATCH_REQUIRE(entry->getSize() == files[name].length());
+            }
+            CATCH_REQUIRE(reader.getNextEntry() == nullptr);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("entries can be skipped")
+    {
+        zipios::DirectoryCollection collection("tree");
+        zipios::ZipFile::SaveOptions options;
+        options.setStreaming(true);
+        options.setBufferLimit(0);
+        std::ostringstream os(std::ios::out | std::ios::binary);
+        zipios::ZipFile::saveCollectionToArchive(os, collection, std::string(), options);
+
+        std::vector<std::string> expected;
+        for(auto const & entry : collection.entries())
+        {
+            expected.push_back(entry->getName());
+        }
+
+        for(int read(0); read < 2; ++read)
+        {
+            pipe_streambuf source(os.str());
+            std::istream in(&source);
+            zipios::ZipStreamReader reader(in);
+            std::vector<std::string> names;
+            for(zipios::FileEntry::pointer_t entry(reader.getNextEntry());
+                entry != nullptr;
+                entry = reader.getNextEntry())
+            {
+                names.push_back(entry->getName());
+                if(read == 1)
+                {
+                    // read only the first byte
+                    //
+                    reader.getInputStream()->get();
+                }
+            }
+            CATCH_REQUIRE(names == expected);
+        }
+    }
+    CATCH_END_SECTION()
+
+    CATCH_START_SECTION("invalid archives")
+    {
+        {
+            pipe_streambuf source("this is not a zip archive");
+            std::istream in(&source);
+            zipios::ZipStreamReader reader(in);
+            CATCH_REQUIRE_THROWS_AS(reader.getNextEntry(), zipios::IOException);
+        }
+
+        for(auto const streaming : { false, true })
+        {
+            zipios::DirectoryCollection collection("tree");
+            collection.setMethod(0, zipios::StorageMethod::STORED, zipios::StorageMethod::STORED);
+            zipios::ZipFile::SaveOptions options;
+            options.setStreaming(streaming);
+            options.setBufferLimit(0);
+            std::ostringstream os(std::ios::out | std::ios::binary);
+            zipios::ZipFile::saveCollectionToArchive(os, collection, std::string(), options);
+
+            // truncated
+            //
+            {
+                pipe_streambuf source(os.str().substr(0, os.str().find("a small file") + 5));
+                std::istream in(&source);
+                zipios::ZipStreamReader reader(in);
+                CATCH_REQUIRE_THROWS_AS(
+                    [&reader]()
+                    {
+                        while(reader.getNextEntry() != nullptr)
+                        {
+                        }
+                    }(), zipios::IOException);
+            }
+
+            // invalid data
+            //
+            std::string zip(os.str());
+            zip[zip.find("a small file")] = 'A';
+            pipe_streambuf source(zip);
+            std::istream in(&source);
+            zipios::ZipStreamReader reader(in);
+            CATCH_REQUIRE_THROWS_AS(
+                [&reader]()
+                {
+                    while(reader.getNextEntry() != nullptr)
+                    {
+                        zipios::ZipStreamReader::stream_pointer_t is(reader.getInputStream());
+                        std::string const data(std::istreambuf_iterator<char>(*is), std::istreambuf_iterator<char>{});
+                    }
+                }(), zipios::IOException);
+        }
+    }
+    CATCH_END_SECTION()
+}
+
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
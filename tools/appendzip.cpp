@@ -88,17 +88,28 @@ int main(int argc, char *argv[])
     }
 
     // get eof pos (to become zip file starting position).
-    std::uint32_t const zip_start(exef.tellp());
+    std::uint64_t const zip_start(exef.tellp());
     std::cout << "zip starts at " << zip_start << std::endl;
 
     // Append zip file to exe file
     exef << zipf.rdbuf();
 
-    // write zipfile start offset to file
-    exef << static_cast<unsigned char>(zip_start);
-    exef << static_cast<unsigned char>(zip_start >> 8);
-    exef << static_cast<unsigned char>(zip_start >> 16);
-    exef << static_cast<unsigned char>(zip_start >> 24);
+    // write zipfile start offset to file; when it does not fit in 32 bits
+    // write it on 64 bits followed by 0xFFFFFFFF
+    //
+    std::uint32_t marker(zip_start);
+    if(zip_start >= 0xFFFFFFFF)
+    {
+        for(int shift(0); shift < 64; shift += 8)
+        {
+            exef << static_cast<unsigned char>(zip_start >> shift);
+        }
+        marker = 0xFFFFFFFF;
+    }
+    exef << static_cast<unsigned char>(marker);
+    exef << static_cast<unsigned char>(marker >> 8);
+    exef << static_cast<unsigned char>(marker >> 16);
+    exef << static_cast<unsigned char>(marker >> 24);
 
     return 0;
 }
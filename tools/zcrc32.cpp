@@ -1,11 +1,11 @@
 
 
+#include    "src/crc32.hpp"
+
 #include    <fstream>
 #include    <iomanip>
 #include    <iostream>
 
-#include    <zlib.h>
-
 
 int main(int argc, char *argv[])
 {
@@ -22,7 +22,7 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    int result(crc32(0, nullptr, 0));
+    uint32_t result(0);
     for(;;)
     {
         char buf[64 * 1024];
@@ -31,7 +31,7 @@ int main(int argc, char *argv[])
         {
             break;
         }
-        result = crc32(result, reinterpret_cast<Bytef const *>(buf), in.gcount());
+        result = zipios::updateCRC32(result, buf, in.gcount());
     }
 
     std::cout << std::hex << std::setw(8) << std::setfill('0') << result << "\n";
@@ -28,6 +28,7 @@
  * not need all the capabilities offered by zip).
  */
 
+#include <zipios/compressionpolicy.hpp>
 #include <zipios/directorycollection.hpp>
 #include <zipios/zipfile.hpp>
 
@@ -36,6 +37,7 @@
 #include <iostream>
 #include <fstream>
 //#include <stdint.h>
+#include <vector>
 
 
 // static variables
@@ -47,9 +49,18 @@ char *g_progname;
 
 void usage()
 {
-    std::cout << "Usage:  " << g_progname << " <output>[.zip] <input-dir>" << std::endl;
+    std::cout << "Usage:  " << g_progname << " [--opts] <output>[.zip] <input-dir>" << std::endl;
     std::cout << "This tool creates a zip file from a directory or a file." << std::endl;
+    std::cout << "Use - as the <output> to write the zip file to stdout." << std::endl;
     std::cout << "This is a way to exercise the library." << std::endl;
+    std::cout << "Where --opts is one or more of:" << std::endl;
+    std::cout << "   --level <level>      compression level: default, smallest, fastest, none, or 1 to 100" << std::endl;
+    std::cout << "   --limit <size>       files of that size or less get stored (default 256)" << std::endl;
+    std::cout << "   --auto               store files which are already compressed (JPEG, PNG, gzip, ...)" << std::endl;
+    std::cout << "                        and files which do not get smaller when compressed" << std::endl;
+    std::cout << "   --store <pattern>    store files matching the glob pattern (implies --auto)" << std::endl;
+    std::cout << "   --compress <pattern> compress files matching the glob pattern (implies --auto)" << std::endl;
+    std::cout << "   --append             add the files to an existing zip file without rewriting it" << std::endl;
     exit(1);
 }
 
@@ -74,6 +85,9 @@ int main(int argc, char *argv[])
 
     int limit(256);
     zipios::FileEntry::CompressionLevel level(zipios::FileEntry::COMPRESSION_LEVEL_DEFAULT);
+    bool use_policy(false);
+    bool append(false);
+    std::vector<std::pair<std::string, zipios::StorageMethod>> rules;
     std::string in;
     std::string out;
     for(int i(1); i < argc; ++i)
@@ -148,6 +162,27 @@ int main(int argc, char *argv[])
                 limit = std::atoi(argv[i]);
             }
         }
+        else if(strcmp(argv[i], "--auto") == 0)
+        {
+            use_policy = true;
+        }
+        else if(strcmp(argv[i], "--append") == 0)
+        {
+            append = true;
+        }
+        else if(strcmp(argv[i], "--store") == 0
+             || strcmp(argv[i], "--compress") == 0)
+        {
+            bool const store(strcmp(argv[i], "--store") == 0);
+            ++i;
+            if(i >= argc)
+            {
+                std::cerr << "error: the " << argv[i - 1] << " option must be followed by a pattern.";
+                return 1;
+            }
+            rules.emplace_back(argv[i], store ? zipios::StorageMethod::STORED : zipios::StorageMethod::DEFLATED);
+            use_policy = true;
+        }
         else if(out.empty())
         {
             out = argv[i];
@@ -172,8 +207,19 @@ int main(int argc, char *argv[])
     }
     if(in.empty())
     {
+        if(out == "-")
+        {
+            std::cerr << "error: the input directory is required when writing to stdout.\n";
+            return 1;
+        }
         in = out;
     }
+    if(append
+    && out == "-")
+    {
+        std::cerr << "error: the --append option cannot be used when writing to stdout.\n";
+        return 1;
+    }
 
     zipios::DirectoryCollection collection(in);
 
@@ -205,14 +251,52 @@ int main(int argc, char *argv[])
                 , level);
     }
 
-    std::string zipname(out);
-    if(zipname.find(".zip", zipname.length() - 4) == std::string::npos)
+    // stdout may be a pipe so the archive gets streamed
+    //
+    zipios::ZipFile::SaveOptions options;
+    std::string zipname;
+    std::ofstream file;
+    std::ostream * output(&std::cout);
+    if(out == "-")
+    {
+        options.setStreaming(true);
+    }
+    else
     {
-        zipname += ".zip";
+        zipname = out;
+        if(zipname.find(".zip", zipname.length() - 4) == std::string::npos)
+        {
+            zipname += ".zip";
+        }
+        if(!append)
+        {
+            file.open(zipname, std::ios_base::binary);
+            output = &file;
+        }
     }
-    std::ofstream output(zipname, std::ios_base::binary);
 
-    zipios::ZipFile::saveCollectionToArchive(output, collection);
+    if(use_policy
+    && level != zipios::FileEntry::COMPRESSION_LEVEL_NONE)
+    {
+        // the policy replaces the method and level defined above
+        //
+        zipios::CompressionPolicy::pointer_t policy(std::make_shared<zipios::CompressionPolicy>());
+        policy->setCompression(zipios::StorageMethod::DEFLATED, level);
+        policy->setStoreLimit(limit);
+        for(auto const & r : rules)
+        {
+            policy->addRule(r.first, r.second, level);
+        }
+
+        options.setCompressionPolicy(policy);
+    }
+    if(append)
+    {
+        zipios::ZipFile::appendCollectionToArchive(zipname, collection, options);
+        return 0;
+    }
+    zipios::ZipFile::saveCollectionToArchive(*output, collection, std::string(), options);
+    output->flush();
 
     return 0;
 }
@@ -30,10 +30,13 @@
  * zip and unzip for example).
  */
 
+#include "zipios/compressionpolicy.hpp"
 #include "zipios/zipfile.hpp"
 #include "zipios/zipiosexceptions.hpp"
 
+#include <algorithm>
 #include <cstring>
+#include <fstream>
 
 #include <stdlib.h>
 
@@ -66,6 +69,12 @@ void usage()
     std::cout << "  --count                 count the number of files in a .zip archive" << std::endl;
     std::cout << "  --count-directories     count the number of files in a .zip archive" << std::endl;
     std::cout << "  --count-files           count the number of files in a .zip archive" << std::endl;
+    std::cout << "  --merge <output>        copy the entries of the .zip archives to <output> without" << std::endl;
+    std::cout << "                          recompressing them; the first entry with a given name is kept" << std::endl;
+    std::cout << "  --filter <pattern>      with --merge, only copy the entries which name matches the" << std::endl;
+    std::cout << "                          case insensitive glob pattern (can be used multiple times);" << std::endl;
+    std::cout << "                          a pattern without a '/' matches the basename, otherwise it" << std::endl;
+    std::cout << "                          matches the full name and '*' also matches '/'" << std::endl;
     std::cout << "  --help                  show this help screen" << std::endl;
     std::cout << "  --libzipios-version     print the library version and exit" << std::endl;
     std::cout << "  --version               print this tool's version and exit" << std::endl;
@@ -107,9 +116,19 @@ enum class func_t
      * It represents the number of entries representing regular files
      * found in a Zip archive.
      */
-    COUNT_FILES
+    COUNT_FILES,
+
+    /** \brief Copy the entries of Zip archives to a new Zip archive.
+     *
+     * This function is used when the user specify --merge. The entries
+     * of all the Zip archives, optionally filtered with --filter, are
+     * copied to the output archive without being decompressed and
+     * compressed again.
+     */
+    MERGE
 };
 
+
 } // no name namespace
 
 
@@ -134,6 +153,8 @@ int main(int argc, char *argv[])
     {
         // check the various command line options
         std::vector<std::string> files;
+        std::vector<std::string> patterns;
+        std::string output;
         func_t function(func_t::UNDEFINED);
         for(int i(1); i < argc; ++i)
         {
@@ -168,6 +189,25 @@ int main(int argc, char *argv[])
                 {
                     function = func_t::COUNT_FILES;
                 }
+                else if(strcmp(argv[i], "--merge") == 0
+                     || strcmp(argv[i], "--filter") == 0)
+                {
+                    ++i;
+                    if(i >= argc)
+                    {
+                        std::cerr << g_progname << ":error: the " << argv[i - 1] << " option must be followed by a parameter." << std::endl;
+                        exit(1);
+                    }
+                    if(strcmp(argv[i - 1], "--merge") == 0)
+                    {
+                        function = func_t::MERGE;
+                        output = argv[i];
+                    }
+                    else
+                    {
+                        patterns.push_back(argv[i]);
+                    }
+                }
             }
             else
             {
@@ -234,6 +274,33 @@ int main(int argc, char *argv[])
             }
             break;
 
+        case func_t::MERGE:
+        {
+            std::ofstream os(output, std::ios::out | std::ios::binary);
+            if(!os)
+            {
+                std::cerr << g_progname << ":error: could not create \"" << output << "\"." << std::endl;
+                exit(1);
+            }
+            zipios::ZipFile::entry_filter_t filter;
+            if(!patterns.empty())
+            {
+                filter = [&patterns](zipios::FileEntry const & entry)
+                {
+                    std::string const name(entry.getName());
+                    return std::any_of(
+                              patterns.begin()
+                            , patterns.end()
+                            , [&name](std::string const & pattern)
+                              {
+                                  return zipios::CompressionPolicy::matchPattern(pattern, name);
+                              });
+                };
+            }
+            zipios::ZipFile::mergeArchives(os, files, filter);
+        }
+            break;
+
         default:
             std::cerr << g_progname << ":error: undefined function." << std::endl;
             usage();
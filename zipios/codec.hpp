@@ -0,0 +1,93 @@
+#pragma once
+#ifndef ZIPIOS_CODEC_HPP
+#define ZIPIOS_CODEC_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Define the zipios::Codec class and its registry.
+ *
+ * A Codec implements a Zip compression method other than STORED and
+ * DEFLATED. The codecs get registered by method and are then used to
+ * read and write the entries using that method.
+ */
+
+#include "zipios/fileentry.hpp"
+
+
+namespace zipios
+{
+
+
+class Compressor
+{
+public:
+    typedef std::unique_ptr<Compressor>     pointer_t;
+
+    virtual                     ~Compressor();
+
+    virtual void                compress(char const * data, size_t size, bool finish, std::vector<char> & output) = 0;
+};
+
+
+class Decompressor
+{
+public:
+    typedef std::unique_ptr<Decompressor>   pointer_t;
+
+    virtual                     ~Decompressor();
+
+    virtual bool                decompress(char const * & input, size_t & input_size, char * & output, size_t & output_size) = 0;
+};
+
+
+class Codec
+{
+public:
+    typedef std::shared_ptr<Codec>          pointer_t;
+
+    virtual                     ~Codec();
+
+    virtual StorageMethod       getMethod() const = 0;
+    virtual std::string         getName() const = 0;
+    virtual uint16_t            getExtractVersion() const = 0;
+    virtual Compressor::pointer_t
+                                createCompressor(FileEntry::CompressionLevel level) const = 0;
+    virtual Decompressor::pointer_t
+                                createDecompressor() const = 0;
+
+    static void                 registerCodec(pointer_t codec);
+    static void                 unregisterCodec(StorageMethod method);
+    static pointer_t            getCodec(StorageMethod method);
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
@@ -51,7 +51,7 @@ public:
     bool                            addCollection(FileCollection::pointer_t collection);
     virtual void                    close() override;
     virtual FileEntry::vector_t     entries() const override;
-    virtual FileEntry::pointer_t    getEntry(std::string const & name, MatchPath matchpath = MatchPath::MATCH) const override;
+    virtual FileEntry::pointer_t    getEntry(std::string_view name, MatchPath matchpath = MatchPath::MATCH) const override;
     virtual stream_pointer_t        getInputStream(std::string const & entry_name, MatchPath matchpath = MatchPath::MATCH) override;
     virtual size_t                  size() const override;
     virtual void                    mustBeValid() const;
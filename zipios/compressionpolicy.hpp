@@ -0,0 +1,97 @@
+#pragma once
+#ifndef ZIPIOS_COMPRESSIONPOLICY_HPP
+#define ZIPIOS_COMPRESSIONPOLICY_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Define the zipios::CompressionPolicy class.
+ *
+ * The CompressionPolicy chooses the storage method and compression
+ * level of each entry saved in an archive from its name and content.
+ */
+
+#include "zipios/fileentry.hpp"
+
+
+namespace zipios
+{
+
+
+class CompressionPolicy
+{
+public:
+    typedef std::shared_ptr<CompressionPolicy>  pointer_t;
+
+    static constexpr size_t     DEFAULT_SAMPLE_SIZE = 4096;
+
+    void                        addRule(std::string const & pattern, StorageMethod method, FileEntry::CompressionLevel level = FileEntry::COMPRESSION_LEVEL_DEFAULT);
+    void                        clearRules();
+    StorageMethod               getMethod() const;
+    FileEntry::CompressionLevel getLevel() const;
+    void                        setCompression(StorageMethod method, FileEntry::CompressionLevel level = FileEntry::COMPRESSION_LEVEL_DEFAULT);
+    size_t                      getStoreLimit() const;
+    void                        setStoreLimit(size_t limit);
+    size_t                      getSampleSize() const;
+    void                        setSampleSize(size_t size);
+    double                      getEntropyThreshold() const;
+    void                        setEntropyThreshold(double threshold);
+    bool                        getDetectFormats() const;
+    void                        setDetectFormats(bool detect);
+    bool                        getStoreFallback() const;
+    void                        setStoreFallback(bool fallback);
+
+    void                        apply(FileEntry & entry, char const * sample, size_t size) const;
+
+    static double               entropy(char const * data, size_t size);
+    static bool                 isCompressedFormat(char const * data, size_t size);
+    static bool                 matchPattern(std::string const & pattern, std::string const & name);
+
+private:
+    struct rule_t
+    {
+        std::string                 m_pattern = std::string();
+        StorageMethod               m_method = StorageMethod::DEFLATED;
+        FileEntry::CompressionLevel m_level = FileEntry::COMPRESSION_LEVEL_DEFAULT;
+    };
+
+    std::vector<rule_t>         m_rules = std::vector<rule_t>();
+    StorageMethod               m_method = StorageMethod::DEFLATED;
+    FileEntry::CompressionLevel m_level = FileEntry::COMPRESSION_LEVEL_DEFAULT;
+    size_t                      m_store_limit = 0;
+    size_t                      m_sample_size = DEFAULT_SAMPLE_SIZE;
+    double                      m_entropy_threshold = 7.5;
+    bool                        m_detect_formats = true;
+    bool                        m_store_fallback = true;
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
@@ -50,11 +50,11 @@ public:
 
     virtual void                    close() override;
     virtual FileEntry::vector_t     entries() const override;
-    virtual FileEntry::pointer_t    getEntry(std::string const & name, MatchPath matchpath = MatchPath::MATCH) const override;
+    virtual FileEntry::pointer_t    getEntry(std::string_view name, MatchPath matchpath = MatchPath::MATCH) const override;
     virtual stream_pointer_t        getInputStream(std::string const & entry_name, MatchPath matchpath = MatchPath::MATCH) override;
 
 protected:
-    void                            loadEntries() const;
+    virtual void                    loadEntries() const override;
     void                            load(FilePath const & subdir);
 
     mutable bool                    m_entries_loaded = false;
@@ -32,11 +32,17 @@
 
 #include "zipios/fileentry.hpp"
 
+#include <deque>
+#include <string_view>
+
 
 namespace zipios
 {
 
 
+class NameIndex;
+
+
 class FileCollection
 {
 public:
@@ -50,6 +56,8 @@ public:
         MATCH
     };
 
+    static constexpr size_t         g_no_entry = static_cast<size_t>(-1);
+
                                     FileCollection(std::string const & filename = std::string());
                                     FileCollection(FileCollection const & rhs);
     virtual pointer_t               clone() const = 0;
@@ -60,7 +68,7 @@ public:
     virtual void                    addEntry(FileEntry const & entry);
     virtual void                    close();
     virtual FileEntry::vector_t     entries() const;
-    virtual FileEntry::pointer_t    getEntry(std::string const & name, MatchPath matchpath = MatchPath::MATCH) const;
+    virtual FileEntry::pointer_t    getEntry(std::string_view name, MatchPath matchpath = MatchPath::MATCH) const;
     virtual stream_pointer_t        getInputStream(std::string const & entry_name, MatchPath matchpath = MatchPath::MATCH) = 0;
     virtual std::string             getName() const;
     virtual size_t                  size() const;
@@ -70,9 +78,19 @@ public:
     void                            setLevel(size_t limit, FileEntry::CompressionLevel small_compression_level, FileEntry::CompressionLevel large_compression_level);
 
 protected:
+    virtual void                    loadEntries() const;
+    size_t                          findEntryIndex(std::string_view name, MatchPath matchpath) const;
+    void                            indexEntries();
+    void                            clearIndex();
+
     std::string                     m_filename = std::string();
     FileEntry::vector_t             m_entries = FileEntry::vector_t();
     bool                            m_valid = true;
+
+private:
+    std::deque<std::string>         m_index_names = std::deque<std::string>();
+    std::shared_ptr<NameIndex>      m_index = std::shared_ptr<NameIndex>();
+    size_t                          m_indexed_entries = 0;
 };
 
 
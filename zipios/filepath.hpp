@@ -36,6 +36,7 @@
 #include "zipios/zipios-config.hpp"
 
 #include <ctime>
+#include <memory>
 #include <string>
 
 
@@ -76,9 +77,9 @@ private:
     void                check() const;
 
     std::string         m_path = std::string();
-    mutable os_stat_t   m_stat = {};
+    mutable std::shared_ptr<os_stat_t const>
+                        m_stat = std::shared_ptr<os_stat_t const>();
     mutable bool        m_checked = false;
-    mutable bool        m_exists = false;
 };
 
 
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef ZIPIOS_IOPOLICY_HPP
+#define ZIPIOS_IOPOLICY_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Define the zipios::IOPolicy class.
+ *
+ * The IOPolicy defines the size of the buffers used by the streams
+ * reading and writing Zip archives.
+ */
+
+#include "zipios/zipios-config.hpp"
+
+
+namespace zipios
+{
+
+
+class IOPolicy
+{
+public:
+    size_t                      getInputBufferSize() const;
+    void                        setInputBufferSize(size_t size);
+    size_t                      getOutputBufferSize() const;
+    void                        setOutputBufferSize(size_t size);
+    size_t                      getReadAhead() const;
+    void                        setReadAhead(size_t size);
+
+private:
+    size_t                      m_input_buffer_size = getBufferSize();
+    size_t                      m_output_buffer_size = getBufferSize();
+    size_t                      m_read_ahead = 0;
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif
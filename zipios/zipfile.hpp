@@ -37,36 +37,198 @@
  */
 
 #include "zipios/filecollection.hpp"
+#include "zipios/compressionpolicy.hpp"
+#include "zipios/iopolicy.hpp"
 #include "zipios/virtualseeker.hpp"
 
+#include <atomic>
+#include <functional>
+
 
 namespace zipios
 {
 
 
+class InflateIndex;
+class RandomAccessFile;
+class ZipCatalog;
+
+
 class ZipFile : public FileCollection
 {
 public:
+    enum class Verification : uint32_t
+    {
+        EAGER,
+        LAZY,
+        NONE
+    };
+
+    enum class CRCVerification : uint32_t
+    {
+        NONE,
+        ALWAYS,
+        FIRST_READ
+    };
+
+    enum class Access : uint32_t
+    {
+        STREAM,
+        POSITIONAL_READ,
+        MEMORY_MAP
+    };
+
+    enum class DeflateBackend : uint32_t
+    {
+        ZLIB,
+        LIBDEFLATE
+    };
+
+    class OpenOptions
+    {
+    public:
+        Access                  getAccess() const;
+        void                    setAccess(Access access);
+        Verification            getVerification() const;
+        void                    setVerification(Verification verification);
+        size_t                  getVerificationThreads() const;
+        void                    setVerificationThreads(size_t threads);
+        bool                    getLazyEntries() const;
+        void                    setLazyEntries(bool lazy);
+        offset_t                getSeekIndexSpan() const;
+        void                    setSeekIndexSpan(offset_t span);
+        CRCVerification         getCRCVerification() const;
+        void                    setCRCVerification(CRCVerification verification);
+        IOPolicy const &        getIOPolicy() const;
+        void                    setIOPolicy(IOPolicy const & policy);
+
+    private:
+        Access                  m_access = Access::STREAM;
+        Verification            m_verification = Verification::EAGER;
+        size_t                  m_verification_threads = 0;
+        bool                    m_lazy_entries = false;
+        offset_t                m_seek_index_span = 0;
+        CRCVerification         m_crc_verification = CRCVerification::NONE;
+        IOPolicy                m_io_policy = IOPolicy();
+    };
+
+    class SaveOptions
+    {
+    public:
+        size_t                  getThreads() const;
+        void                    setThreads(size_t threads);
+        size_t                  getBufferLimit() const;
+        void                    setBufferLimit(size_t limit);
+        size_t                  getBlockSize() const;
+        void                    setBlockSize(size_t block_size);
+        DeflateBackend          getDeflateBackend() const;
+        void                    setDeflateBackend(DeflateBackend backend);
+        CompressionPolicy::pointer_t
+                                getCompressionPolicy() const;
+        void                    setCompressionPolicy(CompressionPolicy::pointer_t policy);
+        IOPolicy const &        getIOPolicy() const;
+        void                    setIOPolicy(IOPolicy const & policy);
+        bool                    getStreaming() const;
+        void                    setStreaming(bool streaming);
+
+    private:
+        size_t                  m_threads = 1;
+        size_t                  m_buffer_limit = 16 * 1024 * 1024;
+        size_t                  m_block_size = 0;
+        DeflateBackend          m_deflate_backend = DeflateBackend::ZLIB;
+        CompressionPolicy::pointer_t
+                                m_compression_policy = CompressionPolicy::pointer_t();
+        IOPolicy                m_io_policy = IOPolicy();
+        bool                    m_streaming = false;
+    };
+
+    typedef std::function<bool(FileEntry const & entry)>  entry_filter_t;
+
     static pointer_t            openEmbeddedZipFile(std::string const & filename);
 
                                 ZipFile();
                                 ZipFile(std::string const & filename, offset_t s_off = 0, offset_t e_off = 0);
+                                ZipFile(std::string const & filename, OpenOptions const & options, offset_t s_off = 0, offset_t e_off = 0);
                                 ZipFile(std::istream & is, offset_t s_off = 0, offset_t e_off = 0);
+                                ZipFile(std::istream & is, OpenOptions const & options, offset_t s_off = 0, offset_t e_off = 0);
     virtual pointer_t           clone() const override;
     virtual                     ~ZipFile() override;
 
+    virtual void                close() override;
+    virtual FileEntry::vector_t entries() const override;
+    virtual FileEntry::pointer_t
+                                getEntry(
+                                          std::string_view name
+                                        , MatchPath matchpath = MatchPath::MATCH) const override;
+    virtual size_t              size() const override;
     virtual stream_pointer_t    getInputStream(
                                           std::string const & entry_name
                                         , MatchPath matchpath = MatchPath::MATCH) override;
+    stream_pointer_t            getRawInputStream(
+                                          std::string const & entry_name
+                                        , MatchPath matchpath = MatchPath::MATCH);
+    size_t                      readEntry(
+                                          std::string const & entry_name
+                                        , void * buffer
+                                        , size_t size
+                                        , MatchPath matchpath = MatchPath::MATCH);
+    FileEntry::buffer_t         readEntry(
+                                          std::string const & entry_name
+                                        , MatchPath matchpath = MatchPath::MATCH);
     static void                 saveCollectionToArchive(
                                           std::ostream & os
                                         , FileCollection & collection
                                         , std::string const & zip_comment = std::string());
+    static void                 saveCollectionToArchive(
+                                          std::ostream & os
+                                        , FileCollection & collection
+                                        , std::string const & zip_comment
+                                        , SaveOptions const & options);
+    static void                 appendCollectionToArchive(
+                                          std::string const & filename
+                                        , FileCollection & collection);
+    static void                 appendCollectionToArchive(
+                                          std::string const & filename
+                                        , FileCollection & collection
+                                        , SaveOptions const & options);
+    static void                 mergeArchives(
+                                          std::ostream & os
+                                        , std::vector<std::string> const & filenames
+                                        , entry_filter_t const & filter = entry_filter_t());
 
 private:
+    typedef std::shared_ptr<RandomAccessFile>           file_pointer_t;
+    typedef std::vector<std::atomic<bool>>              verified_t;
+    typedef std::shared_ptr<verified_t>                 verified_pointer_t;
+    typedef std::vector<std::atomic<offset_t>>          data_offsets_t;
+    typedef std::shared_ptr<data_offsets_t>             data_offsets_pointer_t;
+    typedef std::shared_ptr<ZipCatalog const>           catalog_pointer_t;
+    struct inflate_indexes_t;
+    typedef std::shared_ptr<inflate_indexes_t>          inflate_indexes_pointer_t;
+
     void                        init(std::istream & is);
+    FileEntry::pointer_t        getArchiveEntry(size_t idx) const;
+    FileEntry::pointer_t        findEntry(std::string_view name, MatchPath matchpath, size_t & idx) const;
+    void                        verifyEntries(std::istream & is);
+    void                        verifyEntry(size_t idx, FileEntry const & entry);
+    void                        setDataOffset(size_t idx, offset_t data) const;
+    offset_t                    getDataOffset(size_t idx, FileEntry const & entry) const;
+    void                        readEntryData(size_t idx, FileEntry::pointer_t entry, void * buffer);
+    std::shared_ptr<InflateIndex>
+                                getInflateIndex(size_t idx, FileEntry const & entry) const;
+    bool                        mustVerifyData(size_t idx) const;
+    void                        setDataVerified(size_t idx) const;
 
     VirtualSeeker               m_vs = VirtualSeeker();
+    OpenOptions                 m_options = OpenOptions();
+    file_pointer_t              m_file = file_pointer_t();
+    verified_pointer_t          m_verified = verified_pointer_t();
+    verified_pointer_t          m_data_verified = verified_pointer_t();
+    data_offsets_pointer_t      m_data_offsets = data_offsets_pointer_t();
+    catalog_pointer_t           m_catalog = catalog_pointer_t();
+    inflate_indexes_pointer_t   m_inflate_indexes = inflate_indexes_pointer_t();
+    offset_t                    m_central_directory_offset = 0;
+    std::string                 m_comment = std::string();
 };
 
 
@@ -0,0 +1,80 @@
+#pragma once
+#ifndef ZIPIOS_ZIPSTREAMREADER_HPP
+#define ZIPIOS_ZIPSTREAMREADER_HPP
+
+/*
+  Zipios -- a small C++ library that provides easy access to .zip files.
+
+  Copyright (c) 2015-2022  Made to Order Software Corp.  All Rights Reserved
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/** \file
+ * \brief Define the zipios::ZipStreamReader class.
+ *
+ * The ZipStreamReader reads the entries of a Zip archive one after
+ * another from an input stream which does not need to support seeking.
+ */
+
+#include "zipios/fileentry.hpp"
+#include "zipios/iopolicy.hpp"
+
+
+namespace zipios
+{
+
+
+class PushbackStreambuf;
+class ZipInputStream;
+
+
+class ZipStreamReader
+{
+public:
+    typedef std::shared_ptr<std::istream>   stream_pointer_t;
+
+                                ZipStreamReader(std::istream & is, IOPolicy const & policy = IOPolicy());
+                                ZipStreamReader(ZipStreamReader const & rhs) = delete;
+                                ~ZipStreamReader();
+
+    ZipStreamReader &           operator = (ZipStreamReader const & rhs) = delete;
+
+    FileEntry::pointer_t        getNextEntry();
+    stream_pointer_t            getInputStream() const;
+    void                        closeEntry();
+
+private:
+    IOPolicy                    m_policy = IOPolicy();
+    std::unique_ptr<PushbackStreambuf>
+                                m_input;
+    FileEntry::pointer_t        m_entry = FileEntry::pointer_t();
+    std::shared_ptr<ZipInputStream>
+                                m_stream = std::shared_ptr<ZipInputStream>();
+    bool                        m_end = false;
+};
+
+
+} // zipios namespace
+
+// Local Variables:
+// mode: cpp
+// indent-tabs-mode: nil
+// c-basic-offset: 4
+// tab-width: 4
+// End:
+
+// vim: ts=4 sw=4 et
+#endif